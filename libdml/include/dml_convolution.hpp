@@ -1,17 +1,19 @@
 #pragma once
 #include "dml_types.hpp"
+#include "dml_scalars.hpp"
 
 #include <vector>
 #include <optional>
 #include <memory>
-#include <map>
 
 namespace libdml
 {
 enum class ConvolutionDirection
 {
     eForward = 0,
-    eBackward
+    eBackward,
+    // ..
+    eCount
 };
 
 enum ConvolutionExecParamsType
@@ -21,7 +23,9 @@ enum ConvolutionExecParamsType
     CONVOLUTION_EXEC_PARAM_TYPE_OUTPUT,
     CONVOLUTION_EXEC_PARAM_TYPE_WEIGHTS,
     CONVOLUTION_EXEC_PARAM_TYPE_BIAS,
-    CONVOLUTION_EXEC_PARAM_TYPE_SCALARS  //ToDo: can we assume that scalar are always packed together? Or should be seperated list of scalaras?
+    CONVOLUTION_EXEC_PARAM_TYPE_SCALARS,  // all scalars packed together as root constants, layout given by ConvolutionPrimitive::get_scalars_schema()
+
+    CONVOLUTION_EXEC_PARAM_TYPE_COUNT
 };
 
 /*
@@ -46,9 +50,23 @@ struct ConvolutionDescriptor
     DataType datatype_accumulator = DataType::eFp32;
     ConvolutionDirection direction = ConvolutionDirection::eForward;
 
-    std::optional<Activation> fused_activation = std::nullopt;
+    // bias is applied before the post ops
+    PostOps post_ops;
 };
 
+inline bool operator==(const ConvolutionDescriptor& lhs, const ConvolutionDescriptor& rhs)
+{
+    return lhs.tensor_input == rhs.tensor_input && lhs.tensor_output == rhs.tensor_output && lhs.tensor_weights == rhs.tensor_weights
+        && lhs.tensor_bias == rhs.tensor_bias && lhs.strides == rhs.strides && lhs.dilations == rhs.dilations
+        && lhs.start_padding == rhs.start_padding && lhs.end_padding == rhs.end_padding && lhs.group_count == rhs.group_count
+        && lhs.datatype_accumulator == rhs.datatype_accumulator && lhs.direction == rhs.direction && lhs.post_ops == rhs.post_ops;
+}
+
+inline bool operator!=(const ConvolutionDescriptor& lhs, const ConvolutionDescriptor& rhs)
+{
+    return !(lhs == rhs);
+}
+
 /*
 * 
 */
@@ -60,15 +78,13 @@ struct ConvolutionPrefferedLayout
     std::optional<DataLayout> bias_layout = std::nullopt;
 };
 
-struct ExecParamInfo
-{
-    std::uint32_t index;
-};
-
+// No heap allocations, tables are indexed with ConvolutionExecParamsType.
 struct ConvolutionExecutionParams
 {
-    std::map<ConvolutionExecParamsType, ExecParamInfo> params_map;
-    std::vector<std::byte> scalars_buffer;
+    ExecParamsTable<CONVOLUTION_EXEC_PARAM_TYPE_COUNT> params_map;
+    // tensors of the post ops, in order of desc.post_ops (see PostOp)
+    PostOpsExecParams post_ops_params;
+    ScalarsBuffer scalars_buffer;
 };
 
 class ConvolutionImplementation;
@@ -76,11 +92,13 @@ class ConvolutionPrimitive
 {
 public:
     ConvolutionPrimitive(ConvolutionImplementation* impl);
-    ConvolutionPrimitive(const ConvolutionPrimitive& rhs) = delete;
-    ConvolutionPrimitive& operator=(const ConvolutionPrimitive& rhs) = delete;
+    // copies share the implementation, it is not modified after creation (priority is kept by the primitive)
+    ConvolutionPrimitive(const ConvolutionPrimitive& rhs) = default;
+    ConvolutionPrimitive& operator=(const ConvolutionPrimitive& rhs) = default;
 
     ConvolutionPrimitive(ConvolutionPrimitive&& rhs) noexcept
         : impl_(std::move(rhs.impl_))
+        , priority_(rhs.priority_)
     {
     }
 
@@ -89,6 +107,7 @@ public:
         if (this != &rhs)
         {
             impl_ = std::move(rhs.impl_);
+            priority_ = rhs.priority_;
         }
         return *this;
     }
@@ -97,22 +116,62 @@ public:
 
     ImplementationInfo get_info() const;
     ConvolutionPrefferedLayout query_preffered_layouts() const;
+    // Post ops chains the implementation can fuse, runtime can use it to decide which ops to put into descriptor post ops.
+    PostOpsSupport get_post_ops_support() const;
+    // Layout of execution params scalars_buffer, empty if the kernel takes no scalars (everything is baked with jits).
+    ScalarsSchema get_scalars_schema() const;
     KernelInfo get_kernel_info(const ConvolutionPrefferedLayout& layouts) const;
 
     ConvolutionExecutionParams get_execution_map(ErrorCode* error_code) const;
 
-    struct ImplDeleter
-    {
-        void operator()(ConvolutionImplementation*) const;
-    };
 private:
-    std::unique_ptr<ConvolutionImplementation, ImplDeleter> impl_;
+    // priority is relative to the other implementations, so only the implementations list sets it
+    template<typename Primitive>
+    friend std::vector<Primitive> sort_by_estimated_time(std::vector<Primitive>&& primitives);
+    void set_priority(ImplementationPriority priority);
+
+private:
+    std::shared_ptr<ConvolutionImplementation> impl_;
+    ImplementationPriority priority_{ 0 };
 };
 
 /*
 *   Call get_convolution_implementation_list function to get list of convolution supported on given device and with given paramteres.
 *   If size of vector is 0 (it's empty) then no convolution was supported for given case.
+*   List is sorted by the estimated execution time (see ImplementationInfo), so first implementation is expected to be the fastest one.
+*   Lists are cached per (device_info, desc), repeated queries are a lookup without allocations (first query allocates the list and its implementations). Returned reference is valid for the lifetime of the process.
+*   Function is thread safe.
 */
-std::vector<ConvolutionPrimitive> get_convolution_implementation_list(const DeviceInfo& device_info, const ConvolutionDescriptor& desc);
+const std::vector<ConvolutionPrimitive>& get_convolution_implementation_list(const DeviceInfo& device_info, const ConvolutionDescriptor& desc);
+
+} // namespace libdml
 
-} // namespace libdml
\ No newline at end of file
+namespace std
+{
+template<>
+struct hash<libdml::ConvolutionDescriptor>
+{
+    std::size_t operator()(const libdml::ConvolutionDescriptor& desc) const
+    {
+        using namespace libdml::hash_helpers;
+        std::size_t seed = 0;
+        hash_combine_value(seed, desc.tensor_input);
+        hash_combine_value(seed, desc.tensor_output);
+        hash_combine_value(seed, desc.tensor_weights);
+        hash_combine_value(seed, desc.tensor_bias);
+        hash_combine(seed, hash_dims(desc.strides));
+        hash_combine(seed, hash_dims(desc.dilations));
+        hash_combine(seed, hash_dims(desc.start_padding));
+        hash_combine(seed, hash_dims(desc.end_padding));
+        hash_combine_value(seed, desc.group_count);
+        hash_combine_value(seed, desc.datatype_accumulator);
+        hash_combine_value(seed, desc.direction);
+        hash_combine(seed, desc.post_ops.size());
+        for (const auto& post_op : desc.post_ops)
+        {
+            hash_combine_value(seed, post_op);
+        }
+        return seed;
+    }
+};
+}  // namespace std
\ No newline at end of file
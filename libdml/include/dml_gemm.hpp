@@ -0,0 +1,140 @@
+#pragma once
+#include "dml_types.hpp"
+
+#include <vector>
+#include <optional>
+#include <memory>
+
+namespace libdml
+{
+
+/*
+*   Multi-head attention gemms work directly on the stacked inputs (see TensorDimensionStacked), so no split or transpose is needed.
+*       eAB:       output[b, c, m, n] = alpha * a[b, c, m, k] x b[b, c, k, n]
+*       eQK_QKV:   tensor_a is stacked QKV [batch, seq, heads, 3, head_size], no tensor_b, output [batch, heads, seq, seq]
+*       eSV_S_QKV: tensor_a is S [batch, heads, seq, seq], tensor_b is stacked QKV, output [batch, heads, seq, head_size]
+*       eQK_Q_KV:  tensor_a is Q [batch, seq_q, heads, 1, head_size], tensor_b is stacked KV [batch, seq_kv, heads, 2, head_size], output [batch, heads, seq_q, seq_kv]
+*       eSV_S_KV:  tensor_a is S [batch, heads, seq_q, seq_kv], tensor_b is stacked KV, output [batch, heads, seq_q, head_size]
+*/
+enum class GemmType
+{
+    eAB = 0,
+    // qkv
+    eQK_QKV,
+    eSV_S_QKV,
+
+    // q + kv
+    eQK_Q_KV,
+    eSV_S_KV,
+};
+
+enum GemmExecParamsType
+{
+    GEMM_EXEC_PARAM_TYPE_UNDEFINED = 0,
+    GEMM_EXEC_PARAM_TYPE_INPUT_A,
+    GEMM_EXEC_PARAM_TYPE_INPUT_B,
+    GEMM_EXEC_PARAM_TYPE_OUTPUT,
+
+    GEMM_EXEC_PARAM_TYPE_COUNT
+};
+
+struct GemmDescriptor
+{
+    GemmType type = GemmType::eAB;
+
+    Tensor tensor_a;
+    std::optional<Tensor> tensor_b = std::nullopt;
+    Tensor tensor_output;
+
+    float alpha = 1.0f;
+    float beta = 0.0f;
+
+    // softmax over the last dimension of the output
+    bool fuse_softmax = false;
+    DataType datatype_accumulator = DataType::eFp16;
+};
+
+inline bool operator==(const GemmDescriptor& lhs, const GemmDescriptor& rhs)
+{
+    return lhs.type == rhs.type && lhs.tensor_a == rhs.tensor_a && lhs.tensor_b == rhs.tensor_b && lhs.tensor_output == rhs.tensor_output
+        && lhs.alpha == rhs.alpha && lhs.beta == rhs.beta && lhs.fuse_softmax == rhs.fuse_softmax && lhs.datatype_accumulator == rhs.datatype_accumulator;
+}
+
+inline bool operator!=(const GemmDescriptor& lhs, const GemmDescriptor& rhs)
+{
+    return !(lhs == rhs);
+}
+
+struct GemmExecutionParams
+{
+    ExecParamsTable<GEMM_EXEC_PARAM_TYPE_COUNT> params_map;
+};
+
+class GemmImplementation;
+class GemmPrimitive
+{
+public:
+    GemmPrimitive(GemmImplementation* impl);
+    // copies share the implementation, it is not modified after creation (priority is kept by the primitive)
+    GemmPrimitive(const GemmPrimitive& rhs) = default;
+    GemmPrimitive& operator=(const GemmPrimitive& rhs) = default;
+    GemmPrimitive(GemmPrimitive&& rhs) noexcept
+        : impl_(std::move(rhs.impl_))
+        , priority_(rhs.priority_)
+    {
+    }
+    GemmPrimitive& operator=(GemmPrimitive&& rhs) noexcept
+    {
+        if (this != &rhs)
+        {
+            impl_ = std::move(rhs.impl_);
+            priority_ = rhs.priority_;
+        }
+        return *this;
+    }
+
+    ~GemmPrimitive();
+
+    ImplementationInfo get_info() const;
+    KernelInfo get_kernel_info() const;
+    GemmExecutionParams get_execution_map(ErrorCode* error_code) const;
+
+private:
+    // priority is relative to the other implementations, so only the implementations list sets it
+    template<typename Primitive>
+    friend std::vector<Primitive> sort_by_estimated_time(std::vector<Primitive>&& primitives);
+    void set_priority(ImplementationPriority priority);
+
+private:
+    std::shared_ptr<GemmImplementation> impl_;
+    ImplementationPriority priority_{ 0 };
+};
+
+/*
+*   Same contract as get_convolution_implementation_list: empty list if nothing supports the descriptor,
+*   fastest implementation first, lists are cached and the function is thread safe.
+*/
+const std::vector<GemmPrimitive>& get_gemm_implementation_list(const DeviceInfo& device_info, const GemmDescriptor& desc);
+
+} // namespace libdml
+
+namespace std
+{
+template<>
+struct hash<libdml::GemmDescriptor>
+{
+    std::size_t operator()(const libdml::GemmDescriptor& desc) const
+    {
+        using namespace libdml::hash_helpers;
+        auto seed = std::hash<libdml::GemmType>{}(desc.type);
+        hash_combine_value(seed, desc.tensor_a);
+        hash_combine_value(seed, desc.tensor_b);
+        hash_combine_value(seed, desc.tensor_output);
+        hash_combine_value(seed, desc.alpha);
+        hash_combine_value(seed, desc.beta);
+        hash_combine_value(seed, desc.fuse_softmax);
+        hash_combine_value(seed, desc.datatype_accumulator);
+        return seed;
+    }
+};
+}  // namespace std
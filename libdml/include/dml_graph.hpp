@@ -0,0 +1,133 @@
+#pragma once
+#include "dml_types.hpp"
+#include "dml_convolution.hpp"
+#include "dml_gemm.hpp"
+#include "dml_softmax.hpp"
+#include "dml_mvn.hpp"
+
+#include <vector>
+#include <optional>
+#include <cstdint>
+
+namespace libdml
+{
+
+using TensorId = std::uint32_t;
+
+enum class GraphNodeType
+{
+    eUndefined = 0,
+    eConvolution,
+    eGemm,
+    eSoftmax,
+    eMvn,
+    // elementwise nodes, fused into the producer if possible
+    eActivation,
+    eEltwiseAdd,
+};
+
+enum class GraphTensorStorage
+{
+    eInput = 0,     // provided by the runtime
+    eOutput,        // provided by the runtime
+    eArena,         // intermediate, placed in the arena
+};
+
+// Offsets in the arena are aligned to this value (enough for D3D12 buffer views).
+inline constexpr std::uint64_t graph_arena_alignment = 256;
+
+struct GraphTensor
+{
+    Tensor tensor;
+    GraphTensorStorage storage = GraphTensorStorage::eArena;
+    // eArena only
+    std::uint64_t arena_offset = 0;
+    std::uint64_t size_in_bytes = 0;
+};
+
+/*
+*   Step of the compiled schedule. Primitive matching the type is set, elementwise steps which were not fused have none
+*   (runtime executes them with its generic path).
+*   Inputs are main input(s) first, then eltwise add tensors of the fused post ops (in post ops order).
+*/
+struct GraphStep
+{
+    GraphNodeType type = GraphNodeType::eUndefined;
+    std::vector<TensorId> inputs;
+    TensorId output = 0;
+
+    std::optional<ConvolutionPrimitive> convolution = std::nullopt;
+    std::optional<GemmPrimitive> gemm = std::nullopt;
+    std::optional<SoftmaxPrimitive> softmax = std::nullopt;
+    std::optional<MvnPrimitive> mvn = std::nullopt;
+    // eActivation steps only
+    std::optional<Activation> activation = std::nullopt;
+};
+
+struct CompiledGraph
+{
+    // indexed with TensorId, tensors removed by the fusions stay in the table (with zero size)
+    std::vector<GraphTensor> tensors;
+    std::vector<GraphStep> steps;
+    // Single allocation for all intermediates.
+    std::uint64_t arena_size_in_bytes = 0;
+};
+
+/*
+*   Builds graph of the primitives connected with tensors (TensorId). Weights, bias and other constant tensors of the descriptors
+*   are not edges of the graph, runtime binds them directly.
+*   Nodes have to be added in execution order (inputs of a node are already defined).
+*
+*   compile(...):
+*       - fuses elementwise nodes into the producer, if the producer has single consumer, is not a graph output and an implementation supports the fused descriptor:
+*           convolution + activation / eltwise add -> convolution post ops,
+*           gemm + softmax (over the last dimension) -> gemm fuse_softmax.
+*         Implementations fuse only convolution + relu for now (CM nchw fp16 convolutions), other nodes stay separate steps.
+*       - selects the fastest implementation for every primitive,
+*       - places intermediates in one arena: tensors with not overlapping lifetimes share memory (greedy, largest tensors first).
+*   On error (invalid edges, ex. tensor id not returned by this builder, not matching tensors, dims above max_tensor_rank or not supported primitive) error_code (if not nullptr) is set to eGeneralError
+*   and empty graph is returned.
+*/
+class GraphBuilder
+{
+public:
+    TensorId add_input(const Tensor& tensor);
+    void mark_output(TensorId tensor);
+
+    TensorId add_convolution(const ConvolutionDescriptor& desc, TensorId input);
+    // tensor_b is not used by the gemm types which have no second input
+    TensorId add_gemm(const GemmDescriptor& desc, TensorId tensor_a, std::optional<TensorId> tensor_b = std::nullopt);
+    TensorId add_softmax(const SoftmaxDescriptor& desc, TensorId input);
+    TensorId add_mvn(const MvnDescriptor& desc, TensorId input);
+    TensorId add_activation(const Activation& activation, TensorId input);
+    TensorId add_eltwise_add(TensorId input_a, TensorId input_b);
+
+    CompiledGraph compile(const DeviceInfo& device_info, ErrorCode* error_code) const;
+
+private:
+    struct Node
+    {
+        GraphNodeType type = GraphNodeType::eUndefined;
+        std::vector<TensorId> inputs;
+        TensorId output = 0;
+
+        ConvolutionDescriptor convolution_desc;
+        GemmDescriptor gemm_desc;
+        SoftmaxDescriptor softmax_desc;
+        MvnDescriptor mvn_desc;
+        Activation activation = { ActivationType::eUndefined };
+    };
+
+    TensorId add_tensor(const Tensor& tensor);
+    TensorId add_node(Node&& node, const Tensor& output);
+    bool is_valid_tensor(TensorId tensor) const;
+
+private:
+    std::vector<Tensor> tensors_;
+    std::vector<bool> is_output_;
+    std::vector<Node> nodes_;
+    // set by add_*(..) and mark_output(..) for unknown tensor ids, reported by compile(..)
+    bool has_invalid_tensor_ids_ = false;
+};
+
+} // namespace libdml
@@ -0,0 +1,54 @@
+#pragma once
+#include "dml_types.hpp"
+#include "dml_convolution.hpp"
+
+#include <vector>
+#include <optional>
+
+namespace libdml
+{
+
+// Copy of the activations into another layout, inserted by the planner between the ops.
+struct LayoutReorder
+{
+    DataLayout from = DataLayout::eUndefined;
+    DataLayout to = DataLayout::eUndefined;
+    double estimated_time_us = 0.0;
+};
+
+struct ConvolutionLayoutPlanStep
+{
+    // Descriptor with concrete activations layouts, primitive was selected for it.
+    ConvolutionDescriptor desc;
+    ConvolutionPrimitive primitive;
+    // To be passed to primitive.get_kernel_info(...). If weights_layout is set, weights have to be reordered (pre-packed) once, at load time.
+    ConvolutionPrefferedLayout layouts;
+    // Executed before the primitive, if set.
+    std::optional<LayoutReorder> input_reorder = std::nullopt;
+    // Primitive only, without the reorder.
+    double estimated_time_us = 0.0;
+};
+
+struct ConvolutionLayoutPlan
+{
+    std::vector<ConvolutionLayoutPlanStep> steps;
+    // Per execution: primitives and activations reorders.
+    double estimated_time_us = 0.0;
+    // One time cost of the weights pre-packing.
+    double weights_prepack_time_us = 0.0;
+};
+
+/*
+*   Selects activations layouts, implementations and reorders for a chain of convolutions (output of chain[i] is input of chain[i + 1]),
+*   so the estimated time of the whole chain is minimal.
+*       Activations with DataLayout::eAny can be in any activations layout (NCHW or NHWC), concrete layouts are kept as they are.
+*       Reorder is inserted between the ops when layouts of the output and the next input differ.
+*       Chain input and output with eAny are produced / consumed by the runtime in the planned layout, so they don't need reorders.
+*       Weights with eAny are pre-packed to the layout preffered by the implementation, it's not a part of the per execution time.
+*       Implementations without an estimate (estimated_time_us <= 0) are selected only if there is no estimated one, they add nothing to estimated_time_us.
+*   If chain is empty, tensors of the consecutive ops don't match or some op is not supported in any layout,
+*   then error_code (if not nullptr) is set to eGeneralError and empty plan is returned.
+*/
+ConvolutionLayoutPlan plan_convolution_layouts(const DeviceInfo& device_info, const std::vector<ConvolutionDescriptor>& chain, ErrorCode* error_code);
+
+} // namespace libdml
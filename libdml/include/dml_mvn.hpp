@@ -0,0 +1,116 @@
+#pragma once
+#include "dml_types.hpp"
+
+#include <vector>
+#include <optional>
+#include <memory>
+
+namespace libdml
+{
+
+enum MvnExecParamsType
+{
+    MVN_EXEC_PARAM_TYPE_UNDEFINED = 0,
+    MVN_EXEC_PARAM_TYPE_INPUT,
+    MVN_EXEC_PARAM_TYPE_OUTPUT,
+    MVN_EXEC_PARAM_TYPE_BIAS,
+    MVN_EXEC_PARAM_TYPE_SCALE,
+
+    MVN_EXEC_PARAM_TYPE_COUNT
+};
+
+/*
+*   Mean variance normalization of 4D tensor over the axes (TensorDimension4D), default is per batch and channel (instance normalization).
+*   Optional scale and bias are per channel: [1, C, 1, 1].
+*/
+struct MvnDescriptor
+{
+    Tensor tensor_input;
+    Tensor tensor_output;
+    std::optional<Tensor> tensor_scale = std::nullopt;
+    std::optional<Tensor> tensor_bias = std::nullopt;
+    TensorDims axes = { TENSOR_DIMENSION_4D_H, TENSOR_DIMENSION_4D_W };
+    float epsilon = 0.00005f;
+};
+
+inline bool operator==(const MvnDescriptor& lhs, const MvnDescriptor& rhs)
+{
+    return lhs.tensor_input == rhs.tensor_input && lhs.tensor_output == rhs.tensor_output && lhs.tensor_scale == rhs.tensor_scale
+        && lhs.tensor_bias == rhs.tensor_bias && lhs.axes == rhs.axes && lhs.epsilon == rhs.epsilon;
+}
+
+inline bool operator!=(const MvnDescriptor& lhs, const MvnDescriptor& rhs)
+{
+    return !(lhs == rhs);
+}
+
+struct MvnExecutionParams
+{
+    ExecParamsTable<MVN_EXEC_PARAM_TYPE_COUNT> params_map;
+};
+
+class MvnImplementation;
+class MvnPrimitive
+{
+public:
+    MvnPrimitive(MvnImplementation* impl);
+    // copies share the implementation, it is not modified after creation (priority is kept by the primitive)
+    MvnPrimitive(const MvnPrimitive& rhs) = default;
+    MvnPrimitive& operator=(const MvnPrimitive& rhs) = default;
+    MvnPrimitive(MvnPrimitive&& rhs) noexcept
+        : impl_(std::move(rhs.impl_))
+        , priority_(rhs.priority_)
+    {
+    }
+    MvnPrimitive& operator=(MvnPrimitive&& rhs) noexcept
+    {
+        if (this != &rhs)
+        {
+            impl_ = std::move(rhs.impl_);
+            priority_ = rhs.priority_;
+        }
+        return *this;
+    }
+
+    ~MvnPrimitive();
+
+    ImplementationInfo get_info() const;
+    KernelInfo get_kernel_info() const;
+    MvnExecutionParams get_execution_map(ErrorCode* error_code) const;
+
+private:
+    // priority is relative to the other implementations, so only the implementations list sets it
+    template<typename Primitive>
+    friend std::vector<Primitive> sort_by_estimated_time(std::vector<Primitive>&& primitives);
+    void set_priority(ImplementationPriority priority);
+
+private:
+    std::shared_ptr<MvnImplementation> impl_;
+    ImplementationPriority priority_{ 0 };
+};
+
+/*
+*   Same contract as get_softmax_implementation_list (list contains the generic fallback).
+*/
+const std::vector<MvnPrimitive>& get_mvn_implementation_list(const DeviceInfo& device_info, const MvnDescriptor& desc);
+
+} // namespace libdml
+
+namespace std
+{
+template<>
+struct hash<libdml::MvnDescriptor>
+{
+    std::size_t operator()(const libdml::MvnDescriptor& desc) const
+    {
+        using namespace libdml::hash_helpers;
+        auto seed = std::hash<libdml::Tensor>{}(desc.tensor_input);
+        hash_combine_value(seed, desc.tensor_output);
+        hash_combine_value(seed, desc.tensor_scale);
+        hash_combine_value(seed, desc.tensor_bias);
+        hash_combine(seed, hash_dims(desc.axes));
+        hash_combine_value(seed, desc.epsilon);
+        return seed;
+    }
+};
+}  // namespace std
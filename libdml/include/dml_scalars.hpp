@@ -0,0 +1,88 @@
+#pragma once
+#include "dml_types.hpp"
+
+#include <string_view>
+#include <cstdint>
+#include <cstddef>
+
+namespace libdml
+{
+
+enum class ScalarType
+{
+    eUndefined = 0,
+    eUint32,
+    eInt32,
+    eFp32,
+    eFp16,
+
+    //..
+    //..
+    eCount
+};
+
+/*
+*   Field of the scalars buffer (root constants). Name matches the kernel argument.
+*/
+struct ScalarField
+{
+    const char* name = nullptr;
+    ScalarType type = ScalarType::eUndefined;
+    std::uint32_t offset = 0;
+};
+
+inline constexpr std::size_t max_scalar_fields = max_scalars_buffer_size / sizeof(std::uint16_t);
+
+/*
+*   Layout of ScalarsBuffer, fields are placed in the order they were added:
+*       - every field is aligned to its size (fp16 to 2 bytes, 32 bit types to 4 bytes),
+*       - buffer size is rounded up to DWORD, as root constants are set in DWORDs.
+*   Schema is built once per implementation and doesn't allocate, names have to be string literals (they are not copied).
+*/
+class ScalarsSchema
+{
+public:
+    // Sets field_idx (if not nullptr) to the index of the field, used by ScalarsPacker.
+    // Returns false and doesn't add the field if the type is unknown or the field doesn't fit into max_scalars_buffer_size.
+    bool add_field(const char* name, ScalarType type, std::uint32_t* field_idx = nullptr);
+
+    // nullptr if there is no such field
+    const ScalarField* find(std::string_view name) const;
+
+    const InlineVector<ScalarField, max_scalar_fields>& get_fields() const { return fields_; }
+    std::uint32_t get_size() const;
+    std::uint32_t get_dwords_count() const { return get_size() / sizeof(std::uint32_t); }
+    bool empty() const { return fields_.empty(); }
+
+private:
+    InlineVector<ScalarField, max_scalar_fields> fields_;
+    std::uint32_t end_offset_ = 0;
+};
+
+/*
+*   Writes values into buffer according to the schema (little endian, fp16 converted with round to nearest even).
+*   Buffer is resized to schema size and zeroed (padding is always zero).
+*   Setters return false and don't write if field_idx is not in the schema or the value doesn't match type of the field.
+*/
+class ScalarsPacker
+{
+public:
+    ScalarsPacker(const ScalarsSchema& schema, ScalarsBuffer& buffer);
+
+    bool set_uint32(std::uint32_t field_idx, std::uint32_t value);
+    bool set_int32(std::uint32_t field_idx, std::int32_t value);
+    // eFp32 and eFp16 fields
+    bool set_float(std::uint32_t field_idx, float value);
+
+private:
+    // false if the value doesn't fit into the buffer
+    bool write(std::uint32_t offset, std::uint32_t value, std::uint32_t bytes_width);
+    // nullptr if field_idx is not in the schema
+    const ScalarField* get_field(std::uint32_t field_idx) const;
+
+private:
+    const ScalarsSchema& schema_;
+    ScalarsBuffer& buffer_;
+};
+
+} // namespace libdml
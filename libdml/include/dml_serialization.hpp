@@ -0,0 +1,63 @@
+#pragma once
+#include "dml_types.hpp"
+#include "dml_convolution.hpp"
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+namespace libdml
+{
+
+/*
+*   Binary format of the selection caches. Fields are written in declaration order, integers little endian with fixed width,
+*   enums as single bytes, floats as their bits, strings and vectors prefixed with u32 count and optionals with u8 flag.
+*   Blob starts with header: magic "LDML", format version and payload size. Blobs with other version are rejected,
+*   caches have to be regenerated when the version changes.
+*   Version 2: selections store execution params.
+*/
+inline constexpr std::uint32_t serialization_format_version = 2;
+
+// Result of the convolution implementation selection, kernel_info was generated with the layouts.
+// Execution params are stored too, so warm start binds resources without querying the implementation.
+struct ConvolutionSelection
+{
+    ConvolutionDescriptor desc;
+    ImplementationInfo info;
+    ConvolutionPrefferedLayout layouts;
+    KernelInfo kernel_info;
+    ConvolutionExecutionParams execution_params;
+};
+
+// Selections of the whole model, valid only for the device_info they were made for.
+struct SelectionCache
+{
+    DeviceInfo device_info;
+    std::vector<ConvolutionSelection> convolutions;
+};
+
+std::vector<std::byte> serialize_selection_cache(const SelectionCache& cache);
+
+/*
+*   Data can be mmapped file, it's not referenced after the call.
+*   If data is truncated, has wrong header or invalid values, then error_code (if not nullptr) is set to eGeneralError and empty cache is returned.
+*/
+SelectionCache deserialize_selection_cache(const std::byte* data, std::size_t size, ErrorCode* error_code);
+
+/*
+*   Building blocks for custom containers, without header. Serialize appends to out.
+*   Deserialize reads at offset and advances it, returns false if data is truncated or has invalid values.
+*/
+void serialize(const ConvolutionDescriptor& value, std::vector<std::byte>& out);
+void serialize(const DeviceInfo& value, std::vector<std::byte>& out);
+void serialize(const ImplementationInfo& value, std::vector<std::byte>& out);
+void serialize(const KernelInfo& value, std::vector<std::byte>& out);
+void serialize(const ConvolutionExecutionParams& value, std::vector<std::byte>& out);
+
+bool deserialize(const std::byte* data, std::size_t size, std::size_t& offset, ConvolutionDescriptor& value);
+bool deserialize(const std::byte* data, std::size_t size, std::size_t& offset, DeviceInfo& value);
+bool deserialize(const std::byte* data, std::size_t size, std::size_t& offset, ImplementationInfo& value);
+bool deserialize(const std::byte* data, std::size_t size, std::size_t& offset, KernelInfo& value);
+bool deserialize(const std::byte* data, std::size_t size, std::size_t& offset, ConvolutionExecutionParams& value);
+
+} // namespace libdml
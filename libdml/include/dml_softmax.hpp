@@ -0,0 +1,106 @@
+#pragma once
+#include "dml_types.hpp"
+
+#include <vector>
+#include <memory>
+
+namespace libdml
+{
+
+enum SoftmaxExecParamsType
+{
+    SOFTMAX_EXEC_PARAM_TYPE_UNDEFINED = 0,
+    SOFTMAX_EXEC_PARAM_TYPE_INPUT,
+    SOFTMAX_EXEC_PARAM_TYPE_OUTPUT,
+
+    SOFTMAX_EXEC_PARAM_TYPE_COUNT
+};
+
+/*
+*   Softmax of 4D tensor calculated along the axis (TensorDimension4D).
+*/
+struct SoftmaxDescriptor
+{
+    Tensor tensor_input;
+    Tensor tensor_output;
+    std::uint32_t axis = TENSOR_DIMENSION_4D_W;
+};
+
+inline bool operator==(const SoftmaxDescriptor& lhs, const SoftmaxDescriptor& rhs)
+{
+    return lhs.tensor_input == rhs.tensor_input && lhs.tensor_output == rhs.tensor_output && lhs.axis == rhs.axis;
+}
+
+inline bool operator!=(const SoftmaxDescriptor& lhs, const SoftmaxDescriptor& rhs)
+{
+    return !(lhs == rhs);
+}
+
+struct SoftmaxExecutionParams
+{
+    ExecParamsTable<SOFTMAX_EXEC_PARAM_TYPE_COUNT> params_map;
+};
+
+class SoftmaxImplementation;
+class SoftmaxPrimitive
+{
+public:
+    SoftmaxPrimitive(SoftmaxImplementation* impl);
+    // copies share the implementation, it is not modified after creation (priority is kept by the primitive)
+    SoftmaxPrimitive(const SoftmaxPrimitive& rhs) = default;
+    SoftmaxPrimitive& operator=(const SoftmaxPrimitive& rhs) = default;
+    SoftmaxPrimitive(SoftmaxPrimitive&& rhs) noexcept
+        : impl_(std::move(rhs.impl_))
+        , priority_(rhs.priority_)
+    {
+    }
+    SoftmaxPrimitive& operator=(SoftmaxPrimitive&& rhs) noexcept
+    {
+        if (this != &rhs)
+        {
+            impl_ = std::move(rhs.impl_);
+            priority_ = rhs.priority_;
+        }
+        return *this;
+    }
+
+    ~SoftmaxPrimitive();
+
+    ImplementationInfo get_info() const;
+    KernelInfo get_kernel_info() const;
+    SoftmaxExecutionParams get_execution_map(ErrorCode* error_code) const;
+
+private:
+    // priority is relative to the other implementations, so only the implementations list sets it
+    template<typename Primitive>
+    friend std::vector<Primitive> sort_by_estimated_time(std::vector<Primitive>&& primitives);
+    void set_priority(ImplementationPriority priority);
+
+private:
+    std::shared_ptr<SoftmaxImplementation> impl_;
+    ImplementationPriority priority_{ 0 };
+};
+
+/*
+*   Same contract as get_convolution_implementation_list. For valid descriptors list contains the generic fallback,
+*   so runtime can compare the kernels with its own generic path.
+*/
+const std::vector<SoftmaxPrimitive>& get_softmax_implementation_list(const DeviceInfo& device_info, const SoftmaxDescriptor& desc);
+
+} // namespace libdml
+
+namespace std
+{
+template<>
+struct hash<libdml::SoftmaxDescriptor>
+{
+    std::size_t operator()(const libdml::SoftmaxDescriptor& desc) const
+    {
+        using namespace libdml::hash_helpers;
+        auto seed = std::hash<libdml::Tensor>{}(desc.tensor_input);
+        hash_combine_value(seed, desc.tensor_output);
+        hash_combine_value(seed, desc.axis);
+        return seed;
+    }
+};
+}  // namespace std
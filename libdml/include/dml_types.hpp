@@ -3,6 +3,12 @@
 #include <cstdint>
 #include <string>
 #include <array>
+#include <functional>
+#include <cstddef>
+#include <optional>
+#include <initializer_list>
+#include <algorithm>
+#include <cassert>
 
 namespace libdml
 {
@@ -43,6 +49,7 @@ enum class KernelGrfCount
     e128,
     e256,
     // ... add more for variable grf support
+    eCount
 };
 
 enum class ExecutionParamType
@@ -59,6 +66,15 @@ enum class DataLayout
     eNCHW,
     eNHWC,
 
+    // weights layouts
+    eOIYX,
+    eIO_i8_o8_i2,
+    eOYXI_o8,
+    eOYXI_o16,
+
+    // attention layouts, dims are in TensorDimensionStacked order
+    eStackedHeads,
+
     //..
     //..
     eCount
@@ -104,17 +120,129 @@ enum TensorDimension2D
     TENSOR_DIMENSION_2D_W = 1
 };
 
+// not a en enum class, so name it differently
+// Attention tensors with stacked inputs (ex. Q, K and V packed together in one buffer).
+enum TensorDimensionStacked
+{
+    TENSOR_DIMENSION_STACKED_BATCH = 0,
+    TENSOR_DIMENSION_STACKED_SEQ_LEN = 1,
+    TENSOR_DIMENSION_STACKED_NUM_HEADS = 2,
+    TENSOR_DIMENSION_STACKED_TENSORS = 3,
+    TENSOR_DIMENSION_STACKED_HEAD_SIZE = 4
+};
+
 enum class ActivationType
 {
     eUndefined = 0,
     eRelu = 1,
+    eGelu,      // erf based
+    eSilu,      // x * sigmoid(x)
+    eClamp,     // min(max(x, alpha), beta)
 
     //..
     //..
     eCount
 };
 
-using TensorDims = std::vector<std::int32_t>;
+/*
+*   Vector with fixed capacity, inline storage. Used by the types of the query path (dims, execution params), so queries don't allocate.
+*   Values are never dropped silently: adding above capacity doesn't change the content and sets has_overflow(),
+*   descriptors with overflowed vectors are rejected by validation (no implementation supports them).
+*/
+template<typename T, std::size_t Capacity>
+class InlineVector
+{
+public:
+    using value_type = T;
+    using iterator = T*;
+    using const_iterator = const T*;
+
+public:
+    InlineVector() = default;
+    // initializer list above capacity gives empty vector with has_overflow() set
+    InlineVector(std::initializer_list<T> values)
+    {
+        if (values.size() > Capacity)
+        {
+            overflow_ = true;
+            return;
+        }
+        for (const auto& v : values)
+        {
+            data_[size_++] = v;
+        }
+    }
+
+    static constexpr std::size_t capacity() { return Capacity; }
+    std::size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+    // true if any value didn't fit, until clear()
+    bool has_overflow() const { return overflow_; }
+
+    // returns false (and doesn't add the value) if vector is full
+    bool push_back(const T& value)
+    {
+        if (size_ == Capacity)
+        {
+            overflow_ = true;
+            return false;
+        }
+        data_[size_++] = value;
+        return true;
+    }
+
+    void clear()
+    {
+        size_ = 0;
+        overflow_ = false;
+    }
+
+    // new elements are set to value, returns false (and doesn't resize) if count is above capacity
+    bool resize(std::size_t count, const T& value = T{})
+    {
+        if (count > Capacity)
+        {
+            overflow_ = true;
+            return false;
+        }
+        for (auto i = size_; i < count; i++)
+        {
+            data_[i] = value;
+        }
+        size_ = count;
+        return true;
+    }
+
+    T& operator[](std::size_t idx) { assert(idx < size_); return data_[idx]; }
+    const T& operator[](std::size_t idx) const { assert(idx < size_); return data_[idx]; }
+
+    T* data() { return data_.data(); }
+    const T* data() const { return data_.data(); }
+    iterator begin() { return data_.data(); }
+    iterator end() { return data_.data() + size_; }
+    const_iterator begin() const { return data_.data(); }
+    const_iterator end() const { return data_.data() + size_; }
+
+private:
+    std::array<T, Capacity> data_{};
+    std::size_t size_ = 0;
+    bool overflow_ = false;
+};
+
+template<typename T, std::size_t Capacity>
+inline bool operator==(const InlineVector<T, Capacity>& lhs, const InlineVector<T, Capacity>& rhs)
+{
+    return lhs.size() == rhs.size() && lhs.has_overflow() == rhs.has_overflow() && std::equal(lhs.begin(), lhs.end(), rhs.begin());
+}
+
+template<typename T, std::size_t Capacity>
+inline bool operator!=(const InlineVector<T, Capacity>& lhs, const InlineVector<T, Capacity>& rhs)
+{
+    return !(lhs == rhs);
+}
+
+inline constexpr std::size_t max_tensor_rank = 8;
+using TensorDims = InlineVector<std::int32_t, max_tensor_rank>;
 
 struct Tensor
 {
@@ -126,7 +254,56 @@ struct Tensor
 struct Activation
 {
     ActivationType type;
-    //ToDo: support more activation and add params here as union {};
+    // used only by activations which have params (see ActivationType)
+    float alpha = 0.0f;
+    float beta = 0.0f;
+};
+
+enum class PostOpType
+{
+    eUndefined = 0,
+    eActivation,
+    eEltwiseAdd,    // result + tensor, tensor has the output dims (ex. residual connection)
+    eScaleShift,    // result * scale[c] + shift[c]
+    eDownconvert,   // result converted to data_type, has to be the last post op
+
+    //..
+    //..
+    eCount
+};
+
+/*
+*   Post ops are evaluated in order on the result of the primitive (in accumulator precision), after bias.
+*   Tensors of the post ops are separate resources, bound in the order of post ops (tensor and then tensor_shift).
+*/
+struct PostOp
+{
+    PostOpType type = PostOpType::eUndefined;
+
+    // eActivation
+    Activation activation = { ActivationType::eUndefined };
+
+    // eEltwiseAdd: tensor with the output dims; eScaleShift: scale and optional shift, dims { 1, C, 1, 1 } (same as bias)
+    std::optional<Tensor> tensor = std::nullopt;
+    std::optional<Tensor> tensor_shift = std::nullopt;
+
+    // eDownconvert
+    DataType data_type = DataType::eUndefined;
+};
+
+// Post ops chains are limited, so chains and their tensors (up to two per post op) fit inline into descriptors and execution params.
+inline constexpr std::size_t max_post_ops_count = 8;
+using PostOps = InlineVector<PostOp, max_post_ops_count>;
+
+/*
+*   Post ops chains which implementation can fuse: at most max_count post ops,
+*   with type of every post op (and activation type of eActivation post ops) set in the masks (bit per enum value).
+*/
+struct PostOpsSupport
+{
+    std::uint32_t post_op_types_mask = 0;
+    std::uint32_t activation_types_mask = 0;
+    std::uint32_t max_count = 0;
 };
 
 struct DeviceInfo
@@ -135,6 +312,75 @@ struct DeviceInfo
     std::uint32_t eu_count;
 };
 
+/*
+*   Field wise equality and hashing, usable as keys of the caches (hash does not depend on padding bytes or addresses).
+*/
+namespace hash_helpers
+{
+inline void hash_combine(std::size_t& seed, std::size_t value)
+{
+    seed ^= value + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+}
+
+template<typename T>
+inline void hash_combine_value(std::size_t& seed, const T& value)
+{
+    hash_combine(seed, std::hash<T>{}(value));
+}
+
+inline std::size_t hash_dims(const TensorDims& dims)
+{
+    std::size_t seed = dims.size();
+    for (const auto d : dims)
+    {
+        hash_combine_value(seed, d);
+    }
+    return seed;
+}
+}  // namespace hash_helpers
+
+inline bool operator==(const Tensor& lhs, const Tensor& rhs)
+{
+    return lhs.dims == rhs.dims && lhs.data_layout == rhs.data_layout && lhs.data_type == rhs.data_type;
+}
+
+inline bool operator!=(const Tensor& lhs, const Tensor& rhs)
+{
+    return !(lhs == rhs);
+}
+
+inline bool operator==(const Activation& lhs, const Activation& rhs)
+{
+    return lhs.type == rhs.type && lhs.alpha == rhs.alpha && lhs.beta == rhs.beta;
+}
+
+inline bool operator!=(const Activation& lhs, const Activation& rhs)
+{
+    return !(lhs == rhs);
+}
+
+inline bool operator==(const PostOp& lhs, const PostOp& rhs)
+{
+    return lhs.type == rhs.type && lhs.activation == rhs.activation && lhs.tensor == rhs.tensor
+        && lhs.tensor_shift == rhs.tensor_shift && lhs.data_type == rhs.data_type;
+}
+
+inline bool operator!=(const PostOp& lhs, const PostOp& rhs)
+{
+    return !(lhs == rhs);
+}
+
+inline bool operator==(const DeviceInfo& lhs, const DeviceInfo& rhs)
+{
+    return lhs.platform == rhs.platform && lhs.eu_count == rhs.eu_count;
+}
+
+inline bool operator!=(const DeviceInfo& lhs, const DeviceInfo& rhs)
+{
+    return !(lhs == rhs);
+}
+
+// Higher value means implementation is expected to be faster. Implementations lists are sorted by priority.
 struct ImplementationPriority
 {
     std::uint32_t value;
@@ -144,23 +390,101 @@ struct ImplementationInfo
 {
     ImplementationPriority priority;
     std::string name;
+
+    // Analytic estimate (based on device peaks, occupancy and reorders), meant for ranking, not as exact execution time. 0 if unknown.
+    double estimated_time_us = 0.0;
 };
 
+// Index of the resource in the kernel bindings.
+struct ExecParamInfo
+{
+    std::uint32_t index;
+};
+
+// Flat table indexed by the primitive exec params type, empty entry means the param is not used by the implementation.
+template<std::size_t Count>
+using ExecParamsTable = std::array<std::optional<ExecParamInfo>, Count>;
+
+// D3D12 root signature limit is 64 DWORDs, so root constants never need more.
+inline constexpr std::size_t max_scalars_buffer_size = 256;
+using ScalarsBuffer = InlineVector<std::byte, max_scalars_buffer_size>;
+
+using PostOpsExecParams = InlineVector<ExecParamInfo, 2 * max_post_ops_count>;
+
 struct Jit
 {
     std::string opt;
     std::string value;
 };
 
+/*
+*   For CM kernels code is the name of the kernel file. Jits have to be passed as defines to the kernel compiler.
+*   gws is in HW threads, thread groups count to dispatch is gws / lws (per dimension).
+*   Language eUndefined means there is no kernel (generic fallback), runtime should use its own generic path.
+*   Code and jits are strings for the kernel compiler, so get_kernel_info() allocates. It's called once per compiled kernel, not per query.
+*/
 struct KernelInfo
 {
     KernelLanguage language;
     std::string code;
     std::vector<Jit> jits;
 
+    std::array<std::uint32_t, 3> gws;
     std::array<std::uint32_t, 3> lws;
     KernelGrfCount grf_count;
 
 };
 
-}  // namespace libdml
\ No newline at end of file
+}  // namespace libdml
+
+namespace std
+{
+template<>
+struct hash<libdml::Tensor>
+{
+    std::size_t operator()(const libdml::Tensor& tensor) const
+    {
+        auto seed = libdml::hash_helpers::hash_dims(tensor.dims);
+        libdml::hash_helpers::hash_combine_value(seed, tensor.data_layout);
+        libdml::hash_helpers::hash_combine_value(seed, tensor.data_type);
+        return seed;
+    }
+};
+
+template<>
+struct hash<libdml::Activation>
+{
+    std::size_t operator()(const libdml::Activation& activation) const
+    {
+        auto seed = std::hash<libdml::ActivationType>{}(activation.type);
+        libdml::hash_helpers::hash_combine_value(seed, activation.alpha);
+        libdml::hash_helpers::hash_combine_value(seed, activation.beta);
+        return seed;
+    }
+};
+
+template<>
+struct hash<libdml::PostOp>
+{
+    std::size_t operator()(const libdml::PostOp& post_op) const
+    {
+        auto seed = std::hash<libdml::PostOpType>{}(post_op.type);
+        libdml::hash_helpers::hash_combine_value(seed, post_op.activation);
+        libdml::hash_helpers::hash_combine_value(seed, post_op.tensor);
+        libdml::hash_helpers::hash_combine_value(seed, post_op.tensor_shift);
+        libdml::hash_helpers::hash_combine_value(seed, post_op.data_type);
+        return seed;
+    }
+};
+
+template<>
+struct hash<libdml::DeviceInfo>
+{
+    std::size_t operator()(const libdml::DeviceInfo& device_info) const
+    {
+        auto seed = std::hash<libdml::HwPlatform>{}(device_info.platform);
+        libdml::hash_helpers::hash_combine_value(seed, device_info.eu_count);
+        return seed;
+    }
+};
+}  // namespace std
\ No newline at end of file
@@ -1,17 +1,15 @@
 #include "../include/dml_convolution.hpp"
 #include "impl/convolution/convolution_impl.h"
+#include "impl/implementation_list.h"
 
 #include <vector>
 #include <cassert>
-
-void libdml::ConvolutionPrimitive::ImplDeleter::operator()(ConvolutionImplementation* impl) const
-{
-    delete impl;
-}
-
+#include <algorithm>
+#include <utility>
+#include <memory>
 
 libdml::ConvolutionPrimitive::ConvolutionPrimitive(ConvolutionImplementation* impl)
-    : impl_(std::move(std::unique_ptr<ConvolutionImplementation, ConvolutionPrimitive::ImplDeleter>(impl)))
+    : impl_(impl)
 {
 
 }
@@ -30,23 +28,77 @@ libdml::ConvolutionExecutionParams libdml::ConvolutionPrimitive::get_execution_m
         return {};
     }
 
-    return impl_->get_execution_map();
+    return impl_->get_execution_map(error_code);
 }
 
-std::vector<libdml::ConvolutionPrimitive> libdml::get_convolution_implementation_list(const DeviceInfo& device_info, const ConvolutionDescriptor& desc)
+libdml::ImplementationInfo libdml::ConvolutionPrimitive::get_info() const
 {
-    std::vector<libdml::ConvolutionPrimitive> ret{};
+    if (!impl_)
+    {
+        return {};
+    }
+    auto ret = impl_->get_info();
+    ret.priority = priority_;
+    return ret;
+}
 
-    if (ConvolutionExampleImplementation_0::is_supported_descriptor(device_info, desc))
+libdml::ConvolutionPrefferedLayout libdml::ConvolutionPrimitive::query_preffered_layouts() const
+{
+    if (!impl_)
     {
-        ret.push_back(new ConvolutionExampleImplementation_0(device_info, desc));
+        return {};
     }
+    return impl_->query_preffered_layouts();
+}
 
-    if (ConvolutionExampleImplementation_1::is_supported_descriptor(device_info, desc))
+libdml::PostOpsSupport libdml::ConvolutionPrimitive::get_post_ops_support() const
+{
+    if (!impl_)
     {
-        ret.push_back(new ConvolutionExampleImplementation_1(device_info, desc));
+        return {};
     }
+    return impl_->get_post_ops_support();
+}
 
-    return ret;
+libdml::ScalarsSchema libdml::ConvolutionPrimitive::get_scalars_schema() const
+{
+    if (!impl_)
+    {
+        return {};
+    }
+    return impl_->get_scalars_schema();
+}
+
+libdml::KernelInfo libdml::ConvolutionPrimitive::get_kernel_info(const ConvolutionPrefferedLayout& layouts) const
+{
+    if (!impl_)
+    {
+        return {};
+    }
+    return impl_->get_kernel_info(layouts);
+}
+
+void libdml::ConvolutionPrimitive::set_priority(ImplementationPriority priority)
+{
+    priority_ = priority;
 }
 
+namespace
+{
+std::vector<libdml::ConvolutionPrimitive> create_convolution_implementation_list(const libdml::DeviceInfo& device_info, const libdml::ConvolutionDescriptor& desc)
+{
+    using namespace libdml;
+
+    if (!conv_helpers::is_valid_descriptor(desc))
+    {
+        return {};
+    }
+    return sort_by_estimated_time(ConvolutionImplementationRegistry::create_list(device_info, desc));
+}
+}  // namespace
+
+const std::vector<libdml::ConvolutionPrimitive>& libdml::get_convolution_implementation_list(const DeviceInfo& device_info, const ConvolutionDescriptor& desc)
+{
+    static ImplementationListCache<ConvolutionDescriptor, ConvolutionPrimitive> cache(create_convolution_implementation_list);
+    return cache.get(device_info, desc);
+}
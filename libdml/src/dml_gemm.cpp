@@ -0,0 +1,74 @@
+#include "../include/dml_gemm.hpp"
+#include "impl/gemm/gemm_impl.h"
+#include "impl/implementation_list.h"
+
+#include <vector>
+#include <memory>
+
+libdml::GemmPrimitive::GemmPrimitive(GemmImplementation* impl)
+    : impl_(impl)
+{
+
+}
+
+libdml::GemmPrimitive::~GemmPrimitive() = default;
+
+
+libdml::GemmExecutionParams libdml::GemmPrimitive::get_execution_map(ErrorCode* error_code) const
+{
+    if (!impl_)
+    {
+        if (error_code)
+        {
+            *error_code = ErrorCode::eGeneralError;
+        }
+        return {};
+    }
+
+    return impl_->get_execution_map();
+}
+
+libdml::ImplementationInfo libdml::GemmPrimitive::get_info() const
+{
+    if (!impl_)
+    {
+        return {};
+    }
+    auto ret = impl_->get_info();
+    ret.priority = priority_;
+    return ret;
+}
+
+libdml::KernelInfo libdml::GemmPrimitive::get_kernel_info() const
+{
+    if (!impl_)
+    {
+        return {};
+    }
+    return impl_->get_kernel_info();
+}
+
+void libdml::GemmPrimitive::set_priority(ImplementationPriority priority)
+{
+    priority_ = priority;
+}
+
+namespace
+{
+std::vector<libdml::GemmPrimitive> create_gemm_implementation_list(const libdml::DeviceInfo& device_info, const libdml::GemmDescriptor& desc)
+{
+    using namespace libdml;
+
+    if (!gemm_helpers::is_valid_descriptor(desc))
+    {
+        return {};
+    }
+    return sort_by_estimated_time(GemmImplementationRegistry::create_list(device_info, desc));
+}
+}  // namespace
+
+const std::vector<libdml::GemmPrimitive>& libdml::get_gemm_implementation_list(const DeviceInfo& device_info, const GemmDescriptor& desc)
+{
+    static ImplementationListCache<GemmDescriptor, GemmPrimitive> cache(create_gemm_implementation_list);
+    return cache.get(device_info, desc);
+}
@@ -0,0 +1,432 @@
+#include "../include/dml_graph.hpp"
+#include "impl/impl_helpers.h"
+
+#include <vector>
+#include <algorithm>
+#include <limits>
+#include <cstddef>
+
+namespace
+{
+constexpr std::uint32_t no_node = std::numeric_limits<std::uint32_t>::max();
+
+// Layouts match if they are equal or one of them is eAny.
+bool is_matching_tensor(const libdml::Tensor& edge, const libdml::Tensor& expected)
+{
+    const auto layouts_match = edge.data_layout == expected.data_layout
+        || edge.data_layout == libdml::DataLayout::eAny || expected.data_layout == libdml::DataLayout::eAny;
+    return edge.dims == expected.dims && edge.data_type == expected.data_type && layouts_match;
+}
+
+std::uint64_t align_up(std::uint64_t value, std::uint64_t alignment)
+{
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+struct Lifetime
+{
+    std::size_t first_step = 0;
+    std::size_t last_step = 0;
+
+    bool overlaps(const Lifetime& rhs) const
+    {
+        return first_step <= rhs.last_step && rhs.first_step <= last_step;
+    }
+};
+
+/*
+*   Greedy offsets assignment: largest tensors first, each placed at the lowest offset which
+*   does not overlap (in memory) any already placed tensor with overlapping lifetime.
+*/
+std::uint64_t assign_arena_offsets(std::vector<libdml::GraphTensor>& tensors, const std::vector<std::optional<Lifetime>>& lifetimes)
+{
+    std::vector<std::size_t> order{};
+    for (std::size_t i = 0; i < tensors.size(); i++)
+    {
+        if (lifetimes[i].has_value() && tensors[i].storage == libdml::GraphTensorStorage::eArena)
+        {
+            order.push_back(i);
+        }
+    }
+    std::stable_sort(order.begin(), order.end(), [&tensors](std::size_t lhs, std::size_t rhs) { return tensors[lhs].size_in_bytes > tensors[rhs].size_in_bytes; });
+
+    std::uint64_t arena_size = 0;
+    std::vector<std::size_t> placed{};
+    for (const auto id : order)
+    {
+        auto& tensor = tensors[id];
+        std::vector<std::size_t> conflicts{};
+        for (const auto other : placed)
+        {
+            if (lifetimes[id]->overlaps(*lifetimes[other]))
+            {
+                conflicts.push_back(other);
+            }
+        }
+        std::sort(conflicts.begin(), conflicts.end(), [&tensors](std::size_t lhs, std::size_t rhs) { return tensors[lhs].arena_offset < tensors[rhs].arena_offset; });
+
+        std::uint64_t offset = 0;
+        for (const auto other : conflicts)
+        {
+            const auto& other_tensor = tensors[other];
+            if (offset + tensor.size_in_bytes <= other_tensor.arena_offset)
+            {
+                break;
+            }
+            offset = std::max(offset, align_up(other_tensor.arena_offset + other_tensor.size_in_bytes, libdml::graph_arena_alignment));
+        }
+        tensor.arena_offset = offset;
+        arena_size = std::max(arena_size, offset + tensor.size_in_bytes);
+        placed.push_back(id);
+    }
+    return arena_size;
+}
+}  // namespace
+
+libdml::TensorId libdml::GraphBuilder::add_tensor(const Tensor& tensor)
+{
+    tensors_.push_back(tensor);
+    is_output_.push_back(false);
+    return static_cast<TensorId>(tensors_.size() - 1);
+}
+
+libdml::TensorId libdml::GraphBuilder::add_node(Node&& node, const Tensor& output)
+{
+    for (const auto input : node.inputs)
+    {
+        // input of the node has to be added to the graph first
+        if (!is_valid_tensor(input))
+        {
+            has_invalid_tensor_ids_ = true;
+        }
+    }
+    node.output = add_tensor(output);
+    nodes_.push_back(std::move(node));
+    return nodes_.back().output;
+}
+
+bool libdml::GraphBuilder::is_valid_tensor(TensorId tensor) const
+{
+    return tensor < tensors_.size();
+}
+
+libdml::TensorId libdml::GraphBuilder::add_input(const Tensor& tensor)
+{
+    return add_tensor(tensor);
+}
+
+void libdml::GraphBuilder::mark_output(TensorId tensor)
+{
+    if (!is_valid_tensor(tensor))
+    {
+        has_invalid_tensor_ids_ = true;
+        return;
+    }
+    is_output_[tensor] = true;
+}
+
+libdml::TensorId libdml::GraphBuilder::add_convolution(const ConvolutionDescriptor& desc, TensorId input)
+{
+    Node node{};
+    node.type = GraphNodeType::eConvolution;
+    node.inputs = { input };
+    node.convolution_desc = desc;
+    return add_node(std::move(node), desc.tensor_output);
+}
+
+libdml::TensorId libdml::GraphBuilder::add_gemm(const GemmDescriptor& desc, TensorId tensor_a, std::optional<TensorId> tensor_b)
+{
+    Node node{};
+    node.type = GraphNodeType::eGemm;
+    node.inputs = { tensor_a };
+    if (tensor_b.has_value())
+    {
+        node.inputs.push_back(*tensor_b);
+    }
+    node.gemm_desc = desc;
+    return add_node(std::move(node), desc.tensor_output);
+}
+
+libdml::TensorId libdml::GraphBuilder::add_softmax(const SoftmaxDescriptor& desc, TensorId input)
+{
+    Node node{};
+    node.type = GraphNodeType::eSoftmax;
+    node.inputs = { input };
+    node.softmax_desc = desc;
+    return add_node(std::move(node), desc.tensor_output);
+}
+
+libdml::TensorId libdml::GraphBuilder::add_mvn(const MvnDescriptor& desc, TensorId input)
+{
+    Node node{};
+    node.type = GraphNodeType::eMvn;
+    node.inputs = { input };
+    node.mvn_desc = desc;
+    return add_node(std::move(node), desc.tensor_output);
+}
+
+libdml::TensorId libdml::GraphBuilder::add_activation(const Activation& activation, TensorId input)
+{
+    Node node{};
+    node.type = GraphNodeType::eActivation;
+    node.inputs = { input };
+    node.activation = activation;
+    // output is the same tensor as the input, for unknown input compile(..) fails anyway
+    const auto output = is_valid_tensor(input) ? tensors_[input] : Tensor{};
+    return add_node(std::move(node), output);
+}
+
+libdml::TensorId libdml::GraphBuilder::add_eltwise_add(TensorId input_a, TensorId input_b)
+{
+    Node node{};
+    node.type = GraphNodeType::eEltwiseAdd;
+    node.inputs = { input_a, input_b };
+    const auto output = is_valid_tensor(input_a) ? tensors_[input_a] : Tensor{};
+    return add_node(std::move(node), output);
+}
+
+libdml::CompiledGraph libdml::GraphBuilder::compile(const DeviceInfo& device_info, ErrorCode* error_code) const
+{
+    auto set_error = [&error_code]()
+    {
+        if (error_code)
+        {
+            *error_code = ErrorCode::eGeneralError;
+        }
+        return CompiledGraph{};
+    };
+
+    if (has_invalid_tensor_ids_ || std::any_of(tensors_.begin(), tensors_.end(), [](const Tensor& tensor) { return tensor.dims.has_overflow(); }))
+    {
+        return set_error();
+    }
+
+    // edges have to match the descriptors, tensors of the graph edges can't be passed through descriptors post ops
+    for (const auto& node : nodes_)
+    {
+        const auto& in = tensors_[node.inputs[0]];
+        auto is_valid = true;
+        switch (node.type)
+        {
+        case GraphNodeType::eConvolution:
+            is_valid = is_matching_tensor(in, node.convolution_desc.tensor_input) && std::none_of(node.convolution_desc.post_ops.begin(), node.convolution_desc.post_ops.end(),
+                [](const PostOp& post_op) { return post_op.type == PostOpType::eEltwiseAdd; });
+            break;
+        case GraphNodeType::eGemm:
+        {
+            const auto& b = node.gemm_desc.tensor_b;
+            is_valid = is_matching_tensor(in, node.gemm_desc.tensor_a) && (node.inputs.size() == 2) == b.has_value()
+                && (!b.has_value() || is_matching_tensor(tensors_[node.inputs[1]], *b));
+            break;
+        }
+        case GraphNodeType::eSoftmax:
+            is_valid = is_matching_tensor(in, node.softmax_desc.tensor_input);
+            break;
+        case GraphNodeType::eMvn:
+            is_valid = is_matching_tensor(in, node.mvn_desc.tensor_input);
+            break;
+        case GraphNodeType::eEltwiseAdd:
+            is_valid = is_matching_tensor(tensors_[node.inputs[1]], in);
+            break;
+        default:
+            break;
+        }
+        if (!is_valid)
+        {
+            return set_error();
+        }
+    }
+
+    // fusions
+    auto nodes = nodes_;
+    std::vector<bool> is_removed(nodes.size(), false);
+    std::vector<std::uint32_t> producer(tensors_.size(), no_node);
+    std::vector<std::uint32_t> consumers_count(tensors_.size(), 0);
+    for (std::uint32_t i = 0; i < nodes.size(); i++)
+    {
+        producer[nodes[i].output] = i;
+        for (const auto input : nodes[i].inputs)
+        {
+            consumers_count[input]++;
+        }
+    }
+
+    auto get_fusable_producer = [&](TensorId tensor, GraphNodeType type) -> Node*
+    {
+        const auto p = producer[tensor];
+        if (p == no_node || is_removed[p] || nodes[p].type != type || consumers_count[tensor] != 1 || is_output_[tensor])
+        {
+            return nullptr;
+        }
+        return &nodes[p];
+    };
+    // node is defined before (or is) the producer, so it is ready when the producer executes
+    auto is_ready_before = [&](TensorId tensor, const Node& node)
+    {
+        const auto p = producer[tensor];
+        return p == no_node || p < producer[node.output];
+    };
+    auto fuse = [&](Node& fused_into, std::uint32_t removed_node)
+    {
+        const auto output = nodes[removed_node].output;
+        producer[output] = producer[fused_into.output];
+        fused_into.output = output;
+        is_removed[removed_node] = true;
+    };
+
+    for (std::uint32_t i = 0; i < nodes.size(); i++)
+    {
+        const auto& node = nodes[i];
+        if (node.type == GraphNodeType::eActivation)
+        {
+            auto* conv = get_fusable_producer(node.inputs[0], GraphNodeType::eConvolution);
+            if (conv && conv->convolution_desc.post_ops.size() < PostOps::capacity())
+            {
+                auto desc = conv->convolution_desc;
+                desc.post_ops.push_back(PostOp{ PostOpType::eActivation, node.activation });
+                if (!get_convolution_implementation_list(device_info, desc).empty())
+                {
+                    conv->convolution_desc = desc;
+                    fuse(*conv, i);
+                }
+            }
+        }
+        else if (node.type == GraphNodeType::eEltwiseAdd)
+        {
+            for (std::size_t side = 0; side < 2 && !is_removed[i]; side++)
+            {
+                const auto conv_output = node.inputs[side];
+                const auto other = node.inputs[1 - side];
+                auto* conv = get_fusable_producer(conv_output, GraphNodeType::eConvolution);
+                if (!conv || conv->convolution_desc.post_ops.size() == PostOps::capacity() || other == conv_output || !is_ready_before(other, *conv))
+                {
+                    continue;
+                }
+                auto desc = conv->convolution_desc;
+                PostOp post_op{};
+                post_op.type = PostOpType::eEltwiseAdd;
+                post_op.tensor = tensors_[other];
+                desc.post_ops.push_back(post_op);
+                if (!get_convolution_implementation_list(device_info, desc).empty())
+                {
+                    conv->convolution_desc = desc;
+                    conv->inputs.push_back(other);
+                    fuse(*conv, i);
+                }
+            }
+        }
+        else if (node.type == GraphNodeType::eSoftmax)
+        {
+            auto* gemm = get_fusable_producer(node.inputs[0], GraphNodeType::eGemm);
+            const auto& out_dims = node.softmax_desc.tensor_output.dims;
+            if (gemm && !out_dims.empty() && node.softmax_desc.axis == out_dims.size() - 1)
+            {
+                auto desc = gemm->gemm_desc;
+                desc.fuse_softmax = true;
+                desc.tensor_output = node.softmax_desc.tensor_output;
+                if (!get_gemm_implementation_list(device_info, desc).empty())
+                {
+                    gemm->gemm_desc = desc;
+                    fuse(*gemm, i);
+                }
+            }
+        }
+    }
+
+    // schedule
+    CompiledGraph ret{};
+    std::vector<std::optional<Lifetime>> lifetimes(tensors_.size());
+    for (std::uint32_t i = 0; i < nodes.size(); i++)
+    {
+        if (is_removed[i])
+        {
+            continue;
+        }
+        const auto& node = nodes[i];
+        GraphStep step{};
+        step.type = node.type;
+        step.inputs = node.inputs;
+        step.output = node.output;
+        switch (node.type)
+        {
+        case GraphNodeType::eConvolution:
+        {
+            const auto& impls = get_convolution_implementation_list(device_info, node.convolution_desc);
+            if (impls.empty())
+            {
+                return set_error();
+            }
+            step.convolution = impls.front();
+            break;
+        }
+        case GraphNodeType::eGemm:
+        {
+            const auto& impls = get_gemm_implementation_list(device_info, node.gemm_desc);
+            if (impls.empty())
+            {
+                return set_error();
+            }
+            step.gemm = impls.front();
+            break;
+        }
+        case GraphNodeType::eSoftmax:
+        {
+            const auto& impls = get_softmax_implementation_list(device_info, node.softmax_desc);
+            if (impls.empty())
+            {
+                return set_error();
+            }
+            step.softmax = impls.front();
+            break;
+        }
+        case GraphNodeType::eMvn:
+        {
+            const auto& impls = get_mvn_implementation_list(device_info, node.mvn_desc);
+            if (impls.empty())
+            {
+                return set_error();
+            }
+            step.mvn = impls.front();
+            break;
+        }
+        case GraphNodeType::eActivation:
+            step.activation = node.activation;
+            break;
+        default:
+            break;
+        }
+
+        const auto step_idx = ret.steps.size();
+        lifetimes[node.output] = Lifetime{ step_idx, step_idx };
+        for (const auto input : node.inputs)
+        {
+            if (lifetimes[input].has_value())
+            {
+                lifetimes[input]->last_step = step_idx;
+            }
+        }
+        ret.steps.push_back(std::move(step));
+    }
+
+    // memory plan
+    ret.tensors.resize(tensors_.size());
+    for (std::size_t i = 0; i < tensors_.size(); i++)
+    {
+        auto& tensor = ret.tensors[i];
+        tensor.tensor = tensors_[i];
+        if (producer[i] == no_node)
+        {
+            tensor.storage = GraphTensorStorage::eInput;
+        }
+        else if (is_output_[i])
+        {
+            tensor.storage = GraphTensorStorage::eOutput;
+        }
+        else if (lifetimes[i].has_value())
+        {
+            tensor.size_in_bytes = impl_helpers::get_bytes_width(tensors_[i]);
+        }
+    }
+    ret.arena_size_in_bytes = assign_arena_offsets(ret.tensors, lifetimes);
+    return ret;
+}
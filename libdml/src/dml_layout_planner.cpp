@@ -0,0 +1,145 @@
+#include "../include/dml_layout_planner.hpp"
+#include "impl/impl_helpers.h"
+#include "impl/layout_search.h"
+
+#include <vector>
+#include <array>
+#include <cstddef>
+
+namespace
+{
+constexpr std::array<libdml::DataLayout, 2> activations_layouts = { libdml::DataLayout::eNCHW, libdml::DataLayout::eNHWC };
+
+std::vector<libdml::DataLayout> get_layout_options(const libdml::Tensor& tensor)
+{
+    if (tensor.data_layout == libdml::DataLayout::eAny)
+    {
+        return { activations_layouts.begin(), activations_layouts.end() };
+    }
+    return { tensor.data_layout };
+}
+
+// One way to execute an op: activations layouts and the fastest implementation for them.
+struct OpOption
+{
+    libdml::ConvolutionDescriptor desc;
+    const libdml::ConvolutionPrimitive* primitive = nullptr;
+    double time_us = 0.0;
+};
+
+std::vector<OpOption> get_op_options(const libdml::DeviceInfo& device_info, const libdml::ConvolutionDescriptor& desc)
+{
+    std::vector<OpOption> ret{};
+    for (const auto input_layout : get_layout_options(desc.tensor_input))
+    {
+        for (const auto output_layout : get_layout_options(desc.tensor_output))
+        {
+            auto option_desc = desc;
+            option_desc.tensor_input.data_layout = input_layout;
+            option_desc.tensor_output.data_layout = output_layout;
+            // lists are cached for the process lifetime, so pointers to the primitives stay valid
+            const auto& impls = libdml::get_convolution_implementation_list(device_info, option_desc);
+            if (!impls.empty())
+            {
+                ret.push_back(OpOption{ option_desc, &impls.front(), impls.front().get_info().estimated_time_us });
+            }
+        }
+    }
+    return ret;
+}
+
+bool is_valid_chain(const std::vector<libdml::ConvolutionDescriptor>& chain)
+{
+    if (chain.empty())
+    {
+        return false;
+    }
+    for (std::size_t i = 1; i < chain.size(); i++)
+    {
+        const auto& prev_output = chain[i - 1].tensor_output;
+        const auto& input = chain[i].tensor_input;
+        if (prev_output.dims != input.dims || prev_output.data_type != input.data_type)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+}  // namespace
+
+libdml::ConvolutionLayoutPlan libdml::plan_convolution_layouts(const DeviceInfo& device_info, const std::vector<ConvolutionDescriptor>& chain, ErrorCode* error_code)
+{
+    auto set_error = [&error_code]()
+    {
+        if (error_code)
+        {
+            *error_code = ErrorCode::eGeneralError;
+        }
+        return ConvolutionLayoutPlan{};
+    };
+
+    if (!is_valid_chain(chain))
+    {
+        return set_error();
+    }
+
+    std::vector<std::vector<OpOption>> options(chain.size());
+    for (std::size_t i = 0; i < chain.size(); i++)
+    {
+        options[i] = get_op_options(device_info, chain[i]);
+        if (options[i].empty())
+        {
+            return set_error();
+        }
+    }
+
+    const auto peaks = impl_helpers::get_platform_peaks(device_info);
+    auto get_reorder_time_us = [&](const OpOption& from, const OpOption& to)
+    {
+        const auto& tensor = to.desc.tensor_input;
+        return from.desc.tensor_output.data_layout == tensor.data_layout ? 0.0 : impl_helpers::get_reorder_time_us(tensor, peaks);
+    };
+
+    std::vector<std::vector<double>> op_times(chain.size());
+    for (std::size_t i = 0; i < chain.size(); i++)
+    {
+        for (const auto& option : options[i])
+        {
+            op_times[i].push_back(option.time_us);
+        }
+    }
+    layout_search::PathCost total_cost{};
+    const auto selected = layout_search::select_options(op_times, [&](std::size_t i, std::size_t j, std::size_t k)
+        {
+            return get_reorder_time_us(options[i - 1][j], options[i][k]);
+        }, &total_cost);
+
+    ConvolutionLayoutPlan ret{};
+    ret.estimated_time_us = total_cost.time_us;
+    ret.steps.reserve(chain.size());
+    for (std::size_t i = 0; i < chain.size(); i++)
+    {
+        const auto& option = options[i][selected[i]];
+        ConvolutionLayoutPlanStep step{ option.desc, *option.primitive, {} };
+        step.estimated_time_us = option.time_us;
+        if (i > 0)
+        {
+            const auto& prev_option = options[i - 1][selected[i - 1]];
+            const auto from = prev_option.desc.tensor_output.data_layout;
+            const auto to = option.desc.tensor_input.data_layout;
+            if (from != to)
+            {
+                step.input_reorder = LayoutReorder{ from, to, get_reorder_time_us(prev_option, option) };
+            }
+        }
+        // weights reorder is possible only if descriptor allows it
+        const auto preffered = step.primitive.query_preffered_layouts();
+        if (chain[i].tensor_weights.data_layout == DataLayout::eAny && preffered.weights_layout.has_value())
+        {
+            step.layouts.weights_layout = preffered.weights_layout;
+            ret.weights_prepack_time_us += impl_helpers::get_reorder_time_us(chain[i].tensor_weights, peaks);
+        }
+        ret.steps.push_back(std::move(step));
+    }
+    return ret;
+}
@@ -0,0 +1,74 @@
+#include "../include/dml_mvn.hpp"
+#include "impl/mvn/mvn_impl.h"
+#include "impl/implementation_list.h"
+
+#include <vector>
+#include <memory>
+
+libdml::MvnPrimitive::MvnPrimitive(MvnImplementation* impl)
+    : impl_(impl)
+{
+
+}
+
+libdml::MvnPrimitive::~MvnPrimitive() = default;
+
+
+libdml::MvnExecutionParams libdml::MvnPrimitive::get_execution_map(ErrorCode* error_code) const
+{
+    if (!impl_)
+    {
+        if (error_code)
+        {
+            *error_code = ErrorCode::eGeneralError;
+        }
+        return {};
+    }
+
+    return impl_->get_execution_map();
+}
+
+libdml::ImplementationInfo libdml::MvnPrimitive::get_info() const
+{
+    if (!impl_)
+    {
+        return {};
+    }
+    auto ret = impl_->get_info();
+    ret.priority = priority_;
+    return ret;
+}
+
+libdml::KernelInfo libdml::MvnPrimitive::get_kernel_info() const
+{
+    if (!impl_)
+    {
+        return {};
+    }
+    return impl_->get_kernel_info();
+}
+
+void libdml::MvnPrimitive::set_priority(ImplementationPriority priority)
+{
+    priority_ = priority;
+}
+
+namespace
+{
+std::vector<libdml::MvnPrimitive> create_mvn_implementation_list(const libdml::DeviceInfo& device_info, const libdml::MvnDescriptor& desc)
+{
+    using namespace libdml;
+
+    if (!mvn_helpers::is_valid_descriptor(desc))
+    {
+        return {};
+    }
+    return sort_by_estimated_time(MvnImplementationRegistry::create_list(device_info, desc));
+}
+}  // namespace
+
+const std::vector<libdml::MvnPrimitive>& libdml::get_mvn_implementation_list(const DeviceInfo& device_info, const MvnDescriptor& desc)
+{
+    static ImplementationListCache<MvnDescriptor, MvnPrimitive> cache(create_mvn_implementation_list);
+    return cache.get(device_info, desc);
+}
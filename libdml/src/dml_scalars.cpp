@@ -0,0 +1,172 @@
+#include "../include/dml_scalars.hpp"
+
+#include <cstring>
+
+namespace
+{
+std::uint32_t get_scalar_bytes_width(libdml::ScalarType type)
+{
+    switch (type)
+    {
+    case libdml::ScalarType::eUint32:
+    case libdml::ScalarType::eInt32:
+    case libdml::ScalarType::eFp32: return 4;
+    case libdml::ScalarType::eFp16: return 2;
+    default:
+        return 0;
+    }
+}
+
+// IEEE 754 binary16, round to nearest even, overflow to infinity
+std::uint16_t float_to_half(float value)
+{
+    std::uint32_t bits = 0;
+    std::memcpy(&bits, &value, sizeof(bits));
+    const auto sign = static_cast<std::uint16_t>((bits >> 16) & 0x8000);
+    const auto exponent = static_cast<std::int32_t>((bits >> 23) & 0xff);
+    auto mantissa = bits & 0x7fffff;
+
+    if (exponent == 0xff)
+    {
+        // inf or nan (keep nan quiet)
+        return sign | 0x7c00 | (mantissa ? 0x200 : 0);
+    }
+    const auto half_exponent = exponent - 127 + 15;
+    if (half_exponent >= 0x1f)
+    {
+        return sign | 0x7c00;
+    }
+    if (half_exponent <= 0)
+    {
+        // subnormal or zero
+        if (half_exponent < -10)
+        {
+            return sign;
+        }
+        mantissa |= 0x800000;
+        const auto shift = static_cast<std::uint32_t>(14 - half_exponent);
+        auto half_mantissa = mantissa >> shift;
+        const auto remainder = mantissa & ((1u << shift) - 1);
+        const auto halfway = 1u << (shift - 1);
+        if (remainder > halfway || (remainder == halfway && (half_mantissa & 1)))
+        {
+            half_mantissa++;
+        }
+        return sign | static_cast<std::uint16_t>(half_mantissa);
+    }
+    auto ret = static_cast<std::uint32_t>(half_exponent << 10) | (mantissa >> 13);
+    const auto remainder = mantissa & 0x1fff;
+    if (remainder > 0x1000 || (remainder == 0x1000 && (ret & 1)))
+    {
+        // carry can propagate into exponent, which gives correct rounding up to infinity
+        ret++;
+    }
+    return sign | static_cast<std::uint16_t>(ret);
+}
+}  // namespace
+
+bool libdml::ScalarsSchema::add_field(const char* name, ScalarType type, std::uint32_t* field_idx)
+{
+    const auto bytes_width = get_scalar_bytes_width(type);
+    if (bytes_width == 0)
+    {
+        return false;
+    }
+    const auto offset = (end_offset_ + bytes_width - 1) / bytes_width * bytes_width;
+    // root constants are set in DWORDs, so the rounded up size has to fit too (max_scalars_buffer_size is DWORD aligned)
+    if (offset + bytes_width > max_scalars_buffer_size || !fields_.push_back(ScalarField{ name, type, offset }))
+    {
+        return false;
+    }
+    end_offset_ = offset + bytes_width;
+    if (field_idx)
+    {
+        *field_idx = static_cast<std::uint32_t>(fields_.size() - 1);
+    }
+    return true;
+}
+
+const libdml::ScalarField* libdml::ScalarsSchema::find(std::string_view name) const
+{
+    for (const auto& field : fields_)
+    {
+        if (name == field.name)
+        {
+            return &field;
+        }
+    }
+    return nullptr;
+}
+
+std::uint32_t libdml::ScalarsSchema::get_size() const
+{
+    const auto dword_size = static_cast<std::uint32_t>(sizeof(std::uint32_t));
+    return (end_offset_ + dword_size - 1) / dword_size * dword_size;
+}
+
+libdml::ScalarsPacker::ScalarsPacker(const ScalarsSchema& schema, ScalarsBuffer& buffer)
+    : schema_(schema)
+    , buffer_(buffer)
+{
+    buffer_.clear();
+    buffer_.resize(schema_.get_size(), std::byte{ 0 });
+}
+
+bool libdml::ScalarsPacker::set_uint32(std::uint32_t field_idx, std::uint32_t value)
+{
+    const auto* field = get_field(field_idx);
+    if (!field || field->type != ScalarType::eUint32)
+    {
+        return false;
+    }
+    return write(field->offset, value, 4);
+}
+
+bool libdml::ScalarsPacker::set_int32(std::uint32_t field_idx, std::int32_t value)
+{
+    const auto* field = get_field(field_idx);
+    if (!field || field->type != ScalarType::eInt32)
+    {
+        return false;
+    }
+    return write(field->offset, static_cast<std::uint32_t>(value), 4);
+}
+
+bool libdml::ScalarsPacker::set_float(std::uint32_t field_idx, float value)
+{
+    const auto* field = get_field(field_idx);
+    if (!field || (field->type != ScalarType::eFp32 && field->type != ScalarType::eFp16))
+    {
+        return false;
+    }
+    if (field->type == ScalarType::eFp16)
+    {
+        return write(field->offset, float_to_half(value), 2);
+    }
+    std::uint32_t bits = 0;
+    std::memcpy(&bits, &value, sizeof(bits));
+    return write(field->offset, bits, 4);
+}
+
+bool libdml::ScalarsPacker::write(std::uint32_t offset, std::uint32_t value, std::uint32_t bytes_width)
+{
+    // offset is checked against the buffer, not the schema: buffer could have been modified after the packer resized it
+    if (offset > buffer_.size() || buffer_.size() - offset < bytes_width)
+    {
+        return false;
+    }
+    for (std::uint32_t i = 0; i < bytes_width; i++)
+    {
+        buffer_[offset + i] = static_cast<std::byte>((value >> (8 * i)) & 0xff);
+    }
+    return true;
+}
+
+const libdml::ScalarField* libdml::ScalarsPacker::get_field(std::uint32_t field_idx) const
+{
+    if (field_idx >= schema_.get_fields().size())
+    {
+        return nullptr;
+    }
+    return &schema_.get_fields()[field_idx];
+}
@@ -0,0 +1,646 @@
+#include "../include/dml_serialization.hpp"
+
+#include <vector>
+#include <array>
+#include <string>
+#include <optional>
+#include <cstring>
+#include <cstdint>
+#include <cstddef>
+
+namespace
+{
+constexpr std::array<char, 4> magic = { 'L', 'D', 'M', 'L' };
+
+class Writer
+{
+public:
+    explicit Writer(std::vector<std::byte>& out)
+        : out_(out)
+    {
+    }
+
+    template<typename T>
+    void write_uint(T value)
+    {
+        for (std::size_t i = 0; i < sizeof(T); i++)
+        {
+            out_.push_back(static_cast<std::byte>((value >> (8 * i)) & 0xff));
+        }
+    }
+
+    void write_u8(std::uint8_t value) { write_uint(value); }
+    void write_u32(std::uint32_t value) { write_uint(value); }
+    void write_u64(std::uint64_t value) { write_uint(value); }
+    void write_i32(std::int32_t value) { write_uint(static_cast<std::uint32_t>(value)); }
+    void write_bool(bool value) { write_u8(value ? 1 : 0); }
+
+    void write_f32(float value)
+    {
+        std::uint32_t bits = 0;
+        std::memcpy(&bits, &value, sizeof(bits));
+        write_u32(bits);
+    }
+
+    void write_f64(double value)
+    {
+        std::uint64_t bits = 0;
+        std::memcpy(&bits, &value, sizeof(bits));
+        write_u64(bits);
+    }
+
+    template<typename Enum>
+    void write_enum(Enum value)
+    {
+        write_u8(static_cast<std::uint8_t>(value));
+    }
+
+    void write_string(const std::string& value)
+    {
+        write_u32(static_cast<std::uint32_t>(value.size()));
+        for (const auto c : value)
+        {
+            write_u8(static_cast<std::uint8_t>(c));
+        }
+    }
+
+    void write_dims(const libdml::TensorDims& dims)
+    {
+        write_u32(static_cast<std::uint32_t>(dims.size()));
+        for (const auto d : dims)
+        {
+            write_i32(d);
+        }
+    }
+
+    void write_tensor(const libdml::Tensor& tensor)
+    {
+        write_dims(tensor.dims);
+        write_enum(tensor.data_layout);
+        write_enum(tensor.data_type);
+    }
+
+    void write_optional_tensor(const std::optional<libdml::Tensor>& tensor)
+    {
+        write_bool(tensor.has_value());
+        if (tensor.has_value())
+        {
+            write_tensor(*tensor);
+        }
+    }
+
+    void write_optional_layout(const std::optional<libdml::DataLayout>& layout)
+    {
+        write_bool(layout.has_value());
+        if (layout.has_value())
+        {
+            write_enum(*layout);
+        }
+    }
+
+    void write_activation(const libdml::Activation& activation)
+    {
+        write_enum(activation.type);
+        write_f32(activation.alpha);
+        write_f32(activation.beta);
+    }
+
+    void write_post_op(const libdml::PostOp& post_op)
+    {
+        write_enum(post_op.type);
+        write_activation(post_op.activation);
+        write_optional_tensor(post_op.tensor);
+        write_optional_tensor(post_op.tensor_shift);
+        write_enum(post_op.data_type);
+    }
+
+    void write_exec_param(const libdml::ExecParamInfo& param)
+    {
+        write_u32(param.index);
+    }
+
+    template<std::size_t Count>
+    void write_exec_params_table(const libdml::ExecParamsTable<Count>& table)
+    {
+        write_u32(static_cast<std::uint32_t>(table.size()));
+        for (const auto& param : table)
+        {
+            write_bool(param.has_value());
+            if (param.has_value())
+            {
+                write_exec_param(*param);
+            }
+        }
+    }
+
+private:
+    std::vector<std::byte>& out_;
+};
+
+/*
+*   Reads are bounds checked. First failure is sticky: next reads return default values and ok() stays false.
+*/
+class Reader
+{
+public:
+    Reader(const std::byte* data, std::size_t size, std::size_t offset)
+        : data_(data)
+        , size_(size)
+        , offset_(offset)
+    {
+    }
+
+    bool ok() const { return ok_; }
+    std::size_t get_offset() const { return offset_; }
+    void fail() { ok_ = false; }
+
+    template<typename T>
+    T read_uint()
+    {
+        if (!ok_ || data_ == nullptr || size_ < offset_ || size_ - offset_ < sizeof(T))
+        {
+            ok_ = false;
+            return T{ 0 };
+        }
+        T ret = 0;
+        for (std::size_t i = 0; i < sizeof(T); i++)
+        {
+            ret |= static_cast<T>(static_cast<T>(data_[offset_ + i]) << (8 * i));
+        }
+        offset_ += sizeof(T);
+        return ret;
+    }
+
+    std::uint8_t read_u8() { return read_uint<std::uint8_t>(); }
+    std::uint32_t read_u32() { return read_uint<std::uint32_t>(); }
+    std::uint64_t read_u64() { return read_uint<std::uint64_t>(); }
+    std::int32_t read_i32() { return static_cast<std::int32_t>(read_u32()); }
+
+    bool read_bool()
+    {
+        const auto value = read_u8();
+        if (value > 1)
+        {
+            ok_ = false;
+        }
+        return value == 1;
+    }
+
+    float read_f32()
+    {
+        const auto bits = read_u32();
+        float ret = 0.0f;
+        std::memcpy(&ret, &bits, sizeof(ret));
+        return ret;
+    }
+
+    double read_f64()
+    {
+        const auto bits = read_u64();
+        double ret = 0.0;
+        std::memcpy(&ret, &bits, sizeof(ret));
+        return ret;
+    }
+
+    // values_count: number of valid enum values (eCount for the enums which have it)
+    template<typename Enum>
+    Enum read_enum(std::uint32_t values_count)
+    {
+        const auto value = read_u8();
+        if (value >= values_count)
+        {
+            ok_ = false;
+            return Enum{};
+        }
+        return static_cast<Enum>(value);
+    }
+
+    // every element takes at least one byte, so count can't be bigger than the remaining data
+    std::uint32_t read_count()
+    {
+        const auto count = read_u32();
+        if (ok_ && count > size_ - offset_)
+        {
+            ok_ = false;
+            return 0;
+        }
+        return count;
+    }
+
+    std::string read_string()
+    {
+        const auto count = read_count();
+        std::string ret{};
+        ret.reserve(count);
+        for (std::uint32_t i = 0; i < count && ok_; i++)
+        {
+            ret.push_back(static_cast<char>(read_u8()));
+        }
+        return ret;
+    }
+
+    libdml::TensorDims read_dims()
+    {
+        const auto count = read_count();
+        if (count > libdml::TensorDims::capacity())
+        {
+            ok_ = false;
+        }
+        libdml::TensorDims ret{};
+        for (std::uint32_t i = 0; i < count && ok_; i++)
+        {
+            ret.push_back(read_i32());
+        }
+        return ret;
+    }
+
+    libdml::DataLayout read_layout() { return read_enum<libdml::DataLayout>(static_cast<std::uint32_t>(libdml::DataLayout::eCount)); }
+    libdml::DataType read_data_type() { return read_enum<libdml::DataType>(static_cast<std::uint32_t>(libdml::DataType::eCount)); }
+
+    libdml::Tensor read_tensor()
+    {
+        libdml::Tensor ret{};
+        ret.dims = read_dims();
+        ret.data_layout = read_layout();
+        ret.data_type = read_data_type();
+        return ret;
+    }
+
+    std::optional<libdml::Tensor> read_optional_tensor()
+    {
+        if (!read_bool())
+        {
+            return std::nullopt;
+        }
+        return read_tensor();
+    }
+
+    std::optional<libdml::DataLayout> read_optional_layout()
+    {
+        if (!read_bool())
+        {
+            return std::nullopt;
+        }
+        return read_layout();
+    }
+
+    libdml::Activation read_activation()
+    {
+        libdml::Activation ret{ read_enum<libdml::ActivationType>(static_cast<std::uint32_t>(libdml::ActivationType::eCount)) };
+        ret.alpha = read_f32();
+        ret.beta = read_f32();
+        return ret;
+    }
+
+    libdml::PostOp read_post_op()
+    {
+        libdml::PostOp ret{};
+        ret.type = read_enum<libdml::PostOpType>(static_cast<std::uint32_t>(libdml::PostOpType::eCount));
+        ret.activation = read_activation();
+        ret.tensor = read_optional_tensor();
+        ret.tensor_shift = read_optional_tensor();
+        ret.data_type = read_data_type();
+        return ret;
+    }
+
+    libdml::ExecParamInfo read_exec_param()
+    {
+        return libdml::ExecParamInfo{ read_u32() };
+    }
+
+    // table size is fixed by the primitive type, blob written for other size is invalid
+    template<std::size_t Count>
+    libdml::ExecParamsTable<Count> read_exec_params_table()
+    {
+        libdml::ExecParamsTable<Count> ret{};
+        if (read_count() != Count)
+        {
+            ok_ = false;
+        }
+        for (auto& param : ret)
+        {
+            if (!ok_)
+            {
+                break;
+            }
+            if (read_bool())
+            {
+                param = read_exec_param();
+            }
+        }
+        return ret;
+    }
+
+private:
+    const std::byte* data_;
+    std::size_t size_;
+    std::size_t offset_;
+    bool ok_ = true;
+};
+
+void write_convolution_descriptor(Writer& writer, const libdml::ConvolutionDescriptor& desc)
+{
+    writer.write_tensor(desc.tensor_input);
+    writer.write_tensor(desc.tensor_output);
+    writer.write_tensor(desc.tensor_weights);
+    writer.write_optional_tensor(desc.tensor_bias);
+    writer.write_dims(desc.strides);
+    writer.write_dims(desc.dilations);
+    writer.write_dims(desc.start_padding);
+    writer.write_dims(desc.end_padding);
+    writer.write_u32(desc.group_count);
+    writer.write_enum(desc.datatype_accumulator);
+    writer.write_enum(desc.direction);
+    writer.write_u32(static_cast<std::uint32_t>(desc.post_ops.size()));
+    for (const auto& post_op : desc.post_ops)
+    {
+        writer.write_post_op(post_op);
+    }
+}
+
+libdml::ConvolutionDescriptor read_convolution_descriptor(Reader& reader)
+{
+    libdml::ConvolutionDescriptor ret{};
+    ret.tensor_input = reader.read_tensor();
+    ret.tensor_output = reader.read_tensor();
+    ret.tensor_weights = reader.read_tensor();
+    ret.tensor_bias = reader.read_optional_tensor();
+    ret.strides = reader.read_dims();
+    ret.dilations = reader.read_dims();
+    ret.start_padding = reader.read_dims();
+    ret.end_padding = reader.read_dims();
+    ret.group_count = reader.read_u32();
+    ret.datatype_accumulator = reader.read_data_type();
+    ret.direction = reader.read_enum<libdml::ConvolutionDirection>(static_cast<std::uint32_t>(libdml::ConvolutionDirection::eCount));
+    const auto post_ops_count = reader.read_count();
+    if (post_ops_count > libdml::PostOps::capacity())
+    {
+        reader.fail();
+    }
+    for (std::uint32_t i = 0; i < post_ops_count && reader.ok(); i++)
+    {
+        ret.post_ops.push_back(reader.read_post_op());
+    }
+    return ret;
+}
+
+void write_device_info(Writer& writer, const libdml::DeviceInfo& device_info)
+{
+    writer.write_enum(device_info.platform);
+    writer.write_u32(device_info.eu_count);
+}
+
+libdml::DeviceInfo read_device_info(Reader& reader)
+{
+    libdml::DeviceInfo ret{};
+    ret.platform = reader.read_enum<libdml::HwPlatform>(static_cast<std::uint32_t>(libdml::HwPlatform::eCount));
+    ret.eu_count = reader.read_u32();
+    return ret;
+}
+
+void write_implementation_info(Writer& writer, const libdml::ImplementationInfo& info)
+{
+    writer.write_u32(info.priority.value);
+    writer.write_string(info.name);
+    writer.write_f64(info.estimated_time_us);
+}
+
+libdml::ImplementationInfo read_implementation_info(Reader& reader)
+{
+    libdml::ImplementationInfo ret{};
+    ret.priority.value = reader.read_u32();
+    ret.name = reader.read_string();
+    ret.estimated_time_us = reader.read_f64();
+    return ret;
+}
+
+void write_kernel_info(Writer& writer, const libdml::KernelInfo& kernel_info)
+{
+    writer.write_enum(kernel_info.language);
+    writer.write_string(kernel_info.code);
+    writer.write_u32(static_cast<std::uint32_t>(kernel_info.jits.size()));
+    for (const auto& jit : kernel_info.jits)
+    {
+        writer.write_string(jit.opt);
+        writer.write_string(jit.value);
+    }
+    for (const auto v : kernel_info.gws)
+    {
+        writer.write_u32(v);
+    }
+    for (const auto v : kernel_info.lws)
+    {
+        writer.write_u32(v);
+    }
+    writer.write_enum(kernel_info.grf_count);
+}
+
+libdml::KernelInfo read_kernel_info(Reader& reader)
+{
+    libdml::KernelInfo ret{};
+    ret.language = reader.read_enum<libdml::KernelLanguage>(static_cast<std::uint32_t>(libdml::KernelLanguage::eCount));
+    ret.code = reader.read_string();
+    const auto jits_count = reader.read_count();
+    for (std::uint32_t i = 0; i < jits_count && reader.ok(); i++)
+    {
+        libdml::Jit jit{};
+        jit.opt = reader.read_string();
+        jit.value = reader.read_string();
+        ret.jits.push_back(std::move(jit));
+    }
+    for (auto& v : ret.gws)
+    {
+        v = reader.read_u32();
+    }
+    for (auto& v : ret.lws)
+    {
+        v = reader.read_u32();
+    }
+    ret.grf_count = reader.read_enum<libdml::KernelGrfCount>(static_cast<std::uint32_t>(libdml::KernelGrfCount::eCount));
+    return ret;
+}
+
+void write_convolution_execution_params(Writer& writer, const libdml::ConvolutionExecutionParams& params)
+{
+    writer.write_exec_params_table(params.params_map);
+    writer.write_u32(static_cast<std::uint32_t>(params.post_ops_params.size()));
+    for (const auto& param : params.post_ops_params)
+    {
+        writer.write_exec_param(param);
+    }
+    writer.write_u32(static_cast<std::uint32_t>(params.scalars_buffer.size()));
+    for (const auto b : params.scalars_buffer)
+    {
+        writer.write_u8(static_cast<std::uint8_t>(b));
+    }
+}
+
+libdml::ConvolutionExecutionParams read_convolution_execution_params(Reader& reader)
+{
+    libdml::ConvolutionExecutionParams ret{};
+    ret.params_map = reader.read_exec_params_table<libdml::CONVOLUTION_EXEC_PARAM_TYPE_COUNT>();
+    const auto post_ops_params_count = reader.read_count();
+    if (post_ops_params_count > libdml::PostOpsExecParams::capacity())
+    {
+        reader.fail();
+    }
+    for (std::uint32_t i = 0; i < post_ops_params_count && reader.ok(); i++)
+    {
+        ret.post_ops_params.push_back(reader.read_exec_param());
+    }
+    const auto scalars_size = reader.read_count();
+    if (scalars_size > libdml::ScalarsBuffer::capacity())
+    {
+        reader.fail();
+    }
+    for (std::uint32_t i = 0; i < scalars_size && reader.ok(); i++)
+    {
+        ret.scalars_buffer.push_back(static_cast<std::byte>(reader.read_u8()));
+    }
+    return ret;
+}
+
+// reads with the reader and commits the value and offset only on success
+template<typename T, typename ReadFunc>
+bool deserialize_impl(const std::byte* data, std::size_t size, std::size_t& offset, T& value, ReadFunc read_func)
+{
+    Reader reader(data, size, offset);
+    auto ret = read_func(reader);
+    if (!reader.ok())
+    {
+        return false;
+    }
+    value = std::move(ret);
+    offset = reader.get_offset();
+    return true;
+}
+}  // namespace
+
+void libdml::serialize(const ConvolutionDescriptor& value, std::vector<std::byte>& out)
+{
+    Writer writer(out);
+    write_convolution_descriptor(writer, value);
+}
+
+void libdml::serialize(const DeviceInfo& value, std::vector<std::byte>& out)
+{
+    Writer writer(out);
+    write_device_info(writer, value);
+}
+
+void libdml::serialize(const ImplementationInfo& value, std::vector<std::byte>& out)
+{
+    Writer writer(out);
+    write_implementation_info(writer, value);
+}
+
+void libdml::serialize(const KernelInfo& value, std::vector<std::byte>& out)
+{
+    Writer writer(out);
+    write_kernel_info(writer, value);
+}
+
+void libdml::serialize(const ConvolutionExecutionParams& value, std::vector<std::byte>& out)
+{
+    Writer writer(out);
+    write_convolution_execution_params(writer, value);
+}
+
+bool libdml::deserialize(const std::byte* data, std::size_t size, std::size_t& offset, ConvolutionDescriptor& value)
+{
+    return deserialize_impl(data, size, offset, value, read_convolution_descriptor);
+}
+
+bool libdml::deserialize(const std::byte* data, std::size_t size, std::size_t& offset, DeviceInfo& value)
+{
+    return deserialize_impl(data, size, offset, value, read_device_info);
+}
+
+bool libdml::deserialize(const std::byte* data, std::size_t size, std::size_t& offset, ImplementationInfo& value)
+{
+    return deserialize_impl(data, size, offset, value, read_implementation_info);
+}
+
+bool libdml::deserialize(const std::byte* data, std::size_t size, std::size_t& offset, KernelInfo& value)
+{
+    return deserialize_impl(data, size, offset, value, read_kernel_info);
+}
+
+bool libdml::deserialize(const std::byte* data, std::size_t size, std::size_t& offset, ConvolutionExecutionParams& value)
+{
+    return deserialize_impl(data, size, offset, value, read_convolution_execution_params);
+}
+
+std::vector<std::byte> libdml::serialize_selection_cache(const SelectionCache& cache)
+{
+    std::vector<std::byte> payload{};
+    Writer payload_writer(payload);
+    write_device_info(payload_writer, cache.device_info);
+    payload_writer.write_u32(static_cast<std::uint32_t>(cache.convolutions.size()));
+    for (const auto& selection : cache.convolutions)
+    {
+        write_convolution_descriptor(payload_writer, selection.desc);
+        write_implementation_info(payload_writer, selection.info);
+        payload_writer.write_optional_layout(selection.layouts.input_layout);
+        payload_writer.write_optional_layout(selection.layouts.weights_layout);
+        payload_writer.write_optional_layout(selection.layouts.bias_layout);
+        write_kernel_info(payload_writer, selection.kernel_info);
+        write_convolution_execution_params(payload_writer, selection.execution_params);
+    }
+
+    std::vector<std::byte> ret{};
+    ret.reserve(magic.size() + sizeof(std::uint32_t) + sizeof(std::uint64_t) + payload.size());
+    Writer writer(ret);
+    for (const auto c : magic)
+    {
+        writer.write_u8(static_cast<std::uint8_t>(c));
+    }
+    writer.write_u32(serialization_format_version);
+    writer.write_u64(payload.size());
+    ret.insert(ret.end(), payload.begin(), payload.end());
+    return ret;
+}
+
+libdml::SelectionCache libdml::deserialize_selection_cache(const std::byte* data, std::size_t size, ErrorCode* error_code)
+{
+    Reader reader(data, size, 0);
+    for (const auto c : magic)
+    {
+        if (reader.read_u8() != static_cast<std::uint8_t>(c))
+        {
+            reader.fail();
+        }
+    }
+    const auto version = reader.read_u32();
+    const auto payload_size = reader.read_u64();
+    if (!reader.ok() || version != serialization_format_version || payload_size != size - reader.get_offset())
+    {
+        reader.fail();
+    }
+
+    SelectionCache ret{};
+    ret.device_info = read_device_info(reader);
+    const auto count = reader.read_count();
+    for (std::uint32_t i = 0; i < count && reader.ok(); i++)
+    {
+        ConvolutionSelection selection{};
+        selection.desc = read_convolution_descriptor(reader);
+        selection.info = read_implementation_info(reader);
+        selection.layouts.input_layout = reader.read_optional_layout();
+        selection.layouts.weights_layout = reader.read_optional_layout();
+        selection.layouts.bias_layout = reader.read_optional_layout();
+        selection.kernel_info = read_kernel_info(reader);
+        selection.execution_params = read_convolution_execution_params(reader);
+        ret.convolutions.push_back(std::move(selection));
+    }
+
+    if (!reader.ok() || reader.get_offset() != size)
+    {
+        if (error_code)
+        {
+            *error_code = ErrorCode::eGeneralError;
+        }
+        return {};
+    }
+    return ret;
+}
@@ -0,0 +1,74 @@
+#include "../include/dml_softmax.hpp"
+#include "impl/softmax/softmax_impl.h"
+#include "impl/implementation_list.h"
+
+#include <vector>
+#include <memory>
+
+libdml::SoftmaxPrimitive::SoftmaxPrimitive(SoftmaxImplementation* impl)
+    : impl_(impl)
+{
+
+}
+
+libdml::SoftmaxPrimitive::~SoftmaxPrimitive() = default;
+
+
+libdml::SoftmaxExecutionParams libdml::SoftmaxPrimitive::get_execution_map(ErrorCode* error_code) const
+{
+    if (!impl_)
+    {
+        if (error_code)
+        {
+            *error_code = ErrorCode::eGeneralError;
+        }
+        return {};
+    }
+
+    return impl_->get_execution_map();
+}
+
+libdml::ImplementationInfo libdml::SoftmaxPrimitive::get_info() const
+{
+    if (!impl_)
+    {
+        return {};
+    }
+    auto ret = impl_->get_info();
+    ret.priority = priority_;
+    return ret;
+}
+
+libdml::KernelInfo libdml::SoftmaxPrimitive::get_kernel_info() const
+{
+    if (!impl_)
+    {
+        return {};
+    }
+    return impl_->get_kernel_info();
+}
+
+void libdml::SoftmaxPrimitive::set_priority(ImplementationPriority priority)
+{
+    priority_ = priority;
+}
+
+namespace
+{
+std::vector<libdml::SoftmaxPrimitive> create_softmax_implementation_list(const libdml::DeviceInfo& device_info, const libdml::SoftmaxDescriptor& desc)
+{
+    using namespace libdml;
+
+    if (!softmax_helpers::is_valid_descriptor(desc))
+    {
+        return {};
+    }
+    return sort_by_estimated_time(SoftmaxImplementationRegistry::create_list(device_info, desc));
+}
+}  // namespace
+
+const std::vector<libdml::SoftmaxPrimitive>& libdml::get_softmax_implementation_list(const DeviceInfo& device_info, const SoftmaxDescriptor& desc)
+{
+    static ImplementationListCache<SoftmaxDescriptor, SoftmaxPrimitive> cache(create_softmax_implementation_list);
+    return cache.get(device_info, desc);
+}
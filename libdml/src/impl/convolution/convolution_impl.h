@@ -1,9 +1,14 @@
 #pragma once
 #include <dml_convolution.hpp>
+#include "../impl_helpers.h"
+#include "../implementation_registry.h"
 
 #include <array>
+#include <optional>
 #include <initializer_list>
 #include <algorithm>
+#include <string>
+#include <cstdint>
 
 namespace libdml
 {
@@ -13,9 +18,70 @@ namespace libdml
 
     namespace conv_helpers
     {
-        inline bool is_supported_platform(HwPlatform platform, std::initializer_list<HwPlatform> supported_platforms)
+        using impl_helpers::is_supported_platform;
+        using impl_helpers::get_data_type_bytes_width;
+        using impl_helpers::get_elements_count;
+        using impl_helpers::get_bytes_width;
+        using impl_helpers::CostParams;
+
+        // 4D tensors with positive dims, known data types and valid post ops (none of the vectors overflowed), other descriptors are not supported by any implementation.
+        // Weights are (OC, IC / groups, KH, KW), group_count 0 is the same as 1.
+        inline bool is_valid_descriptor(const ConvolutionDescriptor& desc)
+        {
+            if (!impl_helpers::is_valid_tensor(desc.tensor_input, 4) || !impl_helpers::is_valid_tensor(desc.tensor_output, 4)
+                || !impl_helpers::is_valid_tensor(desc.tensor_weights, 4) || desc.strides.size() != 2
+                || desc.strides.has_overflow() || desc.dilations.has_overflow() || desc.start_padding.has_overflow() || desc.end_padding.has_overflow()
+                || !impl_helpers::is_valid_post_ops(desc.post_ops, desc.tensor_output))
+            {
+                return false;
+            }
+            const auto groups = static_cast<std::int32_t>(std::max(desc.group_count, 1u));
+            const auto& w = desc.tensor_weights.dims;
+            // backward (transposed) weights: IC, OC / groups, KH, KW
+            const auto& grouped_channels = desc.direction == ConvolutionDirection::eForward ? desc.tensor_input : desc.tensor_output;
+            const auto& full_channels = desc.direction == ConvolutionDirection::eForward ? desc.tensor_output : desc.tensor_input;
+            return grouped_channels.dims[TENSOR_DIMENSION_4D_C] == w[TENSOR_DIMENSION_4D_C] * groups
+                && full_channels.dims[TENSOR_DIMENSION_4D_C] == w[TENSOR_DIMENSION_4D_N] && w[TENSOR_DIMENSION_4D_N] % groups == 0;
+        }
+
+        inline std::uint64_t get_flops(const ConvolutionDescriptor& desc)
         {
-            return std::any_of(supported_platforms.begin(), supported_platforms.end(), [&platform](HwPlatform p) { return p == platform; });
+            // every weight is applied once per pixel of the output (forward) or of the input (backward)
+            const auto& pixels = desc.direction == ConvolutionDirection::eForward ? desc.tensor_output.dims : desc.tensor_input.dims;
+            const auto pixels_count = static_cast<std::uint64_t>(pixels[TENSOR_DIMENSION_4D_N]) * pixels[TENSOR_DIMENSION_4D_H] * pixels[TENSOR_DIMENSION_4D_W];
+            auto ret = 2 * get_elements_count(desc.tensor_weights) * pixels_count;
+            if (desc.tensor_bias.has_value())
+            {
+                ret += get_elements_count(desc.tensor_output);
+            }
+            return ret + impl_helpers::get_post_ops_flops(desc.post_ops, desc.tensor_output);
+        }
+
+        // Minimal traffic: every tensor read or written once.
+        inline std::uint64_t get_bytes(const ConvolutionDescriptor& desc)
+        {
+            auto ret = get_bytes_width(desc.tensor_input) + get_bytes_width(desc.tensor_weights) + get_bytes_width(desc.tensor_output);
+            if (desc.tensor_bias.has_value())
+            {
+                ret += get_bytes_width(*desc.tensor_bias);
+            }
+            return ret + impl_helpers::get_post_ops_bytes(desc.post_ops);
+        }
+
+        /*
+        *   Roofline estimate of the kernel.
+        *   Input reorder is a part of every execution, weights reorder is done once at load time, so it is not counted.
+        */
+        inline double estimate_time_us(const DeviceInfo& device_info, const ConvolutionDescriptor& desc, const CostParams& cost_params, const ConvolutionPrefferedLayout& layouts)
+        {
+            const auto peaks = impl_helpers::get_platform_peaks(device_info);
+            const auto is_fp16 = desc.tensor_input.data_type == DataType::eFp16;
+            auto ret = impl_helpers::estimate_roofline_time_us(peaks, get_flops(desc), get_bytes(desc), is_fp16, cost_params);
+            if (ret > 0.0 && desc.tensor_input.data_layout == DataLayout::eAny && layouts.input_layout.has_value())
+            {
+                ret += impl_helpers::get_reorder_time_us(desc.tensor_input, peaks);
+            }
+            return ret;
         }
     }
 
@@ -29,7 +95,62 @@ namespace libdml
         }
         virtual ~ConvolutionImplementation() = default;
 
-        virtual ConvolutionExecutionParams get_execution_map() const = 0;
+        // error_code (if not nullptr) is set to eGeneralError if the params can't be created (ex. scalars don't match the schema)
+        virtual ConvolutionExecutionParams get_execution_map(ErrorCode* error_code) const = 0;
+        virtual std::string get_name() const = 0;
+
+        virtual ConvolutionPrefferedLayout query_preffered_layouts() const
+        {
+            return {};
+        }
+
+        virtual KernelInfo get_kernel_info(const ConvolutionPrefferedLayout& layouts) const = 0;
+
+        virtual PostOpsSupport get_post_ops_support() const
+        {
+            return {};
+        }
+
+        // Runtime values of the kernel (ex. shapes, so one binary serves many shapes), see pack_scalars(...).
+        virtual ScalarsSchema get_scalars_schema() const
+        {
+            return {};
+        }
+
+        // Priority is relative to the other implementations, so it is filled by the primitive.
+        ImplementationInfo get_info() const
+        {
+            ImplementationInfo ret{};
+            ret.name = get_name();
+            ret.estimated_time_us = conv_helpers::estimate_time_us(device_info_, desc_, get_cost_params(), query_preffered_layouts());
+            return ret;
+        }
+
+    protected:
+        virtual conv_helpers::CostParams get_cost_params() const = 0;
+
+        // Values for the fields of get_scalars_schema(), false if any of the values was rejected by the packer.
+        virtual bool pack_scalars(ScalarsPacker& /*packer*/) const
+        {
+            return true;
+        }
+
+        // For get_execution_map(): packs the scalars and binds them at index, nothing to do if schema is empty.
+        bool add_scalars(ConvolutionExecutionParams& params, std::uint32_t index) const
+        {
+            const auto schema = get_scalars_schema();
+            if (schema.empty())
+            {
+                return true;
+            }
+            ScalarsPacker packer(schema, params.scalars_buffer);
+            if (!pack_scalars(packer))
+            {
+                return false;
+            }
+            params.params_map[CONVOLUTION_EXEC_PARAM_TYPE_SCALARS] = ExecParamInfo{ index };
+            return true;
+        }
 
     protected:
         DeviceInfo device_info_;
@@ -37,53 +158,336 @@ namespace libdml
     };
 
 
-    class ConvolutionExampleImplementation_0 : public ConvolutionImplementation
+    /*
+    *   Common part of the CM nchw fp16 convolutions (kernels: conv_nchw_fp16.cpp and conv_1x1_nchw_fp16.cpp).
+    *   Jits names have to match the kernels, tuning params are selected from the descriptor.
+    */
+    class ConvolutionCmNchwFp16ImplementationBase : public ConvolutionImplementation
     {
     public:
-        using ConvolutionImplementation::ConvolutionImplementation;
+        // both kernels use lsc messages
+        static constexpr ImplementationTraits traits{ to_mask(HwPlatform::eDG2), to_mask(DataType::eFp16), to_mask(DataLayout::eNCHW, DataLayout::eAny) };
+        // relu is applied on the accumulators before the store (use_relu scalar), other post ops are not implemented in the kernels
+        static constexpr PostOpsSupport post_ops_support{ to_mask(PostOpType::eActivation), to_mask(ActivationType::eRelu), 1 };
 
-        static bool is_supported_descriptor(const DeviceInfo& device_info, const ConvolutionDescriptor& desc)
+        // Fields of get_scalars_schema(), in order of the kernel arguments (after the surfaces).
+        enum ScalarsField : std::uint32_t
+        {
+            SCALARS_FIELD_USE_RELU = 0,
+
+            SCALARS_FIELD_COUNT
+        };
+
+    public:
+        struct Tuning
+        {
+            std::uint32_t block_w = 8;
+            std::uint32_t block_h = 1;
+            std::uint32_t block_oc = 8;
+            std::uint32_t block_batch = 1;
+            std::uint32_t slice_ic = 1;
+            std::array<std::uint32_t, 3> lws = { 1u, 1u, 1u };
+            KernelGrfCount grf_count = KernelGrfCount::e128;
+        };
+
+    public:
+        ConvolutionCmNchwFp16ImplementationBase(const DeviceInfo& device_info, const ConvolutionDescriptor& desc, Tuning tuning)
+            : ConvolutionImplementation(device_info, desc)
+            , tuning_(tuning)
         {
-            return false;
         }
 
-        ConvolutionExecutionParams get_execution_map() const override
+        ConvolutionExecutionParams get_execution_map(ErrorCode* error_code) const override
         {
             ConvolutionExecutionParams ret{};
-            ret.params_map[CONVOLUTION_EXEC_PARAM_TYPE_INPUT] = ExecParamInfo{ 0 };
-            ret.params_map[CONVOLUTION_EXEC_PARAM_TYPE_OUTPUT] = ExecParamInfo{ 1 };
-            ret.params_map[CONVOLUTION_EXEC_PARAM_TYPE_WEIGHTS] = ExecParamInfo{ 2 };
+            std::uint32_t index = 0;
+            ret.params_map[CONVOLUTION_EXEC_PARAM_TYPE_INPUT] = ExecParamInfo{ index++ };
+            ret.params_map[CONVOLUTION_EXEC_PARAM_TYPE_WEIGHTS] = ExecParamInfo{ index++ };
+            if (desc_.tensor_bias.has_value())
+            {
+                ret.params_map[CONVOLUTION_EXEC_PARAM_TYPE_BIAS] = ExecParamInfo{ index++ };
+            }
+            ret.params_map[CONVOLUTION_EXEC_PARAM_TYPE_OUTPUT] = ExecParamInfo{ index++ };
+            if (!add_scalars(ret, index))
+            {
+                if (error_code)
+                {
+                    *error_code = ErrorCode::eGeneralError;
+                }
+                return {};
+            }
+            return ret;
+        }
+
+        // Sizes stay jits (loops are unrolled with them), runtime values don't change the kernel binary (conv and conv + relu share it).
+        ScalarsSchema get_scalars_schema() const override
+        {
+            ScalarsSchema ret{};
+            ret.add_field("use_relu", ScalarType::eUint32);
+            return ret;
+        }
+
+        ConvolutionPrefferedLayout query_preffered_layouts() const override
+        {
+            ConvolutionPrefferedLayout ret{};
+            ret.weights_layout = get_optimal_weights_layout();
+            return ret;
+        }
+
+        // Weights are read in optimal format only if runtime agreed to reorder them (layouts.weights_layout is set to the preffered one).
+        KernelInfo get_kernel_info(const ConvolutionPrefferedLayout& layouts) const override
+        {
+            const auto& in = desc_.tensor_input.dims;
+            const auto& out = desc_.tensor_output.dims;
+            const auto optimal_weights_layout = get_optimal_weights_layout();
+            const auto weights_in_optimal_format = optimal_weights_layout.has_value() && layouts.weights_layout == optimal_weights_layout;
+
+            KernelInfo ret{};
+            ret.language = KernelLanguage::eCM;
+            ret.code = get_kernel_file_name();
+            auto add_jit = [&ret](const char* name, auto value)
+            {
+                ret.jits.push_back(Jit{ name, std::to_string(value) });
+            };
+            ret.jits.push_back(Jit{ "DT_ACCU", desc_.datatype_accumulator == DataType::eFp16 ? "half" : "float" });
+            add_jit("INPUT_WIDTH", in[TENSOR_DIMENSION_4D_W]);
+            add_jit("INPUT_HEIGHT", in[TENSOR_DIMENSION_4D_H]);
+            add_jit("INPUT_CHANNELS", in[TENSOR_DIMENSION_4D_C]);
+            add_jit("OUTPUT_WIDTH", out[TENSOR_DIMENSION_4D_W]);
+            add_jit("OUTPUT_HEIGHT", out[TENSOR_DIMENSION_4D_H]);
+            add_jit("OUTPUT_CHANNELS", out[TENSOR_DIMENSION_4D_C]);
+            add_jit("BATCH", in[TENSOR_DIMENSION_4D_N]);
+            add_jit("INPUT_PAD", desc_.start_padding[TENSOR_DIMENSION_2D_H]);
+            add_jit("OUTPUT_PAD", 0);
+            add_jit("USE_BIAS", static_cast<std::int32_t>(desc_.tensor_bias.has_value()));
+            add_jit("KERNEL_SIZE", get_kernel_size());
+            add_jit("STRIDE_W", desc_.strides[TENSOR_DIMENSION_2D_W]);
+            add_jit("STRIDE_H", desc_.strides[TENSOR_DIMENSION_2D_H]);
+            add_jit("SLICE_IC", tuning_.slice_ic);
+            add_jit("BLOCK_W", tuning_.block_w);
+            add_jit("BLOCK_H", tuning_.block_h);
+            add_jit("BLOCK_OC", tuning_.block_oc);
+            add_jit("BLOCK_BATCH", tuning_.block_batch);
+            add_jit("WEIGHTS_IN_OPTIMAL_FORMAT", static_cast<std::int32_t>(weights_in_optimal_format));
+
+            // slice_ic threads cooperate on the same outputs, they have to be in the same thread group
+            ret.gws = get_gws();
+            ret.lws = { tuning_.lws[0] * tuning_.slice_ic, tuning_.lws[1], tuning_.lws[2] };
+            ret.grf_count = tuning_.grf_count;
             return ret;
         }
+
+        PostOpsSupport get_post_ops_support() const override
+        {
+            return post_ops_support;
+        }
+
+    protected:
+        bool pack_scalars(ScalarsPacker& packer) const override
+        {
+            // only relu is supported (see post_ops_support)
+            return packer.set_uint32(SCALARS_FIELD_USE_RELU, desc_.post_ops.empty() ? 0u : 1u);
+        }
+
+        virtual const char* get_kernel_file_name() const = 0;
+        // nullopt if kernel has to read weights in the original layout (reorder is not possible for the shape)
+        virtual std::optional<DataLayout> get_optimal_weights_layout() const = 0;
+
+        // common requirements of both kernels (on top of traits): fp16, nchw, no groups, no dilations, symmetric padding and fusable post ops
+        static bool is_supported_common(const DeviceInfo& /*device_info*/, const ConvolutionDescriptor& desc)
+        {
+            for (const auto* tensor : { &desc.tensor_input, &desc.tensor_output, &desc.tensor_weights })
+            {
+                if (tensor->data_type != DataType::eFp16)
+                {
+                    return false;
+                }
+            }
+            for (const auto* tensor : { &desc.tensor_input, &desc.tensor_output })
+            {
+                if (tensor->data_layout != DataLayout::eNCHW && tensor->data_layout != DataLayout::eAny)
+                {
+                    return false;
+                }
+            }
+            if (desc.tensor_bias.has_value() && desc.tensor_bias->data_type != DataType::eFp16)
+            {
+                return false;
+            }
+            if (desc.direction != ConvolutionDirection::eForward || desc.group_count > 1 || !impl_helpers::is_supported_post_ops(post_ops_support, desc.post_ops))
+            {
+                return false;
+            }
+            if (std::any_of(desc.dilations.begin(), desc.dilations.end(), [](std::int32_t d) { return d > 1; }))
+            {
+                return false;
+            }
+            if (desc.start_padding.size() != 2 || desc.end_padding != desc.start_padding || desc.start_padding[0] != desc.start_padding[1])
+            {
+                return false;
+            }
+            const auto& w = desc.tensor_weights.dims;
+            return w[TENSOR_DIMENSION_4D_H] == w[TENSOR_DIMENSION_4D_W];
+        }
+
+        std::int32_t get_kernel_size() const
+        {
+            return desc_.tensor_weights.dims[TENSOR_DIMENSION_4D_W];
+        }
+
+        std::array<std::uint32_t, 3> get_gws() const
+        {
+            const auto& out = desc_.tensor_output.dims;
+            const auto round_up_div = [](std::uint32_t a, std::uint32_t b) { return (a + b - 1) / b; };
+            return {
+                tuning_.slice_ic * round_up_div(out[TENSOR_DIMENSION_4D_W], tuning_.block_w),
+                round_up_div(out[TENSOR_DIMENSION_4D_H], tuning_.block_h),
+                (out[TENSOR_DIMENSION_4D_N] / tuning_.block_batch) * (out[TENSOR_DIMENSION_4D_C] / tuning_.block_oc)
+            };
+        }
+
+        conv_helpers::CostParams get_cost_params_for_efficiency(double compute_efficiency, bool uses_systolic) const
+        {
+            const auto gws = get_gws();
+            conv_helpers::CostParams ret{};
+            ret.hw_threads_count = static_cast<std::uint64_t>(gws[0]) * gws[1] * gws[2];
+            ret.compute_efficiency = compute_efficiency;
+            ret.uses_systolic = uses_systolic;
+            return ret;
+        }
+
+    protected:
+        Tuning tuning_;
     };
 
-    class ConvolutionExampleImplementation_1 : public ConvolutionImplementation
+    /*
+    *   Dpas based 1x1 convolution (conv_1x1_nchw_fp16.cpp).
+    */
+    class ConvolutionCm1x1NchwFp16Implementation : public ConvolutionCmNchwFp16ImplementationBase
     {
     public:
-        using ConvolutionImplementation::ConvolutionImplementation;
+        ConvolutionCm1x1NchwFp16Implementation(const DeviceInfo& device_info, const ConvolutionDescriptor& desc)
+            : ConvolutionCmNchwFp16ImplementationBase(device_info, desc, select_tuning(desc))
+        {
+        }
 
         static bool is_supported_descriptor(const DeviceInfo& device_info, const ConvolutionDescriptor& desc)
         {
-            if (!conv_helpers::is_supported_platform(device_info.platform, {HwPlatform::eDG2, HwPlatform::eTGL, HwPlatform::eADL}))
+            if (!is_supported_common(device_info, desc))
             {
                 return false;
             }
-            return true;
+            // ToDo: kernel has no bias support yet (USE_BIAS branch of the store is #error)
+            if (desc.tensor_bias.has_value())
+            {
+                return false;
+            }
+            const auto& w = desc.tensor_weights.dims;
+            // dpas depth is 16 fp16 input channels, dpas exec size is 8 output channels
+            return w[TENSOR_DIMENSION_4D_H] == 1 && desc.tensor_input.dims[TENSOR_DIMENSION_4D_C] % 16 == 0 && desc.tensor_output.dims[TENSOR_DIMENSION_4D_C] % 8 == 0;
         }
 
-        ConvolutionExecutionParams get_execution_map() const override
+        std::string get_name() const override
         {
-            ConvolutionExecutionParams ret{};
-            ret.params_map[CONVOLUTION_EXEC_PARAM_TYPE_INPUT] = ExecParamInfo{ 0 };
-            ret.params_map[CONVOLUTION_EXEC_PARAM_TYPE_OUTPUT] = ExecParamInfo{ 1 };
-            ret.params_map[CONVOLUTION_EXEC_PARAM_TYPE_WEIGHTS] = ExecParamInfo{ 2 };
-            if (desc_.tensor_bias.has_value())
+            return "conv_1x1_nchw_fp16";
+        }
+
+    protected:
+        static Tuning select_tuning(const ConvolutionDescriptor& desc)
+        {
+            const auto& out = desc.tensor_output.dims;
+            Tuning ret{};
+            ret.block_w = std::min<std::uint32_t>(8, out[TENSOR_DIMENSION_4D_W]);
+            ret.block_oc = out[TENSOR_DIMENSION_4D_C] % 16 == 0 ? 16 : 8;
+            // two threads per group share input rows (same width and height chunk, different output channels)
+            const auto gws_z = out[TENSOR_DIMENSION_4D_N] * (out[TENSOR_DIMENSION_4D_C] / ret.block_oc);
+            ret.lws = { 1u, 1u, gws_z % 2 == 0 ? 2u : 1u };
+            // full 8x16 accumulators and prefetched weights don't fit into 128 registers without spills
+            ret.grf_count = ret.block_oc * ret.block_w >= 128 ? KernelGrfCount::e256 : KernelGrfCount::e128;
+            return ret;
+        }
+
+        const char* get_kernel_file_name() const override
+        {
+            return "conv_1x1_nchw_fp16.cpp";
+        }
+
+        std::optional<DataLayout> get_optimal_weights_layout() const override
+        {
+            // weights reorder to io_i8_o8_i2 handles 128 input channels per hw thread, tails are not reordered
+            if (desc_.tensor_input.dims[TENSOR_DIMENSION_4D_C] % 128 != 0)
+            {
+                return std::nullopt;
+            }
+            return DataLayout::eIO_i8_o8_i2;
+        }
+
+        conv_helpers::CostParams get_cost_params() const override
+        {
+            return get_cost_params_for_efficiency(0.6, true);
+        }
+    };
+
+    /*
+    *   Convolution for small input channels count (not fitting dpas depth), ex. first layer of the network (conv_nchw_fp16.cpp).
+    */
+    class ConvolutionCmNchwFp16Implementation : public ConvolutionCmNchwFp16ImplementationBase
+    {
+    public:
+        ConvolutionCmNchwFp16Implementation(const DeviceInfo& device_info, const ConvolutionDescriptor& desc)
+            : ConvolutionCmNchwFp16ImplementationBase(device_info, desc, select_tuning(desc))
+        {
+        }
+
+        static bool is_supported_descriptor(const DeviceInfo& device_info, const ConvolutionDescriptor& desc)
+        {
+            if (!is_supported_common(device_info, desc))
             {
-                ret.params_map[CONVOLUTION_EXEC_PARAM_TYPE_BIAS] = ExecParamInfo{ 3 };
+                return false;
             }
+            // weights reorder supports o8 and o16 blocks
+            return desc.tensor_input.dims[TENSOR_DIMENSION_4D_C] < 16 && desc.tensor_output.dims[TENSOR_DIMENSION_4D_C] % 8 == 0;
+        }
+
+        std::string get_name() const override
+        {
+            return "conv_nchw_fp16";
+        }
+
+    protected:
+        static Tuning select_tuning(const ConvolutionDescriptor& desc)
+        {
+            const auto& out = desc.tensor_output.dims;
+            Tuning ret{};
+            ret.block_w = std::min<std::uint32_t>(8, out[TENSOR_DIMENSION_4D_W]);
+            ret.block_oc = out[TENSOR_DIMENSION_4D_C] % 16 == 0 ? 16 : 8;
             return ret;
         }
+
+        const char* get_kernel_file_name() const override
+        {
+            return "conv_nchw_fp16.cpp";
+        }
+
+        std::optional<DataLayout> get_optimal_weights_layout() const override
+        {
+            return tuning_.block_oc == 16 ? DataLayout::eOYXI_o16 : DataLayout::eOYXI_o8;
+        }
+
+        conv_helpers::CostParams get_cost_params() const override
+        {
+            return get_cost_params_for_efficiency(0.3, false);
+        }
     };
 
 
-}
\ No newline at end of file
+    inline const Tensor& get_registry_tensor(const ConvolutionDescriptor& desc)
+    {
+        return desc.tensor_input;
+    }
+
+    using ConvolutionImplementationRegistry = ImplementationRegistry<ConvolutionPrimitive, ConvolutionDescriptor,
+        ConvolutionCm1x1NchwFp16Implementation,
+        ConvolutionCmNchwFp16Implementation>;
+
+}
@@ -0,0 +1,566 @@
+#pragma once
+#include <dml_gemm.hpp>
+#include "../impl_helpers.h"
+#include "../implementation_registry.h"
+
+#include <array>
+#include <string>
+#include <cstdint>
+
+namespace libdml
+{
+    namespace gemm_helpers
+    {
+        // Logical gemm sizes: B x C independent gemms of [M, K] x [K, N].
+        struct GemmSizes
+        {
+            std::uint32_t b = 0;
+            std::uint32_t c = 0;
+            std::uint32_t m = 0;
+            std::uint32_t k = 0;
+            std::uint32_t n = 0;
+        };
+
+        inline bool is_stacked_input_a(GemmType type)
+        {
+            return type == GemmType::eQK_QKV || type == GemmType::eQK_Q_KV;
+        }
+
+        inline bool is_stacked_input_b(GemmType type)
+        {
+            return type != GemmType::eAB && type != GemmType::eQK_QKV;
+        }
+
+        inline std::uint32_t get_expected_stacked_tensors(GemmType type, bool input_a)
+        {
+            switch (type)
+            {
+            case GemmType::eQK_QKV: return 3;
+            case GemmType::eSV_S_QKV: return 3;
+            case GemmType::eQK_Q_KV: return input_a ? 1 : 2;
+            case GemmType::eSV_S_KV: return 2;
+            default:
+                return 0;
+            }
+        }
+
+        inline bool is_valid_descriptor(const GemmDescriptor& desc)
+        {
+            const auto has_b = desc.type != GemmType::eQK_QKV;
+            if (has_b != desc.tensor_b.has_value() || !impl_helpers::is_valid_tensor(desc.tensor_output, 4))
+            {
+                return false;
+            }
+
+            auto is_valid_input = [&](const Tensor& tensor, bool stacked, bool input_a)
+            {
+                if (!stacked)
+                {
+                    return impl_helpers::is_valid_tensor(tensor, 4);
+                }
+                return impl_helpers::is_valid_tensor(tensor, 5)
+                    && static_cast<std::uint32_t>(tensor.dims[TENSOR_DIMENSION_STACKED_TENSORS]) == get_expected_stacked_tensors(desc.type, input_a);
+            };
+            if (!is_valid_input(desc.tensor_a, is_stacked_input_a(desc.type), true))
+            {
+                return false;
+            }
+            return !has_b || is_valid_input(*desc.tensor_b, is_stacked_input_b(desc.type), false);
+        }
+
+        // Descriptor has to be valid.
+        inline GemmSizes get_sizes(const GemmDescriptor& desc)
+        {
+            const auto& a = desc.tensor_a.dims;
+            GemmSizes ret{};
+            switch (desc.type)
+            {
+            case GemmType::eAB:
+            case GemmType::eSV_S_QKV:
+            case GemmType::eSV_S_KV:
+            {
+                ret.b = a[TENSOR_DIMENSION_4D_N];
+                ret.c = a[TENSOR_DIMENSION_4D_C];
+                ret.m = a[TENSOR_DIMENSION_4D_H];
+                ret.k = a[TENSOR_DIMENSION_4D_W];
+                const auto& b = desc.tensor_b->dims;
+                ret.n = desc.type == GemmType::eAB ? b[TENSOR_DIMENSION_4D_W] : b[TENSOR_DIMENSION_STACKED_HEAD_SIZE];
+                break;
+            }
+            case GemmType::eQK_QKV:
+                ret.b = a[TENSOR_DIMENSION_STACKED_BATCH];
+                ret.c = a[TENSOR_DIMENSION_STACKED_NUM_HEADS];
+                ret.m = a[TENSOR_DIMENSION_STACKED_SEQ_LEN];
+                ret.k = a[TENSOR_DIMENSION_STACKED_HEAD_SIZE];
+                ret.n = a[TENSOR_DIMENSION_STACKED_SEQ_LEN];
+                break;
+            case GemmType::eQK_Q_KV:
+            {
+                const auto& b = desc.tensor_b->dims;
+                ret.b = a[TENSOR_DIMENSION_STACKED_BATCH];
+                ret.c = b[TENSOR_DIMENSION_STACKED_NUM_HEADS];
+                ret.m = a[TENSOR_DIMENSION_STACKED_SEQ_LEN];
+                ret.k = b[TENSOR_DIMENSION_STACKED_HEAD_SIZE];
+                ret.n = b[TENSOR_DIMENSION_STACKED_SEQ_LEN];
+                break;
+            }
+            default:
+                break;
+            }
+            return ret;
+        }
+
+        // Output has to be [B, C, M, N].
+        inline bool is_output_matching(const GemmDescriptor& desc)
+        {
+            const auto sizes = get_sizes(desc);
+            const auto& out = desc.tensor_output.dims;
+            return static_cast<std::uint32_t>(out[TENSOR_DIMENSION_4D_N]) == sizes.b && static_cast<std::uint32_t>(out[TENSOR_DIMENSION_4D_C]) == sizes.c
+                && static_cast<std::uint32_t>(out[TENSOR_DIMENSION_4D_H]) == sizes.m && static_cast<std::uint32_t>(out[TENSOR_DIMENSION_4D_W]) == sizes.n;
+        }
+
+        inline std::uint64_t get_flops(const GemmDescriptor& desc)
+        {
+            const auto sizes = get_sizes(desc);
+            return 2ull * sizes.b * sizes.c * sizes.m * sizes.k * sizes.n;
+        }
+
+        // Minimal traffic: every tensor read or written once (stacked tensors are counted fully).
+        inline std::uint64_t get_bytes(const GemmDescriptor& desc)
+        {
+            auto ret = impl_helpers::get_bytes_width(desc.tensor_a) + impl_helpers::get_bytes_width(desc.tensor_output);
+            if (desc.tensor_b.has_value())
+            {
+                ret += impl_helpers::get_bytes_width(*desc.tensor_b);
+            }
+            return ret;
+        }
+
+        inline double estimate_time_us(const DeviceInfo& device_info, const GemmDescriptor& desc, const impl_helpers::CostParams& cost_params)
+        {
+            const auto peaks = impl_helpers::get_platform_peaks(device_info);
+            const auto is_fp16 = desc.tensor_a.data_type == DataType::eFp16;
+            return impl_helpers::estimate_roofline_time_us(peaks, get_flops(desc), get_bytes(desc), is_fp16, cost_params);
+        }
+
+        inline bool is_power_of_2(std::uint32_t value)
+        {
+            return value > 0 && (value & (value - 1)) == 0;
+        }
+    }
+
+    /*
+    *   Stateless interface of gemm implementation.
+    */
+    class GemmImplementation
+    {
+    public:
+        GemmImplementation(const DeviceInfo& device_info, const GemmDescriptor& desc)
+            : device_info_(device_info)
+            , desc_(desc)
+        {
+        }
+        virtual ~GemmImplementation() = default;
+
+        virtual GemmExecutionParams get_execution_map() const
+        {
+            GemmExecutionParams ret{};
+            ret.params_map[GEMM_EXEC_PARAM_TYPE_INPUT_A] = ExecParamInfo{ 0 };
+            if (desc_.tensor_b.has_value())
+            {
+                ret.params_map[GEMM_EXEC_PARAM_TYPE_INPUT_B] = ExecParamInfo{ 1 };
+                ret.params_map[GEMM_EXEC_PARAM_TYPE_OUTPUT] = ExecParamInfo{ 2 };
+            }
+            else
+            {
+                ret.params_map[GEMM_EXEC_PARAM_TYPE_OUTPUT] = ExecParamInfo{ 1 };
+            }
+            return ret;
+        }
+
+        virtual std::string get_name() const = 0;
+        virtual KernelInfo get_kernel_info() const = 0;
+
+        // Priority is relative to the other implementations, so it is filled by the primitive.
+        ImplementationInfo get_info() const
+        {
+            ImplementationInfo ret{};
+            ret.name = get_name();
+            ret.estimated_time_us = gemm_helpers::estimate_time_us(device_info_, desc_, get_cost_params());
+            return ret;
+        }
+
+    protected:
+        virtual impl_helpers::CostParams get_cost_params() const = 0;
+
+    protected:
+        DeviceInfo device_info_;
+        GemmDescriptor desc_;
+    };
+
+    /*
+    *   Common part of the CM multi-head attention gemms (kernels: mha_*_gemm_fp16.cpp).
+    *   Jits names have to match the kernels, tiles are selected from the descriptor by the derived classes.
+    */
+    class GemmCmMhaImplementationBase : public GemmImplementation
+    {
+    public:
+        // kernels use lsc messages
+        static constexpr ImplementationTraits traits{ to_mask(HwPlatform::eDG2), to_mask(DataType::eFp16), all_mask };
+
+    public:
+        struct Tuning
+        {
+            std::uint32_t tile_m = 0;
+            std::uint32_t tile_k = 0;
+            std::uint32_t tile_n = 0;
+            std::uint32_t slice_k = 1;
+            std::array<std::uint32_t, 3> lws = { 1u, 1u, 1u };
+            KernelGrfCount grf_count = KernelGrfCount::e256;
+        };
+
+    public:
+        GemmCmMhaImplementationBase(const DeviceInfo& device_info, const GemmDescriptor& desc, Tuning tuning)
+            : GemmImplementation(device_info, desc)
+            , tuning_(tuning)
+        {
+        }
+
+        KernelInfo get_kernel_info() const override
+        {
+            const auto sizes = gemm_helpers::get_sizes(desc_);
+            const auto& stacked = desc_.type == GemmType::eQK_QKV ? desc_.tensor_a.dims : desc_.tensor_b->dims;
+
+            KernelInfo ret{};
+            ret.language = KernelLanguage::eCM;
+            ret.code = get_kernel_file_name();
+            auto add_jit = [&ret](const char* name, auto value)
+            {
+                ret.jits.push_back(Jit{ name, std::to_string(value) });
+            };
+            add_jit("SIZE_B", sizes.b);
+            add_jit("SIZE_C", sizes.c);
+            add_jit("SIZE_M", sizes.m);
+            add_jit("SIZE_K", sizes.k);
+            add_jit("SIZE_N", sizes.n);
+
+            add_jit("SIZE_BATCH", stacked[TENSOR_DIMENSION_STACKED_BATCH]);
+            add_jit("SIZE_SEQ_LEN", stacked[TENSOR_DIMENSION_STACKED_SEQ_LEN]);
+            add_jit("SIZE_NUM_HEADS", stacked[TENSOR_DIMENSION_STACKED_NUM_HEADS]);
+            add_jit("SIZE_STACKED_TENSORS", stacked[TENSOR_DIMENSION_STACKED_TENSORS]);
+            add_jit("SIZE_HEAD_SIZE", stacked[TENSOR_DIMENSION_STACKED_HEAD_SIZE]);
+
+            ret.jits.push_back(Jit{ "SCALE", impl_helpers::to_jit_value(desc_.alpha) });
+            ret.jits.push_back(Jit{ "DT", "half" });
+
+            add_jit("TILE_K", tuning_.tile_k);
+            add_jit("TILE_N", tuning_.tile_n);
+            add_jit("TILE_M", tuning_.tile_m);
+            add_jit("SLICE_K", tuning_.slice_k);
+
+            add_jit("ACCU_IS_FP32", static_cast<std::int32_t>(desc_.datatype_accumulator == DataType::eFp32));
+            add_jit("FUSE_SOFTMAX", static_cast<std::int32_t>(desc_.fuse_softmax));
+
+            ret.gws = get_gws();
+            ret.lws = tuning_.lws;
+            ret.grf_count = tuning_.grf_count;
+            return ret;
+        }
+
+    protected:
+        virtual const char* get_kernel_file_name() const = 0;
+
+        std::array<std::uint32_t, 3> get_gws() const
+        {
+            return get_gws(desc_, tuning_);
+        }
+
+        // QK over stacked QKV walks N first, other kernels M first.
+        static std::array<std::uint32_t, 3> get_gws(const GemmDescriptor& desc, const Tuning& tuning)
+        {
+            const auto sizes = gemm_helpers::get_sizes(desc);
+            const auto gws_m = sizes.m / tuning.tile_m;
+            const auto gws_n = sizes.n / tuning.tile_n;
+            const auto gws_z = sizes.b * sizes.c * tuning.slice_k;
+            if (desc.type == GemmType::eQK_QKV)
+            {
+                return { gws_n, gws_m, gws_z };
+            }
+            return { gws_m, gws_n, gws_z };
+        }
+
+        // fp16 only, softmax fusion and beta are not implemented by the kernels yet
+        static bool is_supported_common(const DeviceInfo& /*device_info*/, const GemmDescriptor& desc, GemmType type)
+        {
+            if (desc.type != type)
+            {
+                return false;
+            }
+            if (desc.fuse_softmax || desc.beta != 0.0f)
+            {
+                return false;
+            }
+            if (desc.datatype_accumulator != DataType::eFp16 && desc.datatype_accumulator != DataType::eFp32)
+            {
+                return false;
+            }
+            if (desc.tensor_a.data_type != DataType::eFp16 || desc.tensor_output.data_type != DataType::eFp16
+                || (desc.tensor_b.has_value() && desc.tensor_b->data_type != DataType::eFp16))
+            {
+                return false;
+            }
+            return gemm_helpers::is_output_matching(desc);
+        }
+
+        static bool is_tuning_valid(const GemmDescriptor& desc, const Tuning& tuning)
+        {
+            const auto sizes = gemm_helpers::get_sizes(desc);
+            if (tuning.tile_m == 0 || tuning.tile_k == 0 || tuning.tile_n == 0 || tuning.slice_k == 0)
+            {
+                return false;
+            }
+            if (sizes.m % tuning.tile_m != 0 || sizes.k % tuning.tile_k != 0 || sizes.n % tuning.tile_n != 0)
+            {
+                return false;
+            }
+            const auto gws = get_gws(desc, tuning);
+            for (std::size_t i = 0; i < gws.size(); i++)
+            {
+                if (gws[i] == 0 || gws[i] % tuning.lws[i] != 0)
+                {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        impl_helpers::CostParams get_cost_params_for_efficiency(double compute_efficiency) const
+        {
+            const auto gws = get_gws();
+            impl_helpers::CostParams ret{};
+            ret.hw_threads_count = static_cast<std::uint64_t>(gws[0]) * gws[1] * gws[2];
+            ret.compute_efficiency = compute_efficiency;
+            // kernels use vector fmas (no dpas)
+            ret.uses_systolic = false;
+            return ret;
+        }
+
+    protected:
+        Tuning tuning_;
+    };
+
+    /*
+    *   Q x K^T with Q and K read from the stacked QKV tensor.
+    */
+    class GemmCmQkQkvImplementation : public GemmCmMhaImplementationBase
+    {
+    public:
+        GemmCmQkQkvImplementation(const DeviceInfo& device_info, const GemmDescriptor& desc)
+            : GemmCmMhaImplementationBase(device_info, desc, select_tuning(desc))
+        {
+        }
+
+        static bool is_supported_descriptor(const DeviceInfo& device_info, const GemmDescriptor& desc)
+        {
+            return is_supported_common(device_info, desc, GemmType::eQK_QKV) && is_tuning_valid(desc, select_tuning(desc));
+        }
+
+        std::string get_name() const override
+        {
+            return "mha_qk_qkv_gemm_fp16";
+        }
+
+    protected:
+        static Tuning select_tuning(const GemmDescriptor& desc)
+        {
+            const auto sizes = gemm_helpers::get_sizes(desc);
+            Tuning ret{};
+            ret.grf_count = KernelGrfCount::e256;
+            ret.tile_k = sizes.k == 40 ? 40 : 80;
+            ret.tile_n = 64;
+            ret.tile_m = sizes.m <= 256 ? 16 : 8;
+            // threads slicing K reduce partial results through slm, so they have to be in one thread group
+            ret.slice_k = sizes.k / ret.tile_k;
+            ret.lws[2] = ret.slice_k;
+            const auto gws_m = ret.tile_m > 0 ? sizes.m / ret.tile_m : 0;
+            if (ret.slice_k == 1 && gws_m % 16 == 0)
+            {
+                ret.lws[1] = 16;
+            }
+            return ret;
+        }
+
+        const char* get_kernel_file_name() const override
+        {
+            return "mha_qk_qkv_gemm_fp16.cpp";
+        }
+
+        impl_helpers::CostParams get_cost_params() const override
+        {
+            return get_cost_params_for_efficiency(0.5);
+        }
+    };
+
+    /*
+    *   S x V with V read from the stacked QKV tensor.
+    */
+    class GemmCmSvSQkvImplementation : public GemmCmMhaImplementationBase
+    {
+    public:
+        GemmCmSvSQkvImplementation(const DeviceInfo& device_info, const GemmDescriptor& desc)
+            : GemmCmMhaImplementationBase(device_info, desc, select_tuning(desc))
+        {
+        }
+
+        static bool is_supported_descriptor(const DeviceInfo& device_info, const GemmDescriptor& desc)
+        {
+            return is_supported_common(device_info, desc, GemmType::eSV_S_QKV) && is_tuning_valid(desc, select_tuning(desc));
+        }
+
+        std::string get_name() const override
+        {
+            return "mha_sv_s_qkv_gemm_fp16";
+        }
+
+    protected:
+        static Tuning select_tuning(const GemmDescriptor& desc)
+        {
+            const auto sizes = gemm_helpers::get_sizes(desc);
+            Tuning ret{};
+            ret.grf_count = KernelGrfCount::e128;
+            // kernel has paths only for 40 and 80 wide tiles
+            ret.tile_n = sizes.n == 40 ? 40 : 80;
+            // bigger tile_n needs smaller tile_m to not spill registers
+            ret.tile_m = ret.tile_n == 40 ? 16 : 8;
+            ret.tile_k = ((sizes.k > 64) && (sizes.k % 16 == 0)) ? 16 : 8;
+            ret.slice_k = 1;
+            ret.lws[0] = ret.tile_k;
+            return ret;
+        }
+
+        const char* get_kernel_file_name() const override
+        {
+            return "mha_sv_s_qkv_gemm_fp16.cpp";
+        }
+
+        impl_helpers::CostParams get_cost_params() const override
+        {
+            return get_cost_params_for_efficiency(0.4);
+        }
+    };
+
+    /*
+    *   Q x K^T with K read from the stacked KV tensor (cross attention, ex. SD1.5 with seq_kv 77).
+    */
+    class GemmCmQkQKvImplementation : public GemmCmMhaImplementationBase
+    {
+    public:
+        GemmCmQkQKvImplementation(const DeviceInfo& device_info, const GemmDescriptor& desc)
+            : GemmCmMhaImplementationBase(device_info, desc, select_tuning(desc))
+        {
+        }
+
+        static bool is_supported_descriptor(const DeviceInfo& device_info, const GemmDescriptor& desc)
+        {
+            if (!is_supported_common(device_info, desc, GemmType::eQK_Q_KV))
+            {
+                return false;
+            }
+            // whole N is a single tile
+            const auto n = gemm_helpers::get_sizes(desc).n;
+            return (n == 77 || (gemm_helpers::is_power_of_2(n) && n <= 128)) && is_tuning_valid(desc, select_tuning(desc));
+        }
+
+        std::string get_name() const override
+        {
+            return "mha_qk_q_kv_gemm_fp16";
+        }
+
+    protected:
+        static Tuning select_tuning(const GemmDescriptor& desc)
+        {
+            const auto sizes = gemm_helpers::get_sizes(desc);
+            Tuning ret{};
+            ret.grf_count = KernelGrfCount::e256;
+            ret.tile_k = sizes.k;
+            ret.tile_n = sizes.n;
+            ret.tile_m = 8;
+            ret.slice_k = 1;
+            return ret;
+        }
+
+        const char* get_kernel_file_name() const override
+        {
+            return "mha_qk_q_kv_gemm_fp16.cpp";
+        }
+
+        impl_helpers::CostParams get_cost_params() const override
+        {
+            return get_cost_params_for_efficiency(0.5);
+        }
+    };
+
+    /*
+    *   S x V with V read from the stacked KV tensor.
+    */
+    class GemmCmSvSKvImplementation : public GemmCmMhaImplementationBase
+    {
+    public:
+        GemmCmSvSKvImplementation(const DeviceInfo& device_info, const GemmDescriptor& desc)
+            : GemmCmMhaImplementationBase(device_info, desc, select_tuning(desc))
+        {
+        }
+
+        static bool is_supported_descriptor(const DeviceInfo& device_info, const GemmDescriptor& desc)
+        {
+            if (!is_supported_common(device_info, desc, GemmType::eSV_S_KV))
+            {
+                return false;
+            }
+            // whole K is a single tile
+            const auto k = gemm_helpers::get_sizes(desc).k;
+            return (k == 77 || (gemm_helpers::is_power_of_2(k) && k <= 128)) && is_tuning_valid(desc, select_tuning(desc));
+        }
+
+        std::string get_name() const override
+        {
+            return "mha_sv_s_kv_gemm_fp16";
+        }
+
+    protected:
+        static Tuning select_tuning(const GemmDescriptor& desc)
+        {
+            const auto sizes = gemm_helpers::get_sizes(desc);
+            Tuning ret{};
+            ret.grf_count = KernelGrfCount::e256;
+            ret.tile_k = sizes.k;
+            ret.tile_n = sizes.n == 40 ? 40 : 80;
+            ret.tile_m = 8;
+            ret.slice_k = 1;
+            return ret;
+        }
+
+        const char* get_kernel_file_name() const override
+        {
+            return "mha_sv_s_kv_gemm_fp16.cpp";
+        }
+
+        impl_helpers::CostParams get_cost_params() const override
+        {
+            return get_cost_params_for_efficiency(0.4);
+        }
+    };
+
+
+    inline const Tensor& get_registry_tensor(const GemmDescriptor& desc)
+    {
+        return desc.tensor_a;
+    }
+
+    using GemmImplementationRegistry = ImplementationRegistry<GemmPrimitive, GemmDescriptor,
+        GemmCmQkQkvImplementation,
+        GemmCmSvSQkvImplementation,
+        GemmCmQkQKvImplementation,
+        GemmCmSvSKvImplementation>;
+
+}
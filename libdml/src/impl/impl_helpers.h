@@ -0,0 +1,290 @@
+#pragma once
+#include <dml_types.hpp>
+
+#include <initializer_list>
+#include <algorithm>
+#include <string>
+#include <sstream>
+#include <iomanip>
+#include <limits>
+#include <cstdint>
+
+namespace libdml
+{
+    /*
+    *   Helpers shared by the implementations of all primitives (tensors sizes and the analytic cost model).
+    */
+    namespace impl_helpers
+    {
+        inline bool is_supported_platform(HwPlatform platform, std::initializer_list<HwPlatform> supported_platforms)
+        {
+            return std::any_of(supported_platforms.begin(), supported_platforms.end(), [&platform](HwPlatform p) { return p == platform; });
+        }
+
+        inline std::uint32_t get_data_type_bytes_width(DataType dt)
+        {
+            switch (dt)
+            {
+            case DataType::eFp32:
+            case DataType::eUint32:
+            case DataType::eInt32: return 4;
+            case DataType::eFp16: return 2;
+            case DataType::eUint8:
+            case DataType::eInt8: return 1;
+            default:
+                return 0;
+            }
+        }
+
+        inline std::uint64_t get_elements_count(const Tensor& tensor)
+        {
+            std::uint64_t ret = 1;
+            for (const auto d : tensor.dims)
+            {
+                ret *= static_cast<std::uint64_t>(d);
+            }
+            return ret;
+        }
+
+        inline std::uint64_t get_bytes_width(const Tensor& tensor)
+        {
+            return get_elements_count(tensor) * get_data_type_bytes_width(tensor.data_type);
+        }
+
+        // Positive dims, given rank (dims didn't overflow capacity) and known data type.
+        inline bool is_valid_tensor(const Tensor& tensor, std::size_t rank)
+        {
+            return !tensor.dims.has_overflow() && tensor.dims.size() == rank && std::all_of(tensor.dims.begin(), tensor.dims.end(), [](std::int32_t d) { return d > 0; })
+                && get_data_type_bytes_width(tensor.data_type) > 0;
+        }
+
+        /*
+        *   Every post op has exactly the params of its type (see PostOp), tensors match the output dims (or its channels)
+        *   and downconvert is the last post op, converting to the output data type.
+        */
+        inline bool is_valid_post_ops(const PostOps& post_ops, const Tensor& output)
+        {
+            if (post_ops.has_overflow())
+            {
+                return false;
+            }
+            const auto rank = output.dims.size();
+            const auto is_per_channel = [&](const Tensor& tensor)
+            {
+                if (rank < 2 || !is_valid_tensor(tensor, rank))
+                {
+                    return false;
+                }
+                for (std::size_t i = 0; i < rank; i++)
+                {
+                    const auto expected = i == 1 ? output.dims[1] : 1;
+                    if (tensor.dims[i] != expected)
+                    {
+                        return false;
+                    }
+                }
+                return true;
+            };
+
+            for (std::size_t i = 0; i < post_ops.size(); i++)
+            {
+                const auto& post_op = post_ops[i];
+                switch (post_op.type)
+                {
+                case PostOpType::eActivation:
+                {
+                    const auto& activation = post_op.activation;
+                    if (activation.type == ActivationType::eUndefined || activation.type >= ActivationType::eCount || post_op.tensor || post_op.tensor_shift)
+                    {
+                        return false;
+                    }
+                    if (activation.type == ActivationType::eClamp && activation.alpha > activation.beta)
+                    {
+                        return false;
+                    }
+                    break;
+                }
+                case PostOpType::eEltwiseAdd:
+                    if (!post_op.tensor || !is_valid_tensor(*post_op.tensor, rank) || post_op.tensor->dims != output.dims || post_op.tensor_shift)
+                    {
+                        return false;
+                    }
+                    break;
+                case PostOpType::eScaleShift:
+                    if (!post_op.tensor || !is_per_channel(*post_op.tensor) || (post_op.tensor_shift && !is_per_channel(*post_op.tensor_shift)))
+                    {
+                        return false;
+                    }
+                    break;
+                case PostOpType::eDownconvert:
+                    if (i + 1 != post_ops.size() || post_op.data_type != output.data_type || post_op.tensor || post_op.tensor_shift)
+                    {
+                        return false;
+                    }
+                    break;
+                default:
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        inline bool is_supported_post_ops(const PostOpsSupport& support, const PostOps& post_ops)
+        {
+            const auto is_set = [](std::uint32_t mask, auto value) { return (mask & (1u << static_cast<std::uint32_t>(value))) != 0; };
+            if (post_ops.size() > support.max_count)
+            {
+                return false;
+            }
+            return std::all_of(post_ops.begin(), post_ops.end(), [&](const PostOp& post_op)
+                {
+                    return is_set(support.post_op_types_mask, post_op.type)
+                        && (post_op.type != PostOpType::eActivation || is_set(support.activation_types_mask, post_op.activation.type));
+                });
+        }
+
+        // Post ops are elementwise on the output: one flop per element (two for scale and shift), downconvert is free.
+        inline std::uint64_t get_post_ops_flops(const PostOps& post_ops, const Tensor& output)
+        {
+            std::uint64_t ret = 0;
+            for (const auto& post_op : post_ops)
+            {
+                if (post_op.type == PostOpType::eScaleShift)
+                {
+                    ret += 2 * get_elements_count(output);
+                }
+                else if (post_op.type != PostOpType::eDownconvert)
+                {
+                    ret += get_elements_count(output);
+                }
+            }
+            return ret;
+        }
+
+        inline std::uint64_t get_post_ops_bytes(const PostOps& post_ops)
+        {
+            std::uint64_t ret = 0;
+            for (const auto& post_op : post_ops)
+            {
+                for (const auto* tensor : { &post_op.tensor, &post_op.tensor_shift })
+                {
+                    if (tensor->has_value())
+                    {
+                        ret += get_bytes_width(tensor->value());
+                    }
+                }
+            }
+            return ret;
+        }
+
+        // Thread group size limit (in HW threads) used by the CM kernels dispatchers.
+        inline constexpr std::uint32_t max_cm_thread_group_size = 64;
+
+        // to_string precision is not enough to match CPU reference, so floats jits are printed with all the digits
+        inline std::string to_jit_value(float value)
+        {
+            return (std::stringstream() << std::setiosflags(std::ios_base::showpoint | std::ios_base::fixed) << std::setprecision(std::numeric_limits<float>::max_digits10 + 1) << value).str();
+        }
+
+        /*
+        *   Theoretical peaks of the platform. Numbers are for the common SKUs, EU count is overwritten by DeviceInfo (if provided).
+        */
+        struct PlatformPeaks
+        {
+            std::uint32_t eu_count = 0;
+            std::uint32_t threads_per_eu = 0;
+            double frequency_ghz = 0.0;
+            std::uint32_t fp32_flops_per_eu_clk = 0;  // FMA counted as 2 flops
+            std::uint32_t fp16_flops_per_eu_clk = 0;
+            std::uint32_t systolic_fp16_flops_per_eu_clk = 0;  // 0 means no systolic arrays (dpas)
+            double memory_bandwidth_gbps = 0.0;
+            double kernel_launch_overhead_us = 0.0;
+        };
+
+        inline PlatformPeaks get_platform_peaks(HwPlatform platform)
+        {
+            switch (platform)
+            {
+            case HwPlatform::eSKL: return { 24, 7, 1.1, 16, 32, 0, 34.0, 10.0 };
+            case HwPlatform::eTGL: return { 96, 7, 1.35, 16, 32, 0, 68.0, 8.0 };
+            case HwPlatform::eADL: return { 96, 7, 1.4, 16, 32, 0, 76.0, 8.0 };
+            case HwPlatform::eDG1: return { 96, 7, 1.5, 16, 32, 0, 68.0, 8.0 };
+            case HwPlatform::eDG2: return { 512, 8, 2.1, 16, 32, 256, 560.0, 5.0 };
+            default:
+                return {};
+            }
+        }
+
+        inline PlatformPeaks get_platform_peaks(const DeviceInfo& device_info)
+        {
+            auto ret = get_platform_peaks(device_info.platform);
+            if (device_info.eu_count > 0)
+            {
+                ret.eu_count = device_info.eu_count;
+            }
+            return ret;
+        }
+
+        /*
+        *   Implementation specific inputs of the cost model.
+        */
+        struct CostParams
+        {
+            std::uint64_t hw_threads_count = 0;   // threads dispatched (all work groups)
+            double compute_efficiency = 1.0;      // fraction of the peak reachable by the kernel inner loop
+            bool uses_systolic = false;           // uses dpas, if the platform has it
+            std::uint64_t extra_bytes = 0;        // traffic above the minimal one (ex. inputs read many times)
+        };
+
+        inline double get_occupancy(std::uint64_t hw_threads_count, const PlatformPeaks& peaks)
+        {
+            const auto slots = static_cast<std::uint64_t>(peaks.eu_count) * peaks.threads_per_eu;
+            if (hw_threads_count == 0 || slots == 0)
+            {
+                return 0.0;
+            }
+            // last, partial wave leaves part of the EUs idle
+            const auto waves = (hw_threads_count + slots - 1) / slots;
+            return static_cast<double>(hw_threads_count) / static_cast<double>(waves * slots);
+        }
+
+        // Reorder is a copy kernel (read + write) of the tensor, bound by memory bandwidth. 0 if platform is unknown.
+        inline double get_reorder_time_us(const Tensor& tensor, const PlatformPeaks& peaks)
+        {
+            if (peaks.memory_bandwidth_gbps <= 0.0)
+            {
+                return 0.0;
+            }
+            return 2.0 * get_bytes_width(tensor) / (peaks.memory_bandwidth_gbps * 1000.0) + peaks.kernel_launch_overhead_us;
+        }
+
+        /*
+        *   Roofline estimate (max of compute and memory time) with compute scaled by occupancy. 0 if platform is unknown.
+        */
+        inline double estimate_roofline_time_us(const PlatformPeaks& peaks, std::uint64_t flops, std::uint64_t bytes, bool is_fp16, const CostParams& cost_params)
+        {
+            if (peaks.eu_count == 0)
+            {
+                return 0.0;
+            }
+
+            auto flops_per_eu_clk = is_fp16 ? peaks.fp16_flops_per_eu_clk : peaks.fp32_flops_per_eu_clk;
+            if (cost_params.uses_systolic && is_fp16 && peaks.systolic_fp16_flops_per_eu_clk > 0)
+            {
+                flops_per_eu_clk = peaks.systolic_fp16_flops_per_eu_clk;
+            }
+            const auto peak_gflops = static_cast<double>(flops_per_eu_clk) * peaks.eu_count * peaks.frequency_ghz;
+            const auto occupancy = get_occupancy(cost_params.hw_threads_count, peaks);
+            const auto achievable_gflops = peak_gflops * cost_params.compute_efficiency * occupancy;
+            if (achievable_gflops <= 0.0)
+            {
+                return 0.0;
+            }
+
+            // GFLOPS and GB/s are the same as flops and bytes per ns
+            const auto compute_time_us = static_cast<double>(flops) / achievable_gflops / 1000.0;
+            const auto memory_time_us = static_cast<double>(bytes + cost_params.extra_bytes) / peaks.memory_bandwidth_gbps / 1000.0;
+            return std::max(compute_time_us, memory_time_us) + peaks.kernel_launch_overhead_us;
+        }
+    }
+}
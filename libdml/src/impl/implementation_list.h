@@ -0,0 +1,122 @@
+#pragma once
+#include <dml_types.hpp>
+
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_map>
+#include <algorithm>
+#include <utility>
+#include <limits>
+#include <functional>
+
+namespace libdml
+{
+    /*
+    *   Sorts primitives fastest first (unknown estimates last) and sets priorities (size of the list for the first one).
+    *   Estimates are calculated once per primitive.
+    */
+    template<typename Primitive>
+    inline std::vector<Primitive> sort_by_estimated_time(std::vector<Primitive>&& primitives)
+    {
+        std::vector<std::pair<double, std::size_t>> estimates;
+        estimates.reserve(primitives.size());
+        for (std::size_t i = 0; i < primitives.size(); i++)
+        {
+            const auto estimate = primitives[i].get_info().estimated_time_us;
+            estimates.push_back({ estimate > 0.0 ? estimate : std::numeric_limits<double>::max(), i });
+        }
+        std::stable_sort(estimates.begin(), estimates.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+
+        std::vector<Primitive> ret{};
+        ret.reserve(primitives.size());
+        for (std::size_t i = 0; i < estimates.size(); i++)
+        {
+            ret.push_back(std::move(primitives[estimates[i].second]));
+            ret.back().set_priority(ImplementationPriority{ static_cast<std::uint32_t>(estimates.size() - i) });
+        }
+        return ret;
+    }
+
+    /*
+    *   Read mostly cache of implementation lists. Entries are never removed, so references to lists stay valid.
+    *   Buckets are keyed by the hash, so lookup compares entries in place and does not need to copy the descriptor into a key.
+    *   Descriptor needs operator== and std::hash specialization.
+    */
+    template<typename Descriptor, typename Primitive>
+    class ImplementationListCache
+    {
+    public:
+        using CreateListFunc = std::vector<Primitive>(*)(const DeviceInfo&, const Descriptor&);
+
+    public:
+        ImplementationListCache(CreateListFunc create_list)
+            : create_list_(create_list)
+        {
+        }
+
+        const std::vector<Primitive>& get(const DeviceInfo& device_info, const Descriptor& desc)
+        {
+            const auto hash = get_hash(device_info, desc);
+            {
+                std::shared_lock lock(mutex_);
+                if (const auto* entry = find(hash, device_info, desc))
+                {
+                    return entry->impls;
+                }
+            }
+
+            // create outside of the lock, other threads can still read
+            auto new_entry = std::make_unique<Entry>(Entry{ device_info, desc, create_list_(device_info, desc) });
+
+            std::unique_lock lock(mutex_);
+            // other thread could add it in the meantime
+            if (const auto* entry = find(hash, device_info, desc))
+            {
+                return entry->impls;
+            }
+            auto& bucket = buckets_[hash];
+            bucket.push_back(std::move(new_entry));
+            return bucket.back()->impls;
+        }
+
+    private:
+        struct Entry
+        {
+            DeviceInfo device_info;
+            Descriptor desc;
+            std::vector<Primitive> impls;
+        };
+
+        static std::size_t get_hash(const DeviceInfo& device_info, const Descriptor& desc)
+        {
+            auto seed = std::hash<DeviceInfo>{}(device_info);
+            hash_helpers::hash_combine_value(seed, desc);
+            return seed;
+        }
+
+        // has to be called with the lock taken
+        const Entry* find(std::size_t hash, const DeviceInfo& device_info, const Descriptor& desc) const
+        {
+            const auto bucket = buckets_.find(hash);
+            if (bucket == buckets_.end())
+            {
+                return nullptr;
+            }
+            for (const auto& entry : bucket->second)
+            {
+                if (entry->device_info == device_info && entry->desc == desc)
+                {
+                    return entry.get();
+                }
+            }
+            return nullptr;
+        }
+
+    private:
+        CreateListFunc create_list_;
+        std::shared_mutex mutex_;
+        std::unordered_map<std::size_t, std::vector<std::unique_ptr<Entry>>> buckets_;
+    };
+}
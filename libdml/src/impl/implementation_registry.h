@@ -0,0 +1,138 @@
+#pragma once
+#include <dml_types.hpp>
+
+#include <array>
+#include <vector>
+#include <utility>
+#include <cstddef>
+#include <cstdint>
+
+namespace libdml
+{
+    using PlatformMask = std::uint32_t;
+    using DataTypeMask = std::uint32_t;
+    using DataLayoutMask = std::uint32_t;
+
+    template<typename Enum>
+    inline constexpr std::uint32_t to_mask(Enum value)
+    {
+        return 1u << static_cast<std::uint32_t>(value);
+    }
+
+    template<typename Enum, typename... Enums>
+    inline constexpr std::uint32_t to_mask(Enum value, Enums... values)
+    {
+        return to_mask(value) | to_mask(values...);
+    }
+
+    inline constexpr std::uint32_t all_mask = ~0u;
+
+    static_assert(static_cast<std::uint32_t>(HwPlatform::eCount) <= 32, "Platforms do not fit into PlatformMask.");
+    static_assert(static_cast<std::uint32_t>(DataType::eCount) <= 32, "Data types do not fit into DataTypeMask.");
+    static_assert(static_cast<std::uint32_t>(DataLayout::eCount) <= 32, "Data layouts do not fit into DataLayoutMask.");
+
+    /*
+    *   Coarse, cheap filters of the implementation, checked before is_supported_descriptor(...).
+    *   Data type and layout are of the main input (see get_registry_tensor(...) overloads of the descriptors).
+    */
+    struct ImplementationTraits
+    {
+        PlatformMask platforms = all_mask;
+        DataTypeMask data_types = all_mask;
+        DataLayoutMask data_layouts = all_mask;
+    };
+
+    namespace registry_detail
+    {
+        template<typename Primitive, typename Descriptor>
+        struct Entry
+        {
+            using TryCreateFunc = void(*)(const DeviceInfo&, const Descriptor&, std::vector<Primitive>&);
+
+            ImplementationTraits traits;
+            TryCreateFunc try_create = nullptr;
+        };
+
+        template<typename Primitive, typename Descriptor, std::size_t Size>
+        struct Candidates
+        {
+            std::array<Entry<Primitive, Descriptor>, Size> entries{};
+            std::size_t count = 0;
+        };
+
+        template<typename Primitive, typename Descriptor, typename Impl>
+        inline void try_create(const DeviceInfo& device_info, const Descriptor& desc, std::vector<Primitive>& list)
+        {
+            if (Impl::is_supported_descriptor(device_info, desc))
+            {
+                list.push_back(new Impl(device_info, desc));
+            }
+        }
+
+        template<typename Primitive, typename Descriptor, typename... Impls>
+        inline constexpr Candidates<Primitive, Descriptor, sizeof...(Impls)> make_candidates(HwPlatform platform)
+        {
+            constexpr std::array<Entry<Primitive, Descriptor>, sizeof...(Impls)> all_entries = { Entry<Primitive, Descriptor>{ Impls::traits, &try_create<Primitive, Descriptor, Impls> }... };
+            Candidates<Primitive, Descriptor, sizeof...(Impls)> ret{};
+            for (std::size_t i = 0; i < all_entries.size(); i++)
+            {
+                if (all_entries[i].traits.platforms & to_mask(platform))
+                {
+                    ret.entries[ret.count++] = all_entries[i];
+                }
+            }
+            return ret;
+        }
+
+        template<typename Primitive, typename Descriptor, typename... Impls, std::size_t... Platforms>
+        inline constexpr auto make_candidates_per_platform(std::index_sequence<Platforms...>)
+        {
+            return std::array<Candidates<Primitive, Descriptor, sizeof...(Impls)>, sizeof...(Platforms)>{ make_candidates<Primitive, Descriptor, Impls...>(static_cast<HwPlatform>(Platforms))... };
+        }
+    }
+
+    /*
+    *   Implementations register by being listed in the registry type (at the end of their *_impl.h file), in priority order for equal estimates.
+    *   Every implementation provides: static constexpr ImplementationTraits traits, static is_supported_descriptor(device_info, desc)
+    *   and constructor (device_info, desc).
+    *   Candidates per platform are filtered at compile time, so query visits only implementations registered for the device platform.
+    */
+    template<typename Primitive, typename Descriptor, typename... Impls>
+    class ImplementationRegistry
+    {
+    public:
+        static std::vector<Primitive> create_list(const DeviceInfo& device_info, const Descriptor& desc)
+        {
+            std::vector<Primitive> ret{};
+            const auto platform_index = static_cast<std::size_t>(device_info.platform);
+            if (platform_index >= candidates_per_platform.size())
+            {
+                return ret;
+            }
+
+            const auto& candidates = candidates_per_platform[platform_index];
+            const auto& tensor = get_registry_tensor(desc);
+            const auto data_type = to_mask(tensor.data_type);
+            const auto data_layout = to_mask(tensor.data_layout);
+            ret.reserve(candidates.count);
+            for (std::size_t i = 0; i < candidates.count; i++)
+            {
+                const auto& candidate = candidates.entries[i];
+                if ((candidate.traits.data_types & data_type) && (candidate.traits.data_layouts & data_layout))
+                {
+                    candidate.try_create(device_info, desc, ret);
+                }
+            }
+            return ret;
+        }
+
+        static constexpr std::size_t get_candidates_count(HwPlatform platform)
+        {
+            return candidates_per_platform[static_cast<std::size_t>(platform)].count;
+        }
+
+    private:
+        static constexpr auto candidates_per_platform = registry_detail::make_candidates_per_platform<Primitive, Descriptor, Impls...>(
+            std::make_index_sequence<static_cast<std::size_t>(HwPlatform::eCount)>{});
+    };
+}
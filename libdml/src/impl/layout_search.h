@@ -0,0 +1,105 @@
+#pragma once
+#include <vector>
+#include <cstddef>
+
+namespace libdml
+{
+    /*
+    *   Search of the layout planner (see plan_convolution_layouts), separated from the implementation lists, so it can be tested with any costs.
+    */
+    namespace layout_search
+    {
+        /*
+        *   Options without an estimate (estimated time <= 0, ex. platform without known peaks) are ranked after every estimated option:
+        *   paths are compared by the count of such options first, then by time of the estimated ops and reorders.
+        */
+        struct PathCost
+        {
+            std::size_t unestimated_count = 0;
+            double time_us = 0.0;
+
+            PathCost add(double op_time_us, double reorder_time_us) const
+            {
+                auto ret = *this;
+                if (op_time_us > 0.0)
+                {
+                    ret.time_us += op_time_us;
+                }
+                else
+                {
+                    ret.unestimated_count++;
+                }
+                ret.time_us += reorder_time_us;
+                return ret;
+            }
+        };
+
+        inline bool operator<(const PathCost& lhs, const PathCost& rhs)
+        {
+            if (lhs.unestimated_count != rhs.unestimated_count)
+            {
+                return lhs.unestimated_count < rhs.unestimated_count;
+            }
+            return lhs.time_us < rhs.time_us;
+        }
+
+        /*
+        *   Returns index of the selected option of every op, so the cost of the whole chain is minimal (dynamic programming over the ops).
+        *   op_times[i][k]: estimated time of op i executed with option k, every op has at least one option.
+        *   reorder_time(i, j, k): time of the reorder between option j of op i - 1 and option k of op i (0 if there is no reorder).
+        */
+        template<typename ReorderTimeFunc>
+        inline std::vector<std::size_t> select_options(const std::vector<std::vector<double>>& op_times, ReorderTimeFunc&& reorder_time, PathCost* total_cost = nullptr)
+        {
+            if (op_times.empty())
+            {
+                return {};
+            }
+            // cost[i][k]: minimal cost of ops 0..i with op i executed with option k; prev[i][k]: option of op i - 1 on that path
+            std::vector<std::vector<PathCost>> cost(op_times.size());
+            std::vector<std::vector<std::size_t>> prev(op_times.size());
+            for (std::size_t i = 0; i < op_times.size(); i++)
+            {
+                cost[i].resize(op_times[i].size());
+                prev[i].assign(op_times[i].size(), 0);
+                for (std::size_t k = 0; k < op_times[i].size(); k++)
+                {
+                    if (i == 0)
+                    {
+                        cost[i][k] = PathCost{}.add(op_times[i][k], 0.0);
+                        continue;
+                    }
+                    for (std::size_t j = 0; j < op_times[i - 1].size(); j++)
+                    {
+                        const auto total = cost[i - 1][j].add(op_times[i][k], reorder_time(i, j, k));
+                        if (j == 0 || total < cost[i][k])
+                        {
+                            cost[i][k] = total;
+                            prev[i][k] = j;
+                        }
+                    }
+                }
+            }
+
+            // backtrack from the cheapest option of the last op
+            std::vector<std::size_t> ret(op_times.size(), 0);
+            const auto& last_cost = cost.back();
+            for (std::size_t k = 1; k < last_cost.size(); k++)
+            {
+                if (last_cost[k] < last_cost[ret.back()])
+                {
+                    ret.back() = k;
+                }
+            }
+            for (std::size_t i = op_times.size() - 1; i > 0; i--)
+            {
+                ret[i - 1] = prev[i][ret[i]];
+            }
+            if (total_cost)
+            {
+                *total_cost = last_cost[ret.back()];
+            }
+            return ret;
+        }
+    }
+}
@@ -0,0 +1,256 @@
+#pragma once
+#include <dml_mvn.hpp>
+#include "../impl_helpers.h"
+#include "../implementation_registry.h"
+
+#include <array>
+#include <string>
+#include <cstdint>
+
+namespace libdml
+{
+    namespace mvn_helpers
+    {
+        inline bool is_valid_descriptor(const MvnDescriptor& desc)
+        {
+            if (!impl_helpers::is_valid_tensor(desc.tensor_input, 4) || desc.tensor_output.dims != desc.tensor_input.dims
+                || impl_helpers::get_data_type_bytes_width(desc.tensor_output.data_type) == 0 || desc.axes.empty() || desc.axes.has_overflow())
+            {
+                return false;
+            }
+            if (!std::all_of(desc.axes.begin(), desc.axes.end(), [](std::int32_t axis) { return axis >= 0 && axis < 4; }))
+            {
+                return false;
+            }
+            // per channel scale and bias
+            const TensorDims per_channel_dims = { 1, desc.tensor_input.dims[TENSOR_DIMENSION_4D_C], 1, 1 };
+            for (const auto* tensor : { &desc.tensor_scale, &desc.tensor_bias })
+            {
+                if (tensor->has_value() && (*tensor)->dims != per_channel_dims)
+                {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        // mean, variance and normalization per element
+        inline std::uint64_t get_flops(const MvnDescriptor& desc)
+        {
+            return 6 * impl_helpers::get_elements_count(desc.tensor_input);
+        }
+
+        inline std::uint64_t get_bytes(const MvnDescriptor& desc)
+        {
+            auto ret = impl_helpers::get_bytes_width(desc.tensor_input) + impl_helpers::get_bytes_width(desc.tensor_output);
+            for (const auto* tensor : { &desc.tensor_scale, &desc.tensor_bias })
+            {
+                if (tensor->has_value())
+                {
+                    ret += impl_helpers::get_bytes_width(**tensor);
+                }
+            }
+            return ret;
+        }
+
+        inline double estimate_time_us(const DeviceInfo& device_info, const MvnDescriptor& desc, const impl_helpers::CostParams& cost_params)
+        {
+            const auto peaks = impl_helpers::get_platform_peaks(device_info);
+            const auto is_fp16 = desc.tensor_input.data_type == DataType::eFp16;
+            return impl_helpers::estimate_roofline_time_us(peaks, get_flops(desc), get_bytes(desc), is_fp16, cost_params);
+        }
+    }
+
+    /*
+    *   Stateless interface of mvn implementation.
+    */
+    class MvnImplementation
+    {
+    public:
+        MvnImplementation(const DeviceInfo& device_info, const MvnDescriptor& desc)
+            : device_info_(device_info)
+            , desc_(desc)
+        {
+        }
+        virtual ~MvnImplementation() = default;
+
+        // bias is bound before scale
+        MvnExecutionParams get_execution_map() const
+        {
+            MvnExecutionParams ret{};
+            std::uint32_t index = 0;
+            ret.params_map[MVN_EXEC_PARAM_TYPE_INPUT] = ExecParamInfo{ index++ };
+            ret.params_map[MVN_EXEC_PARAM_TYPE_OUTPUT] = ExecParamInfo{ index++ };
+            if (desc_.tensor_bias.has_value())
+            {
+                ret.params_map[MVN_EXEC_PARAM_TYPE_BIAS] = ExecParamInfo{ index++ };
+            }
+            if (desc_.tensor_scale.has_value())
+            {
+                ret.params_map[MVN_EXEC_PARAM_TYPE_SCALE] = ExecParamInfo{ index++ };
+            }
+            return ret;
+        }
+
+        virtual std::string get_name() const = 0;
+        virtual KernelInfo get_kernel_info() const = 0;
+
+        // Priority is relative to the other implementations, so it is filled by the primitive.
+        ImplementationInfo get_info() const
+        {
+            ImplementationInfo ret{};
+            ret.name = get_name();
+            ret.estimated_time_us = mvn_helpers::estimate_time_us(device_info_, desc_, get_cost_params());
+            return ret;
+        }
+
+    protected:
+        virtual impl_helpers::CostParams get_cost_params() const = 0;
+
+    protected:
+        DeviceInfo device_info_;
+        MvnDescriptor desc_;
+    };
+
+    /*
+    *   Instance normalization, H * W of every batch and channel is split in 128 items chunks between threads of one group (kernel: mvn_nchw.cpp).
+    */
+    class MvnCmNchwImplementation : public MvnImplementation
+    {
+    public:
+        using MvnImplementation::MvnImplementation;
+
+        static constexpr ImplementationTraits traits{ to_mask(HwPlatform::eDG2), to_mask(DataType::eFp16), to_mask(DataLayout::eNCHW, DataLayout::eAny) };
+
+        static bool is_supported_descriptor(const DeviceInfo& /*device_info*/, const MvnDescriptor& desc)
+        {
+            if (desc.axes != TensorDims{ TENSOR_DIMENSION_4D_H, TENSOR_DIMENSION_4D_W })
+            {
+                return false;
+            }
+            for (const auto* tensor : { &desc.tensor_input, &desc.tensor_output })
+            {
+                if (tensor->data_type != DataType::eFp16 || (tensor->data_layout != DataLayout::eNCHW && tensor->data_layout != DataLayout::eAny))
+                {
+                    return false;
+                }
+            }
+            for (const auto* tensor : { &desc.tensor_scale, &desc.tensor_bias })
+            {
+                if (tensor->has_value() && (*tensor)->data_type != DataType::eFp16)
+                {
+                    return false;
+                }
+            }
+            const auto dataset_size = get_dataset_size(desc);
+            return dataset_size % items_per_hw_thread == 0 && dataset_size / items_per_hw_thread <= impl_helpers::max_cm_thread_group_size;
+        }
+
+        std::string get_name() const override
+        {
+            return "mvn_nchw";
+        }
+
+        KernelInfo get_kernel_info() const override
+        {
+            const auto& dims = desc_.tensor_input.dims;
+
+            KernelInfo ret{};
+            ret.language = KernelLanguage::eCM;
+            ret.code = "mvn_nchw.cpp";
+            auto add_jit = [&ret](const char* name, auto value)
+            {
+                ret.jits.push_back(Jit{ name, std::to_string(value) });
+            };
+            add_jit("INOUT_WIDTH", dims[TENSOR_DIMENSION_4D_W]);
+            add_jit("INOUT_HEIGHT", dims[TENSOR_DIMENSION_4D_H]);
+            add_jit("INOUT_CHANNELS", dims[TENSOR_DIMENSION_4D_C]);
+            add_jit("INOUT_BATCH", dims[TENSOR_DIMENSION_4D_N]);
+            add_jit("USE_BIAS", static_cast<std::int32_t>(desc_.tensor_bias.has_value()));
+            add_jit("USE_SCALE", static_cast<std::int32_t>(desc_.tensor_scale.has_value()));
+            ret.jits.push_back(Jit{ "EPSILON", impl_helpers::to_jit_value(desc_.epsilon) });
+            add_jit("ITEMNUM", items_per_hw_thread);
+
+            // whole dataset is reduced by a single thread group
+            ret.gws = get_gws();
+            ret.lws = { 1u, 1u, ret.gws[2] };
+            ret.grf_count = KernelGrfCount::e128;
+            return ret;
+        }
+
+    protected:
+        static constexpr std::uint32_t items_per_hw_thread = 128;
+
+        static std::uint32_t get_dataset_size(const MvnDescriptor& desc)
+        {
+            const auto& dims = desc.tensor_input.dims;
+            return static_cast<std::uint32_t>(dims[TENSOR_DIMENSION_4D_H] * dims[TENSOR_DIMENSION_4D_W]);
+        }
+
+        std::array<std::uint32_t, 3> get_gws() const
+        {
+            const auto& dims = desc_.tensor_input.dims;
+            return { static_cast<std::uint32_t>(dims[TENSOR_DIMENSION_4D_N]), static_cast<std::uint32_t>(dims[TENSOR_DIMENSION_4D_C]), get_dataset_size(desc_) / items_per_hw_thread };
+        }
+
+        impl_helpers::CostParams get_cost_params() const override
+        {
+            const auto gws = get_gws();
+            impl_helpers::CostParams ret{};
+            ret.hw_threads_count = static_cast<std::uint64_t>(gws[0]) * gws[1] * gws[2];
+            ret.compute_efficiency = 0.5;
+            return ret;
+        }
+    };
+
+    /*
+    *   Generic path of the runtime (ex. DirectML operator), no kernel is provided.
+    *   Modeled as three passes over the input (mean, variance, normalization).
+    */
+    class MvnGenericFallbackImplementation : public MvnImplementation
+    {
+    public:
+        using MvnImplementation::MvnImplementation;
+
+        static constexpr ImplementationTraits traits{};
+
+        static bool is_supported_descriptor(const DeviceInfo& /*device_info*/, const MvnDescriptor& /*desc*/)
+        {
+            return true;
+        }
+
+        std::string get_name() const override
+        {
+            return "generic_fallback";
+        }
+
+        KernelInfo get_kernel_info() const override
+        {
+            KernelInfo ret{};
+            ret.language = KernelLanguage::eUndefined;
+            return ret;
+        }
+
+    protected:
+        impl_helpers::CostParams get_cost_params() const override
+        {
+            impl_helpers::CostParams ret{};
+            // simd16 threads
+            ret.hw_threads_count = (impl_helpers::get_elements_count(desc_.tensor_input) + 15) / 16;
+            ret.compute_efficiency = 0.3;
+            ret.extra_bytes = 2 * impl_helpers::get_bytes_width(desc_.tensor_input);
+            return ret;
+        }
+    };
+
+
+    inline const Tensor& get_registry_tensor(const MvnDescriptor& desc)
+    {
+        return desc.tensor_input;
+    }
+
+    using MvnImplementationRegistry = ImplementationRegistry<MvnPrimitive, MvnDescriptor,
+        MvnCmNchwImplementation,
+        MvnGenericFallbackImplementation>;
+
+}
@@ -0,0 +1,220 @@
+#pragma once
+#include <dml_softmax.hpp>
+#include "../impl_helpers.h"
+#include "../implementation_registry.h"
+
+#include <array>
+#include <string>
+#include <cstdint>
+
+namespace libdml
+{
+    namespace softmax_helpers
+    {
+        inline bool is_valid_descriptor(const SoftmaxDescriptor& desc)
+        {
+            return impl_helpers::is_valid_tensor(desc.tensor_input, 4) && desc.tensor_output.dims == desc.tensor_input.dims
+                && impl_helpers::get_data_type_bytes_width(desc.tensor_output.data_type) > 0 && desc.axis < desc.tensor_input.dims.size();
+        }
+
+        // max, exp, sum and division per element
+        inline std::uint64_t get_flops(const SoftmaxDescriptor& desc)
+        {
+            return 4 * impl_helpers::get_elements_count(desc.tensor_input);
+        }
+
+        inline std::uint64_t get_bytes(const SoftmaxDescriptor& desc)
+        {
+            return impl_helpers::get_bytes_width(desc.tensor_input) + impl_helpers::get_bytes_width(desc.tensor_output);
+        }
+
+        inline double estimate_time_us(const DeviceInfo& device_info, const SoftmaxDescriptor& desc, const impl_helpers::CostParams& cost_params)
+        {
+            const auto peaks = impl_helpers::get_platform_peaks(device_info);
+            const auto is_fp16 = desc.tensor_input.data_type == DataType::eFp16;
+            return impl_helpers::estimate_roofline_time_us(peaks, get_flops(desc), get_bytes(desc), is_fp16, cost_params);
+        }
+    }
+
+    /*
+    *   Stateless interface of softmax implementation.
+    */
+    class SoftmaxImplementation
+    {
+    public:
+        SoftmaxImplementation(const DeviceInfo& device_info, const SoftmaxDescriptor& desc)
+            : device_info_(device_info)
+            , desc_(desc)
+        {
+        }
+        virtual ~SoftmaxImplementation() = default;
+
+        SoftmaxExecutionParams get_execution_map() const
+        {
+            SoftmaxExecutionParams ret{};
+            ret.params_map[SOFTMAX_EXEC_PARAM_TYPE_INPUT] = ExecParamInfo{ 0 };
+            ret.params_map[SOFTMAX_EXEC_PARAM_TYPE_OUTPUT] = ExecParamInfo{ 1 };
+            return ret;
+        }
+
+        virtual std::string get_name() const = 0;
+        virtual KernelInfo get_kernel_info() const = 0;
+
+        // Priority is relative to the other implementations, so it is filled by the primitive.
+        ImplementationInfo get_info() const
+        {
+            ImplementationInfo ret{};
+            ret.name = get_name();
+            ret.estimated_time_us = softmax_helpers::estimate_time_us(device_info_, desc_, get_cost_params());
+            return ret;
+        }
+
+    protected:
+        virtual impl_helpers::CostParams get_cost_params() const = 0;
+
+    protected:
+        DeviceInfo device_info_;
+        SoftmaxDescriptor desc_;
+    };
+
+    /*
+    *   Softmax along W, single pass: each row is kept in registers of the thread group (kernel: softmax_nchw.cpp).
+    */
+    class SoftmaxCmNchwImplementation : public SoftmaxImplementation
+    {
+    public:
+        SoftmaxCmNchwImplementation(const DeviceInfo& device_info, const SoftmaxDescriptor& desc)
+            : SoftmaxImplementation(device_info, desc)
+            , items_per_hw_thread_(get_items_per_hw_thread(desc.tensor_input.dims[TENSOR_DIMENSION_4D_W]))
+        {
+        }
+
+        static constexpr ImplementationTraits traits{ to_mask(HwPlatform::eDG2), to_mask(DataType::eFp16), to_mask(DataLayout::eNCHW, DataLayout::eAny) };
+
+        static bool is_supported_descriptor(const DeviceInfo& /*device_info*/, const SoftmaxDescriptor& desc)
+        {
+            const auto& out = desc.tensor_output;
+            if (desc.axis != TENSOR_DIMENSION_4D_W || out.data_type != DataType::eFp16 || (out.data_layout != DataLayout::eNCHW && out.data_layout != DataLayout::eAny))
+            {
+                return false;
+            }
+            const auto width = static_cast<std::uint32_t>(desc.tensor_input.dims[TENSOR_DIMENSION_4D_W]);
+            const auto items_per_hw_thread = get_items_per_hw_thread(width);
+            return items_per_hw_thread > 0 && width / items_per_hw_thread <= impl_helpers::max_cm_thread_group_size;
+        }
+
+        std::string get_name() const override
+        {
+            return "softmax_nchw";
+        }
+
+        KernelInfo get_kernel_info() const override
+        {
+            const auto& dims = desc_.tensor_input.dims;
+            const auto lws_x = static_cast<std::uint32_t>(dims[TENSOR_DIMENSION_4D_W]) / items_per_hw_thread_;
+
+            KernelInfo ret{};
+            ret.language = KernelLanguage::eCM;
+            ret.code = "softmax_nchw.cpp";
+            auto add_jit = [&ret](const char* name, auto value)
+            {
+                ret.jits.push_back(Jit{ name, std::to_string(value) });
+            };
+            add_jit("INOUT_WIDTH", dims[TENSOR_DIMENSION_4D_W]);
+            add_jit("INOUT_HEIGHT", dims[TENSOR_DIMENSION_4D_H]);
+            add_jit("ITEMNUM_PER_HW", items_per_hw_thread_);
+            // slm reduction buffer is padded to 8 entries
+            add_jit("LWS_SIZE_X_ALIGNED", (lws_x + 7) / 8 * 8);
+
+            ret.gws = get_gws();
+            ret.lws = { lws_x, 1u, 1u };
+            ret.grf_count = KernelGrfCount::e128;
+            return ret;
+        }
+
+    protected:
+        // Row is split between the threads of one group, 0 if width is not supported.
+        static std::uint32_t get_items_per_hw_thread(std::uint32_t width)
+        {
+            for (const auto items : { 128u, 64u, 32u, 16u })
+            {
+                if (width % items == 0)
+                {
+                    return items;
+                }
+            }
+            // technically bigger widths would work, but they are not tested
+            return width < 128 ? width : 0;
+        }
+
+        std::array<std::uint32_t, 3> get_gws() const
+        {
+            const auto& dims = desc_.tensor_input.dims;
+            return { static_cast<std::uint32_t>(dims[TENSOR_DIMENSION_4D_W]) / items_per_hw_thread_, static_cast<std::uint32_t>(dims[TENSOR_DIMENSION_4D_H]),
+                static_cast<std::uint32_t>(dims[TENSOR_DIMENSION_4D_N] * dims[TENSOR_DIMENSION_4D_C]) };
+        }
+
+        impl_helpers::CostParams get_cost_params() const override
+        {
+            const auto gws = get_gws();
+            impl_helpers::CostParams ret{};
+            ret.hw_threads_count = static_cast<std::uint64_t>(gws[0]) * gws[1] * gws[2];
+            ret.compute_efficiency = 0.5;
+            return ret;
+        }
+
+    private:
+        std::uint32_t items_per_hw_thread_;
+    };
+
+    /*
+    *   Generic path of the runtime (ex. DirectML operator), no kernel is provided.
+    *   Modeled as three passes over the input (max, sum of exponents, normalization).
+    */
+    class SoftmaxGenericFallbackImplementation : public SoftmaxImplementation
+    {
+    public:
+        using SoftmaxImplementation::SoftmaxImplementation;
+
+        static constexpr ImplementationTraits traits{};
+
+        static bool is_supported_descriptor(const DeviceInfo& /*device_info*/, const SoftmaxDescriptor& /*desc*/)
+        {
+            return true;
+        }
+
+        std::string get_name() const override
+        {
+            return "generic_fallback";
+        }
+
+        KernelInfo get_kernel_info() const override
+        {
+            KernelInfo ret{};
+            ret.language = KernelLanguage::eUndefined;
+            return ret;
+        }
+
+    protected:
+        impl_helpers::CostParams get_cost_params() const override
+        {
+            impl_helpers::CostParams ret{};
+            // simd16 threads
+            ret.hw_threads_count = (impl_helpers::get_elements_count(desc_.tensor_input) + 15) / 16;
+            ret.compute_efficiency = 0.3;
+            ret.extra_bytes = 2 * impl_helpers::get_bytes_width(desc_.tensor_input);
+            return ret;
+        }
+    };
+
+
+    inline const Tensor& get_registry_tensor(const SoftmaxDescriptor& desc)
+    {
+        return desc.tensor_input;
+    }
+
+    using SoftmaxImplementationRegistry = ImplementationRegistry<SoftmaxPrimitive, SoftmaxDescriptor,
+        SoftmaxCmNchwImplementation,
+        SoftmaxGenericFallbackImplementation>;
+
+}
@@ -0,0 +1,220 @@
+#include "test_utils.h"
+
+#include <dml_graph.hpp>
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+namespace
+{
+libdml::DeviceInfo get_device_info()
+{
+    libdml::DeviceInfo ret{};
+    ret.platform = libdml::HwPlatform::eDG2;
+    return ret;
+}
+
+libdml::Tensor make_activations(std::int32_t channels)
+{
+    return libdml::Tensor{ libdml::TensorDims{ 1, channels, 28, 28 }, libdml::DataLayout::eNCHW, libdml::DataType::eFp16 };
+}
+
+// supported by conv_1x1_nchw_fp16, which fuses relu
+libdml::ConvolutionDescriptor make_convolution_1x1(std::int32_t channels)
+{
+    libdml::ConvolutionDescriptor ret{};
+    ret.tensor_input = make_activations(channels);
+    ret.tensor_output = make_activations(channels);
+    ret.tensor_weights = libdml::Tensor{ libdml::TensorDims{ channels, channels, 1, 1 }, libdml::DataLayout::eOIYX, libdml::DataType::eFp16 };
+    ret.strides = { 1, 1 };
+    ret.start_padding = { 0, 0 };
+    ret.end_padding = { 0, 0 };
+    return ret;
+}
+
+// value of the relu flag in the scalars of the CM convolutions (u32 field at offset 0)
+bool uses_relu(const libdml::ConvolutionPrimitive& convolution)
+{
+    const auto schema = convolution.get_scalars_schema();
+    const auto* field = schema.find("use_relu");
+    const auto params = convolution.get_execution_map(nullptr);
+    return field && params.scalars_buffer.size() >= field->offset + sizeof(std::uint32_t) && params.scalars_buffer[field->offset] == std::byte{ 1 };
+}
+
+libdml::CompiledGraph compile(const libdml::GraphBuilder& builder)
+{
+    auto error_code = libdml::ErrorCode::eSuccess;
+    auto ret = builder.compile(get_device_info(), &error_code);
+    EXPECT_EQ(error_code, libdml::ErrorCode::eSuccess);
+    return ret;
+}
+}  // namespace
+
+LIBDML_TEST(graph_fuses_relu_into_convolution)
+{
+    libdml::GraphBuilder builder{};
+    const auto input = builder.add_input(make_activations(64));
+    const auto conv = builder.add_convolution(make_convolution_1x1(64), input);
+    const auto relu = builder.add_activation(libdml::Activation{ libdml::ActivationType::eRelu }, conv);
+    builder.mark_output(relu);
+
+    const auto graph = compile(builder);
+    EXPECT_EQ(graph.steps.size(), 1u);
+    if (graph.steps.size() != 1)
+    {
+        return;
+    }
+    // convolution step writes the activation output directly
+    const auto& step = graph.steps[0];
+    EXPECT_EQ(step.type, libdml::GraphNodeType::eConvolution);
+    EXPECT_EQ(step.inputs, (std::vector<libdml::TensorId>{ input }));
+    EXPECT_EQ(step.output, relu);
+    EXPECT_TRUE(step.convolution.has_value());
+    if (step.convolution)
+    {
+        EXPECT_TRUE(uses_relu(*step.convolution));
+    }
+    EXPECT_EQ(graph.tensors[relu].storage, libdml::GraphTensorStorage::eOutput);
+    // removed intermediate takes no memory
+    EXPECT_EQ(graph.tensors[conv].size_in_bytes, 0u);
+    EXPECT_EQ(graph.arena_size_in_bytes, 0u);
+}
+
+LIBDML_TEST(graph_remaps_consumer_of_fused_activation)
+{
+    libdml::GraphBuilder builder{};
+    const auto input = builder.add_input(make_activations(64));
+    const auto conv_0 = builder.add_convolution(make_convolution_1x1(64), input);
+    const auto relu = builder.add_activation(libdml::Activation{ libdml::ActivationType::eRelu }, conv_0);
+    const auto conv_1 = builder.add_convolution(make_convolution_1x1(64), relu);
+    builder.mark_output(conv_1);
+
+    const auto graph = compile(builder);
+    EXPECT_EQ(graph.steps.size(), 2u);
+    if (graph.steps.size() != 2)
+    {
+        return;
+    }
+    EXPECT_EQ(graph.steps[0].output, relu);
+    EXPECT_EQ(graph.steps[1].inputs, (std::vector<libdml::TensorId>{ relu }));
+    EXPECT_EQ(graph.steps[1].output, conv_1);
+    EXPECT_EQ(graph.tensors[relu].storage, libdml::GraphTensorStorage::eArena);
+    EXPECT_EQ(graph.tensors[relu].size_in_bytes, 28u * 28u * 64u * 2u);
+    EXPECT_EQ(graph.tensors[conv_0].size_in_bytes, 0u);
+}
+
+LIBDML_TEST(graph_does_not_fuse_into_graph_output)
+{
+    libdml::GraphBuilder builder{};
+    const auto input = builder.add_input(make_activations(64));
+    const auto conv = builder.add_convolution(make_convolution_1x1(64), input);
+    const auto relu = builder.add_activation(libdml::Activation{ libdml::ActivationType::eRelu }, conv);
+    builder.mark_output(conv);
+    builder.mark_output(relu);
+
+    const auto graph = compile(builder);
+    EXPECT_EQ(graph.steps.size(), 2u);
+    if (graph.steps.size() != 2)
+    {
+        return;
+    }
+    EXPECT_EQ(graph.steps[0].output, conv);
+    EXPECT_EQ(graph.steps[1].type, libdml::GraphNodeType::eActivation);
+    EXPECT_EQ(graph.steps[1].inputs, (std::vector<libdml::TensorId>{ conv }));
+}
+
+LIBDML_TEST(graph_keeps_ops_not_supported_by_fused_implementation)
+{
+    // silu and eltwise add are not fused by any convolution implementation, they stay generic steps
+    libdml::GraphBuilder builder{};
+    const auto input = builder.add_input(make_activations(64));
+    const auto conv = builder.add_convolution(make_convolution_1x1(64), input);
+    const auto silu = builder.add_activation(libdml::Activation{ libdml::ActivationType::eSilu }, conv);
+    const auto conv_add = builder.add_convolution(make_convolution_1x1(64), silu);
+    const auto add = builder.add_eltwise_add(conv_add, input);
+    builder.mark_output(add);
+
+    const auto graph = compile(builder);
+    EXPECT_EQ(graph.steps.size(), 4u);
+    if (graph.steps.size() != 4)
+    {
+        return;
+    }
+    EXPECT_EQ(graph.steps[1].type, libdml::GraphNodeType::eActivation);
+    EXPECT_TRUE(graph.steps[1].activation.has_value() && graph.steps[1].activation->type == libdml::ActivationType::eSilu);
+    EXPECT_EQ(graph.steps[3].type, libdml::GraphNodeType::eEltwiseAdd);
+    EXPECT_EQ(graph.steps[3].inputs, (std::vector<libdml::TensorId>{ conv_add, input }));
+    if (graph.steps[0].convolution)
+    {
+        EXPECT_FALSE(uses_relu(*graph.steps[0].convolution));
+    }
+}
+
+LIBDML_TEST(graph_arena_does_not_overlap_live_tensors)
+{
+    // chain with a skip connection: conv_0 lives until the add, other intermediates are short lived and can share memory
+    libdml::GraphBuilder builder{};
+    const auto input = builder.add_input(make_activations(64));
+    const auto conv_0 = builder.add_convolution(make_convolution_1x1(64), input);
+    auto tensor = conv_0;
+    for (int i = 0; i < 4; i++)
+    {
+        tensor = builder.add_convolution(make_convolution_1x1(64), tensor);
+        tensor = builder.add_activation(libdml::Activation{ libdml::ActivationType::eSilu }, tensor);
+    }
+    const auto add = builder.add_eltwise_add(tensor, conv_0);
+    builder.mark_output(builder.add_convolution(make_convolution_1x1(64), add));
+
+    const auto graph = compile(builder);
+    EXPECT_EQ(graph.steps.size(), 11u);
+
+    // live range of every arena tensor: from the producing step to the last consuming step
+    struct Range
+    {
+        std::size_t first = 0;
+        std::size_t last = 0;
+    };
+    std::vector<Range> ranges(graph.tensors.size());
+    for (std::size_t i = 0; i < graph.steps.size(); i++)
+    {
+        ranges[graph.steps[i].output] = Range{ i, i };
+        for (const auto input_id : graph.steps[i].inputs)
+        {
+            ranges[input_id].last = i;
+        }
+    }
+
+    std::vector<libdml::TensorId> arena_tensors{};
+    std::uint64_t total_size = 0;
+    for (libdml::TensorId id = 0; id < graph.tensors.size(); id++)
+    {
+        const auto& graph_tensor = graph.tensors[id];
+        if (graph_tensor.storage == libdml::GraphTensorStorage::eArena && graph_tensor.size_in_bytes > 0)
+        {
+            arena_tensors.push_back(id);
+            total_size += graph_tensor.size_in_bytes;
+            EXPECT_EQ(graph_tensor.arena_offset % libdml::graph_arena_alignment, 0u);
+            EXPECT_TRUE(graph_tensor.arena_offset + graph_tensor.size_in_bytes <= graph.arena_size_in_bytes);
+        }
+    }
+    EXPECT_EQ(arena_tensors.size(), 10u);
+    EXPECT_EQ(ranges[conv_0].last, graph.steps.size() - 2);
+
+    for (std::size_t i = 0; i < arena_tensors.size(); i++)
+    {
+        for (std::size_t j = i + 1; j < arena_tensors.size(); j++)
+        {
+            const auto& a = graph.tensors[arena_tensors[i]];
+            const auto& b = graph.tensors[arena_tensors[j]];
+            const auto& range_a = ranges[arena_tensors[i]];
+            const auto& range_b = ranges[arena_tensors[j]];
+            const auto live_together = range_a.first <= range_b.last && range_b.first <= range_a.last;
+            const auto memory_overlaps = a.arena_offset < b.arena_offset + b.size_in_bytes && b.arena_offset < a.arena_offset + a.size_in_bytes;
+            EXPECT_FALSE(live_together && memory_overlaps);
+        }
+    }
+    // conv_0 and two short lived tensors at a time
+    EXPECT_EQ(graph.arena_size_in_bytes, 3 * graph.tensors[conv_0].size_in_bytes);
+    EXPECT_TRUE(graph.arena_size_in_bytes < total_size);
+}
@@ -0,0 +1,75 @@
+#include "test_utils.h"
+#include "impl/layout_search.h"
+
+#include <dml_layout_planner.hpp>
+
+#include <vector>
+#include <cstddef>
+
+namespace
+{
+// ops with two options each (ex. NCHW and NHWC), reorder is needed when options of the consecutive ops differ
+auto make_reorder_time(double reorder_time_us)
+{
+    return [reorder_time_us](std::size_t /*i*/, std::size_t j, std::size_t k) { return j == k ? 0.0 : reorder_time_us; };
+}
+}  // namespace
+
+LIBDML_TEST(layout_search_selects_reorder_when_it_pays_off)
+{
+    // op 0 is faster in option 0, op 1 is much faster in option 1: 10 + 1 (reorder) + 5 beats 12 + 5 and 10 + 50
+    const std::vector<std::vector<double>> op_times = { { 10.0, 12.0 }, { 50.0, 5.0 } };
+    libdml::layout_search::PathCost total{};
+    const auto selected = libdml::layout_search::select_options(op_times, make_reorder_time(1.0), &total);
+    EXPECT_EQ(selected, (std::vector<std::size_t>{ 0, 1 }));
+    EXPECT_EQ(total.unestimated_count, 0u);
+    EXPECT_EQ(total.time_us, 16.0);
+}
+
+LIBDML_TEST(layout_search_avoids_reorder_when_it_is_too_expensive)
+{
+    const std::vector<std::vector<double>> op_times = { { 10.0, 12.0 }, { 50.0, 5.0 } };
+    libdml::layout_search::PathCost total{};
+    const auto selected = libdml::layout_search::select_options(op_times, make_reorder_time(3.0), &total);
+    EXPECT_EQ(selected, (std::vector<std::size_t>{ 1, 1 }));
+    EXPECT_EQ(total.time_us, 17.0);
+}
+
+LIBDML_TEST(layout_search_ranks_unestimated_options_last)
+{
+    // 0.0 and negative estimates are unknown, not free
+    const std::vector<std::vector<double>> op_times = { { 0.0, 20.0 }, { -1.0, 5.0 } };
+    libdml::layout_search::PathCost total{};
+    const auto selected = libdml::layout_search::select_options(op_times, make_reorder_time(1.0), &total);
+    EXPECT_EQ(selected, (std::vector<std::size_t>{ 1, 1 }));
+    EXPECT_EQ(total.unestimated_count, 0u);
+    EXPECT_EQ(total.time_us, 25.0);
+}
+
+LIBDML_TEST(layout_search_uses_unestimated_option_if_there_is_no_other)
+{
+    // op 1 has no estimate in any option, estimated parts still decide the rest of the chain (including reorders)
+    const std::vector<std::vector<double>> op_times = { { 10.0, 12.0 }, { 0.0, 0.0 }, { 30.0, 3.0 } };
+    libdml::layout_search::PathCost total{};
+    const auto selected = libdml::layout_search::select_options(op_times, make_reorder_time(4.0), &total);
+    EXPECT_EQ(selected, (std::vector<std::size_t>{ 1, 1, 1 }));
+    EXPECT_EQ(total.unestimated_count, 1u);
+    EXPECT_EQ(total.time_us, 15.0);
+}
+
+LIBDML_TEST(layout_search_single_op_selects_cheapest_option)
+{
+    const std::vector<std::vector<double>> op_times = { { 7.0, 3.0, 0.0 } };
+    const auto selected = libdml::layout_search::select_options(op_times, make_reorder_time(1.0));
+    EXPECT_EQ(selected, (std::vector<std::size_t>{ 1 }));
+}
+
+LIBDML_TEST(layout_planner_rejects_empty_chain)
+{
+    libdml::DeviceInfo device_info{};
+    device_info.platform = libdml::HwPlatform::eDG2;
+    auto error_code = libdml::ErrorCode::eSuccess;
+    const auto plan = libdml::plan_convolution_layouts(device_info, {}, &error_code);
+    EXPECT_EQ(error_code, libdml::ErrorCode::eGeneralError);
+    EXPECT_TRUE(plan.steps.empty());
+}
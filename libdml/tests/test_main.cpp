@@ -0,0 +1,35 @@
+#include "test_utils.h"
+
+#include <iostream>
+#include <cstdlib>
+
+namespace
+{
+bool current_test_failed = false;
+}  // namespace
+
+std::vector<libdml_tests::TestCase>& libdml_tests::get_test_cases()
+{
+    static std::vector<TestCase> test_cases;
+    return test_cases;
+}
+
+void libdml_tests::report_failure(const char* file, int line, const char* expression)
+{
+    std::cout << file << "(" << line << "): check failed: " << expression << std::endl;
+    current_test_failed = true;
+}
+
+int main()
+{
+    std::size_t failed_count = 0;
+    for (const auto& test_case : libdml_tests::get_test_cases())
+    {
+        current_test_failed = false;
+        test_case.func();
+        std::cout << (current_test_failed ? "[FAILED] " : "[  OK  ] ") << test_case.name << std::endl;
+        failed_count += current_test_failed ? 1 : 0;
+    }
+    std::cout << libdml_tests::get_test_cases().size() - failed_count << " tests passed, " << failed_count << " failed." << std::endl;
+    return failed_count == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,153 @@
+#include "test_utils.h"
+
+#include <dml_scalars.hpp>
+#include <dml_convolution.hpp>
+
+#include <cstdint>
+#include <cstddef>
+
+namespace
+{
+std::uint32_t read_u32(const libdml::ScalarsBuffer& buffer, std::uint32_t offset)
+{
+    std::uint32_t ret = 0;
+    for (std::uint32_t i = 0; i < 4; i++)
+    {
+        ret |= static_cast<std::uint32_t>(buffer[offset + i]) << (8 * i);
+    }
+    return ret;
+}
+
+std::uint16_t read_u16(const libdml::ScalarsBuffer& buffer, std::uint32_t offset)
+{
+    return static_cast<std::uint16_t>(static_cast<std::uint32_t>(buffer[offset]) | (static_cast<std::uint32_t>(buffer[offset + 1]) << 8));
+}
+
+libdml::ConvolutionDescriptor make_convolution_1x1()
+{
+    libdml::ConvolutionDescriptor ret{};
+    ret.tensor_input = libdml::Tensor{ libdml::TensorDims{ 1, 64, 28, 28 }, libdml::DataLayout::eNCHW, libdml::DataType::eFp16 };
+    ret.tensor_output = libdml::Tensor{ libdml::TensorDims{ 1, 64, 28, 28 }, libdml::DataLayout::eNCHW, libdml::DataType::eFp16 };
+    ret.tensor_weights = libdml::Tensor{ libdml::TensorDims{ 64, 64, 1, 1 }, libdml::DataLayout::eOIYX, libdml::DataType::eFp16 };
+    ret.strides = { 1, 1 };
+    ret.start_padding = { 0, 0 };
+    ret.end_padding = { 0, 0 };
+    return ret;
+}
+}  // namespace
+
+LIBDML_TEST(scalars_schema_aligns_fields)
+{
+    libdml::ScalarsSchema schema{};
+    std::uint32_t field_idx = 0;
+    EXPECT_TRUE(schema.add_field("a", libdml::ScalarType::eFp16, &field_idx));
+    EXPECT_EQ(field_idx, 0u);
+    EXPECT_TRUE(schema.add_field("b", libdml::ScalarType::eUint32, &field_idx));
+    EXPECT_EQ(field_idx, 1u);
+    EXPECT_TRUE(schema.add_field("c", libdml::ScalarType::eFp16));
+    EXPECT_EQ(schema.get_fields()[1].offset, 4u);
+    EXPECT_EQ(schema.get_fields()[2].offset, 8u);
+    // rounded up to DWORD
+    EXPECT_EQ(schema.get_size(), 12u);
+    EXPECT_EQ(schema.get_dwords_count(), 3u);
+    EXPECT_TRUE(schema.find("c") == &schema.get_fields()[2]);
+    EXPECT_TRUE(schema.find("d") == nullptr);
+}
+
+LIBDML_TEST(scalars_schema_rejects_fields_which_do_not_fit)
+{
+    libdml::ScalarsSchema schema{};
+    EXPECT_FALSE(schema.add_field("unknown", libdml::ScalarType::eUndefined));
+    EXPECT_TRUE(schema.empty());
+
+    EXPECT_TRUE(schema.add_field("half", libdml::ScalarType::eFp16));
+    std::uint32_t added_count = 1;
+    while (schema.add_field("dword", libdml::ScalarType::eUint32))
+    {
+        added_count++;
+    }
+    // fp16 field is padded to DWORD by the next field
+    EXPECT_EQ(added_count, libdml::max_scalars_buffer_size / sizeof(std::uint32_t));
+    EXPECT_EQ(schema.get_size(), libdml::max_scalars_buffer_size);
+    EXPECT_FALSE(schema.add_field("half", libdml::ScalarType::eFp16));
+    EXPECT_EQ(schema.get_fields().size(), added_count);
+}
+
+LIBDML_TEST(scalars_packer_writes_little_endian_values)
+{
+    libdml::ScalarsSchema schema{};
+    schema.add_field("u", libdml::ScalarType::eUint32);
+    schema.add_field("h", libdml::ScalarType::eFp16);
+    schema.add_field("i", libdml::ScalarType::eInt32);
+    schema.add_field("f", libdml::ScalarType::eFp32);
+
+    libdml::ScalarsBuffer buffer{};
+    buffer.resize(7, std::byte{ 0xff });
+    libdml::ScalarsPacker packer(schema, buffer);
+    EXPECT_EQ(buffer.size(), schema.get_size());
+    EXPECT_TRUE(packer.set_uint32(0, 0x01020304u));
+    EXPECT_TRUE(packer.set_float(1, 1.0f));
+    EXPECT_TRUE(packer.set_int32(2, -2));
+    EXPECT_TRUE(packer.set_float(3, 2.0f));
+
+    EXPECT_EQ(read_u32(buffer, 0), 0x01020304u);
+    EXPECT_EQ(read_u16(buffer, 4), 0x3c00u);
+    // padding after fp16 is zeroed
+    EXPECT_EQ(read_u16(buffer, 6), 0u);
+    EXPECT_EQ(read_u32(buffer, 8), 0xfffffffeu);
+    EXPECT_EQ(read_u32(buffer, 12), 0x40000000u);
+}
+
+LIBDML_TEST(scalars_packer_rejects_invalid_writes)
+{
+    libdml::ScalarsSchema schema{};
+    schema.add_field("u", libdml::ScalarType::eUint32);
+
+    libdml::ScalarsBuffer buffer{};
+    libdml::ScalarsPacker packer(schema, buffer);
+    // wrong type and field not in the schema
+    EXPECT_FALSE(packer.set_int32(0, 1));
+    EXPECT_FALSE(packer.set_float(0, 1.0f));
+    EXPECT_FALSE(packer.set_uint32(1, 1));
+    EXPECT_EQ(read_u32(buffer, 0), 0u);
+
+    // offset out of the buffer range
+    buffer.clear();
+    EXPECT_FALSE(packer.set_uint32(0, 1));
+    EXPECT_TRUE(buffer.empty());
+}
+
+LIBDML_TEST(scalars_of_cm_convolution)
+{
+    auto desc = make_convolution_1x1();
+    const auto device_info = libdml::DeviceInfo{ libdml::HwPlatform::eDG2, 512 };
+    for (const auto use_relu : { false, true })
+    {
+        desc.post_ops.clear();
+        if (use_relu)
+        {
+            desc.post_ops.push_back(libdml::PostOp{ libdml::PostOpType::eActivation, libdml::Activation{ libdml::ActivationType::eRelu } });
+        }
+        const auto& impls = libdml::get_convolution_implementation_list(device_info, desc);
+        EXPECT_FALSE(impls.empty());
+        for (const auto& impl : impls)
+        {
+            const auto schema = impl.get_scalars_schema();
+            const auto* field = schema.find("use_relu");
+            EXPECT_TRUE(field != nullptr);
+
+            auto error_code = libdml::ErrorCode::eSuccess;
+            const auto params = impl.get_execution_map(&error_code);
+            EXPECT_EQ(error_code, libdml::ErrorCode::eSuccess);
+            EXPECT_EQ(params.scalars_buffer.size(), schema.get_size());
+            // scalars are bound after the output
+            const auto& scalars = params.params_map[libdml::CONVOLUTION_EXEC_PARAM_TYPE_SCALARS];
+            const auto& output = params.params_map[libdml::CONVOLUTION_EXEC_PARAM_TYPE_OUTPUT];
+            EXPECT_TRUE(scalars.has_value() && output.has_value() && scalars->index == output->index + 1);
+            if (field)
+            {
+                EXPECT_EQ(read_u32(params.scalars_buffer, field->offset), use_relu ? 1u : 0u);
+            }
+        }
+    }
+}
@@ -0,0 +1,241 @@
+#include "test_utils.h"
+
+#include <dml_serialization.hpp>
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+namespace
+{
+libdml::ConvolutionDescriptor make_convolution_1x1()
+{
+    libdml::ConvolutionDescriptor ret{};
+    ret.tensor_input = libdml::Tensor{ libdml::TensorDims{ 1, 64, 56, 56 }, libdml::DataLayout::eNCHW, libdml::DataType::eFp16 };
+    ret.tensor_output = libdml::Tensor{ libdml::TensorDims{ 1, 64, 56, 56 }, libdml::DataLayout::eNCHW, libdml::DataType::eFp16 };
+    ret.tensor_weights = libdml::Tensor{ libdml::TensorDims{ 64, 64, 1, 1 }, libdml::DataLayout::eOIYX, libdml::DataType::eFp16 };
+    ret.strides = { 1, 1 };
+    ret.start_padding = { 0, 0 };
+    ret.end_padding = { 0, 0 };
+    return ret;
+}
+
+libdml::SelectionCache make_cache()
+{
+    libdml::SelectionCache ret{};
+    ret.device_info = libdml::DeviceInfo{ libdml::HwPlatform::eDG2, 512 };
+
+    const auto desc = make_convolution_1x1();
+    for (const auto& impl : libdml::get_convolution_implementation_list(ret.device_info, desc))
+    {
+        libdml::ConvolutionSelection selection{};
+        selection.desc = desc;
+        selection.info = impl.get_info();
+        selection.layouts = impl.query_preffered_layouts();
+        selection.kernel_info = impl.get_kernel_info(selection.layouts);
+        selection.execution_params = impl.get_execution_map(nullptr);
+        ret.convolutions.push_back(std::move(selection));
+    }
+
+    // selection with post op tensors and scalars, so every field of the execution params is written
+    libdml::ConvolutionSelection selection{};
+    selection.desc = desc;
+    selection.desc.tensor_bias = libdml::Tensor{ libdml::TensorDims{ 1, 64, 1, 1 }, libdml::DataLayout::eNCHW, libdml::DataType::eFp16 };
+    libdml::PostOp post_op{};
+    post_op.type = libdml::PostOpType::eEltwiseAdd;
+    post_op.tensor = desc.tensor_output;
+    selection.desc.post_ops = { post_op };
+    selection.info.name = "custom";
+    selection.kernel_info.grf_count = libdml::KernelGrfCount::e256;
+    selection.execution_params.params_map[libdml::CONVOLUTION_EXEC_PARAM_TYPE_INPUT] = libdml::ExecParamInfo{ 0 };
+    selection.execution_params.params_map[libdml::CONVOLUTION_EXEC_PARAM_TYPE_SCALARS] = libdml::ExecParamInfo{ 4 };
+    selection.execution_params.post_ops_params = { libdml::ExecParamInfo{ 3 } };
+    selection.execution_params.scalars_buffer = { std::byte{ 1 }, std::byte{ 0 }, std::byte{ 0xff }, std::byte{ 7 } };
+    ret.convolutions.push_back(std::move(selection));
+    return ret;
+}
+
+bool is_equal(const libdml::ConvolutionExecutionParams& lhs, const libdml::ConvolutionExecutionParams& rhs)
+{
+    for (std::size_t i = 0; i < lhs.params_map.size(); i++)
+    {
+        if (lhs.params_map[i].has_value() != rhs.params_map[i].has_value()
+            || (lhs.params_map[i].has_value() && lhs.params_map[i]->index != rhs.params_map[i]->index))
+        {
+            return false;
+        }
+    }
+    if (lhs.post_ops_params.size() != rhs.post_ops_params.size())
+    {
+        return false;
+    }
+    for (std::size_t i = 0; i < lhs.post_ops_params.size(); i++)
+    {
+        if (lhs.post_ops_params[i].index != rhs.post_ops_params[i].index)
+        {
+            return false;
+        }
+    }
+    return lhs.scalars_buffer == rhs.scalars_buffer;
+}
+
+bool is_equal(const libdml::ConvolutionSelection& lhs, const libdml::ConvolutionSelection& rhs)
+{
+    const auto& kernel_lhs = lhs.kernel_info;
+    const auto& kernel_rhs = rhs.kernel_info;
+    if (kernel_lhs.jits.size() != kernel_rhs.jits.size())
+    {
+        return false;
+    }
+    for (std::size_t i = 0; i < kernel_lhs.jits.size(); i++)
+    {
+        if (kernel_lhs.jits[i].opt != kernel_rhs.jits[i].opt || kernel_lhs.jits[i].value != kernel_rhs.jits[i].value)
+        {
+            return false;
+        }
+    }
+    return lhs.desc == rhs.desc
+        && lhs.info.priority.value == rhs.info.priority.value
+        && lhs.info.name == rhs.info.name
+        && lhs.info.estimated_time_us == rhs.info.estimated_time_us
+        && lhs.layouts.input_layout == rhs.layouts.input_layout
+        && lhs.layouts.weights_layout == rhs.layouts.weights_layout
+        && lhs.layouts.bias_layout == rhs.layouts.bias_layout
+        && kernel_lhs.language == kernel_rhs.language
+        && kernel_lhs.code == kernel_rhs.code
+        && kernel_lhs.gws == kernel_rhs.gws
+        && kernel_lhs.lws == kernel_rhs.lws
+        && kernel_lhs.grf_count == kernel_rhs.grf_count
+        && is_equal(lhs.execution_params, rhs.execution_params);
+}
+
+bool is_rejected(const std::vector<std::byte>& blob, std::size_t size)
+{
+    auto error_code = libdml::ErrorCode::eSuccess;
+    const auto cache = libdml::deserialize_selection_cache(blob.data(), size, &error_code);
+    return error_code == libdml::ErrorCode::eGeneralError && cache.convolutions.empty();
+}
+
+// header: magic (4 bytes), version (u32), payload size (u64)
+constexpr std::size_t version_offset = 4;
+constexpr std::size_t payload_offset = 16;
+}  // namespace
+
+LIBDML_TEST(serialization_selection_cache_round_trip)
+{
+    const auto cache = make_cache();
+    EXPECT_TRUE(cache.convolutions.size() > 1);
+    const auto blob = libdml::serialize_selection_cache(cache);
+
+    auto error_code = libdml::ErrorCode::eSuccess;
+    const auto result = libdml::deserialize_selection_cache(blob.data(), blob.size(), &error_code);
+    EXPECT_EQ(error_code, libdml::ErrorCode::eSuccess);
+    EXPECT_TRUE(result.device_info == cache.device_info);
+    EXPECT_EQ(result.convolutions.size(), cache.convolutions.size());
+    for (std::size_t i = 0; i < result.convolutions.size() && i < cache.convolutions.size(); i++)
+    {
+        EXPECT_TRUE(is_equal(result.convolutions[i], cache.convolutions[i]));
+    }
+}
+
+LIBDML_TEST(serialization_execution_params_round_trip)
+{
+    const auto cache = make_cache();
+    const auto& params = cache.convolutions.back().execution_params;
+    std::vector<std::byte> blob{};
+    libdml::serialize(params, blob);
+
+    std::size_t offset = 0;
+    libdml::ConvolutionExecutionParams result{};
+    EXPECT_TRUE(libdml::deserialize(blob.data(), blob.size(), offset, result));
+    EXPECT_EQ(offset, blob.size());
+    EXPECT_TRUE(is_equal(result, params));
+
+    // failed read doesn't advance the offset
+    offset = 0;
+    EXPECT_FALSE(libdml::deserialize(blob.data(), blob.size() - 1, offset, result));
+    EXPECT_EQ(offset, 0u);
+}
+
+LIBDML_TEST(serialization_rejects_truncated_blob)
+{
+    const auto blob = libdml::serialize_selection_cache(make_cache());
+    std::size_t accepted_count = 0;
+    for (std::size_t size = 0; size < blob.size(); size++)
+    {
+        accepted_count += is_rejected(blob, size) ? 0 : 1;
+    }
+    EXPECT_EQ(accepted_count, 0u);
+    EXPECT_TRUE(is_rejected({}, 0));
+}
+
+LIBDML_TEST(serialization_rejects_wrong_header)
+{
+    const auto blob = libdml::serialize_selection_cache(make_cache());
+
+    auto wrong_magic = blob;
+    wrong_magic[0] = std::byte{ 'X' };
+    EXPECT_TRUE(is_rejected(wrong_magic, wrong_magic.size()));
+
+    auto wrong_version = blob;
+    wrong_version[version_offset] = static_cast<std::byte>(libdml::serialization_format_version + 1);
+    EXPECT_TRUE(is_rejected(wrong_version, wrong_version.size()));
+
+    auto trailing_data = blob;
+    trailing_data.push_back(std::byte{ 0 });
+    EXPECT_TRUE(is_rejected(trailing_data, trailing_data.size()));
+}
+
+LIBDML_TEST(serialization_rejects_invalid_values)
+{
+    // device info is the first field of the payload: platform enum and eu count
+    auto wrong_platform = libdml::serialize_selection_cache(make_cache());
+    wrong_platform[payload_offset] = static_cast<std::byte>(libdml::HwPlatform::eCount);
+    EXPECT_TRUE(is_rejected(wrong_platform, wrong_platform.size()));
+
+    // rank over the capacity of TensorDims
+    libdml::ConvolutionDescriptor desc = make_convolution_1x1();
+    std::vector<std::byte> blob{};
+    libdml::serialize(desc, blob);
+    blob[0] = static_cast<std::byte>(libdml::TensorDims::capacity() + 1);
+    std::size_t offset = 0;
+    EXPECT_FALSE(libdml::deserialize(blob.data(), blob.size(), offset, desc));
+
+    // direction is the last byte before the post ops count
+    blob.clear();
+    libdml::serialize(make_convolution_1x1(), blob);
+    blob[blob.size() - 5] = static_cast<std::byte>(libdml::ConvolutionDirection::eCount);
+    offset = 0;
+    EXPECT_FALSE(libdml::deserialize(blob.data(), blob.size(), offset, desc));
+
+    // grf count is the last byte of the kernel info
+    libdml::KernelInfo kernel_info{};
+    blob.clear();
+    libdml::serialize(kernel_info, blob);
+    blob.back() = static_cast<std::byte>(libdml::KernelGrfCount::eCount);
+    offset = 0;
+    EXPECT_FALSE(libdml::deserialize(blob.data(), blob.size(), offset, kernel_info));
+}
+
+LIBDML_TEST(serialization_rejects_execution_params_over_capacity)
+{
+    libdml::ConvolutionExecutionParams params{};
+    params.scalars_buffer.resize(libdml::ScalarsBuffer::capacity());
+    std::vector<std::byte> blob{};
+    libdml::serialize(params, blob);
+
+    // scalars buffer is the last field: u32 size followed by the bytes
+    const auto size_offset = blob.size() - libdml::ScalarsBuffer::capacity() - sizeof(std::uint32_t);
+    blob[size_offset] = static_cast<std::byte>((libdml::ScalarsBuffer::capacity() + 1) & 0xff);
+    blob[size_offset + 1] = static_cast<std::byte>((libdml::ScalarsBuffer::capacity() + 1) >> 8);
+    blob.push_back(std::byte{ 0 });
+    std::size_t offset = 0;
+    EXPECT_FALSE(libdml::deserialize(blob.data(), blob.size(), offset, params));
+
+    // table written for other count of the exec params
+    blob.clear();
+    libdml::serialize(libdml::ConvolutionExecutionParams{}, blob);
+    blob[0] = static_cast<std::byte>(libdml::CONVOLUTION_EXEC_PARAM_TYPE_COUNT + 1);
+    offset = 0;
+    EXPECT_FALSE(libdml::deserialize(blob.data(), blob.size(), offset, params));
+}
@@ -0,0 +1,111 @@
+#include "test_utils.h"
+#include "impl/impl_helpers.h"
+
+#include <dml_convolution.hpp>
+#include <dml_graph.hpp>
+
+#include <cstdint>
+
+namespace
+{
+libdml::ConvolutionDescriptor make_convolution_1x1()
+{
+    libdml::ConvolutionDescriptor ret{};
+    ret.tensor_input = libdml::Tensor{ libdml::TensorDims{ 1, 64, 28, 28 }, libdml::DataLayout::eNCHW, libdml::DataType::eFp16 };
+    ret.tensor_output = libdml::Tensor{ libdml::TensorDims{ 1, 64, 28, 28 }, libdml::DataLayout::eNCHW, libdml::DataType::eFp16 };
+    ret.tensor_weights = libdml::Tensor{ libdml::TensorDims{ 64, 64, 1, 1 }, libdml::DataLayout::eOIYX, libdml::DataType::eFp16 };
+    ret.strides = { 1, 1 };
+    ret.start_padding = { 0, 0 };
+    ret.end_padding = { 0, 0 };
+    return ret;
+}
+
+libdml::DeviceInfo get_device_info()
+{
+    libdml::DeviceInfo ret{};
+    ret.platform = libdml::HwPlatform::eDG2;
+    return ret;
+}
+
+using SmallVector = libdml::InlineVector<std::int32_t, 2>;
+}  // namespace
+
+LIBDML_TEST(inline_vector_push_back_above_capacity_is_reported)
+{
+    SmallVector vector{};
+    EXPECT_TRUE(vector.push_back(1));
+    EXPECT_TRUE(vector.push_back(2));
+    EXPECT_FALSE(vector.has_overflow());
+    EXPECT_FALSE(vector.push_back(3));
+    EXPECT_TRUE(vector.has_overflow());
+    // content is not changed
+    EXPECT_EQ(vector.size(), 2u);
+    EXPECT_EQ(vector[1], 2);
+    // overflowed vector is not equal to the one which holds the same values
+    EXPECT_TRUE(vector != (SmallVector{ 1, 2 }));
+
+    vector.clear();
+    EXPECT_FALSE(vector.has_overflow());
+    EXPECT_TRUE(vector.empty());
+}
+
+LIBDML_TEST(inline_vector_resize_and_initializer_list_above_capacity_are_reported)
+{
+    SmallVector vector{ 1 };
+    EXPECT_FALSE(vector.resize(3, 7));
+    EXPECT_TRUE(vector.has_overflow());
+    EXPECT_EQ(vector[0], 1);
+    EXPECT_EQ(vector.size(), 1u);
+
+    const SmallVector too_long{ 1, 2, 3 };
+    EXPECT_TRUE(too_long.has_overflow());
+    EXPECT_TRUE(too_long.empty());
+
+    const SmallVector fits{ 1, 2 };
+    EXPECT_FALSE(fits.has_overflow());
+    EXPECT_EQ(fits.size(), 2u);
+}
+
+LIBDML_TEST(convolution_rejects_dims_above_max_rank)
+{
+    auto desc = make_convolution_1x1();
+    EXPECT_FALSE(libdml::get_convolution_implementation_list(get_device_info(), desc).empty());
+
+    // rank 9 input, the first 8 dims would be a valid tensor if they were truncated
+    desc.tensor_input.dims.resize(libdml::max_tensor_rank, 1);
+    desc.tensor_input.dims.push_back(1);
+    EXPECT_TRUE(desc.tensor_input.dims.has_overflow());
+    EXPECT_TRUE(libdml::get_convolution_implementation_list(get_device_info(), desc).empty());
+
+    desc = make_convolution_1x1();
+    desc.strides = { 1, 1, 1, 1, 1, 1, 1, 1, 1 };
+    EXPECT_TRUE(libdml::get_convolution_implementation_list(get_device_info(), desc).empty());
+}
+
+LIBDML_TEST(post_ops_above_capacity_are_invalid)
+{
+    const auto output = make_convolution_1x1().tensor_output;
+    libdml::PostOp relu{};
+    relu.type = libdml::PostOpType::eActivation;
+    relu.activation = libdml::Activation{ libdml::ActivationType::eRelu };
+
+    libdml::PostOps post_ops{};
+    post_ops.resize(libdml::PostOps::capacity(), relu);
+    EXPECT_TRUE(libdml::impl_helpers::is_valid_post_ops(post_ops, output));
+    EXPECT_FALSE(post_ops.push_back(relu));
+    EXPECT_FALSE(libdml::impl_helpers::is_valid_post_ops(post_ops, output));
+}
+
+LIBDML_TEST(graph_rejects_tensor_above_max_rank)
+{
+    auto tensor = make_convolution_1x1().tensor_input;
+    tensor.dims.resize(libdml::max_tensor_rank + 1, 1);
+
+    libdml::GraphBuilder builder{};
+    const auto input = builder.add_input(tensor);
+    builder.mark_output(builder.add_activation(libdml::Activation{ libdml::ActivationType::eRelu }, input));
+    auto error_code = libdml::ErrorCode::eSuccess;
+    const auto graph = builder.compile(get_device_info(), &error_code);
+    EXPECT_EQ(error_code, libdml::ErrorCode::eGeneralError);
+    EXPECT_TRUE(graph.steps.empty());
+}
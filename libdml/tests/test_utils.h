@@ -0,0 +1,40 @@
+#pragma once
+#include <vector>
+#include <string>
+
+/*
+*   Minimal test registry (libdml has no dependencies, so no test framework either).
+*   Test is a function registered with LIBDML_TEST, failed EXPECT_* marks the test as failed and the test continues.
+*/
+namespace libdml_tests
+{
+    using TestFunc = void(*)();
+
+    struct TestCase
+    {
+        const char* name;
+        TestFunc func;
+    };
+
+    std::vector<TestCase>& get_test_cases();
+    void report_failure(const char* file, int line, const char* expression);
+
+    struct TestRegistration
+    {
+        TestRegistration(const char* name, TestFunc func)
+        {
+            get_test_cases().push_back(TestCase{ name, func });
+        }
+    };
+}
+
+#define LIBDML_TEST(name) \
+    static void name(); \
+    static const libdml_tests::TestRegistration name##_registration(#name, &name); \
+    static void name()
+
+#define EXPECT_TRUE(expression) \
+    do { if (!(expression)) { libdml_tests::report_failure(__FILE__, __LINE__, #expression); } } while (false)
+
+#define EXPECT_FALSE(expression) EXPECT_TRUE(!(expression))
+#define EXPECT_EQ(lhs, rhs) EXPECT_TRUE((lhs) == (rhs))
@@ -0,0 +1,34 @@
+#include <cm/cm.h>
+#include <cm/cmtl.h>
+
+// independent mad chains, enough to hide the FPU latency
+#define CHAINS 4
+
+extern "C" _GENX_MAIN_ void compute_peak(
+	SurfaceIndex surface_output [[type("buffer_t")]])
+{
+    const uint32_t thread_id = cm_group_id(0) * cm_local_size(0) + cm_local_id(0);
+
+	vector<DT, SIMD> a = (DT)(thread_id % 7) * (DT)0.001f;
+	vector<DT, SIMD> b = (DT)0.5f;
+	matrix<DT, CHAINS, SIMD> acc = (DT)1.0f;
+
+	#pragma unroll(8)
+	for(int i = 0; i < ITERATIONS; i++)
+	{
+		#pragma unroll
+		for(int c = 0; c < CHAINS; c++)
+		{
+			acc.row(c) = acc.row(c) * a + b;
+		}
+	}
+
+	// store the result so compiler can't drop the math
+	vector<DT, SIMD> result = acc.row(0);
+	#pragma unroll
+	for(int c = 1; c < CHAINS; c++)
+	{
+		result += acc.row(c);
+	}
+	cm_store<uint32_t, (SIMD * sizeof(DT)) / sizeof(uint32_t)>(surface_output, thread_id * SIMD * sizeof(DT), result.format<uint32_t>());
+}
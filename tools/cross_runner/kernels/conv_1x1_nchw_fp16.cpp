@@ -201,7 +201,8 @@ extern "C" _GENX_MAIN_ void convolution_nchw_1x1(
 #if USE_BIAS
 	SurfaceIndex surface_bias [[type("buffer_t")]],
 #endif
-	SurfaceIndex surface_output [[type("buffer_t")]]
+	SurfaceIndex surface_output [[type("buffer_t")]],
+	uint32_t use_relu   // runtime scalar (root constant), conv and conv + relu share the binary
 )
 {
     const uint32_t thg_0 = (cm_group_id(0) * cm_local_size(0) + cm_local_id(0));
@@ -346,6 +347,19 @@ extern "C" _GENX_MAIN_ void convolution_nchw_1x1(
     }
 
 #endif // SLICE_IC > 1
+
+    // fused activation, applied in accumulator precision (after the slice_ic reduction), uniform branch
+    if (use_relu)
+    {
+        accu_row_0_oc_0 = cm_max<DT_ACCU>(accu_row_0_oc_0, DT_ACCU(0.0f));
+#if BLOCK_OC >= 16
+        accu_row_0_oc_1 = cm_max<DT_ACCU>(accu_row_0_oc_1, DT_ACCU(0.0f));
+#endif
+#if BLOCK_OC == 32
+        accu_row_0_oc_2 = cm_max<DT_ACCU>(accu_row_0_oc_2, DT_ACCU(0.0f));
+        accu_row_0_oc_3 = cm_max<DT_ACCU>(accu_row_0_oc_3, DT_ACCU(0.0f));
+#endif
+    }
     
     vector<DT_OUT, ACCU_REG_SIZE> output_row_0_oc_0 = vector<DT_OUT, ACCU_REG_SIZE>(accu_row_0_oc_0);
 #if BLOCK_OC >= 16
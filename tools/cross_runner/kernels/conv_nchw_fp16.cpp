@@ -252,7 +252,8 @@ extern "C" _GENX_MAIN_ void convolution_nchw_nondpas(
 #if USE_BIAS
 	SurfaceIndex surface_bias [[type("buffer_t")]],
 #endif
-	SurfaceIndex surface_output [[type("buffer_t")]]
+	SurfaceIndex surface_output [[type("buffer_t")]],
+	uint32_t use_relu   // runtime scalar (root constant), conv and conv + relu share the binary
 )
 {
     const uint32_t thg_0 = cm_group_id(0) * cm_local_size(0) + cm_local_id(0);
@@ -305,6 +306,12 @@ extern "C" _GENX_MAIN_ void convolution_nchw_nondpas(
 		}		
 	}
 
+	// fused activation, applied in accumulator precision (uniform branch, same for all threads)
+	if (use_relu)
+	{
+		accu_row_0 = cm_max<DT_ACCU>(accu_row_0, DT_ACCU(0.0f));
+	}
+
 	// if the DT_OUT == DT_ACCU then compiler will not do anything here
 	// but if data types are different then this cast accumulator to output type
     //vector<DT_OUT, ACCU_REG_SIZE> output_row_0 = vector<DT_OUT, ACCU_REG_SIZE>(accu_row_0);
@@ -1,8 +1,16 @@
 #include <cm/cm.h>
 #include <cm/cmtl.h>
 
-#define DT half
+// MODE values, have to match MemoryBandwidthDispatcher::Mode
+#define MODE_COPY 0
+#define MODE_READ 1
+#define MODE_WRITE 2
+#define MODE_STRIDED 3
+
 #define ITEMNUM_PER_HW_PACKED ((ITEMS_PER_HW * sizeof(DT))/sizeof(uint32_t))
+#define GATHER_SIZE 16
+
+static const uint32_t init_gather_offsets[] = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15 };
 
 extern "C" _GENX_MAIN_ void memory_copy(
 	SurfaceIndex surface_input [[type("buffer_t")]],
@@ -10,6 +18,29 @@ extern "C" _GENX_MAIN_ void memory_copy(
 {
     const uint32_t thread_id = cm_group_id(0) * cm_local_size(0) + cm_local_id(0);
 	const uint32_t in_out_offset = thread_id * ITEMS_PER_HW * sizeof(DT);
+#if MODE == MODE_COPY
   	vector<uint32_t, ITEMNUM_PER_HW_PACKED> data_packed = cm_load<uint32_t, ITEMNUM_PER_HW_PACKED, DataSize::Default, CacheHint::Cached, CacheHint::Cached>(surface_input, in_out_offset);
 	cm_store<uint32_t, ITEMNUM_PER_HW_PACKED, DataSize::Default, CacheHint::WriteBack, CacheHint::WriteBack>(surface_output, in_out_offset, data_packed);
+#elif MODE == MODE_READ
+	// reduce to single dword per thread, so the loads can't be optimized out
+  	vector<uint32_t, ITEMNUM_PER_HW_PACKED> data_packed = cm_load<uint32_t, ITEMNUM_PER_HW_PACKED, DataSize::Default, CacheHint::Cached, CacheHint::Cached>(surface_input, in_out_offset);
+	vector<uint32_t, 1> result = cm_sum<uint32_t>(data_packed);
+	cm_store<uint32_t, 1, DataSize::Default, CacheHint::WriteBack, CacheHint::WriteBack>(surface_output, thread_id * sizeof(uint32_t), result);
+#elif MODE == MODE_WRITE
+	vector<uint32_t, ITEMNUM_PER_HW_PACKED> data_packed = thread_id;
+	cm_store<uint32_t, ITEMNUM_PER_HW_PACKED, DataSize::Default, CacheHint::WriteBack, CacheHint::WriteBack>(surface_output, in_out_offset, data_packed);
+#elif MODE == MODE_STRIDED
+	// dword i of the thread is at (thread_id + i * THREADS_COUNT), every lane of the gather hits different cache line
+	vector<uint32_t, ITEMNUM_PER_HW_PACKED> data_packed;
+	vector<uint32_t, GATHER_SIZE> lanes(init_gather_offsets);
+	#pragma unroll
+	for(int i = 0; i < ITEMNUM_PER_HW_PACKED / GATHER_SIZE; i++)
+	{
+		vector<uint32_t, GATHER_SIZE> offsets = ((lanes + i * GATHER_SIZE) * THREADS_COUNT + thread_id) * sizeof(uint32_t);
+		data_packed.select<GATHER_SIZE, 1>(i * GATHER_SIZE) = cm_load<uint32_t, VectorSize::N1, DataSize::Default, CacheHint::Default, CacheHint::Default>(surface_input, offsets);
+	}
+	cm_store<uint32_t, ITEMNUM_PER_HW_PACKED, DataSize::Default, CacheHint::WriteBack, CacheHint::WriteBack>(surface_output, in_out_offset, data_packed);
+#else
+#error "Unknown MODE"
+#endif
 }
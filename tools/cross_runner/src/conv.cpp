@@ -1,6 +1,14 @@
 #include "conv.h"
 #include "dnnl_utils.h"
 
+#include <algorithm>
+#include <execution>
+#include <numeric>
+#include <cmath>
+#include <unordered_map>
+#include <intrin.h>
+#include <immintrin.h>
+
 inline dnnl::memory create_dnnl_memory(const cpu_op::binding_t binding, dnnl::engine& engine)
 {
     const auto dims = to_dnnl_dims(binding.shape);
@@ -9,8 +17,562 @@ inline dnnl::memory create_dnnl_memory(const cpu_op::binding_t binding, dnnl::en
     return dnnl::memory({ dims, dt, ft }, engine);
 }
 
+namespace
+{
+// Intrinsics of the wider ISAs are compiled without /arch (binary has to run on any x64), functions using them are called only after the cpuid check.
+#if defined(__clang__)
+#define CPU_TARGET_AVX2 __attribute__((target("avx2")))
+#define CPU_TARGET_AVX512_VNNI __attribute__((target("avx512f,avx512bw,avx512vnni")))
+#else
+#define CPU_TARGET_AVX2
+#define CPU_TARGET_AVX512_VNNI
+#endif
+
+// Values are 9 bit (quantized value minus zero point), so int32 sums are exact (and pairs of products don't saturate pmaddwd).
+inline std::int32_t dot_product_scalar(const std::int16_t* a, const std::int16_t* b, std::size_t count)
+{
+    std::int32_t acc = 0;
+    for (std::size_t i = 0; i < count; i++)
+    {
+        acc += static_cast<std::int32_t>(a[i]) * static_cast<std::int32_t>(b[i]);
+    }
+    return acc;
+}
+
+// pmaddwd: 16 products per instruction, pairs summed into int32 lanes
+CPU_TARGET_AVX2 std::int32_t dot_product_avx2(const std::int16_t* a, const std::int16_t* b, std::size_t count)
+{
+    __m256i acc = _mm256_setzero_si256();
+    std::size_t i = 0;
+    for (; i + 16 <= count; i += 16)
+    {
+        const auto va = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i));
+        const auto vb = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i));
+        acc = _mm256_add_epi32(acc, _mm256_madd_epi16(va, vb));
+    }
+    auto sum = _mm_add_epi32(_mm256_castsi256_si128(acc), _mm256_extracti128_si256(acc, 1));
+    sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(1, 0, 3, 2)));
+    sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(2, 3, 0, 1)));
+    return _mm_cvtsi128_si32(sum) + dot_product_scalar(a + i, b + i, count - i);
+}
+
+// vpdpwssd: multiply and accumulate in one instruction, 32 products per instruction
+CPU_TARGET_AVX512_VNNI std::int32_t dot_product_avx512_vnni(const std::int16_t* a, const std::int16_t* b, std::size_t count)
+{
+    __m512i acc = _mm512_setzero_si512();
+    std::size_t i = 0;
+    for (; i + 32 <= count; i += 32)
+    {
+        const auto va = _mm512_loadu_si512(a + i);
+        const auto vb = _mm512_loadu_si512(b + i);
+        acc = _mm512_dpwssd_epi32(acc, va, vb);
+    }
+    return _mm512_reduce_add_epi32(acc) + dot_product_scalar(a + i, b + i, count - i);
+}
+
+using DotProductFunc = std::int32_t(*)(const std::int16_t*, const std::int16_t*, std::size_t);
+
+// Widest ISA supported by the cpu and enabled by the OS (xgetbv: ymm and zmm state saved on context switch), checked once.
+DotProductFunc select_dot_product()
+{
+    static const DotProductFunc ret = []() -> DotProductFunc
+    {
+        int regs[4] = {};
+        __cpuid(regs, 0);
+        const auto max_leaf = regs[0];
+        __cpuid(regs, 1);
+        const bool osxsave = (regs[2] & (1 << 27)) != 0;
+        if (!osxsave || max_leaf < 7)
+        {
+            return dot_product_scalar;
+        }
+        const auto xcr0 = _xgetbv(0);
+        __cpuidex(regs, 7, 0);
+        const bool avx2 = (regs[1] & (1 << 5)) != 0 && (xcr0 & 0x6) == 0x6;
+        const bool avx512_vnni = (regs[1] & (1 << 16)) != 0 && (regs[1] & (1 << 30)) != 0 && (regs[2] & (1 << 11)) != 0 && (xcr0 & 0xe6) == 0xe6;
+        if (avx512_vnni)
+        {
+            return dot_product_avx512_vnni;
+        }
+        return avx2 ? dot_product_avx2 : dot_product_scalar;
+    }();
+    return ret;
+}
+
+inline std::int32_t read_quantized(const std::byte* data, DataType dt, std::size_t idx)
+{
+    return dt == DataType::eInt8 ? static_cast<std::int32_t>(reinterpret_cast<const std::int8_t*>(data)[idx])
+        : static_cast<std::int32_t>(reinterpret_cast<const std::uint8_t*>(data)[idx]);
+}
+
+inline float read_float(const std::byte* data, DataType dt, std::size_t idx)
+{
+    return dt == DataType::eFp16 ? cast_to_float(reinterpret_cast<const Half*>(data)[idx]) : reinterpret_cast<const float*>(data)[idx];
+}
+
+inline void write_float(std::byte* data, DataType dt, std::size_t idx, float value)
+{
+    if (dt == DataType::eFp16)
+    {
+        reinterpret_cast<Half*>(data)[idx] = DirectX::PackedVector::XMConvertFloatToHalf(value);
+    }
+    else
+    {
+        reinterpret_cast<float*>(data)[idx] = value;
+    }
+}
+
+// Host paths evaluate only activation post ops (see cpu_op::convolution).
+inline float apply_activations(const libdml::PostOps& post_ops, float value)
+{
+    for (const auto& post_op : post_ops)
+    {
+        const auto& activation = post_op.activation;
+        switch (activation.type)
+        {
+        case libdml::ActivationType::eRelu: value = std::max(value, 0.0f); break;
+        case libdml::ActivationType::eGelu: value = 0.5f * value * (1.0f + std::erf(value / std::sqrt(2.0f))); break;
+        case libdml::ActivationType::eSilu: value = value / (1.0f + std::exp(-value)); break;
+        case libdml::ActivationType::eClamp: value = std::clamp(value, activation.alpha, activation.beta); break;
+        default:
+            assert(!"[host][conv] Unsupported activation type!");
+        }
+    }
+    return value;
+}
+
+// Filters follow activations layout: NCHW -> OIYX, NHWC -> OYXI.
+inline std::size_t get_element_index(DataLayout layout, const TensorShape& shape, std::size_t n, std::size_t c, std::size_t h, std::size_t w)
+{
+    return layout == DataLayout::eNHWC
+        ? ((n * shape.h + h) * shape.w + w) * shape.c + c
+        : ((n * shape.c + c) * shape.h + h) * shape.w + w;
+}
+
+// Rows of the output (batch, output y) are independent, they are computed in parallel.
+template<typename Func>
+inline void for_each_output_row(const TensorShape& output_shape, Func&& func)
+{
+    std::vector<std::size_t> rows(output_shape.n * output_shape.h);
+    std::iota(rows.begin(), rows.end(), std::size_t{ 0 });
+    std::for_each(std::execution::par, rows.begin(), rows.end(), [&](std::size_t row)
+        {
+            func(row / output_shape.h, row % output_shape.h);
+        });
+}
+
+/*
+*   Input as NHWC with spatial padding (padded values are T{}), read(idx) converts element idx of the source tensor.
+*   Channels innermost make kernel taps contiguous vectors of channels.
+*/
+template<typename T, typename ReadFunc>
+inline std::vector<T> to_padded_nhwc(const cpu_op::binding_t& binding, std::size_t pad, ReadFunc&& read)
+{
+    const auto& shape = binding.shape;
+    const std::size_t padded_height = shape.h + 2 * pad;
+    const std::size_t padded_width = shape.w + 2 * pad;
+    std::vector<T> ret(shape.n * padded_height * padded_width * shape.c, T{});
+    for (std::size_t n = 0; n < shape.n; n++)
+    {
+        for (std::size_t c = 0; c < shape.c; c++)
+        {
+            for (std::size_t h = 0; h < shape.h; h++)
+            {
+                for (std::size_t w = 0; w < shape.w; w++)
+                {
+                    const auto dst_idx = ((n * padded_height + h + pad) * padded_width + w + pad) * shape.c + c;
+                    ret[dst_idx] = read(get_element_index(binding.layout, shape, n, c, h, w));
+                }
+            }
+        }
+    }
+    return ret;
+}
+
+/*
+*   Reference of quantized convolution (oneDNN can't apply per channel zero points of weights), see cpu_op::quantization_t.
+*   Input (padded) and filter are repacked once to channels innermost layouts with zero points subtracted,
+*   so each output is a few contiguous int16 dot products. Without groups and dilation whole kernel row is one dot product.
+*/
+std::vector<std::byte> quantized_convolution(const cpu_op::bindings_t& bindings, const cpu_op::opts_t& opts)
+{
+    const auto& quantization = *opts.quantization;
+    const auto& input_shape = bindings.input.shape;
+    const auto& filter_shape = bindings.filter.shape;
+    const auto& output_shape = opts.output_shape;
+    assert(bindings.filter.dt == DataType::eInt8);
+    assert(bindings.input.dt == DataType::eInt8 || bindings.input.dt == DataType::eUint8);
+    assert(quantization.filter_scales.size() == output_shape.c && quantization.filter_zero_points.size() == output_shape.c);
+
+    const std::size_t ic = input_shape.c;
+    const std::size_t group_ic = filter_shape.c;
+    const std::size_t group_oc = output_shape.c / opts.groups;
+    const std::size_t pad = opts.inp_pad;
+    const std::size_t padded_height = input_shape.h + 2 * pad;
+    const std::size_t padded_width = input_shape.w + 2 * pad;
+
+    // padded values are zero points (real zero)
+    const auto input = to_padded_nhwc<std::int16_t>(bindings.input, pad, [&](std::size_t idx)
+        {
+            return static_cast<std::int16_t>(read_quantized(bindings.input.data, bindings.input.dt, idx) - quantization.input_zero_point);
+        });
+
+    // OYXI
+    const std::size_t kernel_height = filter_shape.h;
+    const std::size_t kernel_width = filter_shape.w;
+    std::vector<std::int16_t> filter(filter_shape.n * kernel_height * kernel_width * group_ic);
+    for (std::size_t o = 0; o < filter_shape.n; o++)
+    {
+        for (std::size_t c = 0; c < group_ic; c++)
+        {
+            for (std::size_t y = 0; y < kernel_height; y++)
+            {
+                for (std::size_t x = 0; x < kernel_width; x++)
+                {
+                    const auto src_idx = get_element_index(bindings.filter.layout, filter_shape, o, c, y, x);
+                    const auto dst_idx = ((o * kernel_height + y) * kernel_width + x) * group_ic + c;
+                    filter[dst_idx] = static_cast<std::int16_t>(read_quantized(bindings.filter.data, DataType::eInt8, src_idx) - quantization.filter_zero_points[o]);
+                }
+            }
+        }
+    }
+
+    const auto* bias = reinterpret_cast<const std::int32_t*>(bindings.bias.data);
+    const auto min_value = opts.out_dt == DataType::eInt8 ? -128 : 0;
+    const auto max_value = opts.out_dt == DataType::eInt8 ? 127 : 255;
+    std::vector<float> requantization_scales(output_shape.c);
+    for (std::size_t o = 0; o < output_shape.c; o++)
+    {
+        requantization_scales[o] = quantization.input_scale * quantization.filter_scales[o] / quantization.output_scale;
+    }
+
+    const bool contiguous_kernel_rows = opts.groups == 1 && opts.dilation[1] == 1;
+    const auto dot_product = select_dot_product();
+    std::vector<std::byte> ret(output_shape.get_elements_count() * get_data_type_bytes_width(opts.out_dt));
+    for_each_output_row(output_shape, [&](std::size_t n, std::size_t oh)
+        {
+            const auto kernel_row_size = kernel_width * group_ic;
+            for (std::size_t ow = 0; ow < output_shape.w; ow++)
+            {
+                for (std::size_t o = 0; o < output_shape.c; o++)
+                {
+                    const auto group = o / group_oc;
+                    std::int32_t acc = bias ? bias[o] : 0;
+                    for (std::size_t y = 0; y < kernel_height; y++)
+                    {
+                        const auto ih = oh * opts.stride.h + y * opts.dilation[0];
+                        const auto* input_row = input.data() + ((n * padded_height + ih) * padded_width + ow * opts.stride.w) * ic + group * group_ic;
+                        const auto* filter_row = filter.data() + (o * kernel_height + y) * kernel_row_size;
+                        if (contiguous_kernel_rows)
+                        {
+                            acc += dot_product(input_row, filter_row, kernel_row_size);
+                            continue;
+                        }
+                        for (std::size_t x = 0; x < kernel_width; x++)
+                        {
+                            acc += dot_product(input_row + x * opts.dilation[1] * ic, filter_row + x * group_ic, group_ic);
+                        }
+                    }
+                    const auto value = static_cast<std::int32_t>(std::nearbyint(static_cast<float>(acc) * requantization_scales[o])) + quantization.output_zero_point;
+                    const auto saturated = std::clamp(value, min_value, max_value);
+                    ret[get_element_index(opts.out_layout, output_shape, n, o, oh, ow)] = static_cast<std::byte>(static_cast<std::uint8_t>(saturated));
+                }
+            }
+        });
+    return ret;
+}
+
+inline bool is_depthwise_convolution(const TensorShape& input_shape, const cpu_op::opts_t& opts)
+{
+    return opts.groups > 1 && opts.groups == input_shape.c && opts.groups == opts.output_shape.c;
+}
+
+/*
+*   Depthwise convolution (groups == ic == oc) is memory bound and oneDNN GPU reference round trip dominates its time,
+*   so it's computed on the host: fp32 accumulation, input and filter repacked to channels innermost
+*   (every kernel tap is multiply-add of contiguous channel vectors, vectorized by the compiler).
+*/
+std::vector<std::byte> depthwise_convolution(const cpu_op::bindings_t& bindings, const cpu_op::opts_t& opts)
+{
+    const auto& input_shape = bindings.input.shape;
+    const auto& filter_shape = bindings.filter.shape;
+    const auto& output_shape = opts.output_shape;
+    assert(filter_shape.c == 1 && filter_shape.n == input_shape.c && output_shape.c == input_shape.c);
+
+    const std::size_t channels = input_shape.c;
+    const std::size_t pad = opts.inp_pad;
+    const std::size_t padded_height = input_shape.h + 2 * pad;
+    const std::size_t padded_width = input_shape.w + 2 * pad;
+    const auto input = to_padded_nhwc<float>(bindings.input, pad, [&](std::size_t idx) { return read_float(bindings.input.data, bindings.input.dt, idx); });
+
+    // YXC
+    const std::size_t kernel_height = filter_shape.h;
+    const std::size_t kernel_width = filter_shape.w;
+    std::vector<float> filter(kernel_height * kernel_width * channels);
+    for (std::size_t c = 0; c < channels; c++)
+    {
+        for (std::size_t y = 0; y < kernel_height; y++)
+        {
+            for (std::size_t x = 0; x < kernel_width; x++)
+            {
+                filter[(y * kernel_width + x) * channels + c] = read_float(bindings.filter.data, bindings.filter.dt, get_element_index(bindings.filter.layout, filter_shape, c, 0, y, x));
+            }
+        }
+    }
+
+    std::vector<float> bias(channels, 0.0f);
+    if (bindings.bias.data)
+    {
+        for (std::size_t c = 0; c < channels; c++)
+        {
+            bias[c] = read_float(bindings.bias.data, bindings.bias.dt, c);
+        }
+    }
+
+    std::vector<std::byte> ret(output_shape.get_elements_count() * get_data_type_bytes_width(opts.out_dt));
+    for_each_output_row(output_shape, [&](std::size_t n, std::size_t oh)
+        {
+            std::vector<float> acc(channels);
+            for (std::size_t ow = 0; ow < output_shape.w; ow++)
+            {
+                std::copy(bias.begin(), bias.end(), acc.begin());
+                for (std::size_t y = 0; y < kernel_height; y++)
+                {
+                    const auto ih = oh * opts.stride.h + y * opts.dilation[0];
+                    for (std::size_t x = 0; x < kernel_width; x++)
+                    {
+                        const auto iw = ow * opts.stride.w + x * opts.dilation[1];
+                        const auto* input_pixel = input.data() + ((n * padded_height + ih) * padded_width + iw) * channels;
+                        const auto* filter_tap = filter.data() + (y * kernel_width + x) * channels;
+                        for (std::size_t c = 0; c < channels; c++)
+                        {
+                            acc[c] += input_pixel[c] * filter_tap[c];
+                        }
+                    }
+                }
+                for (std::size_t c = 0; c < channels; c++)
+                {
+                    write_float(ret.data(), opts.out_dt, get_element_index(opts.out_layout, output_shape, n, c, oh, ow), apply_activations(opts.post_ops, acc[c]));
+                }
+            }
+        });
+    return ret;
+}
+
+/*
+*   Dense (and grouped) fp16/fp32 convolution on the host, used when the reference runs while the GPU is timed (oneDNN GPU engine would disturb the measurement).
+*   fp32 accumulation, input repacked to padded NHWC and filter to (kh, kw, ic, oc / groups): each input channel of a kernel tap
+*   is multiply-add of contiguous output channels vector (vectorized by the compiler), output rows are computed in parallel.
+*/
+std::vector<std::byte> dense_convolution(const cpu_op::bindings_t& bindings, const cpu_op::opts_t& opts)
+{
+    const auto& input_shape = bindings.input.shape;
+    const auto& filter_shape = bindings.filter.shape;
+    const auto& output_shape = opts.output_shape;
+    assert(filter_shape.n == output_shape.c && filter_shape.c * opts.groups == input_shape.c);
+
+    const std::size_t ic = input_shape.c;
+    const std::size_t oc = output_shape.c;
+    const std::size_t group_ic = filter_shape.c;
+    const std::size_t group_oc = oc / opts.groups;
+    const std::size_t pad = opts.inp_pad;
+    const std::size_t padded_height = input_shape.h + 2 * pad;
+    const std::size_t padded_width = input_shape.w + 2 * pad;
+    const auto input = to_padded_nhwc<float>(bindings.input, pad, [&](std::size_t idx) { return read_float(bindings.input.data, bindings.input.dt, idx); });
+
+    const std::size_t kernel_height = filter_shape.h;
+    const std::size_t kernel_width = filter_shape.w;
+    std::vector<float> filter(kernel_height * kernel_width * ic * group_oc);
+    for (std::size_t i = 0; i < ic; i++)
+    {
+        const auto group = i / group_ic;
+        for (std::size_t o = 0; o < group_oc; o++)
+        {
+            for (std::size_t y = 0; y < kernel_height; y++)
+            {
+                for (std::size_t x = 0; x < kernel_width; x++)
+                {
+                    const auto src_idx = get_element_index(bindings.filter.layout, filter_shape, group * group_oc + o, i % group_ic, y, x);
+                    filter[((y * kernel_width + x) * ic + i) * group_oc + o] = read_float(bindings.filter.data, bindings.filter.dt, src_idx);
+                }
+            }
+        }
+    }
+
+    std::vector<float> bias(oc, 0.0f);
+    if (bindings.bias.data)
+    {
+        for (std::size_t o = 0; o < oc; o++)
+        {
+            bias[o] = read_float(bindings.bias.data, bindings.bias.dt, o);
+        }
+    }
+
+    std::vector<std::byte> ret(output_shape.get_elements_count() * get_data_type_bytes_width(opts.out_dt));
+    for_each_output_row(output_shape, [&](std::size_t n, std::size_t oh)
+        {
+            std::vector<float> acc(oc);
+            for (std::size_t ow = 0; ow < output_shape.w; ow++)
+            {
+                std::copy(bias.begin(), bias.end(), acc.begin());
+                for (std::size_t y = 0; y < kernel_height; y++)
+                {
+                    const auto ih = oh * opts.stride.h + y * opts.dilation[0];
+                    for (std::size_t x = 0; x < kernel_width; x++)
+                    {
+                        const auto iw = ow * opts.stride.w + x * opts.dilation[1];
+                        const auto* input_pixel = input.data() + ((n * padded_height + ih) * padded_width + iw) * ic;
+                        const auto* filter_tap = filter.data() + (y * kernel_width + x) * ic * group_oc;
+                        for (std::size_t i = 0; i < ic; i++)
+                        {
+                            const auto value = input_pixel[i];
+                            const auto* filter_row = filter_tap + i * group_oc;
+                            auto* group_acc = acc.data() + (i / group_ic) * group_oc;
+                            for (std::size_t o = 0; o < group_oc; o++)
+                            {
+                                group_acc[o] += value * filter_row[o];
+                            }
+                        }
+                    }
+                }
+                for (std::size_t o = 0; o < oc; o++)
+                {
+                    write_float(ret.data(), opts.out_dt, get_element_index(opts.out_layout, output_shape, n, o, oh, ow), apply_activations(opts.post_ops, acc[o]));
+                }
+            }
+        });
+    return ret;
+}
+
+/*
+*   Transposed convolution (backward data) as a gather: output pixel (oh, ow) is reached by input pixel (ih, iw) through kernel tap (y, x)
+*   when oh + pad == ih * stride + y * dilation (same for w), so every output is owned by one thread and there are no scatter conflicts.
+*   Filter is repacked to (kh, kw, ic, oc / groups): each input channel is multiply-add of contiguous output channels vector.
+*/
+std::vector<std::byte> transposed_convolution(const cpu_op::bindings_t& bindings, const cpu_op::opts_t& opts)
+{
+    const auto& input_shape = bindings.input.shape;
+    const auto& filter_shape = bindings.filter.shape;
+    const auto& output_shape = opts.output_shape;
+    assert(filter_shape.n == input_shape.c && filter_shape.c * opts.groups == output_shape.c);
+
+    const std::size_t ic = input_shape.c;
+    const std::size_t oc = output_shape.c;
+    const std::size_t group_ic = ic / opts.groups;
+    const std::size_t group_oc = filter_shape.c;
+    const auto input = to_padded_nhwc<float>(bindings.input, 0, [&](std::size_t idx) { return read_float(bindings.input.data, bindings.input.dt, idx); });
+
+    const std::size_t kernel_height = filter_shape.h;
+    const std::size_t kernel_width = filter_shape.w;
+    std::vector<float> filter(kernel_height * kernel_width * ic * group_oc);
+    for (std::size_t i = 0; i < ic; i++)
+    {
+        for (std::size_t o = 0; o < group_oc; o++)
+        {
+            for (std::size_t y = 0; y < kernel_height; y++)
+            {
+                for (std::size_t x = 0; x < kernel_width; x++)
+                {
+                    const auto src_idx = get_element_index(bindings.filter.layout, filter_shape, i, o, y, x);
+                    filter[((y * kernel_width + x) * ic + i) * group_oc + o] = read_float(bindings.filter.data, bindings.filter.dt, src_idx);
+                }
+            }
+        }
+    }
+
+    std::vector<float> bias(oc, 0.0f);
+    if (bindings.bias.data)
+    {
+        for (std::size_t o = 0; o < oc; o++)
+        {
+            bias[o] = read_float(bindings.bias.data, bindings.bias.dt, o);
+        }
+    }
+
+    // input coordinate reaching output coordinate through kernel tap, -1 if there is none
+    auto get_input_coord = [&](std::size_t out_coord, std::size_t tap, std::size_t stride, std::size_t dilation, std::size_t input_size)
+    {
+        const auto pos = static_cast<std::int64_t>(out_coord + opts.inp_pad) - static_cast<std::int64_t>(tap * dilation);
+        if (pos < 0 || pos % static_cast<std::int64_t>(stride) != 0 || pos / static_cast<std::int64_t>(stride) >= static_cast<std::int64_t>(input_size))
+        {
+            return std::int64_t{ -1 };
+        }
+        return pos / static_cast<std::int64_t>(stride);
+    };
+
+    std::vector<std::byte> ret(output_shape.get_elements_count() * get_data_type_bytes_width(opts.out_dt));
+    for_each_output_row(output_shape, [&](std::size_t n, std::size_t oh)
+        {
+            std::vector<float> acc(oc);
+            for (std::size_t ow = 0; ow < output_shape.w; ow++)
+            {
+                std::copy(bias.begin(), bias.end(), acc.begin());
+                for (std::size_t y = 0; y < kernel_height; y++)
+                {
+                    const auto ih = get_input_coord(oh, y, opts.stride.h, opts.dilation[0], input_shape.h);
+                    if (ih < 0)
+                    {
+                        continue;
+                    }
+                    for (std::size_t x = 0; x < kernel_width; x++)
+                    {
+                        const auto iw = get_input_coord(ow, x, opts.stride.w, opts.dilation[1], input_shape.w);
+                        if (iw < 0)
+                        {
+                            continue;
+                        }
+                        const auto* input_pixel = input.data() + ((n * input_shape.h + ih) * input_shape.w + iw) * ic;
+                        const auto* filter_tap = filter.data() + (y * kernel_width + x) * ic * group_oc;
+                        for (std::size_t i = 0; i < ic; i++)
+                        {
+                            const auto value = input_pixel[i];
+                            const auto* filter_row = filter_tap + i * group_oc;
+                            auto* group_acc = acc.data() + (i / group_ic) * group_oc;
+                            for (std::size_t o = 0; o < group_oc; o++)
+                            {
+                                group_acc[o] += value * filter_row[o];
+                            }
+                        }
+                    }
+                }
+                for (std::size_t o = 0; o < oc; o++)
+                {
+                    write_float(ret.data(), opts.out_dt, get_element_index(opts.out_layout, output_shape, n, o, oh, ow), apply_activations(opts.post_ops, acc[o]));
+                }
+            }
+        });
+    return ret;
+}
+}  // namespace
+
 std::vector<std::byte> cpu_op::convolution(const bindings_t& bindings, opts_t opts)
 {
+    const auto is_host = opts.quantization || opts.transposed || opts.host_only || is_depthwise_convolution(bindings.input.shape, opts);
+    if (is_host && std::any_of(opts.post_ops.begin(), opts.post_ops.end(), [](const libdml::PostOp& post_op) { return post_op.type != libdml::PostOpType::eActivation; }))
+    {
+        throw std::runtime_error("Host convolution reference supports only activation post ops.");
+    }
+    if (opts.quantization && !opts.post_ops.empty())
+    {
+        throw std::runtime_error("Quantized convolution reference does not support post ops.");
+    }
+    if (opts.quantization)
+    {
+        return quantized_convolution(bindings, opts);
+    }
+    if (opts.transposed)
+    {
+        return transposed_convolution(bindings, opts);
+    }
+    if (is_depthwise_convolution(bindings.input.shape, opts))
+    {
+        return depthwise_convolution(bindings, opts);
+    }
+    if (opts.host_only)
+    {
+        return dense_convolution(bindings, opts);
+    }
+
     static dnnl::engine engine(dnnl::engine::kind::gpu, 0);
     static dnnl::stream stream(engine);
     const auto engine_kind = engine.get_kind();
@@ -31,16 +593,23 @@ std::vector<std::byte> cpu_op::convolution(const bindings_t& bindings, opts_t op
 
     dnnl::memory filter_memory = [&](const auto& binding)
     {
-        const auto dims = to_dnnl_dims(binding.shape);
+        auto dims = to_dnnl_dims(binding.shape);
         const auto dt = to_dnnl_data_type(binding.dt);
+        // grouped weights have groups as the outermost dimension: (g, oc / g, ic / g, kh, kw), memory is the same
+        const auto grouped = opts.groups > 1;
+        if (grouped)
+        {
+            dims.insert(dims.begin(), opts.groups);
+            dims[1] /= opts.groups;
+        }
         auto ft = dnnl::memory::format_tag::undef;
         if (binding.layout == DataLayout::eNCHW)
         {
-            ft = dnnl::memory::format_tag::oihw;
+            ft = grouped ? dnnl::memory::format_tag::goihw : dnnl::memory::format_tag::oihw;
         }
         else if (binding.layout == DataLayout::eNHWC)
         {
-            ft = dnnl::memory::format_tag::ohwi;
+            ft = grouped ? dnnl::memory::format_tag::gohwi : dnnl::memory::format_tag::ohwi;
         }
         assert(ft != dnnl::memory::format_tag::undef);
         auto ret = dnnl::memory({ dims, dt, ft }, engine);
@@ -70,16 +639,75 @@ std::vector<std::byte> cpu_op::convolution(const bindings_t& bindings, opts_t op
     }();
 
 
+    std::unordered_map<int, dnnl::memory> post_ops_args;
+    const dnnl::post_ops post_ops = [&]()
+    {
+        dnnl::post_ops ret{};
+        std::size_t binding_idx = 0;
+        auto append_binary = [&](dnnl::algorithm algorithm)
+        {
+            assert(binding_idx < bindings.post_ops.size() && "[dnnl][conv] Missing binding of post op tensor!");
+            const auto& binding = bindings.post_ops[binding_idx++];
+            auto memory = create_dnnl_memory(binding, engine);
+            copy_to_dnnl_memory(memory, binding.data);
+            post_ops_args[DNNL_ARG_ATTR_MULTIPLE_POST_OP(ret.len()) | DNNL_ARG_SRC_1] = memory;
+            ret.append_binary(algorithm, memory.get_desc());
+        };
+
+        for (const auto& post_op : opts.post_ops)
+        {
+            switch (post_op.type)
+            {
+            case libdml::PostOpType::eActivation:
+            {
+                const auto& activation = post_op.activation;
+                switch (activation.type)
+                {
+                case libdml::ActivationType::eRelu: ret.append_eltwise(dnnl::algorithm::eltwise_relu, 0.0f, 0.0f); break;
+                case libdml::ActivationType::eGelu: ret.append_eltwise(dnnl::algorithm::eltwise_gelu_erf, 0.0f, 0.0f); break;
+                case libdml::ActivationType::eSilu: ret.append_eltwise(dnnl::algorithm::eltwise_swish, 1.0f, 0.0f); break;
+                case libdml::ActivationType::eClamp: ret.append_eltwise(dnnl::algorithm::eltwise_clip, activation.alpha, activation.beta); break;
+                default:
+                    assert(!"[dnnl][conv] Unsupported activation type!");
+                }
+                break;
+            }
+            case libdml::PostOpType::eEltwiseAdd:
+                append_binary(dnnl::algorithm::binary_add);
+                break;
+            case libdml::PostOpType::eScaleShift:
+                append_binary(dnnl::algorithm::binary_mul);
+                if (post_op.tensor_shift)
+                {
+                    append_binary(dnnl::algorithm::binary_add);
+                }
+                break;
+            case libdml::PostOpType::eDownconvert:
+                // output memory is already created with the output data type
+                break;
+            default:
+                assert(!"[dnnl][conv] Unsupported post op type!");
+            }
+        }
+        return ret;
+    }();
+    dnnl::primitive_attr attr{};
+    attr.set_post_ops(post_ops);
+
     const dnnl::memory::dims pad{ opts.inp_pad, opts.inp_pad };
     const dnnl::memory::dims stride{ opts.stride.h, opts.stride.w };
+    // oneDNN counts skipped pixels, 0 is dense kernel
+    const dnnl::memory::dims dilation{ opts.dilation[0] - 1, opts.dilation[1] - 1 };
     const dnnl::convolution_forward::primitive_desc conv_desc(engine,
         dnnl::prop_kind::forward_inference, dnnl::algorithm::convolution_direct,
-        input_memory.get_desc(), filter_memory.get_desc(), bindings.bias.data ? bias_memory.get_desc() : dnnl::memory::desc{}, output_memory.get_desc(), stride, pad, pad);
+        input_memory.get_desc(), filter_memory.get_desc(), bindings.bias.data ? bias_memory.get_desc() : dnnl::memory::desc{}, output_memory.get_desc(), stride, dilation, pad, pad, attr);
 
     const auto guery_impl_str = conv_desc.impl_info_str();
 
     dnnl::convolution_forward convolution(conv_desc);
-    convolution.execute(stream, { { DNNL_ARG_SRC, input_memory }, {DNNL_ARG_WEIGHTS, filter_memory}, {DNNL_ARG_BIAS, bias_memory}, {DNNL_ARG_DST, output_memory} });
+    std::unordered_map<int, dnnl::memory> args = { { DNNL_ARG_SRC, input_memory }, {DNNL_ARG_WEIGHTS, filter_memory}, {DNNL_ARG_BIAS, bias_memory}, {DNNL_ARG_DST, output_memory} };
+    args.insert(post_ops_args.begin(), post_ops_args.end());
+    convolution.execute(stream, args);
     stream.wait();
 
     auto* out_dnnl_data = output_memory.map_data<uint8_t>();
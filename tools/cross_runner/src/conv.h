@@ -1,17 +1,25 @@
 #pragma once
 #include <vector>
 #include <random>
+#include <numeric>
+#include <cmath>
+#include <cstring>
 #include "dml_base_node.h"
 
+#include <dml_convolution.hpp>
+
 namespace gpu_op
 {
+/*
+*   Backward direction is transposed convolution: filter is (ic, oc / groups, kh, kw), output padding is added to the end of the output spatial dims.
+*/
 class Convolution : public DirectMlBaseNode
 {
 public:
     Convolution(const TensorShape& input_shape, const TensorShape& filter_shape, const TensorShape& output_shape,
         const DML_TENSOR_DATA_TYPE data_type, const dml::TensorPolicy& tensor_policy,
-        const TensorShape& stride_shape, std::uint32_t input_pad, std::uint32_t output_pad,
-            bool use_bias, bool allow_fp16_computations, 
+        const TensorShape& stride_shape, const std::array<std::uint32_t, 2>& dilation, std::uint32_t group_count, DML_CONVOLUTION_DIRECTION direction,
+            std::uint32_t input_pad, std::uint32_t output_pad, bool use_bias, bool allow_fp16_computations, bool fused_relu,
             IDMLDevice* dml_device, ID3D12Device* d3d12_device)
         : DirectMlBaseNode(dml_device, d3d12_device)
     {
@@ -22,7 +30,7 @@ public:
         const dml::TensorDimensions bias_dims{ 1, output_shape.c, 1, 1 };
 
         const std::array<std::uint32_t, 2> strides = { stride_shape.h, stride_shape.w };
-        const std::vector<std::uint32_t> dilations = { 1u, 1u };
+        const std::vector<std::uint32_t> dilations = { dilation[0], dilation[1] };
         const std::vector<std::uint32_t> start_pad = { input_pad, input_pad };
         const std::vector<std::uint32_t> end_pad = { input_pad, input_pad };
         const std::vector<std::uint32_t> out_pad = { output_pad, output_pad };
@@ -105,15 +113,18 @@ public:
         desc.BiasTensor = use_bias ? &bias_desc : nullptr;
         desc.OutputTensor = &output_desc;
         desc.Mode = DML_CONVOLUTION_MODE_CROSS_CORRELATION;
-        desc.Direction = DML_CONVOLUTION_DIRECTION_FORWARD;
+        desc.Direction = direction;
         desc.DimensionCount = 2;
         desc.Strides = strides.data();
         desc.Dilations = dilations.data();
         desc.StartPadding = start_pad.data();
         desc.EndPadding = end_pad.data();
         desc.OutputPadding = out_pad.data();
-        desc.GroupCount = 1u;
-        desc.FusedActivation = nullptr;
+        desc.GroupCount = group_count;
+        // fused activation has no tensors
+        DML_ACTIVATION_RELU_OPERATOR_DESC relu_desc{};
+        const DML_OPERATOR_DESC fused_activation_desc{ DML_OPERATOR_ACTIVATION_RELU, &relu_desc };
+        desc.FusedActivation = fused_relu ? &fused_activation_desc : nullptr;
 
         DML_OPERATOR_DESC dml_operator_desc{};
         dml_operator_desc.Type = DML_OPERATOR_CONVOLUTION;
@@ -198,6 +209,159 @@ private:
     std::optional<DML_BUFFER_TENSOR_DESC> tensor_bias_desc_;
     DML_BUFFER_TENSOR_DESC tensor_out_desc_;
 };
+
+/*
+*   Int8/uint8 convolution (DML_OPERATOR_QUANTIZED_LINEAR_CONVOLUTION): int8 weights with per output channel scales and zero points,
+*   per tensor scales and zero points of input and output, int32 bias and accumulation. Output has the data type of the input.
+*/
+class QuantizedConvolution : public DirectMlBaseNode
+{
+public:
+    // Scales and zero points, filter ones have output channels count of elements.
+    struct quantization_bindings_t
+    {
+        DML_BUFFER_BINDING input_scale;
+        DML_BUFFER_BINDING input_zero_point;
+        DML_BUFFER_BINDING filter_scales;
+        DML_BUFFER_BINDING filter_zero_points;
+        DML_BUFFER_BINDING output_scale;
+        DML_BUFFER_BINDING output_zero_point;
+    };
+
+public:
+    QuantizedConvolution(const TensorShape& input_shape, const TensorShape& filter_shape, const TensorShape& output_shape,
+        const DML_TENSOR_DATA_TYPE data_type, const dml::TensorPolicy& tensor_policy,
+        const TensorShape& stride_shape, const std::array<std::uint32_t, 2>& dilation, std::uint32_t group_count, std::uint32_t input_pad, bool use_bias,
+        IDMLDevice* dml_device, ID3D12Device* d3d12_device)
+        : DirectMlBaseNode(dml_device, d3d12_device)
+        , use_bias_(use_bias)
+    {
+        assert(data_type == DML_TENSOR_DATA_TYPE_INT8 || data_type == DML_TENSOR_DATA_TYPE_UINT8);
+
+        const dml::TensorDimensions input_dims{ input_shape.n, input_shape.c, input_shape.h, input_shape.w };
+        const dml::TensorDimensions filter_dims{ filter_shape.n, filter_shape.c, filter_shape.h, filter_shape.w };
+        const dml::TensorDimensions output_dims{ output_shape.n, output_shape.c, output_shape.h, output_shape.w };
+        const dml::TensorDimensions per_tensor_dims{ 1, 1, 1, 1 };
+        const dml::TensorDimensions per_channel_dims{ 1, output_shape.c, 1, 1 };
+
+        const std::array<std::uint32_t, 2> strides = { stride_shape.h, stride_shape.w };
+        const std::array<std::uint32_t, 2> dilations = dilation;
+        const std::array<std::uint32_t, 2> start_pad = { input_pad, input_pad };
+        const std::array<std::uint32_t, 2> end_pad = { input_pad, input_pad };
+
+        // buffer descs point to strides of the properties, they have to live until the operator is created
+        std::vector<dml::TensorProperties> tensors_properties;
+        tensors_properties.reserve(10);
+        auto make_buffer_desc = [&](DML_TENSOR_DATA_TYPE dt, const dml::TensorDimensions& dims, const dml::TensorPolicy& policy)
+        {
+            const auto& properties = tensors_properties.emplace_back(policy.Get(dt, DML_TENSOR_FLAG_NONE, dims));
+            DML_BUFFER_TENSOR_DESC ret{};
+            ret.DataType = dt;
+            ret.Flags = DML_TENSOR_FLAG_NONE;
+            ret.DimensionCount = static_cast<std::uint32_t>(dims.size());
+            ret.Sizes = dims.data();
+            ret.Strides = properties.strides.has_value() ? properties.strides->data() : nullptr;
+            ret.TotalTensorSizeInBytes = properties.totalTensorSizeInBytes;
+            ret.GuaranteedBaseOffsetAlignment = properties.guaranteedBaseOffsetAlignment;
+            return ret;
+        };
+
+        const auto default_policy = dml::TensorPolicy::Default();
+        const DML_BUFFER_TENSOR_DESC input_buffer_desc = make_buffer_desc(data_type, input_dims, tensor_policy);
+        const DML_BUFFER_TENSOR_DESC input_scale_buffer_desc = make_buffer_desc(DML_TENSOR_DATA_TYPE_FLOAT32, per_tensor_dims, default_policy);
+        const DML_BUFFER_TENSOR_DESC input_zero_point_buffer_desc = make_buffer_desc(data_type, per_tensor_dims, default_policy);
+        const DML_BUFFER_TENSOR_DESC filter_buffer_desc = make_buffer_desc(DML_TENSOR_DATA_TYPE_INT8, filter_dims, tensor_policy);
+        const DML_BUFFER_TENSOR_DESC filter_scales_buffer_desc = make_buffer_desc(DML_TENSOR_DATA_TYPE_FLOAT32, per_channel_dims, default_policy);
+        const DML_BUFFER_TENSOR_DESC filter_zero_points_buffer_desc = make_buffer_desc(DML_TENSOR_DATA_TYPE_INT8, per_channel_dims, default_policy);
+        const DML_BUFFER_TENSOR_DESC bias_buffer_desc = make_buffer_desc(DML_TENSOR_DATA_TYPE_INT32, per_channel_dims, default_policy);
+        const DML_BUFFER_TENSOR_DESC output_scale_buffer_desc = make_buffer_desc(DML_TENSOR_DATA_TYPE_FLOAT32, per_tensor_dims, default_policy);
+        const DML_BUFFER_TENSOR_DESC output_zero_point_buffer_desc = make_buffer_desc(data_type, per_tensor_dims, default_policy);
+        const DML_BUFFER_TENSOR_DESC output_buffer_desc = make_buffer_desc(data_type, output_dims, tensor_policy);
+
+        const DML_TENSOR_DESC input_desc{ DML_TENSOR_TYPE_BUFFER, &input_buffer_desc };
+        const DML_TENSOR_DESC input_scale_desc{ DML_TENSOR_TYPE_BUFFER, &input_scale_buffer_desc };
+        const DML_TENSOR_DESC input_zero_point_desc{ DML_TENSOR_TYPE_BUFFER, &input_zero_point_buffer_desc };
+        const DML_TENSOR_DESC filter_desc{ DML_TENSOR_TYPE_BUFFER, &filter_buffer_desc };
+        const DML_TENSOR_DESC filter_scales_desc{ DML_TENSOR_TYPE_BUFFER, &filter_scales_buffer_desc };
+        const DML_TENSOR_DESC filter_zero_points_desc{ DML_TENSOR_TYPE_BUFFER, &filter_zero_points_buffer_desc };
+        const DML_TENSOR_DESC bias_desc{ DML_TENSOR_TYPE_BUFFER, &bias_buffer_desc };
+        const DML_TENSOR_DESC output_scale_desc{ DML_TENSOR_TYPE_BUFFER, &output_scale_buffer_desc };
+        const DML_TENSOR_DESC output_zero_point_desc{ DML_TENSOR_TYPE_BUFFER, &output_zero_point_buffer_desc };
+        const DML_TENSOR_DESC output_desc{ DML_TENSOR_TYPE_BUFFER, &output_buffer_desc };
+
+        DML_QUANTIZED_LINEAR_CONVOLUTION_OPERATOR_DESC desc = {};
+        desc.InputTensor = &input_desc;
+        desc.InputScaleTensor = &input_scale_desc;
+        desc.InputZeroPointTensor = &input_zero_point_desc;
+        desc.FilterTensor = &filter_desc;
+        desc.FilterScaleTensor = &filter_scales_desc;
+        desc.FilterZeroPointTensor = &filter_zero_points_desc;
+        desc.BiasTensor = use_bias ? &bias_desc : nullptr;
+        desc.OutputScaleTensor = &output_scale_desc;
+        desc.OutputZeroPointTensor = &output_zero_point_desc;
+        desc.OutputTensor = &output_desc;
+        desc.DimensionCount = 2;
+        desc.Strides = strides.data();
+        desc.Dilations = dilations.data();
+        desc.StartPadding = start_pad.data();
+        desc.EndPadding = end_pad.data();
+        desc.GroupCount = group_count;
+
+        DML_OPERATOR_DESC dml_operator_desc{};
+        dml_operator_desc.Type = DML_OPERATOR_QUANTIZED_LINEAR_CONVOLUTION;
+        dml_operator_desc.Desc = &desc;
+
+        throw_if_failed(dml_device->CreateOperator(
+            &dml_operator_desc, IID_PPV_ARGS(dml_operator_.ReleaseAndGetAddressOf())), "create quantized convolution operator");
+
+        throw_if_failed(dml_device->CompileOperator(
+            dml_operator_.Get(),
+            DML_EXECUTION_FLAG_DESCRIPTORS_VOLATILE,
+            IID_PPV_ARGS(dml_op_executor_.ReleaseAndGetAddressOf())), "create quantized convolution compiled operator");
+
+        create_operator_impl();
+    }
+
+    void record_execute(IDMLCommandRecorder* dml_cmd_recorder, ID3D12GraphicsCommandList* cmd_list, ID3D12Resource* resource_out,
+        ID3D12Resource* resource_input, ID3D12Resource* resource_filter, ID3D12Resource* resource_bias, const quantization_bindings_t& quantization)
+    {
+        assert(((resource_bias != nullptr) == use_bias_) && "bias resources is not matching what was expected.");
+
+        DML_BUFFER_BINDING input_buffer_binding{ resource_input, 0, resource_input->GetDesc().Width };
+        DML_BUFFER_BINDING filter_buffer_binding{ resource_filter, 0, resource_filter->GetDesc().Width };
+        DML_BUFFER_BINDING bias_buffer_binding{};
+
+        // order of the operator desc tensors
+        std::vector<DML_BINDING_DESC> input_bindings;
+        input_bindings.reserve(9);
+        input_bindings.push_back({ DML_BINDING_TYPE_BUFFER, &input_buffer_binding });
+        input_bindings.push_back({ DML_BINDING_TYPE_BUFFER, &quantization.input_scale });
+        input_bindings.push_back({ DML_BINDING_TYPE_BUFFER, &quantization.input_zero_point });
+        input_bindings.push_back({ DML_BINDING_TYPE_BUFFER, &filter_buffer_binding });
+        input_bindings.push_back({ DML_BINDING_TYPE_BUFFER, &quantization.filter_scales });
+        input_bindings.push_back({ DML_BINDING_TYPE_BUFFER, &quantization.filter_zero_points });
+        if (resource_bias)
+        {
+            bias_buffer_binding = { resource_bias, 0, resource_bias->GetDesc().Width };
+            input_bindings.push_back({ DML_BINDING_TYPE_BUFFER, &bias_buffer_binding });
+        }
+        else
+        {
+            input_bindings.push_back({ DML_BINDING_TYPE_NONE, nullptr });
+        }
+        input_bindings.push_back({ DML_BINDING_TYPE_BUFFER, &quantization.output_scale });
+        input_bindings.push_back({ DML_BINDING_TYPE_BUFFER, &quantization.output_zero_point });
+
+        DML_BUFFER_BINDING output_buffer_binding{ resource_out, 0, resource_out->GetDesc().Width };
+        DML_BINDING_DESC output_binding_desc{ DML_BINDING_TYPE_BUFFER, &output_buffer_binding };
+
+        record_execute_impl(dml_cmd_recorder, cmd_list, input_bindings, output_binding_desc);
+    }
+
+private:
+    ComPtr<IDMLOperator> dml_operator_;
+    bool use_bias_ = false;
+};
 }
 
 namespace cpu_op
@@ -216,6 +380,24 @@ struct bindings_t
     binding_t input;
     binding_t filter;
     binding_t bias;
+    // tensors of opts_t::post_ops in binding order (see libdml::PostOp)
+    std::vector<binding_t> post_ops;
+};
+
+/*
+*   Quantized convolution (int8/uint8 input and output, int8 filter, int32 bias): real value is scale * (q - zero_point).
+*   Accumulation is exact in int32, bias is added to accumulators (its scale is input_scale * filter_scales[oc]),
+*   then result is requantized with round to nearest even and saturated to the output data type.
+*/
+struct quantization_t
+{
+    float input_scale = 1.0f;
+    std::int32_t input_zero_point = 0;
+    // per output channel
+    std::vector<float> filter_scales;
+    std::vector<std::int8_t> filter_zero_points;
+    float output_scale = 1.0f;
+    std::int32_t output_zero_point = 0;
 };
 
 struct opts_t
@@ -224,9 +406,23 @@ struct opts_t
     std::uint32_t out_pad;
     TensorShape stride;
     TensorShape output_shape;
+    // filter shape is (oc, ic / groups, kh, kw), depthwise convolution has groups == ic == oc
+    std::array<std::uint32_t, 2> dilation{ 1u, 1u };
+    std::uint32_t groups = 1;
+    // transposed convolution (backward data): filter shape is (ic, oc / groups, kh, kw), out_pad is ignored (it's already in output_shape)
+    bool transposed = false;
 
     DataType out_dt = DataType::eCount;
     DataLayout out_layout = DataLayout::eCount;
+
+    // set for int8/uint8 data types
+    std::optional<quantization_t> quantization = std::nullopt;
+
+    // same chain as in libdml::ConvolutionDescriptor, evaluated after bias (host paths support only activations)
+    libdml::PostOps post_ops;
+
+    // fp16/fp32 convolution is calculated on the host instead of oneDNN GPU engine (reference calculated while GPU is timed)
+    bool host_only = false;
 };
 std::vector<std::byte> convolution(const bindings_t& bindings, opts_t opts);
 }
@@ -244,22 +440,43 @@ public:
         std::uint32_t in_pad;
         std::uint32_t out_pad;
         TensorShape stride;
+        std::array<std::uint32_t, 2> dilation{ 1u, 1u };
+        std::uint32_t groups = 1;
+        // set by conv_transposed_dml node: filter shape is (ic, oc / groups, kh, kw), out_pad is output padding of transposed convolution
+        bool transposed = false;
         bool no_bias = false;
         bool allow_fp16_computations = false;
+        // fused into the convolution (DML fused activation, CM kernels) and applied by the reference
+        libdml::ActivationType activation = libdml::ActivationType::eUndefined;
         bool managaed_weights = false; // ToDo: pass it to DML class so its actually beigned used
 
+        // int8/uint8 data type only, filter scales and zero points are generated per output channel
+        float input_scale = 1.0f / 128.0f;
+        std::int32_t input_zero_point = 0;
+        float output_scale = 0.0f;  // 0 - derived from the generated data, so outputs don't saturate
+        std::int32_t output_zero_point = 0;
+
         inline static void add_cli_options(CLI::App* opts, create_params_t& params)
         {
-            add_data_type_cli_option(opts, "--data_type", params.dt)->required();
+            add_data_type_cli_option(opts, "--data_type", params.dt, { DataType::eFp32, DataType::eFp16, DataType::eInt8, DataType::eUint8 })->required();
             add_data_layout_cli_option(opts, "--layout", params.layout)->required();
             opts->add_option("--input_shape", params.input_shape, "speciify list: <n, ic, h, w")->required();
-            opts->add_option("--filter_shape", params.filter_shape, "speciify list: <oc, ic, kh, kw")->required();
+            opts->add_option("--filter_shape", params.filter_shape, "speciify list: <oc, ic / groups, kh, kw (conv_transposed_dml: ic, oc / groups, kh, kw)")->required();
             opts->add_option("--in_pad", params.in_pad)->required();
             opts->add_option("--out_pad", params.out_pad)->required();
             opts->add_option("--stride", params.stride, "speciify list: <stride_h, stride_w>")->required();
+            opts->add_option("--dilation", params.dilation, "speciify list: <dilation_h, dilation_w>")->delimiter(',');
+            opts->add_option("--groups", params.groups, "Input and output channels are split into groups, depthwise convolution has groups equal to input channels.")->check(CLI::PositiveNumber);
             opts->add_flag("--no_bias", params.no_bias);
             opts->add_flag("--allow_fp16_computations", params.allow_fp16_computations);
-
+            opts->add_option("--activation", params.activation, "Activation fused into convolution, checked against the reference post ops.")
+                ->transform(CLI::CheckedTransformer(std::map<std::string, libdml::ActivationType>{
+                    { "relu", libdml::ActivationType::eRelu }
+            }, CLI::ignore_case));
+            opts->add_option("--input_scale", params.input_scale, "Scale of quantized input.")->check(CLI::PositiveNumber);
+            opts->add_option("--input_zero_point", params.input_zero_point, "Zero point of quantized input.");
+            opts->add_option("--output_scale", params.output_scale, "Scale of quantized output, derived from the data if not set.")->check(CLI::PositiveNumber);
+            opts->add_option("--output_zero_point", params.output_zero_point, "Zero point of quantized output.");
         }
     };
 
@@ -267,13 +484,24 @@ public:
         : params_(std::move(params))
         , d3d12_device_(d3d12_device)
         , input_data_(params_.input_shape.get_elements_count()* get_data_type_bytes_width(params_.dt))
-        , filter_data_(params_.filter_shape.get_elements_count()* get_data_type_bytes_width(params_.dt))
+        , filter_data_(params_.filter_shape.get_elements_count()* get_data_type_bytes_width(get_filter_data_type()))
 
     {
-        assert(params_.input_shape.c == params_.filter_shape.c);
+        if (params_.dilation[0] == 0 || params_.dilation[1] == 0)
+        {
+            throw std::runtime_error("Dilation has to be at least 1.");
+        }
+        if (params_.transposed)
+        {
+            validate_transposed_params();
+        }
+        else if (params_.input_shape.c != params_.filter_shape.c * params_.groups || params_.filter_shape.n % params_.groups != 0)
+        {
+            throw std::runtime_error("Filter shape is not matching input channels and groups (filter ic has to be input channels / groups, oc divisible by groups).");
+        }
         if (!params_.no_bias)
         {
-            bias_data_ = std::vector<std::byte>(params_.filter_shape.n * get_data_type_bytes_width(params_.dt));
+            bias_data_ = std::vector<std::byte>(get_output_channels() * get_data_type_bytes_width(get_bias_data_type()));
         }
         // randomize data
         std::mt19937 random_generator(42); // static, create it once!
@@ -305,6 +533,10 @@ public:
                 randomize_linear_container_half(random_generator, uniform_distribution, bias_data_);
             }
         }
+        else if (is_quantized())
+        {
+            randomize_quantized_data(random_generator);
+        }
         else
         {
             assert(false && "Unsupported data type in convolution dispatcher!");
@@ -316,8 +548,6 @@ public:
         const auto output_shape = get_output_shape();
         const auto tensor_out_bytes_width = output_shape.get_elements_count() * get_data_type_bytes_width(params_.dt);
 
-        upload_buffer_ = create_buffer(d3d12_device_, tensor_input_bytes_width + tensor_filter_bytes_width + tensor_bias_bytes_width,
-            D3D12_HEAP_TYPE_UPLOAD, D3D12_RESOURCE_STATE_GENERIC_READ);
         input_buffer_ = create_buffer(d3d12_device, tensor_input_bytes_width,
             D3D12_HEAP_TYPE_DEFAULT, D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS);
         filter_buffer_ = create_buffer(d3d12_device, tensor_filter_bytes_width,
@@ -329,30 +559,24 @@ public:
         }
         output_buffer_ = create_buffer(d3d12_device, tensor_out_bytes_width,
             D3D12_HEAP_TYPE_DEFAULT, D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS);
-
-        // copy data into buffer
-        std::byte* upload_mapped_ptr = nullptr;
-        upload_buffer_->Map(0, nullptr, reinterpret_cast<void**>(&upload_mapped_ptr));
-        std::size_t memcopy_offset = 0;
-        std::memcpy(upload_mapped_ptr, input_data_.data(), tensor_input_bytes_width);
-        memcopy_offset += tensor_input_bytes_width;
-        std::memcpy(upload_mapped_ptr + memcopy_offset, filter_data_.data(), tensor_filter_bytes_width);
-        if (use_bias())
+        const auto quantization_data = is_quantized() ? get_quantization_data() : std::vector<std::byte>{};
+        if (is_quantized())
         {
-            memcopy_offset += tensor_filter_bytes_width;
-            std::memcpy(upload_mapped_ptr + memcopy_offset, bias_data_.data(), tensor_bias_bytes_width);
+            quantization_buffer_ = create_buffer(d3d12_device, quantization_data.size(),
+                D3D12_HEAP_TYPE_DEFAULT, D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS);
         }
-        // unmap memory
-        upload_buffer_->Unmap(0, nullptr);
 
-        memcopy_offset = 0;
-        cmd_list->CopyBufferRegion(input_buffer_.Get(), 0, upload_buffer_.Get(), 0, tensor_input_bytes_width);
-        memcopy_offset += tensor_input_bytes_width;
-        cmd_list->CopyBufferRegion(filter_buffer_.Get(), 0, upload_buffer_.Get(), memcopy_offset, tensor_filter_bytes_width);
+        // copy data into buffers, barriers below are executed after the uploads (see close_execute_reset_wait)
+        auto& staging_ring = get_staging_ring();
+        staging_ring.upload(input_buffer_.Get(), 0, input_data_);
+        staging_ring.upload(filter_buffer_.Get(), 0, filter_data_);
         if (use_bias())
         {
-            memcopy_offset += tensor_filter_bytes_width;
-            cmd_list->CopyBufferRegion(bias_buffer_.Get(), 0, upload_buffer_.Get(), memcopy_offset, tensor_bias_bytes_width);
+            staging_ring.upload(bias_buffer_.Get(), 0, bias_data_);
+        }
+        if (is_quantized())
+        {
+            staging_ring.upload(quantization_buffer_.Get(), 0, quantization_data);
         }
 
         std::vector<CD3DX12_RESOURCE_BARRIER> barriers;
@@ -365,61 +589,327 @@ public:
             barriers.push_back(CD3DX12_RESOURCE_BARRIER::Transition(bias_buffer_.Get(),
                 D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_UNORDERED_ACCESS));
         }
+        if (is_quantized())
+        {
+            barriers.push_back(CD3DX12_RESOURCE_BARRIER::Transition(quantization_buffer_.Get(),
+                D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_UNORDERED_ACCESS));
+        }
         cmd_list->ResourceBarrier(static_cast<std::uint32_t>(barriers.size()), barriers.data());
     }
 
     ConformanceResult validate_conformance(ID3D12CommandQueue* command_queue,
         ID3D12CommandAllocator* command_allocator, ID3D12GraphicsCommandList* command_list) override
+    {
+        return validate_conformance_with_reference(get_reference_result(command_queue, command_allocator, command_list), command_queue, command_allocator, command_list);
+    }
+
+    ConformanceResult validate_conformance_with_reference(const std::vector<std::byte>& reference, ID3D12CommandQueue* command_queue,
+        ID3D12CommandAllocator* command_allocator, ID3D12GraphicsCommandList* command_list) override
     {
         const auto tensor_out_bytes_width = output_buffer_->GetDesc().Width;
 
         // readback data and validate
-        auto readback_buffer = create_buffer(d3d12_device_, tensor_out_bytes_width, D3D12_HEAP_TYPE_READBACK, D3D12_RESOURCE_STATE_COPY_DEST);
-        auto readback_output_barrirer = CD3DX12_RESOURCE_BARRIER::Transition(output_buffer_.Get(),
-            D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_COPY_SOURCE);
-        command_list->ResourceBarrier(1, &readback_output_barrirer);
-        command_list->CopyResource(readback_buffer.Get(), output_buffer_.Get());
-        close_execute_reset_wait(d3d12_device_, command_queue, command_allocator, command_list);
-
-        std::vector<std::byte> data_out(tensor_out_bytes_width);
-        std::byte* readback_mapped_ptr = nullptr;
-        readback_buffer->Map(0, nullptr, reinterpret_cast<void**>(&readback_mapped_ptr));
-        std::memcpy(data_out.data(), readback_mapped_ptr, data_out.size());
-        readback_buffer->Unmap(0, nullptr);
-
-        const auto dnnl_untyped_result = get_dnnl_result();
+        const auto data_out = readback_buffer_data(d3d12_device_, command_queue, command_allocator, command_list, output_buffer_.Get(), tensor_out_bytes_width);
 
         if (params_.dt == DataType::eFp32)
         {
-            return run_conformance_check<float>(data_out, dnnl_untyped_result, 0.001f);
+            return run_conformance_check<float>(data_out, reference, 0.001f);
         }
         else if (params_.dt == DataType::eFp16)
         {
-            return run_conformance_check<Half>(data_out, dnnl_untyped_result, 0.05f);
+            return run_conformance_check<Half>(data_out, reference, 0.05f);
+        }
+        // accumulators are exact, requantization (fp32 multiply and rounding) can differ by one step
+        else if (params_.dt == DataType::eInt8)
+        {
+            return run_conformance_check<std::int8_t>(data_out, reference, 1.0f);
+        }
+        else if (params_.dt == DataType::eUint8)
+        {
+            return run_conformance_check<std::uint8_t>(data_out, reference, 1.0f);
         }
         assert(false && "Unsupported output data type!");
         ConformanceResult ret{};
         return ret;
     }
 
+    std::vector<std::byte> get_reference_result(ID3D12CommandQueue* command_queue,
+        ID3D12CommandAllocator* command_allocator, ID3D12GraphicsCommandList* command_list) override
+    {
+        if (auto async_result = async_reference_.take())
+        {
+            return std::move(*async_result);
+        }
+        return get_cpu_reference_result();
+    }
+
+    // oneDNN reference runs on the GPU engine and would disturb the timed iterations, so async reference is always calculated on the host
+    bool start_reference_async() override
+    {
+        async_reference_.start([this]() { return get_cpu_reference_result(true); });
+        return true;
+    }
+
+    ID3D12Resource* get_output_resource() override
+    {
+        return output_buffer_.Get();
+    }
+
+    ID3D12Resource* get_input_resource(std::uint32_t idx) override
+    {
+        assert(idx < 3);
+        return idx == 0 ? input_buffer_.Get() : (idx == 1 ? filter_buffer_.Get() : bias_buffer_.Get());
+    }
+
+    void set_input_resource(std::uint32_t idx, ComPtr<ID3D12Resource> resource) override
+    {
+        // weights can be reordered at construction time, so only activations can come from other nodes
+        if (idx != 0)
+        {
+            throw std::runtime_error("Only input tensor of convolution can be linked to other node.");
+        }
+        check_input_resource_size(resource.Get(), input_data_.size());
+        input_buffer_ = std::move(resource);
+    }
+
+    const std::vector<std::byte>& get_input_data(std::uint32_t idx) const override
+    {
+        assert(idx < 3);
+        return idx == 0 ? input_data_ : (idx == 1 ? filter_data_ : bias_data_);
+    }
+
+    void set_input_data(std::uint32_t idx, std::vector<std::byte> data) override
+    {
+        assert(idx < 3);
+        auto& input_data = idx == 0 ? input_data_ : (idx == 1 ? filter_data_ : bias_data_);
+        check_input_data_size(data, input_data.size());
+        async_reference_.cancel();
+        input_data = std::move(data);
+    }
+
+    LayerCost get_layer_cost() const override
+    {
+        const auto output_shape = get_output_shape();
+        const auto dt_size = get_data_type_bytes_width(params_.dt);
+        // every filter element is applied once per pixel of the output (forward) or of the input (transposed)
+        const auto& pixels_shape = params_.transposed ? params_.input_shape : output_shape;
+        const auto macs = static_cast<std::uint64_t>(params_.filter_shape.get_elements_count()) * pixels_shape.n * pixels_shape.h * pixels_shape.w;
+
+        LayerCost ret{};
+        ret.flops = 2 * macs;
+        if (use_bias())
+        {
+            ret.flops += output_shape.get_elements_count();
+        }
+        ret.bytes = input_data_.size() + filter_data_.size() + bias_data_.size() + output_shape.get_elements_count() * dt_size;
+        return ret;
+    }
+
+    DataType get_compute_data_type() const override
+    {
+        return params_.dt;
+    }
+
 protected:
     inline TensorShape get_output_shape() const
     {
         TensorShape ret;
         ret.n = params_.input_shape.n;
-        ret.c = params_.filter_shape.n; // output channels
+        ret.c = get_output_channels();
         ret.d = 0;
-        ret.h = (params_.input_shape.h - params_.filter_shape.h + params_.in_pad + params_.in_pad) / params_.stride.h + 1;
-        ret.w = (params_.input_shape.w - params_.filter_shape.w + params_.in_pad + params_.in_pad) / params_.stride.w + 1;
+        // dilated kernel covers (k - 1) * dilation + 1 input pixels
+        const auto kernel_extent_h = (params_.filter_shape.h - 1) * params_.dilation[0] + 1;
+        const auto kernel_extent_w = (params_.filter_shape.w - 1) * params_.dilation[1] + 1;
+        if (params_.transposed)
+        {
+            // inverse of the forward formula, output padding resolves ambiguity of strided sizes
+            ret.h = (params_.input_shape.h - 1) * params_.stride.h + kernel_extent_h + params_.out_pad - params_.in_pad - params_.in_pad;
+            ret.w = (params_.input_shape.w - 1) * params_.stride.w + kernel_extent_w + params_.out_pad - params_.in_pad - params_.in_pad;
+            return ret;
+        }
+        ret.h = (params_.input_shape.h - kernel_extent_h + params_.in_pad + params_.in_pad) / params_.stride.h + 1;
+        ret.w = (params_.input_shape.w - kernel_extent_w + params_.in_pad + params_.in_pad) / params_.stride.w + 1;
         return ret;
     }
 
+    inline std::uint32_t get_output_channels() const
+    {
+        return params_.transposed ? params_.filter_shape.c * params_.groups : params_.filter_shape.n;
+    }
+
+    void validate_transposed_params() const
+    {
+        if (is_quantized())
+        {
+            throw std::runtime_error("DML quantized convolution has no backward direction, transposed convolution supports only fp32 and fp16.");
+        }
+        if (params_.input_shape.c != params_.filter_shape.n || params_.filter_shape.n % params_.groups != 0)
+        {
+            throw std::runtime_error("Transposed convolution filter shape is not matching input channels and groups (filter first dim has to be input channels, divisible by groups).");
+        }
+        // same rule as ONNX ConvTranspose, bigger padding would add outputs not reached by any input
+        if (params_.out_pad >= std::max(params_.stride.h, params_.dilation[0]) || params_.out_pad >= std::max(params_.stride.w, params_.dilation[1]))
+        {
+            throw std::runtime_error("Transposed convolution output padding has to be smaller than stride or dilation.");
+        }
+        const auto kernel_extent_h = (params_.filter_shape.h - 1) * params_.dilation[0] + 1;
+        const auto kernel_extent_w = (params_.filter_shape.w - 1) * params_.dilation[1] + 1;
+        if ((params_.input_shape.h - 1) * params_.stride.h + kernel_extent_h + params_.out_pad <= 2 * params_.in_pad
+            || (params_.input_shape.w - 1) * params_.stride.w + kernel_extent_w + params_.out_pad <= 2 * params_.in_pad)
+        {
+            throw std::runtime_error("Transposed convolution padding removes whole output.");
+        }
+    }
+
     inline bool use_bias() const
     {
         return !params_.no_bias;
     }
 
-    std::vector<std::byte> get_dnnl_result() const
+    libdml::PostOps get_post_ops() const
+    {
+        libdml::PostOps ret{};
+        if (params_.activation != libdml::ActivationType::eUndefined)
+        {
+            ret.push_back(libdml::PostOp{ libdml::PostOpType::eActivation, libdml::Activation{ params_.activation } });
+        }
+        return ret;
+    }
+
+    inline bool is_quantized() const
+    {
+        return params_.dt == DataType::eInt8 || params_.dt == DataType::eUint8;
+    }
+
+    inline DataType get_filter_data_type() const
+    {
+        return is_quantized() ? DataType::eInt8 : params_.dt;
+    }
+
+    inline DataType get_bias_data_type() const
+    {
+        return is_quantized() ? DataType::eInt32 : params_.dt;
+    }
+
+    // Scales and zero points of quantized convolution share one buffer, every param has own slot (DML binding offsets have to be aligned).
+    enum class QuantizationParam
+    {
+        eInputScale = 0,
+        eInputZeroPoint,
+        eFilterScales,
+        eFilterZeroPoints,
+        eOutputScale,
+        eOutputZeroPoint,
+        eCount
+    };
+
+    inline std::uint64_t get_quantization_slot_size() const
+    {
+        return round_up_next_multiple<std::uint64_t>(params_.filter_shape.n * sizeof(float), 256);
+    }
+
+    inline std::uint64_t get_quantization_param_offset(QuantizationParam param) const
+    {
+        return static_cast<std::uint64_t>(param) * get_quantization_slot_size();
+    }
+
+    std::vector<std::byte> get_quantization_data() const
+    {
+        std::vector<std::byte> ret(get_quantization_param_offset(QuantizationParam::eCount));
+        auto write = [&](QuantizationParam param, const void* values, std::size_t bytes_width)
+        {
+            std::memcpy(ret.data() + get_quantization_param_offset(param), values, bytes_width);
+        };
+        // zero points have data type of the tensor, int8 and uint8 have the same bit pattern for in range values
+        const auto input_zero_point = static_cast<std::uint8_t>(params_.input_zero_point);
+        const auto output_zero_point = static_cast<std::uint8_t>(params_.output_zero_point);
+        write(QuantizationParam::eInputScale, &params_.input_scale, sizeof(float));
+        write(QuantizationParam::eInputZeroPoint, &input_zero_point, sizeof(input_zero_point));
+        write(QuantizationParam::eFilterScales, filter_scales_.data(), filter_scales_.size() * sizeof(float));
+        write(QuantizationParam::eFilterZeroPoints, filter_zero_points_.data(), filter_zero_points_.size() * sizeof(std::int8_t));
+        write(QuantizationParam::eOutputScale, &params_.output_scale, sizeof(float));
+        write(QuantizationParam::eOutputZeroPoint, &output_zero_point, sizeof(output_zero_point));
+        return ret;
+    }
+
+    /*
+    *   Input and filter cover full range of the data types, filter scales and zero points are random per output channel.
+    *   If output scale is not given, it's chosen so rms of the outputs is 32 quantization steps.
+    */
+    void randomize_quantized_data(std::mt19937& random_generator)
+    {
+        const auto min_value = params_.dt == DataType::eInt8 ? -128 : 0;
+        const auto max_value = params_.dt == DataType::eInt8 ? 127 : 255;
+        if (params_.input_zero_point < min_value || params_.input_zero_point > max_value
+            || params_.output_zero_point < min_value || params_.output_zero_point > max_value)
+        {
+            throw std::runtime_error("Quantized convolution zero points have to be in range of the data type.");
+        }
+
+        std::uniform_int_distribution<std::int32_t> input_distribution(min_value, max_value);
+        if (params_.dt == DataType::eInt8)
+        {
+            randomize_linear_container_integer<std::int8_t>(random_generator, input_distribution, input_data_);
+        }
+        else
+        {
+            randomize_linear_container_integer<std::uint8_t>(random_generator, input_distribution, input_data_);
+        }
+        std::uniform_int_distribution<std::int32_t> filter_distribution(-127, 127);
+        randomize_linear_container_integer<std::int8_t>(random_generator, filter_distribution, filter_data_);
+        if (use_bias())
+        {
+            std::uniform_int_distribution<std::int32_t> bias_distribution(-4096, 4096);
+            randomize_linear_container_integer<std::int32_t>(random_generator, bias_distribution, bias_data_);
+        }
+
+        const auto oc = params_.filter_shape.n;
+        std::uniform_real_distribution<float> scale_distribution(0.5f / 128.0f, 2.0f / 128.0f);
+        std::uniform_int_distribution<std::int32_t> zero_point_distribution(-8, 8);
+        filter_scales_.resize(oc);
+        filter_zero_points_.resize(oc);
+        for (std::uint32_t i = 0; i < oc; i++)
+        {
+            filter_scales_[i] = scale_distribution(random_generator);
+            filter_zero_points_[i] = static_cast<std::int8_t>(zero_point_distribution(random_generator));
+        }
+
+        if (params_.output_scale == 0.0f)
+        {
+            // accumulator is sum of K products of independent values: rms^2 = K * E[a^2] * E[b^2] + (K * E[a] * E[b])^2
+            double input_mean = 0.0;
+            double input_square_mean = 0.0;
+            for (std::size_t i = 0; i < input_data_.size(); i++)
+            {
+                const auto value = params_.dt == DataType::eInt8 ? static_cast<std::int32_t>(static_cast<std::int8_t>(input_data_[i])) : static_cast<std::int32_t>(input_data_[i]);
+                const auto centered = static_cast<double>(value - params_.input_zero_point);
+                input_mean += centered;
+                input_square_mean += centered * centered;
+            }
+            input_mean /= static_cast<double>(input_data_.size());
+            input_square_mean /= static_cast<double>(input_data_.size());
+
+            // filter layouts have output channels as the outermost dimension
+            const auto macs_per_output = filter_data_.size() / oc;
+            double filter_mean = 0.0;
+            double filter_square_mean = 0.0;
+            for (std::size_t i = 0; i < filter_data_.size(); i++)
+            {
+                const auto centered = static_cast<double>(static_cast<std::int8_t>(filter_data_[i]) - filter_zero_points_[i / macs_per_output]);
+                filter_mean += centered;
+                filter_square_mean += centered * centered;
+            }
+            filter_mean /= static_cast<double>(filter_data_.size());
+            filter_square_mean /= static_cast<double>(filter_data_.size());
+
+            const auto k = static_cast<double>(macs_per_output);
+            const auto accumulator_rms = std::sqrt(k * input_square_mean * filter_square_mean + std::pow(k * input_mean * filter_mean, 2.0));
+            const auto filter_scale_mean = std::accumulate(filter_scales_.begin(), filter_scales_.end(), 0.0) / oc;
+            params_.output_scale = static_cast<float>(params_.input_scale * filter_scale_mean * accumulator_rms / 32.0);
+        }
+    }
+
+    std::vector<std::byte> get_cpu_reference_result(bool host_only = false) const
     {
         cpu_op::bindings_t bindings{};
         {
@@ -431,25 +921,41 @@ protected:
 
         {
             bindings.filter.data = filter_data_.data();
-            bindings.filter.dt = params_.dt;
+            bindings.filter.dt = get_filter_data_type();
             bindings.filter.layout = params_.layout;
             bindings.filter.shape = params_.filter_shape;
         }
         if (use_bias())
         {
             bindings.bias.data = bias_data_.data();
-            bindings.bias.dt = params_.dt;
+            bindings.bias.dt = get_bias_data_type();
             bindings.bias.layout = params_.layout;
-            bindings.bias.shape = TensorShape(params_.filter_shape.n, 1u, 1u, 1u);
+            bindings.bias.shape = TensorShape(get_output_channels(), 1u, 1u, 1u);
         }
+        auto opts = get_cpu_reference_opts();
+        opts.host_only = host_only;
+        return cpu_op::convolution(bindings, opts);
+    }
+
+    cpu_op::opts_t get_cpu_reference_opts() const
+    {
         cpu_op::opts_t opts{};
         opts.output_shape = get_output_shape();
         opts.inp_pad = params_.in_pad;
         opts.out_pad = params_.out_pad;
         opts.stride = params_.stride;
+        opts.dilation = params_.dilation;
+        opts.groups = params_.groups;
+        opts.transposed = params_.transposed;
         opts.out_layout = params_.layout;
         opts.out_dt = params_.dt;
-        return cpu_op::convolution(bindings, opts);
+        opts.post_ops = get_post_ops();
+        if (is_quantized())
+        {
+            opts.quantization = cpu_op::quantization_t{ params_.input_scale, params_.input_zero_point, filter_scales_, filter_zero_points_,
+                params_.output_scale, params_.output_zero_point };
+        }
+        return opts;
     }
 
 protected:
@@ -459,12 +965,18 @@ protected:
     std::vector<std::byte> input_data_;
     std::vector<std::byte> filter_data_;
     std::vector<std::byte> bias_data_;
+    // quantized convolution only
+    std::vector<float> filter_scales_;
+    std::vector<std::int8_t> filter_zero_points_;
 
     ComPtr<ID3D12Resource> input_buffer_;
     ComPtr<ID3D12Resource> filter_buffer_;
     ComPtr<ID3D12Resource> bias_buffer_;
     ComPtr<ID3D12Resource> output_buffer_;
-    ComPtr<ID3D12Resource> upload_buffer_;
+    ComPtr<ID3D12Resource> quantization_buffer_;
+
+    // last member, so the calculation is finished before host data is destroyed
+    AsyncReference async_reference_;
 };
 
 class ConvolutionDirectMLDispatcher : public ConvolutionBaseDispatcher
@@ -474,31 +986,80 @@ public:
     ConvolutionDirectMLDispatcher(create_params_t&& params, ID3D12Device* d3d12_device, IDMLDevice* dml_device, IDMLCommandRecorder* dml_cmd_recorder, ID3D12GraphicsCommandList* cmd_list)
         : ConvolutionBaseDispatcher(std::move(params), d3d12_device, cmd_list)
         , dml_cmd_recorder_(dml_cmd_recorder)
-        , conv_(params_.input_shape, params_.filter_shape, get_output_shape(),
-            to_dml_data_type(params_.dt), to_dml_tensor_policy(params_.layout),
-            params_.stride, params_.in_pad, params_.out_pad, !params_.no_bias, params_.allow_fp16_computations,
-            dml_device, d3d12_device)
     {
+        if (is_quantized())
+        {
+            if (params_.out_pad != 0)
+            {
+                throw std::runtime_error("Quantized DML convolution does not support output padding.");
+            }
+            if (params_.activation != libdml::ActivationType::eUndefined)
+            {
+                throw std::runtime_error("Quantized DML convolution does not support fused activation.");
+            }
+            quantized_conv_.emplace(params_.input_shape, params_.filter_shape, get_output_shape(),
+                to_dml_data_type(params_.dt), to_dml_tensor_policy(params_.layout),
+                params_.stride, params_.dilation, params_.groups, params_.in_pad, !params_.no_bias, dml_device, d3d12_device);
+        }
+        else
+        {
+            conv_.emplace(params_.input_shape, params_.filter_shape, get_output_shape(),
+                to_dml_data_type(params_.dt), to_dml_tensor_policy(params_.layout),
+                params_.stride, params_.dilation, params_.groups, params_.transposed ? DML_CONVOLUTION_DIRECTION_BACKWARD : DML_CONVOLUTION_DIRECTION_FORWARD,
+                params_.in_pad, params_.out_pad, !params_.no_bias, params_.allow_fp16_computations, params_.activation == libdml::ActivationType::eRelu,
+                dml_device, d3d12_device);
+        }
     }
 
     std::uint32_t get_total_descriptor_count()override
     {
-        return conv_.get_total_descriptor_count();
+        return get_dml_node().get_total_descriptor_count();
     }
 
     void initialize(ID3D12GraphicsCommandList* cmd_list, D3D12_CPU_DESCRIPTOR_HANDLE cpu_handle, D3D12_GPU_DESCRIPTOR_HANDLE gpu_handle) override
     {
-        conv_.create_binding_tables(cpu_handle, gpu_handle);
-        conv_.record_initialize(dml_cmd_recorder_, cmd_list);
+        get_dml_node().create_binding_tables(cpu_handle, gpu_handle);
+        get_dml_node().record_initialize(dml_cmd_recorder_, cmd_list);
     }
 
     void execute(ID3D12GraphicsCommandList* cmd_list) override
     {
-        conv_.record_execute(dml_cmd_recorder_, cmd_list, output_buffer_.Get(), input_buffer_.Get(), filter_buffer_.Get(), bias_buffer_.Get());
+        if (quantized_conv_)
+        {
+            quantized_conv_->record_execute(dml_cmd_recorder_, cmd_list, output_buffer_.Get(), input_buffer_.Get(), filter_buffer_.Get(), bias_buffer_.Get(),
+                get_quantization_bindings());
+            return;
+        }
+        conv_->record_execute(dml_cmd_recorder_, cmd_list, output_buffer_.Get(), input_buffer_.Get(), filter_buffer_.Get(), bias_buffer_.Get());
     }
 
 private:
-    gpu_op::Convolution conv_;
+    gpu_op::DirectMlBaseNode& get_dml_node()
+    {
+        return quantized_conv_ ? static_cast<gpu_op::DirectMlBaseNode&>(*quantized_conv_) : *conv_;
+    }
+
+    gpu_op::QuantizedConvolution::quantization_bindings_t get_quantization_bindings() const
+    {
+        const auto slot_size = get_quantization_slot_size();
+        auto binding = [&](QuantizationParam param)
+        {
+            return DML_BUFFER_BINDING{ quantization_buffer_.Get(), get_quantization_param_offset(param), slot_size };
+        };
+        gpu_op::QuantizedConvolution::quantization_bindings_t ret{};
+        ret.input_scale = binding(QuantizationParam::eInputScale);
+        ret.input_zero_point = binding(QuantizationParam::eInputZeroPoint);
+        ret.filter_scales = binding(QuantizationParam::eFilterScales);
+        ret.filter_zero_points = binding(QuantizationParam::eFilterZeroPoints);
+        ret.output_scale = binding(QuantizationParam::eOutputScale);
+        ret.output_zero_point = binding(QuantizationParam::eOutputZeroPoint);
+        return ret;
+    }
+
+private:
+    // one of them is set, depending on the data type
+    std::optional<gpu_op::Convolution> conv_;
+    std::optional<gpu_op::QuantizedConvolution> quantized_conv_;
     IDMLCommandRecorder* dml_cmd_recorder_;
 };
 
@@ -518,6 +1079,7 @@ public:
         std::uint32_t slice_ic = 1;
         bool reorder_weights = true;
         bool dispatch_only_weights_reorder = false;
+        bool use_libdml = false;  // jits, lws, grf and kernel file selected by libdml, tuning options above are ignored
 
         inline static void add_cli_options(CLI::App* opts, conv_cm_params_t& params)
         {
@@ -531,6 +1093,7 @@ public:
             opts->add_option("--lws", params.lws)->delimiter(',');
             opts->add_flag("--reorder_weights,!--no_reorder_weights", params.reorder_weights);
             opts->add_flag("--dispatch_only_weights_reorder", params.dispatch_only_weights_reorder);
+            opts->add_flag("--use_libdml", params.use_libdml, "Use kernel info (jits, lws, grf) generated by libdml instead of the tuning options.")->default_val(false);
         }
     };
 public:
@@ -542,9 +1105,62 @@ public:
         , output_shape_(get_output_shape())
     {
         assert(params_.filter_shape.h == params_.filter_shape.w);
+        if (is_quantized())
+        {
+            throw std::runtime_error("CM convolution kernels support only fp16, use conv_dml for quantized convolution.");
+        }
+        if (params_.groups != 1 || params_.dilation[0] != 1 || params_.dilation[1] != 1)
+        {
+            throw std::runtime_error("CM convolution kernels don't support groups and dilation, use conv_dml.");
+        }
+
+        std::optional<libdml::KernelInfo> libdml_kernel_info;
+        std::optional<DataLayout> libdml_weights_layout;
+        if (cm_params_.use_libdml)
+        {
+            if (params_.out_pad != 0)
+            {
+                throw std::runtime_error("libdml convolution descriptor does not support output padding.");
+            }
+            const auto& impls = libdml::get_convolution_implementation_list(get_libdml_device_info(), get_libdml_descriptor());
+            if (impls.empty())
+            {
+                throw std::runtime_error("libdml does not support given convolution parameters.");
+            }
+            // first one is the fastest
+            const auto& impl = impls.front();
+            std::cout << std::format("libdml implementation: {}\n", impl.get_info().name);
+            auto layouts = impl.query_preffered_layouts();
+            if (!cm_params_.reorder_weights)
+            {
+                layouts.weights_layout = std::nullopt;
+            }
+            if (layouts.weights_layout)
+            {
+                libdml_weights_layout = to_data_layout(*layouts.weights_layout);
+            }
+            libdml_kernel_info = impl.get_kernel_info(layouts);
+            assert(libdml_kernel_info->language == libdml::KernelLanguage::eCM);
 
-        // weights reoder
-        if(cm_params_.reorder_weights)
+            auto error_code = libdml::ErrorCode::eSuccess;
+            const auto execution_params = impl.get_execution_map(&error_code);
+            if (error_code != libdml::ErrorCode::eSuccess)
+            {
+                throw std::runtime_error("libdml failed to create convolution execution params.");
+            }
+            // scalars buffer is DWORD aligned (root constants)
+            const auto& scalars_buffer = execution_params.scalars_buffer;
+            scalars_.resize(scalars_buffer.size() / sizeof(std::uint32_t));
+            std::memcpy(scalars_.data(), scalars_buffer.data(), scalars_.size() * sizeof(std::uint32_t));
+        }
+        else
+        {
+            // same layout as the scalars schema of libdml CM convolutions
+            scalars_ = { params_.activation == libdml::ActivationType::eRelu ? 1u : 0u };
+        }
+
+        // weights reoder (libdml kernel reads original weights when it did not ask for a layout, e.g. reorder can't handle the input channels)
+        if(cm_params_.reorder_weights && (!cm_params_.use_libdml || libdml_weights_layout))
         {
             WeightsReorder::create_params_t wr_params{};
             wr_params.input_dt = params_.dt;
@@ -569,6 +1185,10 @@ public:
                     wr_params.output_layout = DataLayout::eOYXI_o16;
                 }
             }
+            if (libdml_weights_layout)
+            {
+                wr_params.output_layout = *libdml_weights_layout;
+            }
 
             weights_reorder_.emplace(WeightsReorder(std::move(wr_params), filter_buffer_, intc_ext, d3d12_device, cmd_list));
         }
@@ -583,7 +1203,8 @@ public:
             }
             // output 
             desc_list.push_back(DescType::eUav);
-            root_signature_ = create_root_signature(d3d12_device_, desc_list);
+            // scalars (kernel arguments after the surfaces)
+            root_signature_ = create_root_signature(d3d12_device_, desc_list, static_cast<std::uint32_t>(scalars_.size()));
             assert(root_signature_);
         }
 
@@ -608,45 +1229,59 @@ public:
             build_options += pre_jit + name + between_name_and_value + value_str + post_jit;
         };
 
-        if (params_.allow_fp16_computations)
+        if (libdml_kernel_info)
         {
-            add_define("DT_ACCU", "half");
+            for (const auto& jit : libdml_kernel_info->jits)
+            {
+                build_options += pre_jit + jit.opt + between_name_and_value + jit.value + post_jit;
+            }
         }
         else
         {
-            add_define("DT_ACCU", "float");
+            if (params_.allow_fp16_computations)
+            {
+                add_define("DT_ACCU", "half");
+            }
+            else
+            {
+                add_define("DT_ACCU", "float");
+            }
+            add_define("INPUT_WIDTH", params_.input_shape.w);
+            add_define("INPUT_HEIGHT", params_.input_shape.h);
+            add_define("INPUT_CHANNELS", params_.input_shape.c);
+
+            add_define("OUTPUT_WIDTH", output_shape_.w);
+            add_define("OUTPUT_HEIGHT", output_shape_.h);
+            add_define("OUTPUT_CHANNELS", output_shape_.c);
+
+            add_define("BATCH", params_.input_shape.n);
+            add_define("INPUT_PAD", params_.in_pad);
+            add_define("OUTPUT_PAD", params_.out_pad);
+            add_define("USE_BIAS", !params_.no_bias);
+            add_define("KERNEL_SIZE", params_.filter_shape.h);
+            add_define("STRIDE_W", params_.stride.w);
+            add_define("STRIDE_H", params_.stride.h);
+
+            add_define("SLICE_IC", cm_params_.slice_ic);
+            add_define("BLOCK_W", cm_params_.block_w);
+            add_define("BLOCK_H", cm_params_.block_h);
+            add_define("BLOCK_OC", cm_params_.block_oc);
+            add_define("BLOCK_BATCH", cm_params_.block_batch);
+
+            add_define("WEIGHTS_IN_OPTIMAL_FORMAT", cm_params.reorder_weights);
         }
-        add_define("INPUT_WIDTH", params_.input_shape.w);
-        add_define("INPUT_HEIGHT", params_.input_shape.h);
-        add_define("INPUT_CHANNELS", params_.input_shape.c);
-
-        add_define("OUTPUT_WIDTH", output_shape_.w);
-        add_define("OUTPUT_HEIGHT", output_shape_.h);
-        add_define("OUTPUT_CHANNELS", output_shape_.c);
-
-        add_define("BATCH", params_.input_shape.n);
-        add_define("INPUT_PAD", params_.in_pad);
-        add_define("OUTPUT_PAD", params_.out_pad);
-        add_define("USE_BIAS", !params_.no_bias);
-        add_define("KERNEL_SIZE", params_.filter_shape.h);
-        add_define("STRIDE_W", params_.stride.w);
-        add_define("STRIDE_H", params_.stride.h);
-
-        add_define("SLICE_IC", cm_params_.slice_ic);
-        add_define("BLOCK_W", cm_params_.block_w);
-        add_define("BLOCK_H", cm_params_.block_h);
-        add_define("BLOCK_OC", cm_params_.block_oc);
-        add_define("BLOCK_BATCH", cm_params_.block_batch);
-
-        add_define("WEIGHTS_IN_OPTIMAL_FORMAT", cm_params.reorder_weights);
 
         // kernel compilation
+        const auto large_grf = libdml_kernel_info ? libdml_kernel_info->grf_count == libdml::KernelGrfCount::e256 : cm_params_.large_grf;
+        // libdml lws already includes slice_ic
+        const std::array<std::uint32_t, 3> lws = libdml_kernel_info ? libdml_kernel_info->lws
+            : std::array<std::uint32_t, 3>{ cm_params_.lws[0] * cm_params_.slice_ic, cm_params_.lws[1], cm_params_.lws[2] };
         const auto dump_asm_str = cm_params_.dump_asm ? " -mdump_asm" : "";
-        const auto large_grf_str = cm_params_.large_grf ? " -Qxcm_doubleGRF" : "";
+        const auto large_grf_str = large_grf ? " -Qxcm_doubleGRF" : "";
         const auto print_reg_str = cm_params_.print_reg_usage ? " -mCM_printregusage" : "";
-        const auto lws_x = " -DLWS_SIZE_X=" + std::to_string(cm_params_.lws[0] * cm_params_.slice_ic);
-        const auto lws_y = " -DLWS_SIZE_Y=" + std::to_string(cm_params_.lws[1]);
-        const auto lws_z = " -DLWS_SIZE_Z=" + std::to_string(cm_params_.lws[2]);
+        const auto lws_x = " -DLWS_SIZE_X=" + std::to_string(lws[0]);
+        const auto lws_y = " -DLWS_SIZE_Y=" + std::to_string(lws[1]);
+        const auto lws_z = " -DLWS_SIZE_Z=" + std::to_string(lws[2]);
         const auto build_options_final = " -I \" \" " + build_options + dump_asm_str + large_grf_str + print_reg_str + lws_x + lws_y + lws_z;
 
         if (cm_params_.dump_asm)
@@ -654,10 +1289,14 @@ public:
             std::cout << build_options_final << std::endl;
         }
 
-        auto kernel_source_content = [](const auto kernel_size)
+        auto kernel_source_content = [&libdml_kernel_info](const auto kernel_size)
         {
             std::string path = "";
-            if (kernel_size == 1)
+            if (libdml_kernel_info)
+            {
+                path = libdml_kernel_info->code;
+            }
+            else if (kernel_size == 1)
             {
                 path = "conv_1x1_nchw_fp16.cpp";
             }
@@ -682,6 +1321,16 @@ public:
 
         pso_ = intc_ext_.create_pipeline(byte_code, build_options_final, root_signature_.Get(), INTC_D3D12_SHADER_INPUT_TYPE::CM);
         assert(pso_);
+
+        if (libdml_kernel_info)
+        {
+            const auto& gws = libdml_kernel_info->gws;
+            for (std::size_t i = 0; i < gws.size(); i++)
+            {
+                assert(gws[i] % lws[i] == 0);
+            }
+            libdml_thread_groups_ = std::array<std::uint32_t, 3>{ gws[0] / lws[0], gws[1] / lws[1], gws[2] / lws[2] };
+        }
     }
 
     std::uint32_t get_total_descriptor_count() override
@@ -754,6 +1403,13 @@ public:
             }
         }
 
+        if (libdml_thread_groups_)
+        {
+            const auto& thg = *libdml_thread_groups_;
+            dispatch_kernel(cmd_list, pso_.Get(), root_signature_.Get(), gpu_handles_, thg[0], thg[1], thg[2], scalars_);
+            return;
+        }
+
         const auto gws_x = cm_params_.slice_ic * (round_up_next_multiple(output_shape_.w, cm_params_.block_w) / cm_params_.block_w);
         const auto gws_y = round_up_next_multiple(output_shape_.h, cm_params_.block_h) / cm_params_.block_h;
         const auto gws_z = (params_.input_shape.n / cm_params_.block_batch) * (params_.filter_shape.n / cm_params_.block_oc);
@@ -768,7 +1424,7 @@ public:
 
         //std::cout << std::format("gws: {}, {}, {}, thg: {}, {}, {}\n", gws_x, gws_y, gws_z, thg_x, thg_y, thg_z);
 
-        dispatch_kernel(cmd_list, pso_.Get(), root_signature_.Get(), gpu_handles_, thg_x, thg_y, thg_z);
+        dispatch_kernel(cmd_list, pso_.Get(), root_signature_.Get(), gpu_handles_, thg_x, thg_y, thg_z, scalars_);
     }
 
     ConformanceResult validate_conformance(ID3D12CommandQueue* command_queue,
@@ -783,6 +1439,55 @@ public:
     }
 
 private:
+    // kernels in this dispatcher use lsc messages
+    static libdml::DeviceInfo get_libdml_device_info()
+    {
+        libdml::DeviceInfo ret{};
+        ret.platform = libdml::HwPlatform::eDG2;
+        return ret;
+    }
+
+    libdml::ConvolutionDescriptor get_libdml_descriptor() const
+    {
+        const auto dt = params_.dt == DataType::eFp16 ? libdml::DataType::eFp16 : libdml::DataType::eFp32;
+        const auto layout = params_.layout == DataLayout::eNCHW ? libdml::DataLayout::eNCHW : libdml::DataLayout::eNHWC;
+        auto to_dims = [](const TensorShape& shape)
+        {
+            return libdml::TensorDims{ static_cast<std::int32_t>(shape.n), static_cast<std::int32_t>(shape.c), static_cast<std::int32_t>(shape.h), static_cast<std::int32_t>(shape.w) };
+        };
+
+        libdml::ConvolutionDescriptor ret{};
+        ret.tensor_input = libdml::Tensor{ to_dims(params_.input_shape), layout, dt };
+        ret.tensor_weights = libdml::Tensor{ to_dims(params_.filter_shape), libdml::DataLayout::eOIYX, dt };
+        ret.tensor_output = libdml::Tensor{ to_dims(output_shape_), layout, dt };
+        if (!params_.no_bias)
+        {
+            ret.tensor_bias = libdml::Tensor{ libdml::TensorDims{ 1, static_cast<std::int32_t>(params_.filter_shape.n), 1, 1 }, layout, dt };
+        }
+        ret.strides = { static_cast<std::int32_t>(params_.stride.h), static_cast<std::int32_t>(params_.stride.w) };
+        ret.dilations = { static_cast<std::int32_t>(params_.dilation[0]), static_cast<std::int32_t>(params_.dilation[1]) };
+        const auto in_pad = static_cast<std::int32_t>(params_.in_pad);
+        ret.start_padding = { in_pad, in_pad };
+        ret.end_padding = { in_pad, in_pad };
+        ret.group_count = params_.groups;
+        ret.datatype_accumulator = params_.allow_fp16_computations ? libdml::DataType::eFp16 : libdml::DataType::eFp32;
+        ret.post_ops = get_post_ops();
+        return ret;
+    }
+
+    static DataLayout to_data_layout(libdml::DataLayout layout)
+    {
+        switch (layout)
+        {
+        case libdml::DataLayout::eIO_i8_o8_i2: return DataLayout::eIO_i8_o8_i2;
+        case libdml::DataLayout::eOYXI_o8: return DataLayout::eOYXI_o8;
+        case libdml::DataLayout::eOYXI_o16: return DataLayout::eOYXI_o16;
+        case libdml::DataLayout::eOIYX: return DataLayout::eOIYX;
+        default:
+            throw std::runtime_error("Unsupported libdml weights layout.");
+        }
+    }
+
     class WeightsReorder : public NodeDispatcher
     {
     public:
@@ -1080,6 +1785,9 @@ private:
     ComPtr<ID3D12RootSignature> root_signature_;
 
     std::optional<WeightsReorder> weights_reorder_;
+    std::optional<std::array<std::uint32_t, 3>> libdml_thread_groups_;
+    // kernel scalars, set as root constants
+    std::vector<std::uint32_t> scalars_;
 
     const TensorShape output_shape_;
 };
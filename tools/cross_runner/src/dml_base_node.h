@@ -57,6 +57,9 @@ inline DML_TENSOR_DATA_TYPE to_dml_data_type(DataType dt)
     {
     case DataType::eFp32: return DML_TENSOR_DATA_TYPE_FLOAT32;
     case DataType::eFp16: return DML_TENSOR_DATA_TYPE_FLOAT16;
+    case DataType::eInt8: return DML_TENSOR_DATA_TYPE_INT8;
+    case DataType::eUint8: return DML_TENSOR_DATA_TYPE_UINT8;
+    case DataType::eInt32: return DML_TENSOR_DATA_TYPE_INT32;
     default:
         assert(false && "Unknown data type.");
     }
@@ -92,6 +95,7 @@ public:
         const auto initialize_binding_properties = dml_op_initializer_->GetBindingProperties();
         if (initialize_binding_properties.TemporaryResourceSize > 0 && temporary_buffer_)
         {
+            record_temporary_buffer_aliasing_barrier(cmd_list);
             DML_BUFFER_BINDING buffer_binding{ temporary_buffer_.Get(), 0, temporary_buffer_->GetDesc().Width };
             DML_BINDING_DESC binding_desc{ DML_BINDING_TYPE_BUFFER, &buffer_binding };
             dml_init_binding_table->BindTemporaryResource(&binding_desc);
@@ -164,26 +168,25 @@ protected:
 
         if (temporary_resource_size != 0)
         {
-            const auto heap_props = CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT);
-            const auto buffer_desc = CD3DX12_RESOURCE_DESC::Buffer(temporary_resource_size, D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS);
-            throw_if_failed(d3d12_device_->CreateCommittedResource(
-                &heap_props,
-                D3D12_HEAP_FLAG_NONE,
-                &buffer_desc,
-                D3D12_RESOURCE_STATE_COMMON,
-                nullptr, IID_PPV_ARGS(temporary_buffer_.ReleaseAndGetAddressOf())), "create buffer resource");
+            // temporary content is not needed between dispatches, so its memory is shared with temporaries of other nodes
+            temporary_buffer_ = create_transient_buffer(d3d12_device_, temporary_resource_size,
+                D3D12_RESOURCE_STATE_COMMON, D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS, temporary_buffer_aliased_);
         }
 
         if (persistent_resource_size != 0)
         {
-            const auto heap_props = CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT);
-            const auto buffder_desc = CD3DX12_RESOURCE_DESC::Buffer(persistent_resource_size);
-            throw_if_failed(d3d12_device_->CreateCommittedResource(
-                &heap_props,
-                D3D12_HEAP_FLAG_NONE,
-                &buffder_desc,
-                D3D12_RESOURCE_STATE_COMMON,
-                nullptr, IID_PPV_ARGS(persistent_buffer_.ReleaseAndGetAddressOf())), "create buffer resource");
+            persistent_buffer_ = create_buffer(d3d12_device_, persistent_resource_size,
+                D3D12_HEAP_TYPE_DEFAULT, D3D12_RESOURCE_STATE_COMMON);
+        }
+    }
+
+    void record_temporary_buffer_aliasing_barrier(ID3D12GraphicsCommandList* cmd_list)
+    {
+        // only if temporary of other node was used since the last dispatch of this one, so single node runs don't time the barrier
+        if (temporary_buffer_aliased_ && get_resource_allocator()->begin_transient_use(temporary_buffer_.Get()))
+        {
+            const auto barrier = CD3DX12_RESOURCE_BARRIER::Aliasing(nullptr, temporary_buffer_.Get());
+            cmd_list->ResourceBarrier(1, &barrier);
         }
     }
 
@@ -193,6 +196,7 @@ protected:
         const auto execute_binding_properties = dml_op_executor_->GetBindingProperties();
         if (execute_binding_properties.TemporaryResourceSize > 0 && temporary_buffer_)
         {
+            record_temporary_buffer_aliasing_barrier(cmd_list);
             DML_BUFFER_BINDING buffer_binding{ temporary_buffer_.Get(), 0, temporary_buffer_->GetDesc().Width };
             DML_BINDING_DESC binding_desc{ DML_BINDING_TYPE_BUFFER, &buffer_binding };
             dml_exec_binding_table->BindTemporaryResource(&binding_desc);
@@ -221,6 +225,7 @@ protected:
 
     ComPtr<ID3D12Resource> temporary_buffer_;
     ComPtr<ID3D12Resource> persistent_buffer_;
+    bool temporary_buffer_aliased_ = false;
 
     ComPtr<IDMLBindingTable> dml_init_binding_table;
     ComPtr<IDMLBindingTable> dml_exec_binding_table;
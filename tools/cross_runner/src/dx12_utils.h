@@ -2,6 +2,14 @@
 #include <stdexcept>
 #include <optional>
 #include <span>
+#include <deque>
+#include <cstring>
+#include <algorithm>
+#include <memory>
+#include <map>
+#include <utility>
+#include <format>
+#include <vector>
 
 #include <dxgi1_4.h>
 #include <d3d12.h>
@@ -221,8 +229,522 @@ inline ComPtr<ID3D12DescriptorHeap> create_descriptor_heap(ID3D12Device* d3d12_d
     return descriptor_heap;
 }
 
+/*
+*   Single, long lived shader visible descriptor heap. Ranges of descriptors are handed out to nodes (first fit from the free list)
+*   and returned when the range is destroyed, so there is no heap creation (and no heap switch) per node or per reference run.
+*   Ranges can be released only when GPU finished using them (all the runner executions are blocking).
+*/
+class DescriptorHeapAllocator
+{
+public:
+    class Range
+    {
+    public:
+        Range() = default;
+        Range(DescriptorHeapAllocator* allocator, std::uint32_t offset, std::uint32_t count)
+            : allocator_(allocator), offset_(offset), count_(count)
+        {
+        }
+        Range(const Range& rhs) = delete;
+        Range& operator=(const Range& rhs) = delete;
+        Range(Range&& rhs) noexcept
+        {
+            *this = std::move(rhs);
+        }
+        Range& operator=(Range&& rhs) noexcept
+        {
+            if (this != &rhs)
+            {
+                release();
+                allocator_ = std::exchange(rhs.allocator_, nullptr);
+                offset_ = rhs.offset_;
+                count_ = std::exchange(rhs.count_, 0);
+            }
+            return *this;
+        }
+        ~Range()
+        {
+            release();
+        }
+
+        D3D12_CPU_DESCRIPTOR_HANDLE get_cpu_handle() const
+        {
+            assert(allocator_);
+            return CD3DX12_CPU_DESCRIPTOR_HANDLE(allocator_->heap_->GetCPUDescriptorHandleForHeapStart(), offset_, allocator_->increment_size_);
+        }
+
+        D3D12_GPU_DESCRIPTOR_HANDLE get_gpu_handle() const
+        {
+            assert(allocator_);
+            return CD3DX12_GPU_DESCRIPTOR_HANDLE(allocator_->heap_->GetGPUDescriptorHandleForHeapStart(), offset_, allocator_->increment_size_);
+        }
+
+        std::uint32_t get_count() const
+        {
+            return count_;
+        }
+
+    private:
+        void release()
+        {
+            if (allocator_ && count_ > 0)
+            {
+                allocator_->free(offset_, count_);
+            }
+            allocator_ = nullptr;
+            count_ = 0;
+        }
+
+    private:
+        DescriptorHeapAllocator* allocator_ = nullptr;
+        std::uint32_t offset_ = 0;
+        std::uint32_t count_ = 0;
+    };
+
+public:
+    DescriptorHeapAllocator(ID3D12Device* d3d12_device, std::uint32_t descriptors_count)
+        : heap_(create_descriptor_heap(d3d12_device, descriptors_count))
+        , increment_size_(d3d12_device->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV))
+        , capacity_(descriptors_count)
+    {
+        free_ranges_[0] = descriptors_count;
+    }
+
+    DescriptorHeapAllocator(const DescriptorHeapAllocator& rhs) = delete;
+    DescriptorHeapAllocator& operator=(const DescriptorHeapAllocator& rhs) = delete;
+
+    ~DescriptorHeapAllocator()
+    {
+        assert(used_ == 0 && "Descriptor ranges outlive the heap.");
+    }
+
+    Range allocate(std::uint32_t count)
+    {
+        if (count == 0)
+        {
+            return Range(this, 0, 0);
+        }
+        for (auto it = free_ranges_.begin(); it != free_ranges_.end(); ++it)
+        {
+            if (it->second >= count)
+            {
+                const auto offset = it->first;
+                const auto remaining = it->second - count;
+                free_ranges_.erase(it);
+                if (remaining > 0)
+                {
+                    free_ranges_[offset + count] = remaining;
+                }
+                used_ += count;
+                return Range(this, offset, count);
+            }
+        }
+        throw std::runtime_error(std::format("Not enough space in descriptor heap. Requested: {}, used: {}, capacity: {}.", count, used_, capacity_));
+    }
+
+    // Has to be called on every command list using the ranges (it is the same heap for whole app, so there are no heap switches).
+    void bind(ID3D12GraphicsCommandList* cmd_list)
+    {
+        ID3D12DescriptorHeap* d3d12_descriptor_heaps[] = { heap_.Get() };
+        cmd_list->SetDescriptorHeaps(1, d3d12_descriptor_heaps);
+    }
+
+private:
+    void free(std::uint32_t offset, std::uint32_t count)
+    {
+        used_ -= count;
+        auto it = free_ranges_.emplace(offset, count).first;
+        auto next = std::next(it);
+        if (next != free_ranges_.end() && it->first + it->second == next->first)
+        {
+            it->second += next->second;
+            free_ranges_.erase(next);
+        }
+        if (it != free_ranges_.begin())
+        {
+            auto prev = std::prev(it);
+            if (prev->first + prev->second == it->first)
+            {
+                prev->second += it->second;
+                free_ranges_.erase(it);
+            }
+        }
+    }
+
+private:
+    ComPtr<ID3D12DescriptorHeap> heap_;
+    std::uint32_t increment_size_ = 0;
+    std::uint32_t capacity_ = 0;
+    std::uint32_t used_ = 0;
+    std::map<std::uint32_t, std::uint32_t> free_ranges_;  // offset -> count
+};
+
+inline std::unique_ptr<DescriptorHeapAllocator>& get_descriptor_heap_allocator_storage()
+{
+    static std::unique_ptr<DescriptorHeapAllocator> allocator;
+    return allocator;
+}
+
+inline DescriptorHeapAllocator& get_descriptor_heap_allocator()
+{
+    assert(get_descriptor_heap_allocator_storage() && "Descriptor heap allocator not initialized.");
+    return *get_descriptor_heap_allocator_storage();
+}
+
+// Creates process wide descriptor heap and releases it at the end of the scope.
+class DescriptorHeapAllocatorScope
+{
+public:
+    DescriptorHeapAllocatorScope(ID3D12Device* d3d12_device, std::uint32_t descriptors_count)
+    {
+        assert(!get_descriptor_heap_allocator_storage() && "Descriptor heap allocator already initialized.");
+        get_descriptor_heap_allocator_storage() = std::make_unique<DescriptorHeapAllocator>(d3d12_device, descriptors_count);
+    }
+    DescriptorHeapAllocatorScope(const DescriptorHeapAllocatorScope& rhs) = delete;
+    DescriptorHeapAllocatorScope& operator=(const DescriptorHeapAllocatorScope& rhs) = delete;
+
+    ~DescriptorHeapAllocatorScope()
+    {
+        get_descriptor_heap_allocator_storage().reset();
+    }
+};
+
+/*
+*   Places default heap buffers into big, buffer only heaps instead of creating commited resource per buffer.
+*   Space of released buffers is returned to the heap free list (checked lazily, allocator holds one reference to every buffer).
+*   Buffer placed on memory of released one is activated with aliasing barrier submitted at creation, before any use of the buffer.
+*   Transient buffers (alive only for single dispatch, ex. DML temporary resources) are aliased:
+*   all of them are placed at the beginning of the same heap, user has to record aliasing barrier when begin_transient_use(..) returns true.
+*/
+class ResourceAllocator
+{
+public:
+    struct Stats
+    {
+        std::uint64_t buffers_count = 0;
+        std::uint64_t requested_bytes = 0;       // sum of sizes of all alive buffers (what commited resources would take)
+        std::uint64_t peak_requested_bytes = 0;
+        std::uint64_t heaps_bytes = 0;           // memory actually reserved in heaps
+        std::uint64_t peak_heaps_bytes = 0;
+        std::uint64_t transient_bytes = 0;       // sum of sizes of alive transient buffers, backed by single aliased range
+    };
+
+public:
+    // Activation barriers are submitted to command_queue, it has to be the queue all the work using the buffers goes to.
+    ResourceAllocator(ID3D12Device* d3d12_device, ID3D12CommandQueue* command_queue, std::uint64_t heap_bytes_width)
+        : d3d12_device_(d3d12_device)
+        , command_queue_(command_queue)
+        , heap_size_(static_cast<std::uint64_t>(align(heap_bytes_width, D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT)))
+    {
+    }
+
+    ResourceAllocator(const ResourceAllocator& rhs) = delete;
+    ResourceAllocator& operator=(const ResourceAllocator& rhs) = delete;
+
+    ComPtr<ID3D12Resource> create_buffer(const D3D12_RESOURCE_DESC& desc, D3D12_RESOURCE_STATES init_state)
+    {
+        collect_released();
+        const auto alloc_info = d3d12_device_->GetResourceAllocationInfo(0, 1, &desc);
+        const auto bytes_width = static_cast<std::uint64_t>(align(alloc_info.SizeInBytes, alloc_info.Alignment));
+
+        Heap* heap = nullptr;
+        std::uint64_t offset = 0;
+        for (auto& h : heaps_)
+        {
+            if (!h->transient && h->allocate(bytes_width, offset))
+            {
+                heap = h.get();
+                break;
+            }
+        }
+        if (!heap)
+        {
+            // buffers bigger than default heap size get dedicated heap
+            heap = &add_heap(std::max<std::uint64_t>(heap_size_, bytes_width), false);
+            const auto success = heap->allocate(bytes_width, offset);
+            assert(success);
+        }
+        // heap is filled from the beginning, so free range below the high water mark was used by released buffer
+        const auto is_reused_memory = offset < heap->used_bytes;
+        heap->used_bytes = std::max(heap->used_bytes, offset + bytes_width);
+
+        auto ret = create_placed(*heap, offset, desc, init_state);
+        if (is_reused_memory)
+        {
+            submit_activation_barrier(ret.Get());
+        }
+        allocations_.push_back({ ret, heap, offset, bytes_width, desc.Width });
+        on_allocated(desc.Width);
+        return ret;
+    }
+
+    // Transient buffers of nodes running concurrently (ex. on different queues) can't share memory.
+    void set_transient_aliasing(bool enabled)
+    {
+        transient_aliasing_ = enabled;
+    }
+
+    bool is_transient_aliasing_enabled() const
+    {
+        return transient_aliasing_;
+    }
+
+    // Call before recording use of transient buffer. Returns true if other transient buffer was used since the last use
+    // of this one (in recording order), only then aliasing barrier has to be recorded. Repeated dispatches of single node need no barriers.
+    bool begin_transient_use(ID3D12Resource* buffer)
+    {
+        const auto needs_barrier = last_transient_user_ != buffer;
+        last_transient_user_ = buffer;
+        return needs_barrier;
+    }
+
+    ComPtr<ID3D12Resource> create_transient_buffer(const D3D12_RESOURCE_DESC& desc, D3D12_RESOURCE_STATES init_state)
+    {
+        collect_released();
+        const auto alloc_info = d3d12_device_->GetResourceAllocationInfo(0, 1, &desc);
+        const auto bytes_width = static_cast<std::uint64_t>(align(alloc_info.SizeInBytes, alloc_info.Alignment));
+        if (!transient_heap_ || transient_heap_->size < bytes_width)
+        {
+            // old transient heap is released when its last buffer is gone
+            transient_heap_ = &add_heap(std::max(bytes_width, transient_heap_ ? transient_heap_->size : 0ull), true);
+        }
+
+        auto ret = create_placed(*transient_heap_, 0, desc, init_state);
+        allocations_.push_back({ ret, transient_heap_, 0, bytes_width, desc.Width });
+        stats_.transient_bytes += desc.Width;
+        on_allocated(desc.Width);
+        return ret;
+    }
+
+    Stats get_stats()
+    {
+        collect_released();
+        return stats_;
+    }
+
+private:
+    struct Heap
+    {
+        ComPtr<ID3D12Heap> heap;
+        std::uint64_t size = 0;
+        bool transient = false;
+        std::uint32_t allocations_count = 0;
+        std::uint64_t used_bytes = 0;  // high water mark of allocations
+        std::map<std::uint64_t, std::uint64_t> free_ranges;  // offset -> size
+
+        // first fit
+        bool allocate(std::uint64_t bytes_width, std::uint64_t& offset)
+        {
+            for (auto it = free_ranges.begin(); it != free_ranges.end(); ++it)
+            {
+                if (it->second >= bytes_width)
+                {
+                    offset = it->first;
+                    const auto remaining = it->second - bytes_width;
+                    free_ranges.erase(it);
+                    if (remaining > 0)
+                    {
+                        free_ranges[offset + bytes_width] = remaining;
+                    }
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        void free(std::uint64_t offset, std::uint64_t bytes_width)
+        {
+            auto it = free_ranges.emplace(offset, bytes_width).first;
+            // merge with next and previous range
+            auto next = std::next(it);
+            if (next != free_ranges.end() && it->first + it->second == next->first)
+            {
+                it->second += next->second;
+                free_ranges.erase(next);
+            }
+            if (it != free_ranges.begin())
+            {
+                auto prev = std::prev(it);
+                if (prev->first + prev->second == it->first)
+                {
+                    prev->second += it->second;
+                    free_ranges.erase(it);
+                }
+            }
+        }
+    };
+
+    struct Allocation
+    {
+        ComPtr<ID3D12Resource> resource;
+        Heap* heap = nullptr;
+        std::uint64_t offset = 0;
+        std::uint64_t heap_bytes = 0;
+        std::uint64_t requested_bytes = 0;
+    };
+
+    Heap& add_heap(std::uint64_t bytes_width, bool transient)
+    {
+        auto heap = std::make_unique<Heap>();
+        heap->size = bytes_width;
+        heap->transient = transient;
+        if (!transient)
+        {
+            heap->free_ranges[0] = bytes_width;
+        }
+        const auto heap_desc = CD3DX12_HEAP_DESC(bytes_width, D3D12_HEAP_TYPE_DEFAULT, 0, D3D12_HEAP_FLAG_ALLOW_ONLY_BUFFERS);
+        throw_if_failed(d3d12_device_->CreateHeap(&heap_desc, IID_PPV_ARGS(heap->heap.ReleaseAndGetAddressOf())), "create heap");
+
+        stats_.heaps_bytes += bytes_width;
+        stats_.peak_heaps_bytes = std::max(stats_.peak_heaps_bytes, stats_.heaps_bytes);
+        heaps_.push_back(std::move(heap));
+        return *heaps_.back();
+    }
+
+    ComPtr<ID3D12Resource> create_placed(Heap& heap, std::uint64_t offset, const D3D12_RESOURCE_DESC& desc, D3D12_RESOURCE_STATES init_state)
+    {
+        ComPtr<ID3D12Resource> ret;
+        throw_if_failed(d3d12_device_->CreatePlacedResource(heap.heap.Get(), offset, &desc, init_state, nullptr,
+            IID_PPV_ARGS(ret.ReleaseAndGetAddressOf())), "create placed resource");
+        heap.allocations_count++;
+        return ret;
+    }
+
+    void submit_activation_barrier(ID3D12Resource* resource)
+    {
+        if (!activation_command_list_)
+        {
+            throw_if_failed(d3d12_device_->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_DIRECT,
+                IID_PPV_ARGS(activation_command_allocator_.ReleaseAndGetAddressOf())), "create resource allocator cmd allocator");
+            throw_if_failed(d3d12_device_->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_DIRECT, activation_command_allocator_.Get(), nullptr,
+                IID_PPV_ARGS(activation_command_list_.ReleaseAndGetAddressOf())), "create resource allocator cmd list");
+            throw_if_failed(d3d12_device_->CreateFence(0, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(activation_fence_.ReleaseAndGetAddressOf())), "create resource allocator fence");
+        }
+        const auto barrier = CD3DX12_RESOURCE_BARRIER::Aliasing(nullptr, resource);
+        activation_command_list_->ResourceBarrier(1, &barrier);
+        throw_if_failed(activation_command_list_->Close(), "resource allocator cmd list close");
+        ID3D12CommandList* command_lists[] = { activation_command_list_.Get() };
+        command_queue_->ExecuteCommandLists(1, command_lists);
+        throw_if_failed(command_queue_->Signal(activation_fence_.Get(), ++activation_fence_value_), "resource allocator signal");
+
+        // buffers are created at setup, so waiting here (null event blocks) is simpler than tracking the allocator
+        throw_if_failed(activation_fence_->SetEventOnCompletion(activation_fence_value_, nullptr), "resource allocator wait");
+        throw_if_failed(activation_command_allocator_->Reset(), "resource allocator cmd allocator reset");
+        throw_if_failed(activation_command_list_->Reset(activation_command_allocator_.Get(), nullptr), "resource allocator cmd list reset");
+    }
+
+    void on_allocated(std::uint64_t requested_bytes)
+    {
+        stats_.buffers_count++;
+        stats_.requested_bytes += requested_bytes;
+        stats_.peak_requested_bytes = std::max(stats_.peak_requested_bytes, stats_.requested_bytes);
+    }
+
+    bool is_released(ID3D12Resource* resource)
+    {
+        // only reference held by the allocator left
+        resource->AddRef();
+        return resource->Release() == 1;
+    }
+
+    void collect_released()
+    {
+        for (auto it = allocations_.begin(); it != allocations_.end();)
+        {
+            if (!is_released(it->resource.Get()))
+            {
+                ++it;
+                continue;
+            }
+            auto* heap = it->heap;
+            if (heap->transient)
+            {
+                stats_.transient_bytes -= it->requested_bytes;
+                if (last_transient_user_ == it->resource.Get())
+                {
+                    last_transient_user_ = nullptr;
+                }
+            }
+            else
+            {
+                heap->free(it->offset, it->heap_bytes);
+            }
+            heap->allocations_count--;
+            stats_.buffers_count--;
+            stats_.requested_bytes -= it->requested_bytes;
+            it = allocations_.erase(it);
+        }
+
+        // keep first heap and the current transient one for following allocations
+        for (auto it = heaps_.begin(); it != heaps_.end();)
+        {
+            auto* heap = it->get();
+            const auto keep = heap->allocations_count > 0 || heap == heaps_.front().get() || heap == transient_heap_;
+            if (keep)
+            {
+                ++it;
+                continue;
+            }
+            stats_.heaps_bytes -= heap->size;
+            it = heaps_.erase(it);
+        }
+    }
+
+private:
+    ID3D12Device* d3d12_device_;
+    ID3D12CommandQueue* command_queue_;
+    std::uint64_t heap_size_ = 0;
+    std::vector<std::unique_ptr<Heap>> heaps_;
+    Heap* transient_heap_ = nullptr;
+    std::vector<Allocation> allocations_;
+    Stats stats_{};
+    bool transient_aliasing_ = true;
+    ID3D12Resource* last_transient_user_ = nullptr;
+
+    ComPtr<ID3D12CommandAllocator> activation_command_allocator_;
+    ComPtr<ID3D12GraphicsCommandList> activation_command_list_;
+    ComPtr<ID3D12Fence> activation_fence_;
+    std::uint64_t activation_fence_value_ = 0;
+};
+
+inline std::unique_ptr<ResourceAllocator>& get_resource_allocator_storage()
+{
+    static std::unique_ptr<ResourceAllocator> allocator;
+    return allocator;
+}
+
+// Optional, without it buffers are created as commited resources.
+inline ResourceAllocator* get_resource_allocator()
+{
+    return get_resource_allocator_storage().get();
+}
+
+// Creates process wide allocator and releases it (with all the heaps) at the end of the scope.
+class ResourceAllocatorScope
+{
+public:
+    ResourceAllocatorScope(ID3D12Device* d3d12_device, ID3D12CommandQueue* command_queue, std::uint64_t heap_bytes_width)
+    {
+        assert(!get_resource_allocator_storage() && "Resource allocator already initialized.");
+        get_resource_allocator_storage() = std::make_unique<ResourceAllocator>(d3d12_device, command_queue, heap_bytes_width);
+    }
+    ResourceAllocatorScope(const ResourceAllocatorScope& rhs) = delete;
+    ResourceAllocatorScope& operator=(const ResourceAllocatorScope& rhs) = delete;
+
+    ~ResourceAllocatorScope()
+    {
+        get_resource_allocator_storage().reset();
+    }
+};
+
 inline ComPtr<ID3D12Resource> create_buffer(ID3D12Device* d3d12_device, std::size_t bytes_width, D3D12_HEAP_TYPE heap_type, D3D12_RESOURCE_STATES init_state, D3D12_RESOURCE_FLAGS resource_flag = D3D12_RESOURCE_FLAG_NONE)
 {
+    // upload and readback buffers are short lived or persistently mapped (staging ring), keep them commited
+    if (auto* allocator = get_resource_allocator(); allocator && heap_type == D3D12_HEAP_TYPE_DEFAULT)
+    {
+        return allocator->create_buffer(CD3DX12_RESOURCE_DESC::Buffer(align(bytes_width, 256), resource_flag), init_state);
+    }
+
     ComPtr<ID3D12Resource> ret;
     const auto heap_props = CD3DX12_HEAP_PROPERTIES(heap_type);
     const auto buffer_desc = CD3DX12_RESOURCE_DESC::Buffer(align(bytes_width, 256), resource_flag);
@@ -235,12 +757,247 @@ inline ComPtr<ID3D12Resource> create_buffer(ID3D12Device* d3d12_device, std::siz
     return ret;
 }
 
+// Default heap buffer used only within single dispatch. Returns true in is_aliased when the memory is shared with other
+// transient buffers, then aliasing barrier (CD3DX12_RESOURCE_BARRIER::Aliasing(nullptr, buffer)) has to be recorded before use
+// when ResourceAllocator::begin_transient_use(..) says so.
+inline ComPtr<ID3D12Resource> create_transient_buffer(ID3D12Device* d3d12_device, std::size_t bytes_width, D3D12_RESOURCE_STATES init_state, D3D12_RESOURCE_FLAGS resource_flag, bool& is_aliased)
+{
+    is_aliased = get_resource_allocator() != nullptr && get_resource_allocator()->is_transient_aliasing_enabled();
+    if (is_aliased)
+    {
+        return get_resource_allocator()->create_transient_buffer(CD3DX12_RESOURCE_DESC::Buffer(align(bytes_width, 256), resource_flag), init_state);
+    }
+    return create_buffer(d3d12_device, bytes_width, D3D12_HEAP_TYPE_DEFAULT, init_state, resource_flag);
+}
+
+/*
+*   Process wide upload ring. Host data is copied through fixed size, persistently mapped upload buffer in chunks.
+*   Every submission of copies is tracked with a fence value, ring memory is reused once GPU finished the copies,
+*   so peak staging memory stays bounded no matter how big or how many tensors are uploaded.
+*   Copies are recorded into ring own command list and submitted right away, so they overlap with the work done on host (ex. kernels compilation).
+*/
+class StagingRing
+{
+public:
+    StagingRing(ID3D12Device* d3d12_device, ID3D12CommandQueue* command_queue, std::size_t ring_bytes_width)
+        : d3d12_device_(d3d12_device)
+        , command_queue_(command_queue)
+        , size_(static_cast<std::uint64_t>(align(ring_bytes_width, chunk_alignment)))
+    {
+        upload_buffer_ = create_buffer(d3d12_device_, size_, D3D12_HEAP_TYPE_UPLOAD, D3D12_RESOURCE_STATE_GENERIC_READ);
+        throw_if_failed(upload_buffer_->Map(0, nullptr, reinterpret_cast<void**>(&mapped_ptr_)), "map staging ring");
+
+        throw_if_failed(d3d12_device_->CreateFence(0, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(fence_.ReleaseAndGetAddressOf())), "create staging ring fence");
+        fence_event_ = ::CreateEvent(nullptr, false, false, nullptr);
+
+        current_allocator_ = get_free_allocator();
+        throw_if_failed(d3d12_device_->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_DIRECT, current_allocator_.Get(), nullptr,
+            IID_PPV_ARGS(command_list_.ReleaseAndGetAddressOf())), "create staging ring command list");
+    }
+
+    StagingRing(const StagingRing& rhs) = delete;
+    StagingRing& operator=(const StagingRing& rhs) = delete;
+
+    ~StagingRing()
+    {
+        flush();
+        upload_buffer_->Unmap(0, nullptr);
+        ::CloseHandle(fence_event_);
+    }
+
+    // Records copy of data into dst buffer (expected in COPY_DEST state). Blocks only if the ring is full.
+    void upload(ID3D12Resource* dst, std::size_t dst_offset, std::span<const std::byte> data)
+    {
+        const auto max_chunk_bytes = size_ / 2;
+        std::size_t copied = 0;
+        while (copied < data.size())
+        {
+            const auto chunk_bytes = std::min<std::uint64_t>(data.size() - copied, max_chunk_bytes);
+            const auto ring_offset = allocate(chunk_bytes);
+            std::memcpy(mapped_ptr_ + ring_offset, data.data() + copied, chunk_bytes);
+            command_list_->CopyBufferRegion(dst, dst_offset + copied, upload_buffer_.Get(), ring_offset, chunk_bytes);
+            has_pending_copies_ = true;
+            copied += chunk_bytes;
+        }
+        submit();
+    }
+
+    // Submits recorded copies (non blocking). Returns fence value which is signaled when all submitted copies are done.
+    std::uint64_t submit()
+    {
+        if (!has_pending_copies_)
+        {
+            return last_signaled_value_;
+        }
+        throw_if_failed(command_list_->Close(), "staging ring cmd list close");
+        ID3D12CommandList* command_lists[] = { command_list_.Get() };
+        command_queue_->ExecuteCommandLists(1, command_lists);
+        throw_if_failed(command_queue_->Signal(fence_.Get(), ++last_signaled_value_), "staging ring signal");
+
+        in_flight_.push_back({ current_allocator_, last_signaled_value_, head_ });
+        has_pending_copies_ = false;
+
+        current_allocator_ = get_free_allocator();
+        throw_if_failed(command_list_->Reset(current_allocator_.Get(), nullptr), "staging ring cmd list reset");
+        return last_signaled_value_;
+    }
+
+    // Makes work submitted to other queue wait (on GPU) for all uploads.
+    void gpu_wait_for_uploads(ID3D12CommandQueue* command_queue)
+    {
+        const auto value = submit();
+        if (value > 0)
+        {
+            throw_if_failed(command_queue->Wait(fence_.Get(), value), "wait for staging ring");
+        }
+    }
+
+    void flush()
+    {
+        wait_for_fence_value(submit());
+        retire_completed();
+    }
+
+    std::uint64_t get_size() const
+    {
+        return size_;
+    }
+
+private:
+    static constexpr std::int64_t chunk_alignment = 256;
+
+    struct Submission
+    {
+        ComPtr<ID3D12CommandAllocator> allocator;
+        std::uint64_t fence_value = 0;
+        std::uint64_t ring_head = 0;  // ring memory up to this (virtual) offset is free once fence value is reached
+    };
+
+    // Offsets are virtual (monotonic), physical offset is virtual offset modulo ring size.
+    std::uint64_t allocate(std::uint64_t bytes_width)
+    {
+        bytes_width = align(bytes_width, chunk_alignment);
+        assert(bytes_width <= size_);
+        // chunk can't wrap around the end of the ring
+        auto begin = head_;
+        if ((begin % size_) + bytes_width > size_)
+        {
+            begin = align(begin, size_);
+        }
+        while (begin + bytes_width - tail_ > size_)
+        {
+            if (in_flight_.empty())
+            {
+                // only not submitted copies occupy the ring
+                submit();
+            }
+            wait_for_fence_value(in_flight_.front().fence_value);
+            retire_completed();
+        }
+        head_ = begin + bytes_width;
+        return begin % size_;
+    }
+
+    void retire_completed()
+    {
+        const auto completed_value = fence_->GetCompletedValue();
+        while (!in_flight_.empty() && in_flight_.front().fence_value <= completed_value)
+        {
+            tail_ = in_flight_.front().ring_head;
+            free_allocators_.push_back(std::move(in_flight_.front().allocator));
+            in_flight_.pop_front();
+        }
+        if (in_flight_.empty() && !has_pending_copies_)
+        {
+            tail_ = head_;
+        }
+    }
+
+    void wait_for_fence_value(std::uint64_t value)
+    {
+        if (fence_->GetCompletedValue() < value)
+        {
+            throw_if_failed(fence_->SetEventOnCompletion(value, fence_event_), "staging ring set event on completion");
+            ::WaitForSingleObjectEx(fence_event_, INFINITE, FALSE);
+        }
+    }
+
+    ComPtr<ID3D12CommandAllocator> get_free_allocator()
+    {
+        ComPtr<ID3D12CommandAllocator> ret;
+        if (!free_allocators_.empty())
+        {
+            ret = std::move(free_allocators_.back());
+            free_allocators_.pop_back();
+            throw_if_failed(ret->Reset(), "staging ring allocator reset");
+            return ret;
+        }
+        throw_if_failed(d3d12_device_->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_DIRECT, IID_PPV_ARGS(ret.ReleaseAndGetAddressOf())), "create staging ring allocator");
+        return ret;
+    }
+
+private:
+    ID3D12Device* d3d12_device_;
+    ID3D12CommandQueue* command_queue_;
+    std::uint64_t size_ = 0;
+
+    ComPtr<ID3D12Resource> upload_buffer_;
+    std::byte* mapped_ptr_ = nullptr;
+    std::uint64_t head_ = 0;
+    std::uint64_t tail_ = 0;
+
+    ComPtr<ID3D12Fence> fence_;
+    HANDLE fence_event_ = nullptr;
+    std::uint64_t last_signaled_value_ = 0;
+
+    ComPtr<ID3D12GraphicsCommandList> command_list_;
+    ComPtr<ID3D12CommandAllocator> current_allocator_;
+    std::vector<ComPtr<ID3D12CommandAllocator>> free_allocators_;
+    std::deque<Submission> in_flight_;
+    bool has_pending_copies_ = false;
+};
+
+inline std::unique_ptr<StagingRing>& get_staging_ring_storage()
+{
+    static std::unique_ptr<StagingRing> ring;
+    return ring;
+}
+
+// Creates process wide ring and releases it at the end of the scope (before the device and queue it uses).
+class StagingRingScope
+{
+public:
+    StagingRingScope(ID3D12Device* d3d12_device, ID3D12CommandQueue* command_queue, std::size_t ring_bytes_width)
+    {
+        assert(!get_staging_ring_storage() && "Staging ring already initialized.");
+        get_staging_ring_storage() = std::make_unique<StagingRing>(d3d12_device, command_queue, ring_bytes_width);
+    }
+    StagingRingScope(const StagingRingScope& rhs) = delete;
+    StagingRingScope& operator=(const StagingRingScope& rhs) = delete;
+
+    ~StagingRingScope()
+    {
+        get_staging_ring_storage().reset();
+    }
+};
+
+inline StagingRing& get_staging_ring()
+{
+    assert(get_staging_ring_storage() && "Staging ring not initialized.");
+    return *get_staging_ring_storage();
+}
 
 inline void close_execute_reset_wait(ID3D12Device* d3d12_device, ID3D12CommandQueue* command_queue,
     ID3D12CommandAllocator* command_allocator, ID3D12GraphicsCommandList* command_list)
 {
     throw_if_failed(command_list->Close(), "cmd list close");
 
+    // command list can consume data uploaded through the staging ring (ex. barriers recorded after the upload)
+    if (auto& ring = get_staging_ring_storage())
+    {
+        ring->gpu_wait_for_uploads(command_queue);
+    }
+
     ID3D12CommandList* command_lists[] = { command_list };
     command_queue->ExecuteCommandLists(1, command_lists);
 
@@ -300,4 +1057,62 @@ std::vector<TimeType> get_timestamps_timings_from_ptr(uint64_t timestamp_frequen
         exec_times[i] = TimeType(static_cast<uint64_t>(1e6 * t0));
     }
     return exec_times;
-}
\ No newline at end of file
+}
+
+template<typename TimeType = std::chrono::microseconds>
+inline std::vector<TimeType> resolve_timestamps(ID3D12Device* d3d12_device, ID3D12CommandQueue* command_queue,
+    ID3D12CommandAllocator* command_allocator, ID3D12GraphicsCommandList* command_list, PerfCollectorDX12& performance_collector)
+{
+    // Copy the timing data back
+    command_list->ResolveQueryData(
+        performance_collector.timestamp_query_heap.Get(),
+        D3D12_QUERY_TYPE_TIMESTAMP,
+        0,
+        performance_collector.timestamp_index,
+        performance_collector.timestamp_readback_buffer.Get(),
+        0);
+    close_execute_reset_wait(d3d12_device, command_queue, command_allocator, command_list);
+
+    uint64_t timestamp_frequency = 0;
+    command_queue->GetTimestampFrequency(&timestamp_frequency);
+
+    auto ret = get_timestamps_timings_from_ptr<TimeType>(timestamp_frequency, performance_collector.timestamp_readback, performance_collector.timestamp_index);
+    performance_collector.timestamp_index = 0;
+    return ret;
+}
+
+// Creates default heap buffer (in UAV state) filled with host data. Blocking call.
+inline ComPtr<ID3D12Resource> upload_data_to_new_buffer(ID3D12Device* d3d12_device, ID3D12CommandQueue* command_queue,
+    ID3D12CommandAllocator* command_allocator, ID3D12GraphicsCommandList* command_list, std::span<const std::byte> data)
+{
+    auto ret = create_buffer(d3d12_device, data.size(),
+        D3D12_HEAP_TYPE_DEFAULT, D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS);
+    get_staging_ring().upload(ret.Get(), 0, data);
+    const auto barrier = CD3DX12_RESOURCE_BARRIER::Transition(ret.Get(),
+        D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+    command_list->ResourceBarrier(1, &barrier);
+    close_execute_reset_wait(d3d12_device, command_queue, command_allocator, command_list);
+    return ret;
+}
+
+// Copies bytes_width of buffer (expected in UAV state) to the host. Buffer is left in UAV state. Blocking call.
+inline std::vector<std::byte> readback_buffer_data(ID3D12Device* d3d12_device, ID3D12CommandQueue* command_queue,
+    ID3D12CommandAllocator* command_allocator, ID3D12GraphicsCommandList* command_list, ID3D12Resource* buffer, std::size_t bytes_width)
+{
+    auto readback_buffer = create_buffer(d3d12_device, bytes_width, D3D12_HEAP_TYPE_READBACK, D3D12_RESOURCE_STATE_COPY_DEST);
+    auto barrier = CD3DX12_RESOURCE_BARRIER::Transition(buffer,
+        D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_COPY_SOURCE);
+    command_list->ResourceBarrier(1, &barrier);
+    command_list->CopyBufferRegion(readback_buffer.Get(), 0, buffer, 0, bytes_width);
+    barrier = CD3DX12_RESOURCE_BARRIER::Transition(buffer,
+        D3D12_RESOURCE_STATE_COPY_SOURCE, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+    command_list->ResourceBarrier(1, &barrier);
+    close_execute_reset_wait(d3d12_device, command_queue, command_allocator, command_list);
+
+    std::vector<std::byte> ret(bytes_width);
+    std::byte* readback_mapped_ptr = nullptr;
+    readback_buffer->Map(0, nullptr, reinterpret_cast<void**>(&readback_mapped_ptr));
+    std::memcpy(ret.data(), readback_mapped_ptr, ret.size());
+    readback_buffer->Unmap(0, nullptr);
+    return ret;
+}
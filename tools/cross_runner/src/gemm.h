@@ -466,8 +466,6 @@ public:
         const auto out_shape = get_shape_output();
         const auto tensor_out_bytes_width = out_shape.get_elements_count() * get_data_type_bytes_width(params_.dt);
 
-        upload_buffer_ = create_buffer(d3d12_device_, tensor_input_a_bytes_width + tensor_input_b_bytes_width,
-            D3D12_HEAP_TYPE_UPLOAD, D3D12_RESOURCE_STATE_GENERIC_READ);
         input_buffer_a_ = create_buffer(d3d12_device, tensor_input_a_bytes_width,
             D3D12_HEAP_TYPE_DEFAULT, D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS);
         if (tensor_input_b_bytes_width > 0)
@@ -479,27 +477,12 @@ public:
         output_buffer_ = create_buffer(d3d12_device, tensor_out_bytes_width,
             D3D12_HEAP_TYPE_DEFAULT, D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS);
 
-        // copy data into buffer
-        std::byte* upload_mapped_ptr = nullptr;
-        upload_buffer_->Map(0, nullptr, reinterpret_cast<void**>(&upload_mapped_ptr));
-        std::size_t memcopy_offset = 0;
-        std::memcpy(upload_mapped_ptr, input_data_a_.data(), tensor_input_a_bytes_width);
-        memcopy_offset += tensor_input_a_bytes_width;
+        // copy data into buffers, barriers below are executed after the uploads (see close_execute_reset_wait)
+        auto& staging_ring = get_staging_ring();
+        staging_ring.upload(input_buffer_a_.Get(), 0, input_data_a_);
         if (tensor_input_b_bytes_width > 0)
         {
-            std::memcpy(upload_mapped_ptr + memcopy_offset, input_data_b_.data(), tensor_input_b_bytes_width);
-            memcopy_offset += tensor_input_b_bytes_width;
-        }
-        // unmap memory
-        upload_buffer_->Unmap(0, nullptr);
-
-        memcopy_offset = 0;
-        cmd_list->CopyBufferRegion(input_buffer_a_.Get(), 0, upload_buffer_.Get(), 0, tensor_input_a_bytes_width);
-        memcopy_offset += tensor_input_a_bytes_width;
-        if (tensor_input_b_bytes_width > 0)
-        {
-            cmd_list->CopyBufferRegion(input_buffer_b_.Get(), 0, upload_buffer_.Get(), memcopy_offset, tensor_input_b_bytes_width);
-            memcopy_offset += tensor_input_b_bytes_width;
+            staging_ring.upload(input_buffer_b_.Get(), 0, input_data_b_);
         }
         std::vector<CD3DX12_RESOURCE_BARRIER> barriers;
         barriers.push_back(CD3DX12_RESOURCE_BARRIER::Transition(input_buffer_a_.Get(),
@@ -513,78 +496,140 @@ public:
     }
 
     virtual ConformanceResult validate_conformance(ID3D12CommandQueue* command_queue, ID3D12CommandAllocator* command_allocator, ID3D12GraphicsCommandList* command_list)
+    {
+        return validate_conformance_with_reference(get_reference_result(command_queue, command_allocator, command_list), command_queue, command_allocator, command_list);
+    }
+
+    ConformanceResult validate_conformance_with_reference(const std::vector<std::byte>& reference, ID3D12CommandQueue* command_queue,
+        ID3D12CommandAllocator* command_allocator, ID3D12GraphicsCommandList* command_list) override
     {
         const auto out_shape = get_shape_output();
         const auto tensor_out_bytes_width = out_shape.get_elements_count() * get_data_type_bytes_width(params_.dt);
 
         // readback data and validate
-        auto readback_buffer = create_buffer(d3d12_device_, tensor_out_bytes_width, D3D12_HEAP_TYPE_READBACK, D3D12_RESOURCE_STATE_COPY_DEST);
-        auto readback_output_barrirer = CD3DX12_RESOURCE_BARRIER::Transition(output_buffer_.Get(),
-            D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_COPY_SOURCE);
-        command_list->ResourceBarrier(1, &readback_output_barrirer);
-        command_list->CopyResource(readback_buffer.Get(), output_buffer_.Get());
-        close_execute_reset_wait(d3d12_device_, command_queue, command_allocator, command_list);
+        const auto data_out = readback_buffer_data(d3d12_device_, command_queue, command_allocator, command_list, output_buffer_.Get(), tensor_out_bytes_width);
+
+        if (params_.dt == DataType::eFp32)
+        {
+            return run_conformance_check<float>(data_out, reference, 0.05f);
+        }
+        else if (params_.dt == DataType::eFp16)
+        {
+            return run_conformance_check<Half>(data_out, reference, 0.05f);
+        }
+        assert(false && "Unsupported output data type!");
+        ConformanceResult ret{};
+        return ret;
 
-        std::vector<std::byte> data_out(tensor_out_bytes_width);
-        std::byte* readback_mapped_ptr = nullptr;
-        readback_buffer->Map(0, nullptr, reinterpret_cast<void**>(&readback_mapped_ptr));
-        std::memcpy(data_out.data(), readback_mapped_ptr, data_out.size());
-        readback_buffer->Unmap(0, nullptr);
+    }
+
+    std::vector<std::byte> get_reference_result(ID3D12CommandQueue* command_queue, ID3D12CommandAllocator* command_allocator, ID3D12GraphicsCommandList* command_list) override
+    {
+        const auto out_shape = get_shape_output();
+        const auto tensor_out_bytes_width = out_shape.get_elements_count() * get_data_type_bytes_width(params_.dt);
 
         //
-        //  calc reference with dml non-mc 
+        //  calc reference with dml non-mc, inputs are uploaded from host data (node inputs can be bound to other node outputs)
         //
-        readback_output_barrirer = CD3DX12_RESOURCE_BARRIER::Transition(output_buffer_.Get(),
-            D3D12_RESOURCE_STATE_COPY_SOURCE, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
-        command_list->ResourceBarrier(1, &readback_output_barrirer);
+        auto ref_input_a = upload_data_to_new_buffer(d3d12_device_, command_queue, command_allocator, command_list, input_data_a_);
+        ComPtr<ID3D12Resource> ref_input_b;
+        if (!input_data_b_.empty())
+        {
+            ref_input_b = upload_data_to_new_buffer(d3d12_device_, command_queue, command_allocator, command_list, input_data_b_);
+        }
+        auto ref_output = create_buffer(d3d12_device_, tensor_out_bytes_width,
+            D3D12_HEAP_TYPE_DEFAULT, D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS);
 
         gpu_op::Gemm gemm_ref(params_.type, to_dml_data_type(params_.dt), to_dml_tensor_policy(params_.layout), params_.shape_a, params_.shape_b, get_shape_output(),
              params_.alpha, params_.beta, dml_device_, d3d12_device_, true);
 
         // bind descriptor heap
-        auto descriptor_heap = create_descriptor_heap(d3d12_device_, gemm_ref.get_total_descriptor_count());
-        ID3D12DescriptorHeap* d3d12_descriptor_heaps[] = { descriptor_heap.Get() };
-        command_list->SetDescriptorHeaps(1, d3d12_descriptor_heaps);
+        auto& descriptor_heap_allocator = get_descriptor_heap_allocator();
+        const auto descriptors = descriptor_heap_allocator.allocate(gemm_ref.get_total_descriptor_count());
+        descriptor_heap_allocator.bind(command_list);
 
-        gemm_ref.create_binding_tables(descriptor_heap->GetCPUDescriptorHandleForHeapStart(), descriptor_heap->GetGPUDescriptorHandleForHeapStart());
+        gemm_ref.create_binding_tables(descriptors.get_cpu_handle(), descriptors.get_gpu_handle());
         gemm_ref.record_initialize(dml_cmd_recorder_, command_list);
         close_execute_reset_wait(d3d12_device_, command_queue, command_allocator, command_list);
 
-        command_list->SetDescriptorHeaps(1, d3d12_descriptor_heaps);
-        gemm_ref.record_execute(dml_cmd_recorder_, command_list, output_buffer_.Get(), input_buffer_a_.Get(), input_buffer_b_.Get());
+        descriptor_heap_allocator.bind(command_list);
+        gemm_ref.record_execute(dml_cmd_recorder_, command_list, ref_output.Get(), ref_input_a.Get(), ref_input_b.Get());
         close_execute_reset_wait(d3d12_device_, command_queue, command_allocator, command_list);
 
-        readback_output_barrirer = CD3DX12_RESOURCE_BARRIER::Transition(output_buffer_.Get(),
-            D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_COPY_SOURCE);
-        command_list->ResourceBarrier(1, &readback_output_barrirer);
-        command_list->CopyResource(readback_buffer.Get(), output_buffer_.Get());
-        close_execute_reset_wait(d3d12_device_, command_queue, command_allocator, command_list);
-
-        std::vector<std::byte> ref_untyped_result(tensor_out_bytes_width);
-        readback_mapped_ptr = nullptr;
-        readback_buffer->Map(0, nullptr, reinterpret_cast<void**>(&readback_mapped_ptr));
-        std::memcpy(ref_untyped_result.data(), readback_mapped_ptr, ref_untyped_result.size());
-        readback_buffer->Unmap(0, nullptr);
+        auto ref_untyped_result = readback_buffer_data(d3d12_device_, command_queue, command_allocator, command_list, ref_output.Get(), tensor_out_bytes_width);
 
         if (params_.fuse_softmax)
         {
             ref_untyped_result = cpu_op::softmax(3, ref_untyped_result.data(), get_shape_output(), params_.dt, params_.layout);
         }
+        return ref_untyped_result;
+    }
 
+    ID3D12Resource* get_output_resource() override
+    {
+        return output_buffer_.Get();
+    }
 
+    ID3D12Resource* get_input_resource(std::uint32_t idx) override
+    {
+        assert(idx < 2);
+        return idx == 0 ? input_buffer_a_.Get() : input_buffer_b_.Get();
+    }
 
-        if (params_.dt == DataType::eFp32)
+    void set_input_resource(std::uint32_t idx, ComPtr<ID3D12Resource> resource) override
+    {
+        assert(idx < 2);
+        check_input_resource_size(resource.Get(), get_input_data(idx).size());
+        auto& buffer = idx == 0 ? input_buffer_a_ : input_buffer_b_;
+        buffer = std::move(resource);
+    }
+
+    const std::vector<std::byte>& get_input_data(std::uint32_t idx) const override
+    {
+        assert(idx < 2);
+        return idx == 0 ? input_data_a_ : input_data_b_;
+    }
+
+    void set_input_data(std::uint32_t idx, std::vector<std::byte> data) override
+    {
+        assert(idx < 2);
+        auto& input_data = idx == 0 ? input_data_a_ : input_data_b_;
+        check_input_data_size(data, input_data.size());
+        input_data = std::move(data);
+    }
+
+    LayerCost get_layer_cost() const override
+    {
+        const auto batches = static_cast<std::uint64_t>(get_batch()) * get_channels();
+        const std::uint64_t output_elements = get_shape_output().get_elements_count();
+
+        LayerCost ret{};
+        ret.flops = 2 * batches * get_M() * get_K() * get_N();
+        if (params_.fuse_softmax)
         {
-            return run_conformance_check<float>(data_out, ref_untyped_result, 0.05f);
+            // max, sub, exp, sum and div per output element
+            ret.flops += 5 * output_elements;
         }
-        else if (params_.dt == DataType::eFp16)
+
+        // stacked tensors are only partially read by the MHA kernels
+        std::uint64_t bytes_a = input_data_a_.size();
+        std::uint64_t bytes_b = input_data_b_.size();
+        switch (params_.type)
         {
-            return run_conformance_check<Half>(data_out, ref_untyped_result, 0.05f);
+        case GemmType::GemmType_QK_QKV: bytes_a = bytes_a * 2 / 3; break; // Q and K out of QKV
+        case GemmType::GemmType_SV_S_QKV: bytes_b = bytes_b / 3; break;   // V out of QKV
+        case GemmType::GemmType_QK_Q_KV:                                   // K out of KV
+        case GemmType::GemmType_SV_S_KV: bytes_b = bytes_b / 2; break;    // V out of KV
+        default:
+            break;
         }
-        assert(false && "Unsupported output data type!");
-        ConformanceResult ret{};
+        ret.bytes = bytes_a + bytes_b + output_elements * get_data_type_bytes_width(params_.dt);
         return ret;
+    }
 
+    DataType get_compute_data_type() const override
+    {
+        return params_.dt;
     }
 
 protected:
@@ -683,7 +728,6 @@ protected:
     ComPtr<ID3D12Resource> input_buffer_b_;
 
     ComPtr<ID3D12Resource> output_buffer_;
-    ComPtr<ID3D12Resource> upload_buffer_;
 };
 
 class GemmDmlDispatcher : public GemmBaseDispatcher
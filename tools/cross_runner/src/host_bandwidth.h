@@ -0,0 +1,261 @@
+#pragma once
+#include <vector>
+#include <thread>
+#include <latch>
+#include <chrono>
+#include <format>
+#include <iostream>
+#include <algorithm>
+#include <cstring>
+#include <optional>
+#include <emmintrin.h>
+
+#include "dx12_utils.h"
+#include "layers_utils.h"
+
+namespace cpu_op
+{
+
+/*
+*   Host memory bandwidth microbenchmark. Host side phases of the runner (data generation, memcpy into mapped upload buffers,
+*   readbacks and CPU references) are bound by it, so it helps to explain the time outside of GPU timestamps.
+*/
+class HostBandwidthBenchmark
+{
+public:
+    struct create_params_t
+    {
+        std::size_t buffer_bytes = 256ull * 1024 * 1024;
+        std::uint32_t threads_count = 0;  // 0 - all hardware threads
+        std::uint32_t iterations = 10;
+        bool numa = false;
+
+        inline static void add_cli_options(CLI::App* opts, create_params_t& params)
+        {
+            opts->add_option("--buffer_bytes", params.buffer_bytes, "Size of single buffer, should be much bigger than LLC.");
+            opts->add_option("--threads", params.threads_count, "Threads count for multi threaded runs, 0 means all hardware threads.");
+            opts->add_option("--iters", params.iterations);
+            opts->add_flag("--numa", params.numa, "Measure local vs remote NUMA node traffic.")->default_val(false);
+        }
+    };
+
+    enum class Op
+    {
+        eRead,
+        eWrite,
+        eCopy,
+        eWriteNonTemporal,
+        eCopyNonTemporal,
+    };
+
+public:
+    HostBandwidthBenchmark(create_params_t&& params)
+        : params_(std::move(params))
+    {
+        if (params_.threads_count == 0)
+        {
+            params_.threads_count = std::max(1u, std::thread::hardware_concurrency());
+        }
+        // chunks of threads are aligned to cache lines, required by non temporal stores
+        params_.buffer_bytes = static_cast<std::size_t>(align(static_cast<std::int64_t>(params_.buffer_bytes), static_cast<std::int64_t>(cache_line_size * params_.threads_count)));
+    }
+
+    void run()
+    {
+        std::cout << std::format("Host bandwidth, buffer: {} MB, threads: {}, iterations: {}\n", params_.buffer_bytes / (1024 * 1024), params_.threads_count, params_.iterations);
+
+        HostBuffer src(params_.buffer_bytes, std::nullopt);
+        HostBuffer dst(params_.buffer_bytes, std::nullopt);
+
+        std::cout << std::format("{:>12} {:>8} {:>12}\n", "op", "threads", "BW [GB/s]");
+        for (const auto op : { Op::eRead, Op::eWrite, Op::eCopy, Op::eWriteNonTemporal, Op::eCopyNonTemporal })
+        {
+            for (const auto threads : { 1u, params_.threads_count })
+            {
+                const auto bw = measure(op, threads, src.data(), dst.data(), std::nullopt);
+                std::cout << std::format("{:>12} {:>8} {:>12.2f}\n", op_name(op), threads, bw);
+            }
+        }
+
+        if (params_.numa)
+        {
+            run_numa();
+        }
+    }
+
+private:
+    static constexpr std::size_t cache_line_size = 64;
+
+    // page aligned, committed and touched memory, optionally allocated on given NUMA node
+    class HostBuffer
+    {
+    public:
+        HostBuffer(std::size_t bytes_width, std::optional<std::uint32_t> numa_node)
+            : bytes_width_(bytes_width)
+        {
+            const auto alloc_type = MEM_RESERVE | MEM_COMMIT;
+            ptr_ = numa_node ? ::VirtualAllocExNuma(::GetCurrentProcess(), nullptr, bytes_width_, alloc_type, PAGE_READWRITE, *numa_node)
+                : ::VirtualAlloc(nullptr, bytes_width_, alloc_type, PAGE_READWRITE);
+            if (!ptr_)
+            {
+                throw std::runtime_error(std::format("Failed to allocate host buffer, bytes: {}.", bytes_width_));
+            }
+            // page faults should not be part of the measurment
+            std::memset(ptr_, 1, bytes_width_);
+        }
+        HostBuffer(const HostBuffer& rhs) = delete;
+        HostBuffer& operator=(const HostBuffer& rhs) = delete;
+
+        ~HostBuffer()
+        {
+            ::VirtualFree(ptr_, 0, MEM_RELEASE);
+        }
+
+        std::byte* data() { return reinterpret_cast<std::byte*>(ptr_); }
+
+    private:
+        void* ptr_ = nullptr;
+        std::size_t bytes_width_ = 0;
+    };
+
+    static const char* op_name(Op op)
+    {
+        switch (op)
+        {
+        case Op::eRead: return "read";
+        case Op::eWrite: return "write";
+        case Op::eCopy: return "copy";
+        case Op::eWriteNonTemporal: return "write_nt";
+        case Op::eCopyNonTemporal: return "copy_nt";
+        default:
+            assert(false && "Unknown host bandwidth op.");
+        }
+        return "";
+    }
+
+    static std::uint64_t run_op(Op op, const std::byte* src, std::byte* dst, std::size_t bytes_width)
+    {
+        std::uint64_t ret = 0;
+        if (op == Op::eRead)
+        {
+            const auto* src_typed = reinterpret_cast<const std::uint64_t*>(src);
+            for (std::size_t i = 0; i < bytes_width / sizeof(std::uint64_t); i++)
+            {
+                ret += src_typed[i];
+            }
+        }
+        else if (op == Op::eWrite)
+        {
+            std::memset(dst, 0x5a, bytes_width);
+        }
+        else if (op == Op::eCopy)
+        {
+            std::memcpy(dst, src, bytes_width);
+        }
+        else
+        {
+            // stores bypass the caches, so there is no read for ownership of destination lines
+            const auto value = _mm_set1_epi32(0x5a5a5a5a);
+            const auto* src_typed = reinterpret_cast<const __m128i*>(src);
+            auto* dst_typed = reinterpret_cast<__m128i*>(dst);
+            for (std::size_t i = 0; i < bytes_width / sizeof(__m128i); i++)
+            {
+                _mm_stream_si128(dst_typed + i, op == Op::eCopyNonTemporal ? _mm_load_si128(src_typed + i) : value);
+            }
+            _mm_sfence();
+        }
+        return ret;
+    }
+
+    static std::uint64_t get_op_bytes(Op op, std::size_t bytes_width)
+    {
+        return (op == Op::eCopy || op == Op::eCopyNonTemporal) ? 2 * bytes_width : bytes_width;
+    }
+
+    // Returns best bandwidth in GB/s. Threads are pinned to the cpu_numa_node, if provided.
+    // Threads are created and released together, so thread creation and joins are not a part of the measured time.
+    double measure(Op op, std::uint32_t threads_count, const std::byte* src, std::byte* dst, std::optional<std::uint32_t> cpu_numa_node)
+    {
+        const auto chunk_bytes = params_.buffer_bytes / threads_count;
+        std::vector<std::uint64_t> sinks(threads_count * (cache_line_size / sizeof(std::uint64_t)));
+
+        std::optional<GROUP_AFFINITY> affinity;
+        if (cpu_numa_node)
+        {
+            GROUP_AFFINITY node_affinity{};
+            if (!::GetNumaNodeProcessorMaskEx(static_cast<USHORT>(*cpu_numa_node), &node_affinity))
+            {
+                throw std::runtime_error(std::format("Failed to query processors of NUMA node: {}.", *cpu_numa_node));
+            }
+            affinity = node_affinity;
+        }
+
+        auto best = std::chrono::nanoseconds::max();
+        for (std::uint32_t it = 0; it < params_.iterations; it++)
+        {
+            std::latch ready(threads_count);
+            std::latch start_barrier(1);
+            std::latch done(threads_count);
+            std::vector<std::thread> threads;
+            threads.reserve(threads_count);
+            for (std::uint32_t t = 0; t < threads_count; t++)
+            {
+                threads.emplace_back([&, t]()
+                    {
+                        if (affinity)
+                        {
+                            ::SetThreadGroupAffinity(::GetCurrentThread(), &*affinity, nullptr);
+                        }
+                        ready.count_down();
+                        start_barrier.wait();
+                        // sinks are a cache line apart to avoid false sharing
+                        sinks[t * (cache_line_size / sizeof(std::uint64_t))] += run_op(op, src + t * chunk_bytes, dst + t * chunk_bytes, chunk_bytes);
+                        done.count_down();
+                    });
+            }
+            ready.wait();
+            const auto start = std::chrono::steady_clock::now();
+            start_barrier.count_down();
+            done.wait();
+            const auto end = std::chrono::steady_clock::now();
+            for (auto& thread : threads)
+            {
+                thread.join();
+            }
+            best = std::min(best, std::chrono::duration_cast<std::chrono::nanoseconds>(end - start));
+        }
+
+        // bytes / ns = GB/s
+        return static_cast<double>(get_op_bytes(op, chunk_bytes * threads_count)) / static_cast<double>(best.count());
+    }
+
+    void run_numa()
+    {
+        ULONG highest_node = 0;
+        if (!::GetNumaHighestNodeNumber(&highest_node) || highest_node == 0)
+        {
+            std::cout << "Single NUMA node system, skipping NUMA measurments.\n";
+            return;
+        }
+
+        const auto nodes_count = highest_node + 1;
+        std::cout << std::format("NUMA copy bandwidth [GB/s], threads: {} (rows: cpu node, columns: memory node)\n", params_.threads_count);
+        for (std::uint32_t cpu_node = 0; cpu_node < nodes_count; cpu_node++)
+        {
+            std::cout << std::format("cpu {:>3}:", cpu_node);
+            for (std::uint32_t memory_node = 0; memory_node < nodes_count; memory_node++)
+            {
+                HostBuffer src(params_.buffer_bytes, memory_node);
+                HostBuffer dst(params_.buffer_bytes, memory_node);
+                const auto bw = measure(Op::eCopy, params_.threads_count, src.data(), dst.data(), cpu_node);
+                std::cout << std::format(" {:>10.2f}{}", bw, cpu_node == memory_node ? " (local)" : "");
+            }
+            std::cout << std::endl;
+        }
+    }
+
+private:
+    create_params_t params_;
+};
+
+}  // namespace cpu_op
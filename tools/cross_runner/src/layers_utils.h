@@ -5,6 +5,8 @@
 #include <cstdint>
 #include <istream>
 #include <vector>
+#include <future>
+#include <optional>
 
 #include "CLI/App.hpp"
 #include "CLI/Formatter.hpp"
@@ -100,6 +102,10 @@ enum class DataType
 {
     eFp32 = 0,
     eFp16 = 1,
+    // quantized tensors (values are scale * (q - zero_point)), int32 is used for bias and accumulators
+    eInt8 = 2,
+    eUint8 = 3,
+    eInt32 = 4,
     eCount
 };
 
@@ -109,6 +115,9 @@ inline std::uint8_t get_data_type_bytes_width(DataType dt)
     {
     case DataType::eFp32: return sizeof(float);
     case DataType::eFp16: return sizeof(std::uint16_t);
+    case DataType::eInt8: return sizeof(std::int8_t);
+    case DataType::eUint8: return sizeof(std::uint8_t);
+    case DataType::eInt32: return sizeof(std::int32_t);
     default:
         assert(false && "Unknown data type.");
     }
@@ -201,17 +210,29 @@ inline float cast_to_float(float v)
     return v;
 }
 
+inline float cast_to_float(std::int8_t v)
+{
+    return static_cast<float>(v);
+}
+
+inline float cast_to_float(std::uint8_t v)
+{
+    return static_cast<float>(v);
+}
+
 enum class NodeType
 {
     eGemmDml,
     eGemmCm,
     eConvDml,
+    eConvTransposedDml,
     eConvCm,
     eSoftmaxDml,
     eSoftmaxCm,
     eMvnDml,
     eMvnCm,
     eMemoryBandwidth,
+    eHostBandwidth,
     eCount
 };
 
@@ -236,6 +257,16 @@ inline void randomize_linear_container_half(std::mt19937& gen, std::uniform_real
     }
 }
 
+template<typename Dt>
+inline void randomize_linear_container_integer(std::mt19937& gen, std::uniform_int_distribution<std::int32_t>& dist, std::span<std::byte> container)
+{
+    auto* ptr = reinterpret_cast<Dt*>(container.data());
+    for (auto i = 0; i < container.size() / sizeof(Dt); i++)
+    {
+        ptr[i] = static_cast<Dt>(dist(gen));
+    }
+}
+
 inline void fill_with_constant_linear_container_half(std::span<std::byte> container, Half value)
 {
     using Dt = Half;
@@ -246,11 +277,12 @@ inline void fill_with_constant_linear_container_half(std::span<std::byte> contai
     }
 }
 
-inline auto add_data_type_cli_option(CLI::App* opts, std::string_view opt_name, DataType& dt)
+// Layers supporting quantized data types pass them in supported list.
+inline auto add_data_type_cli_option(CLI::App* opts, std::string_view opt_name, DataType& dt, std::vector<DataType> supported = { DataType::eFp32, DataType::eFp16 })
 {
-    return opts->add_option(opt_name.data(), dt)->check(CLI::IsMember({DataType::eFp32, DataType::eFp16}))
+    return opts->add_option(opt_name.data(), dt)->check(CLI::IsMember(std::move(supported)))
         ->transform(CLI::Transformer(std::map<std::string, DataType>{
-            {"fp32", DataType::eFp32}, { "fp16", DataType::eFp16 }
+            {"fp32", DataType::eFp32}, { "fp16", DataType::eFp16 }, { "int8", DataType::eInt8 }, { "uint8", DataType::eUint8 }
     }, CLI::ignore_case, CLI::ignore_underscore));
 }
 
@@ -291,6 +323,84 @@ inline ConformanceResult run_conformance_check(const std::vector<std::byte>& gpu
     return ret;
 }
 
+/*
+*   Theoretical work of a single dispatch, used by the roofline report.
+*   flops counts multiply-add as 2 operations, bytes is the minimal traffic (every input read once, every output written once).
+*/
+struct LayerCost
+{
+    std::uint64_t flops = 0;
+    std::uint64_t bytes = 0;
+
+    inline double get_arithmetic_intensity() const
+    {
+        return bytes == 0 ? 0.0 : static_cast<double>(flops) / static_cast<double>(bytes);
+    }
+};
+
+inline void check_input_resource_size(ID3D12Resource* resource, std::size_t bytes_width)
+{
+    if (!resource || resource->GetDesc().Width < bytes_width)
+    {
+        throw std::runtime_error(std::format("Input resource too small, required bytes: {}.", bytes_width));
+    }
+}
+
+inline void check_input_data_size(const std::vector<std::byte>& data, std::size_t bytes_width)
+{
+    if (data.size() != bytes_width)
+    {
+        throw std::runtime_error(std::format("Input data size mismatch, expected bytes: {}, got: {}.", bytes_width, data.size()));
+    }
+}
+
+/*
+*   Reference result calculated on worker thread. Calculation has to own or outlive all the data it reads,
+*   input data can't be modified until result is taken or calculation is cancelled.
+*/
+class AsyncReference
+{
+public:
+    AsyncReference() = default;
+    AsyncReference(const AsyncReference& rhs) = delete;
+    AsyncReference& operator=(const AsyncReference& rhs) = delete;
+
+    ~AsyncReference()
+    {
+        cancel();
+    }
+
+    template<typename Func>
+    void start(Func&& func)
+    {
+        cancel();
+        future_ = std::async(std::launch::async, std::forward<Func>(func));
+    }
+
+    // Waits for the result if calculation was started.
+    std::optional<std::vector<std::byte>> take()
+    {
+        if (!future_.valid())
+        {
+            return std::nullopt;
+        }
+        return future_.get();
+    }
+
+    // Waits for the calculation and drops the result (ex. inputs are going to change).
+    void cancel()
+    {
+        if (future_.valid())
+        {
+            future_.wait();
+            future_ = {};
+        }
+    }
+
+private:
+    std::future<std::vector<std::byte>> future_;
+};
+
 class NodeDispatcher
 {
 public:
@@ -301,6 +411,49 @@ public:
     virtual ConformanceResult validate_conformance(ID3D12CommandQueue* command_queue,
         ID3D12CommandAllocator* command_allocator, ID3D12GraphicsCommandList* command_list) = 0;
 
+    virtual LayerCost get_layer_cost() const { return {}; }
+    // Data type of the layer math, selects compute roof of the roofline report. eCount if the layer does no math.
+    virtual DataType get_compute_data_type() const { return DataType::eCount; }
+
+    /*
+    *   Pipeline support. Inputs are indexed in the order of the layer definition (ex. gemm: a, b; conv: input, filter, bias).
+    *   External input resource has to be set before initialize(..) and after construction commands were executed.
+    */
+    virtual ID3D12Resource* get_output_resource() { return nullptr; }
+    virtual ID3D12Resource* get_input_resource(std::uint32_t idx) { return nullptr; }
+    virtual void set_input_resource(std::uint32_t idx, ComPtr<ID3D12Resource> resource)
+    {
+        throw std::runtime_error("Node does not support external input resources.");
+    }
+
+    // Host copies of inputs, used by references. Replacing host data does not change GPU input.
+    virtual const std::vector<std::byte>& get_input_data(std::uint32_t idx) const
+    {
+        throw std::runtime_error("Node does not expose input data.");
+    }
+    virtual void set_input_data(std::uint32_t idx, std::vector<std::byte> data)
+    {
+        throw std::runtime_error("Node does not support setting input data.");
+    }
+
+    // Reference output calculated from host input data.
+    virtual std::vector<std::byte> get_reference_result(ID3D12CommandQueue* command_queue,
+        ID3D12CommandAllocator* command_allocator, ID3D12GraphicsCommandList* command_list)
+    {
+        throw std::runtime_error("Node does not support reference calculation.");
+    }
+
+    // Compares output with given result of get_reference_result(..), so a reference needed also by other nodes is calculated once.
+    virtual ConformanceResult validate_conformance_with_reference(const std::vector<std::byte>& reference, ID3D12CommandQueue* command_queue,
+        ID3D12CommandAllocator* command_allocator, ID3D12GraphicsCommandList* command_list)
+    {
+        throw std::runtime_error("Node does not support validation with external reference.");
+    }
+
+    // Starts reference calculation on worker thread (overlapped with timed executions), returns false if not supported.
+    // Only references calculated purely on the host can be started this way, GPU work would disturb the timed executions.
+    virtual bool start_reference_async() { return false; }
+
     virtual ~NodeDispatcher() = default;
 };
 
@@ -311,13 +464,14 @@ enum class DescType
     eUav
 };
 
-inline ComPtr<ID3D12RootSignature> create_root_signature(ID3D12Device* d3d12_device, std::span<const DescType> desc_list)
+// root_constants_count: DWORDs of the kernel scalars, bound after the descriptor tables (see dispatch_kernel)
+inline ComPtr<ID3D12RootSignature> create_root_signature(ID3D12Device* d3d12_device, std::span<const DescType> desc_list, std::uint32_t root_constants_count = 0)
 {
     const auto bindings_size = desc_list.size();
     std::vector<D3D12_DESCRIPTOR_RANGE1> ranges;
     std::vector<CD3DX12_ROOT_PARAMETER1> root_params;
     ranges.reserve(bindings_size);
-    root_params.reserve(bindings_size + 1); // + 1 beacuse of the CM driver path
+    root_params.reserve(bindings_size + 2); // + 1 beacuse of the CM driver path, + 1 for the scalars
 
     std::uint32_t srv_range_reg = 0;
     std::uint32_t uav_range_reg = 0;
@@ -350,6 +504,13 @@ inline ComPtr<ID3D12RootSignature> create_root_signature(ID3D12Device* d3d12_dev
         add_desc_table(d);
     }
 
+    if (root_constants_count > 0)
+    {
+        CD3DX12_ROOT_PARAMETER1 rp{};
+        rp.InitAsConstants(root_constants_count, cbv_range_reg++);
+        root_params.push_back(rp);
+    }
+
     if (root_params.size() == 0)
     {
         throw std::runtime_error("Something gone wrong. Why kernel has 0 root params?");
@@ -432,7 +593,9 @@ inline std::vector<CD3DX12_GPU_DESCRIPTOR_HANDLE> create_resource_views_and_hand
     return gpu_handles;
 }
 
-inline void dispatch_kernel(ID3D12GraphicsCommandList* cmd_list, ID3D12PipelineState* pso, ID3D12RootSignature* root_signature, std::span<CD3DX12_GPU_DESCRIPTOR_HANDLE> gpu_handles, std::uint32_t thg_x, std::uint32_t thg_y, std::uint32_t thg_z)
+// root_constants: kernel scalars, root signature has to be created with the same root_constants_count
+inline void dispatch_kernel(ID3D12GraphicsCommandList* cmd_list, ID3D12PipelineState* pso, ID3D12RootSignature* root_signature, std::span<CD3DX12_GPU_DESCRIPTOR_HANDLE> gpu_handles, std::uint32_t thg_x, std::uint32_t thg_y, std::uint32_t thg_z,
+    std::span<const std::uint32_t> root_constants = {})
 {
     assert(thg_x > 0);
     assert(thg_y > 0);
@@ -451,6 +614,10 @@ inline void dispatch_kernel(ID3D12GraphicsCommandList* cmd_list, ID3D12PipelineS
         const auto gpu_heap_handle = gpu_handles[i];
         cmd_list->SetComputeRootDescriptorTable(root_index++, gpu_heap_handle);
     }
+    if (!root_constants.empty())
+    {
+        cmd_list->SetComputeRoot32BitConstants(root_index++, static_cast<UINT>(root_constants.size()), root_constants.data(), 0);
+    }
 
     cmd_list->Dispatch(thg_x, thg_y, thg_z);
 }
\ No newline at end of file
@@ -4,6 +4,9 @@
 #include "softmax.h"
 #include "mvn.h"
 #include "memory_bandwidth.h"
+#include "host_bandwidth.h"
+#include "roofline.h"
+#include "pipeline.h"
 #include "layers_utils.h"
 
 #include <dml_types.hpp>
@@ -18,6 +21,8 @@
 #include <sstream>
 #include <string>
 #include <utility>
+#include <algorithm>
+#include <fstream>
 
 template<typename TimeType>
 inline void print_performance_stats(const std::vector<TimeType>& timings)
@@ -51,12 +56,225 @@ inline void print_performance_stats(const std::vector<TimeType>& timings)
     std::cout << "Best: " << best << std::endl;
 }
 
+inline void print_memory_stats(const ResourceAllocator::Stats& stats)
+{
+    constexpr const double mb = 1024.0 * 1024.0;
+    std::cout << "Device memory:" << std::endl;
+    std::cout << std::format("  Buffers alive: {}, sum of sizes: {:.2f} MB (peak: {:.2f} MB)\n", stats.buffers_count, stats.requested_bytes / mb, stats.peak_requested_bytes / mb);
+    std::cout << std::format("  Heaps reserved: {:.2f} MB (peak: {:.2f} MB)\n", stats.heaps_bytes / mb, stats.peak_heaps_bytes / mb);
+    std::cout << std::format("  Transient (aliased) buffers sum of sizes: {:.2f} MB\n", stats.transient_bytes / mb);
+}
+
+inline std::vector<std::chrono::microseconds> resolve_timings(ID3D12Device* d3d12_device, ID3D12CommandQueue* command_queue,
+    ID3D12CommandAllocator* command_allocator, ID3D12GraphicsCommandList* command_list, PerfCollectorDX12& performance_collector)
+{
+    const auto timestamps_timings = resolve_timestamps(d3d12_device, command_queue, command_allocator, command_list, performance_collector);
+
+    std::vector<std::chrono::microseconds> timings(timestamps_timings.size() / 2);
+    for (uint32_t i = 0; i < timings.size(); i++)
+    {
+        const auto t0 = timestamps_timings[i * 2];
+        const auto t1 = timestamps_timings[i * 2 + 1];
+        timings[i] = t1 - t0;
+    }
+    return timings;
+}
+
+// Runs standalone node (used for peak measurments) and returns the best time.
+inline std::chrono::microseconds measure_best_time(NodeDispatcher& node, std::uint32_t iterations, ID3D12Device* d3d12_device, ID3D12CommandQueue* command_queue,
+    ID3D12CommandAllocator* command_allocator, ID3D12GraphicsCommandList* command_list, PerfCollectorDX12& performance_collector)
+{
+    close_execute_reset_wait(d3d12_device, command_queue, command_allocator, command_list);
+
+    auto& descriptor_heap_allocator = get_descriptor_heap_allocator();
+    const auto descriptors = descriptor_heap_allocator.allocate(node.get_total_descriptor_count());
+    descriptor_heap_allocator.bind(command_list);
+    node.initialize(command_list, descriptors.get_cpu_handle(), descriptors.get_gpu_handle());
+    close_execute_reset_wait(d3d12_device, command_queue, command_allocator, command_list);
+
+    descriptor_heap_allocator.bind(command_list);
+    for (std::uint32_t i = 0; i < iterations; ++i)
+    {
+        performance_collector.add_timestamp(command_list);
+        node.execute(command_list);
+        performance_collector.add_timestamp(command_list);
+    }
+    close_execute_reset_wait(d3d12_device, command_queue, command_allocator, command_list);
+
+    const auto timings = resolve_timings(d3d12_device, command_queue, command_allocator, command_list, performance_collector);
+    return *std::min_element(timings.begin(), timings.end());
+}
+
+inline void run_memory_bandwidth_sweep(const gpu_op::MemoryBandwidthDispatcher::create_params_t& params, std::uint32_t iterations, ID3D12Device* d3d12_device, ID3D12CommandQueue* command_queue,
+    ID3D12CommandAllocator* command_allocator, ID3D12GraphicsCommandList* command_list, IntelExtension& intel_extension, PerfCollectorDX12& performance_collector)
+{
+    const auto configs = gpu_op::MemoryBandwidthDispatcher::get_sweep_configs(params);
+    std::cout << std::format("Running memory bandwidth sweep, configurations count: {}\n", configs.size());
+
+    std::vector<gpu_op::MemoryBandwidthSample> samples;
+    samples.reserve(configs.size());
+    for (auto config : configs)
+    {
+        gpu_op::MemoryBandwidthSample sample{};
+        sample.working_set_bytes = config.shape.get_elements_count() * get_data_type_bytes_width(config.dt);
+        sample.items_per_hw = config.items_per_hw;
+        sample.lws_x = config.lws_x;
+
+        gpu_op::MemoryBandwidthDispatcher node(std::move(config), d3d12_device, command_list, intel_extension);
+        sample.time = measure_best_time(node, iterations, d3d12_device, command_queue, command_allocator, command_list, performance_collector);
+        sample.bandwidth_gbps = to_giga_per_second(node.get_layer_cost().bytes, sample.time);
+        samples.push_back(sample);
+    }
+    gpu_op::print_bandwidth_curve(samples);
+}
+
+/*
+*   Every node instance gets own compute queue, all the queues are submitted at the same time.
+*   Aggregate throughput is measured with host wall time (from submission till all the queues are done) and compared with single queue run,
+*   per queue latency comes from the timestamps. Scaling close to 1x means single instance already saturates the GPU.
+*/
+inline void run_multi_queue_throughput(std::vector<std::unique_ptr<NodeDispatcher>>& nodes, std::uint32_t iterations, bool validate, ID3D12Device* d3d12_device,
+    ID3D12CommandQueue* command_queue, ID3D12CommandAllocator* command_allocator, ID3D12GraphicsCommandList* command_list)
+{
+    struct QueueContext
+    {
+        ComPtr<ID3D12CommandQueue> queue;
+        ComPtr<ID3D12CommandAllocator> allocator;
+        ComPtr<ID3D12GraphicsCommandList> list;
+        ComPtr<ID3D12Fence> fence;
+        std::uint64_t fence_value = 0;
+        PerfCollectorDX12 performance_collector;
+        DescriptorHeapAllocator::Range descriptors;
+    };
+
+    auto& descriptor_heap_allocator = get_descriptor_heap_allocator();
+    close_execute_reset_wait(d3d12_device, command_queue, command_allocator, command_list);
+
+    std::vector<QueueContext> contexts(nodes.size());
+    descriptor_heap_allocator.bind(command_list);
+    for (std::size_t i = 0; i < nodes.size(); i++)
+    {
+        auto& ctx = contexts[i];
+        D3D12_COMMAND_QUEUE_DESC queue_desc{};
+        queue_desc.Type = D3D12_COMMAND_LIST_TYPE_COMPUTE;
+        throw_if_failed(d3d12_device->CreateCommandQueue(&queue_desc, IID_PPV_ARGS(ctx.queue.ReleaseAndGetAddressOf())), "create compute queue");
+        throw_if_failed(d3d12_device->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_COMPUTE, IID_PPV_ARGS(ctx.allocator.ReleaseAndGetAddressOf())), "create compute allocator");
+        throw_if_failed(d3d12_device->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_COMPUTE, ctx.allocator.Get(), nullptr, IID_PPV_ARGS(ctx.list.ReleaseAndGetAddressOf())), "create compute command list");
+        throw_if_failed(ctx.list->Close(), "compute cmd list close");
+        throw_if_failed(d3d12_device->CreateFence(0, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(ctx.fence.ReleaseAndGetAddressOf())), "create fence");
+        ctx.performance_collector = initialize_d3d12_performance_collector(d3d12_device, iterations);
+
+        ctx.descriptors = descriptor_heap_allocator.allocate(nodes[i]->get_total_descriptor_count());
+        nodes[i]->initialize(command_list, ctx.descriptors.get_cpu_handle(), ctx.descriptors.get_gpu_handle());
+    }
+    close_execute_reset_wait(d3d12_device, command_queue, command_allocator, command_list);
+
+    // returns host wall time of running first queues_count queues concurrently
+    const auto fence_event = ::CreateEvent(nullptr, false, false, nullptr);
+    auto run_concurrently = [&](std::size_t queues_count)
+    {
+        for (std::size_t i = 0; i < queues_count; i++)
+        {
+            auto& ctx = contexts[i];
+            throw_if_failed(ctx.allocator->Reset(), "compute allocator reset");
+            throw_if_failed(ctx.list->Reset(ctx.allocator.Get(), nullptr), "compute cmd list reset");
+            descriptor_heap_allocator.bind(ctx.list.Get());
+            ctx.performance_collector.timestamp_index = 0;
+            for (std::uint32_t it = 0; it < iterations; it++)
+            {
+                ctx.performance_collector.add_timestamp(ctx.list.Get());
+                nodes[i]->execute(ctx.list.Get());
+                ctx.performance_collector.add_timestamp(ctx.list.Get());
+            }
+            ctx.list->ResolveQueryData(ctx.performance_collector.timestamp_query_heap.Get(), D3D12_QUERY_TYPE_TIMESTAMP, 0,
+                ctx.performance_collector.timestamp_index, ctx.performance_collector.timestamp_readback_buffer.Get(), 0);
+            throw_if_failed(ctx.list->Close(), "compute cmd list close");
+        }
+
+        const auto start = std::chrono::steady_clock::now();
+        for (std::size_t i = 0; i < queues_count; i++)
+        {
+            auto& ctx = contexts[i];
+            ID3D12CommandList* command_lists[] = { ctx.list.Get() };
+            ctx.queue->ExecuteCommandLists(1, command_lists);
+            throw_if_failed(ctx.queue->Signal(ctx.fence.Get(), ++ctx.fence_value), "compute queue signal");
+        }
+        for (std::size_t i = 0; i < queues_count; i++)
+        {
+            auto& ctx = contexts[i];
+            if (ctx.fence->GetCompletedValue() < ctx.fence_value)
+            {
+                throw_if_failed(ctx.fence->SetEventOnCompletion(ctx.fence_value, fence_event), "set event on completion");
+                ::WaitForSingleObjectEx(fence_event, INFINITE, FALSE);
+            }
+        }
+        return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+    };
+
+    const auto single_queue_time = run_concurrently(1);
+    const auto all_queues_time = run_concurrently(contexts.size());
+    ::CloseHandle(fence_event);
+
+    for (std::size_t i = 0; i < contexts.size(); i++)
+    {
+        auto& ctx = contexts[i];
+        std::uint64_t timestamp_frequency = 0;
+        ctx.queue->GetTimestampFrequency(&timestamp_frequency);
+        const auto timestamps = get_timestamps_timings_from_ptr<std::chrono::microseconds>(timestamp_frequency,
+            ctx.performance_collector.timestamp_readback, ctx.performance_collector.timestamp_index);
+        std::vector<std::chrono::microseconds> timings(timestamps.size() / 2);
+        for (std::size_t t = 0; t < timings.size(); t++)
+        {
+            timings[t] = timestamps[t * 2 + 1] - timestamps[t * 2];
+        }
+        std::cout << std::format("Queue {} latency:\n", i);
+        print_performance_stats(timings);
+    }
+
+    const auto dispatches_count = static_cast<std::uint64_t>(iterations) * contexts.size();
+    const auto single_queue_throughput = static_cast<double>(iterations) / single_queue_time.count();
+    const auto all_queues_throughput = static_cast<double>(dispatches_count) / all_queues_time.count();
+    std::cout << std::format("Single queue: {} dispatches in {} us, {:.2f} dispatches/ms\n", iterations, single_queue_time.count(), 1000.0 * single_queue_throughput);
+    std::cout << std::format("{} queues: {} dispatches in {} us, {:.2f} dispatches/ms, scaling: {:.2f}x\n",
+        contexts.size(), dispatches_count, all_queues_time.count(), 1000.0 * all_queues_throughput, all_queues_throughput / single_queue_throughput);
+
+    const auto cost = nodes.front()->get_layer_cost();
+    if (cost.flops > 0 || cost.bytes > 0)
+    {
+        std::cout << std::format("Aggregate: {:.2f} GFLOPS, {:.2f} GB/s\n",
+            to_giga_per_second(cost.flops * dispatches_count, all_queues_time), to_giga_per_second(cost.bytes * dispatches_count, all_queues_time));
+    }
+
+    if (validate)
+    {
+        // all the instances run the same code on the same data, checking one of them is enough
+        const auto conformance_result = nodes.front()->validate_conformance(command_queue, command_allocator, command_list);
+        std::cout << std::format("Conformance {}. Tested values (tensor out elements count): {} \n", conformance_result.passed, conformance_result.tested_samples_count);
+        std::cout << std::format("Biggest difference in the output tensor: {}. It is in the epsilion range: {}. \n", conformance_result.biggest_difference, conformance_result.epsilon);
+    }
+}
+
 struct CliOptions
 {
     NodeType node_type = NodeType::eCount;
     std::uint32_t dispatch_iterations = 1;
     bool no_conformance_check = false;
+    bool async_reference = false;
+    std::uint32_t queues_count = 1;
     bool print_opts = false;
+    std::uint32_t staging_ring_mb = 64;
+    std::uint32_t heap_mb = 256;
+    std::uint32_t descriptor_heap_size = 64 * 1024;
+    bool no_placed_resources = false;
+    bool memory_stats = false;
+
+    // roofline report
+    bool roofline = false;
+    bool roofline_compute_peak = false;
+    std::optional<double> peak_gflops = std::nullopt;
+
+    // file with pipeline description, every line has options of single stage
+    std::string pipeline_desc_path = "";
 
     // generic type of layers params
     GemmBaseDispatcher::create_params_t gemm_opts{};
@@ -71,25 +289,16 @@ struct CliOptions
     GemmCmDispatcher::cm_params_t gemm_cm_params{};
     
     gpu_op::MemoryBandwidthDispatcher::create_params_t memory_bw_params{};
+    cpu_op::HostBandwidthBenchmark::create_params_t host_bw_params{};
 };
 
-int main()
+inline void add_layers_cli_options(CLI::App& app, CliOptions& opts)
 {
-    libdml::DeviceInfo device_info{};
-    device_info.platform = libdml::HwPlatform::eDG2;
-    device_info.eu_count = 512;
-
-    libdml::ConvolutionDescriptor conv_desc{};
-    const auto convs_impls = libdml::get_convolution_implementation_list(device_info, conv_desc);
-
-    constexpr const std::uint32_t MAX_ITERATIONS = 10'000;
-
-    CliOptions opts;
-    CLI::App dml_runner_app{ "App to microbenchmark and developer dml kernels.", "DirectML runner." };
-    dml_runner_app.add_option("--type", opts.node_type, "Name of the type of layer to run.")
-        ->required()->check(CLI::IsMember({ NodeType::eConvDml, NodeType::eConvCm, NodeType::eGemmDml, NodeType::eGemmCm, NodeType::eSoftmaxDml, NodeType::eSoftmaxCm, NodeType::eMvnDml, NodeType::eMvnCm, NodeType::eMemoryBandwidth }))->
+    app.add_option("--type", opts.node_type, "Name of the type of layer to run.")
+        ->check(CLI::IsMember({ NodeType::eConvDml, NodeType::eConvTransposedDml, NodeType::eConvCm, NodeType::eGemmDml, NodeType::eGemmCm, NodeType::eSoftmaxDml, NodeType::eSoftmaxCm, NodeType::eMvnDml, NodeType::eMvnCm, NodeType::eMemoryBandwidth, NodeType::eHostBandwidth }))->
         transform(CLI::Transformer(std::map<std::string, NodeType>{
             { "conv_dml", NodeType::eConvDml },
+            { "conv_transposed_dml", NodeType::eConvTransposedDml },
             { "conv_cm", NodeType::eConvCm },
             { "gemm_dml", NodeType::eGemmDml },
             { "gemm_cm", NodeType::eGemmCm },
@@ -98,32 +307,207 @@ int main()
             { "mvn_dml", NodeType::eMvnDml },
             { "mvn_cm", NodeType::eMvnCm },
             { "mem_bw", NodeType::eMemoryBandwidth },
+            { "host_bw", NodeType::eHostBandwidth },
     }, CLI::ignore_case, CLI::ignore_underscore));
-    dml_runner_app.add_option("--iters", opts.dispatch_iterations, "How many iterations to run.")->check(CLI::Range(1u, MAX_ITERATIONS));
-    dml_runner_app.add_flag("--no_conform", opts.no_conformance_check);
-    dml_runner_app.add_flag("--print_opts", opts.print_opts);
 
     // generic type of layers options
-    auto gemm_option_groups = dml_runner_app.add_subcommand("gemm_opts", "Options for genn layer.");
+    auto gemm_option_groups = app.add_subcommand("gemm_opts", "Options for genn layer.");
     GemmBaseDispatcher::create_params_t::add_cli_options(gemm_option_groups, opts.gemm_opts);
-    auto conv_option_groups = dml_runner_app.add_subcommand("conv_opts", "Options for convolution layer.");
+    auto conv_option_groups = app.add_subcommand("conv_opts", "Options for convolution layer.");
     ConvolutionBaseDispatcher::create_params_t::add_cli_options(conv_option_groups, opts.conv_opts);
-    auto softmax_option_groups = dml_runner_app.add_subcommand("softmax_opts", "Options for softmax layer.");
+    auto softmax_option_groups = app.add_subcommand("softmax_opts", "Options for softmax layer.");
     SoftmaxBaseDispatcher::create_params_t::add_cli_options(softmax_option_groups, opts.softmax_opts);
-    auto mvn_option_groups = dml_runner_app.add_subcommand("mvn_opts", "Options for mvn layer.");
+    auto mvn_option_groups = app.add_subcommand("mvn_opts", "Options for mvn layer.");
     MvnBaseDispatcher::create_params_t::add_cli_options(mvn_option_groups, opts.mvn_opts);
 
     // specific for implementation
-    auto conv_cm_option_groups = dml_runner_app.add_subcommand("conv_cm_opts", "Options for convolution layer with CM implementation.");
+    auto conv_cm_option_groups = app.add_subcommand("conv_cm_opts", "Options for convolution layer with CM implementation.");
     ConvolutionCmDispatcher::conv_cm_params_t::add_cli_options(conv_cm_option_groups, opts.conv_cm_params);
-    auto mvn_cm_option_groups = dml_runner_app.add_subcommand("mvn_cm_opts", "Options for mvn layer with CM implementation.");
+    auto mvn_cm_option_groups = app.add_subcommand("mvn_cm_opts", "Options for mvn layer with CM implementation.");
     MvnCmDispatcher::mvn_cm_params_t::add_cli_options(mvn_cm_option_groups, opts.mvn_cm_params);
-    auto softmax_cm_option_groups = dml_runner_app.add_subcommand("softmax_cm_opts", "Options for softmax layer with CM implementation.");
+    auto softmax_cm_option_groups = app.add_subcommand("softmax_cm_opts", "Options for softmax layer with CM implementation.");
     SoftmaxCmDispatcher::softmax_cm_params_t::add_cli_options(softmax_cm_option_groups, opts.softmax_cm_params);
-    auto gemm_cm_option_groups = dml_runner_app.add_subcommand("gemm_cm_opts", "Options for gemm layer with CM implementation.");
+    auto gemm_cm_option_groups = app.add_subcommand("gemm_cm_opts", "Options for gemm layer with CM implementation.");
     GemmCmDispatcher::cm_params_t::add_cli_options(gemm_cm_option_groups, opts.gemm_cm_params);
-    auto mem_bw_option_group = dml_runner_app.add_subcommand("mem_bw_opts", "Options for memory banddiwth measurments");
-    gpu_op::MemoryBandwidthDispatcher::MemoryBandwidthDispatcher::create_params_t::add_cli_options(mem_bw_option_group, opts.memory_bw_params);
+    auto mem_bw_option_groups = app.add_subcommand("mem_bw_opts", "Options for memory banddiwth measurments");
+    gpu_op::MemoryBandwidthDispatcher::MemoryBandwidthDispatcher::create_params_t::add_cli_options(mem_bw_option_groups, opts.memory_bw_params);
+    auto host_bw_option_groups = app.add_subcommand("host_bw_opts", "Options for host memory bandwidth measurments");
+    cpu_op::HostBandwidthBenchmark::create_params_t::add_cli_options(host_bw_option_groups, opts.host_bw_params);
+}
+
+inline bool check_layers_cli_options(CLI::App& app, const CliOptions& opts)
+{
+    if (opts.node_type == NodeType::eCount)
+    {
+        std::cout << "Layer type not set.\n";
+        return false;
+    }
+    if ((opts.node_type == NodeType::eConvCm || opts.node_type == NodeType::eConvDml || opts.node_type == NodeType::eConvTransposedDml)
+        && !app.get_subcommand("conv_opts")->parsed())
+    {
+        std::cout << "Convoltion options not set.\n";
+        return false;
+    }
+    if ((opts.node_type == NodeType::eGemmDml || opts.node_type == NodeType::eGemmCm) && !app.get_subcommand("gemm_opts")->parsed())
+    {
+        std::cout << "Gemm options not set.\n";
+        return false;
+    }
+    if ((opts.node_type == NodeType::eSoftmaxDml || opts.node_type == NodeType::eSoftmaxCm) && !app.get_subcommand("softmax_opts")->parsed())
+    {
+        std::cout << "Softmax options not set.\n";
+        return false;
+    }
+    return true;
+}
+
+inline std::unique_ptr<NodeDispatcher> create_node(CliOptions& opts, ID3D12Device* d3d12_device, IDMLDevice* dml_device,
+    IDMLCommandRecorder* dml_command_recorder, IntelExtension& intel_extension, ID3D12GraphicsCommandList* command_list)
+{
+    std::unique_ptr<NodeDispatcher> node;
+    if (opts.node_type == NodeType::eGemmDml)
+    {
+        node = std::make_unique<GemmDmlDispatcher>(std::move(opts.gemm_opts), 
+            d3d12_device, dml_device, dml_command_recorder, command_list);
+    }
+    else if (opts.node_type == NodeType::eGemmCm)
+    {
+        node = std::make_unique<GemmCmDispatcher>(std::move(opts.gemm_opts), std::move(opts.gemm_cm_params),
+            intel_extension, d3d12_device, dml_device, dml_command_recorder, command_list);
+    }
+    else if (opts.node_type == NodeType::eConvDml)
+    {
+        node = std::make_unique<ConvolutionDirectMLDispatcher>(std::move(opts.conv_opts),
+            d3d12_device, dml_device, dml_command_recorder, command_list);
+    }
+    else if (opts.node_type == NodeType::eConvTransposedDml)
+    {
+        // same options as forward convolution, filter and output shapes follow transposed convolution
+        opts.conv_opts.transposed = true;
+        node = std::make_unique<ConvolutionDirectMLDispatcher>(std::move(opts.conv_opts),
+            d3d12_device, dml_device, dml_command_recorder, command_list);
+    }
+    else if (opts.node_type == NodeType::eConvCm)
+    {
+        node = std::make_unique<ConvolutionCmDispatcher>(std::move(opts.conv_opts), std::move(opts.conv_cm_params),
+            intel_extension, d3d12_device, command_list);
+    }
+    else if (opts.node_type == NodeType::eSoftmaxDml)
+    {
+        node = std::make_unique<SoftmaxDmlDispatcher>(std::move(opts.softmax_opts),
+            d3d12_device, dml_device, dml_command_recorder, command_list);
+    }
+    else if (opts.node_type == NodeType::eSoftmaxCm)
+    {
+        node = std::make_unique<SoftmaxCmDispatcher>(std::move(opts.softmax_opts), std::move(opts.softmax_cm_params),
+            intel_extension, d3d12_device, dml_device, dml_command_recorder, command_list);
+    }
+    else if (opts.node_type == NodeType::eMvnDml)
+    {
+        node = std::make_unique<MvnDmlDispatcher>(std::move(opts.mvn_opts),
+            d3d12_device, dml_device, dml_command_recorder, command_list);
+    }
+    else if (opts.node_type == NodeType::eMvnCm)
+    {
+        node = std::make_unique<MvnCmDispatcher>(std::move(opts.mvn_opts), std::move(opts.mvn_cm_params),
+            intel_extension, d3d12_device, dml_device, dml_command_recorder, command_list);
+    }
+    else if (opts.node_type == NodeType::eMemoryBandwidth)
+    {
+        node = std::make_unique<gpu_op::MemoryBandwidthDispatcher>(std::move(opts.memory_bw_params), d3d12_device, command_list, intel_extension);
+    }
+    else
+    {
+        throw std::runtime_error("Unknown node type, node can't be created.");
+    }
+    return node;
+}
+
+/*
+*   Reads pipeline description file. Every not empty line (lines starting with # are comments) describes single stage
+*   with the same options as single layer run, ex.:
+*       --type gemm_dml --name qk gemm_opts --gemm_type qk_q_kv ...
+*       --type softmax_dml --name softmax softmax_opts ...
+*       --type gemm_dml --name sv --input 1=0:in1 gemm_opts --gemm_type sv_s_kv ...
+*   By default input 0 of the stage is output of the previous stage, other links are set with --input.
+*/
+inline std::vector<Pipeline::Stage> create_pipeline_stages(const std::string& path, ID3D12Device* d3d12_device, IDMLDevice* dml_device,
+    IDMLCommandRecorder* dml_command_recorder, IntelExtension& intel_extension, ID3D12GraphicsCommandList* command_list)
+{
+    std::ifstream file(path);
+    if (!file.is_open())
+    {
+        throw std::runtime_error(std::format("Pipeline description file cant be opened: {}.", path));
+    }
+
+    std::vector<Pipeline::Stage> ret;
+    std::string line;
+    while (std::getline(file, line))
+    {
+        if (line.empty() || line.starts_with("#"))
+        {
+            continue;
+        }
+
+        CliOptions stage_opts{};
+        std::vector<std::string> stage_inputs;
+        Pipeline::Stage stage{};
+        stage.name = std::format("stage_{}", ret.size());
+
+        CLI::App stage_app{ "Pipeline stage." };
+        add_layers_cli_options(stage_app, stage_opts);
+        stage_app.add_option("--name", stage.name, "Name of the stage used in the report.");
+        stage_app.add_option("--input", stage_inputs, "Input link: <input_idx>=<stage>:out or <input_idx>=<stage>:in<idx>.");
+        stage_app.parse(line, false);
+        if (!check_layers_cli_options(stage_app, stage_opts))
+        {
+            throw std::runtime_error(std::format("Wrong options of pipeline stage {}.", ret.size()));
+        }
+
+        // host_bw runs without GPU node (see main), so it can't be a part of the pipeline
+        if (stage_opts.node_type == NodeType::eHostBandwidth)
+        {
+            throw std::runtime_error(std::format("Pipeline stage {} has type host_bw, which is not supported in pipeline.", stage.name));
+        }
+
+        for (const auto& input : stage_inputs)
+        {
+            stage.links.push_back(parse_pipeline_input_link(input));
+        }
+        stage.node = create_node(stage_opts, d3d12_device, dml_device, dml_command_recorder, intel_extension, command_list);
+        ret.push_back(std::move(stage));
+    }
+    return ret;
+}
+
+int main()
+{
+    libdml::DeviceInfo device_info{};
+    device_info.platform = libdml::HwPlatform::eDG2;
+    device_info.eu_count = 512;
+
+    libdml::ConvolutionDescriptor conv_desc{};
+    const auto& convs_impls = libdml::get_convolution_implementation_list(device_info, conv_desc);
+
+    constexpr const std::uint32_t MAX_ITERATIONS = 10'000;
+
+    CliOptions opts;
+    CLI::App dml_runner_app{ "App to microbenchmark and developer dml kernels.", "DirectML runner." };
+    add_layers_cli_options(dml_runner_app, opts);
+    dml_runner_app.add_option("--pipeline", opts.pipeline_desc_path, "Path to pipeline description file (one stage options per line). Replaces --type.")->check(CLI::ExistingFile)->excludes("--type");
+    dml_runner_app.add_option("--iters", opts.dispatch_iterations, "How many iterations to run.")->check(CLI::Range(1u, MAX_ITERATIONS));
+    dml_runner_app.add_option("--queues", opts.queues_count, "Run instance of the layer on each of the compute queues concurrently and report aggregate throughput.")->check(CLI::Range(1u, 64u))->excludes("--pipeline");
+    dml_runner_app.add_flag("--no_conform", opts.no_conformance_check);
+    dml_runner_app.add_flag("--async_reference", opts.async_reference, "Calculate reference on worker thread, while layer is timed. Only convolution (and pipelines starting with it) supports it, its reference is then calculated on the host. Other node types are calculated after timing.")->excludes("--no_conform");
+    dml_runner_app.add_flag("--print_opts", opts.print_opts);
+    dml_runner_app.add_option("--staging_ring_mb", opts.staging_ring_mb, "Size of the upload ring shared by all layers (bigger inputs are uploaded in chunks).")->check(CLI::Range(1u, 4096u));
+    dml_runner_app.add_option("--heap_mb", opts.heap_mb, "Size of the heaps device buffers are placed in (bigger buffers get dedicated heap).")->check(CLI::Range(1u, 16384u));
+    dml_runner_app.add_option("--descriptor_heap_size", opts.descriptor_heap_size, "Descriptors count of the heap shared by all layers and references.")->check(CLI::Range(1u, 1'000'000u));
+    dml_runner_app.add_flag("--no_placed_resources", opts.no_placed_resources, "Create commited resource per buffer, without heaps and aliasing.")->excludes("--heap_mb");
+    dml_runner_app.add_flag("--memory_stats", opts.memory_stats, "Print sum of buffers sizes vs memory reserved in heaps.")->excludes("--no_placed_resources");
+    dml_runner_app.add_flag("--roofline", opts.roofline, "Measure peak memory bandwidth and report layer performance against the roofline.");
+    dml_runner_app.add_flag("--roofline_compute_peak", opts.roofline_compute_peak, "Run compute peak microkernel to find the compute roof.")->needs("--roofline");
+    dml_runner_app.add_option("--peak_gflops", opts.peak_gflops, "Use given compute peak (GFLOPS) instead of measuring it.")->needs("--roofline")->excludes("--roofline_compute_peak");
 
     try {
         dml_runner_app.parse();
@@ -138,22 +522,26 @@ int main()
         std::cout << std::format("Running app with config:\n {}", dumped_config);
     }
 
-    assert(opts.node_type != NodeType::eCount);
-    if ((opts.node_type == NodeType::eConvCm || opts.node_type == NodeType::eConvDml)
-        && !conv_option_groups->parsed())
+    const bool run_pipeline = !opts.pipeline_desc_path.empty();
+    if (!run_pipeline && !check_layers_cli_options(dml_runner_app, opts))
     {
-        std::cout << "Convoltion options not set.\n";
-        return -1;
-    }
-    if ((opts.node_type == NodeType::eGemmDml || opts.node_type == NodeType::eGemmCm) && !gemm_option_groups->parsed())
-    {
-        std::cout << "Gemm options not set.\n";
         return -1;
     }
-    if ((opts.node_type == NodeType::eSoftmaxDml || opts.node_type == NodeType::eSoftmaxCm) && !softmax_option_groups->parsed())
+
+    if (opts.node_type == NodeType::eHostBandwidth)
     {
-        std::cout << "Softmax options not set.\n";
-        return -1;
+        // host only, no need for the device
+        try
+        {
+            cpu_op::HostBandwidthBenchmark host_bw(std::move(opts.host_bw_params));
+            host_bw.run();
+        }
+        catch (std::exception e)
+        {
+            std::cerr << std::format("Exception caught: {} \n", e.what());
+            return -1;
+        }
+        return 0;
     }
 
     try
@@ -164,6 +552,14 @@ int main()
         ComPtr<ID3D12GraphicsCommandList> command_list;
         initalize_d3d12(d3d12_device, command_queue, command_allocator, command_list);
         auto dml_device = create_dml_device(d3d12_device.Get());
+        StagingRingScope staging_ring_scope(d3d12_device.Get(), command_queue.Get(), static_cast<std::size_t>(opts.staging_ring_mb) * 1024 * 1024);
+        // declared before any node, so the heaps outlive all placed buffers
+        std::optional<ResourceAllocatorScope> resource_allocator_scope;
+        if (!opts.no_placed_resources)
+        {
+            resource_allocator_scope.emplace(d3d12_device.Get(), command_queue.Get(), static_cast<std::uint64_t>(opts.heap_mb) * 1024 * 1024);
+        }
+        DescriptorHeapAllocatorScope descriptor_heap_allocator_scope(d3d12_device.Get(), opts.descriptor_heap_size);
         assert(opts.dispatch_iterations < MAX_ITERATIONS);
         auto performance_collector = initialize_d3d12_performance_collector(d3d12_device.Get(), MAX_ITERATIONS);
 
@@ -172,77 +568,123 @@ int main()
         ComPtr<IDMLCommandRecorder> dml_command_recorder;
         throw_if_failed(dml_device->CreateCommandRecorder(IID_PPV_ARGS(dml_command_recorder.ReleaseAndGetAddressOf())), "create dml command recorder");
 
-        std::unique_ptr<NodeDispatcher> node;
-        if (opts.node_type == NodeType::eGemmDml)
-        {
-            node = std::make_unique<GemmDmlDispatcher>(std::move(opts.gemm_opts), 
-                d3d12_device.Get(), dml_device.Get(), dml_command_recorder.Get(), command_list.Get());
-        }
-        else if (opts.node_type == NodeType::eGemmCm)
-        {
-            node = std::make_unique<GemmCmDispatcher>(std::move(opts.gemm_opts), std::move(opts.gemm_cm_params),
-                intel_extension_d3d12, d3d12_device.Get(), dml_device.Get(), dml_command_recorder.Get(), command_list.Get());
-        }
-        else if (opts.node_type == NodeType::eConvDml)
-        {
-            node = std::make_unique<ConvolutionDirectMLDispatcher>(std::move(opts.conv_opts),
-                d3d12_device.Get(), dml_device.Get(), dml_command_recorder.Get(), command_list.Get());
-        }
-        else if (opts.node_type == NodeType::eConvCm)
-        {
-            node = std::make_unique<ConvolutionCmDispatcher>(std::move(opts.conv_opts), std::move(opts.conv_cm_params),
-                intel_extension_d3d12, d3d12_device.Get(), command_list.Get());
-        }
-        else if (opts.node_type == NodeType::eSoftmaxDml)
-        {
-            node = std::make_unique<SoftmaxDmlDispatcher>(std::move(opts.softmax_opts),
-                d3d12_device.Get(), dml_device.Get(), dml_command_recorder.Get(), command_list.Get());
-        }
-        else if (opts.node_type == NodeType::eSoftmaxCm)
+        // peaks are measured once, before the layer
+        constexpr const std::uint32_t peak_iterations = 100;
+        RooflinePeaks roofline_peaks{};
+        if (opts.roofline)
         {
-            node = std::make_unique<SoftmaxCmDispatcher>(std::move(opts.softmax_opts), std::move(opts.softmax_cm_params),
-                intel_extension_d3d12, d3d12_device.Get(), dml_device.Get(), dml_command_recorder.Get(), command_list.Get());
+            auto mem_bw_params = opts.memory_bw_params;
+            if (!dml_runner_app.get_subcommand("mem_bw_opts")->parsed())
+            {
+                // big enough to not fit into the caches
+                mem_bw_params.dt = DataType::eFp16;
+                mem_bw_params.shape = TensorShape(1, 1, 1, 64 * 1024 * 1024);
+                mem_bw_params.items_per_hw = 128;
+                mem_bw_params.lws_x = 16;
+                mem_bw_params.dump_asm = false;
+                mem_bw_params.large_grf = false;
+                mem_bw_params.print_reg_usage = false;
+            }
+            gpu_op::MemoryBandwidthDispatcher mem_bw_node(std::move(mem_bw_params), d3d12_device.Get(), command_list.Get(), intel_extension_d3d12);
+            const auto mem_bw_time = measure_best_time(mem_bw_node, peak_iterations, d3d12_device.Get(), command_queue.Get(), command_allocator.Get(), command_list.Get(), performance_collector);
+            roofline_peaks.bandwidth_gbps = to_giga_per_second(mem_bw_node.get_layer_cost().bytes, mem_bw_time);
+
+            // compute peak is measured after the node is created, it has to match data type of the layer math
+            roofline_peaks.gflops = opts.peak_gflops;
         }
-        else if (opts.node_type == NodeType::eMvnDml)
+
+        if (!run_pipeline && opts.node_type == NodeType::eMemoryBandwidth && opts.memory_bw_params.is_sweep())
         {
-            node = std::make_unique<MvnDmlDispatcher>(std::move(opts.mvn_opts),
-                d3d12_device.Get(), dml_device.Get(), dml_command_recorder.Get(), command_list.Get());
+            run_memory_bandwidth_sweep(opts.memory_bw_params, opts.dispatch_iterations, d3d12_device.Get(), command_queue.Get(), command_allocator.Get(), command_list.Get(),
+                intel_extension_d3d12, performance_collector);
+            if (opts.memory_stats)
+            {
+                print_memory_stats(get_resource_allocator()->get_stats());
+            }
+            return 0;
         }
-        else if (opts.node_type == NodeType::eMvnCm)
+
+        if (opts.queues_count > 1)
         {
-            node = std::make_unique<MvnCmDispatcher>(std::move(opts.mvn_opts), std::move(opts.mvn_cm_params),
-                intel_extension_d3d12, d3d12_device.Get(), dml_device.Get(), dml_command_recorder.Get(), command_list.Get());
+            // instances run concurrently, so they can't share aliased temporaries
+            if (auto* allocator = get_resource_allocator())
+            {
+                allocator->set_transient_aliasing(false);
+            }
+            std::vector<std::unique_ptr<NodeDispatcher>> nodes;
+            for (std::uint32_t i = 0; i < opts.queues_count; i++)
+            {
+                // node creation consumes the params
+                auto instance_opts = opts;
+                nodes.push_back(create_node(instance_opts, d3d12_device.Get(), dml_device.Get(), dml_command_recorder.Get(), intel_extension_d3d12, command_list.Get()));
+            }
+            run_multi_queue_throughput(nodes, opts.dispatch_iterations, !opts.no_conformance_check, d3d12_device.Get(), command_queue.Get(), command_allocator.Get(), command_list.Get());
+            return 0;
         }
-        else if (opts.node_type == NodeType::eMemoryBandwidth)
+
+        std::unique_ptr<NodeDispatcher> node;
+        Pipeline* pipeline = nullptr;
+        if (run_pipeline)
         {
-            node = std::make_unique<gpu_op::MemoryBandwidthDispatcher>(std::move(opts.memory_bw_params), d3d12_device.Get(), command_list.Get(), intel_extension_d3d12);
+            auto stages = create_pipeline_stages(opts.pipeline_desc_path, d3d12_device.Get(), dml_device.Get(), dml_command_recorder.Get(), intel_extension_d3d12, command_list.Get());
+            // stages inputs are replaced by the pipeline, so upload commands have to be finished before
+            close_execute_reset_wait(d3d12_device.Get(), command_queue.Get(), command_allocator.Get(), command_list.Get());
+            auto pipeline_node = std::make_unique<Pipeline>(std::move(stages), d3d12_device.Get());
+            pipeline = pipeline_node.get();
+            node = std::move(pipeline_node);
         }
         else
         {
-            assert(false && "Unknown node type!");
+            node = create_node(opts, d3d12_device.Get(), dml_device.Get(), dml_command_recorder.Get(), intel_extension_d3d12, command_list.Get());
         }
 
         close_execute_reset_wait(d3d12_device.Get(), command_queue.Get(), command_allocator.Get(), command_list.Get());
+
+        if (opts.roofline && opts.roofline_compute_peak)
+        {
+            // microkernel has only fp32 and fp16 variants, int8 layers are compared with fp16 roof
+            gpu_op::ComputePeakDispatcher::create_params_t compute_peak_params{};
+            compute_peak_params.dt = node->get_compute_data_type() == DataType::eFp32 ? DataType::eFp32 : DataType::eFp16;
+            gpu_op::ComputePeakDispatcher compute_peak_node(std::move(compute_peak_params), d3d12_device.Get(), intel_extension_d3d12);
+            const auto compute_peak_time = measure_best_time(compute_peak_node, peak_iterations, d3d12_device.Get(), command_queue.Get(), command_allocator.Get(), command_list.Get(), performance_collector);
+            roofline_peaks.gflops = to_giga_per_second(compute_peak_node.get_layer_cost().flops, compute_peak_time);
+        }
         const auto descriptors_count = node->get_total_descriptor_count();
         
         // bind descriptor heap
-        auto descriptor_heap = create_descriptor_heap(d3d12_device.Get(), descriptors_count);
-        ID3D12DescriptorHeap* d3d12_descriptor_heaps[] = { descriptor_heap.Get() };
-        command_list->SetDescriptorHeaps(1, d3d12_descriptor_heaps);
+        auto& descriptor_heap_allocator = get_descriptor_heap_allocator();
+        const auto descriptors = descriptor_heap_allocator.allocate(descriptors_count);
+        descriptor_heap_allocator.bind(command_list.Get());
 
 
         // initalize
-        node->initialize(command_list.Get(), descriptor_heap->GetCPUDescriptorHandleForHeapStart(), descriptor_heap->GetGPUDescriptorHandleForHeapStart());
+        node->initialize(command_list.Get(), descriptors.get_cpu_handle(), descriptors.get_gpu_handle());
         close_execute_reset_wait(d3d12_device.Get(), command_queue.Get(), command_allocator.Get(), command_list.Get());
 
+        // host inputs are final here, reference is calculated while GPU is busy with the timed iterations
+        if (opts.async_reference && !node->start_reference_async())
+        {
+            std::cout << "Layer does not support async reference, it will be calculated after timing." << std::endl;
+        }
+
         // 
         // Bind and execute the operator on the GPU.
         // 
         // 
-        command_list->SetDescriptorHeaps(1, d3d12_descriptor_heaps);
+        descriptor_heap_allocator.bind(command_list.Get());
+
+        if (pipeline && opts.dispatch_iterations * (pipeline->get_stages_count() + 1) > 2 * MAX_ITERATIONS)
+        {
+            throw std::runtime_error("Too many iterations for the pipeline, not enough space for timestamps.");
+        }
 
         for (std::uint32_t i = 0; i < opts.dispatch_iterations; ++i)
         {
+            if (pipeline)
+            {
+                pipeline->execute_profiled(command_list.Get(), &performance_collector);
+                continue;
+            }
             performance_collector.add_timestamp(command_list.Get());
             node->execute(command_list.Get());
             performance_collector.add_timestamp(command_list.Get());
@@ -266,31 +708,46 @@ int main()
             std::cout << std::format("Biggest difference in the output tensor: {}. It is in the epsilion range: {}. \n", conformance_result.biggest_difference, conformance_result.epsilon);
         }
 
-        // Copy the timing data back
-        command_list->ResolveQueryData(
-            performance_collector.timestamp_query_heap.Get(),
-            D3D12_QUERY_TYPE_TIMESTAMP,
-            0,
-            performance_collector.timestamp_index,
-            performance_collector.timestamp_readback_buffer.Get(),
-            0);
-        close_execute_reset_wait(d3d12_device.Get(), command_queue.Get(), command_allocator.Get(), command_list.Get());
+        std::vector<std::chrono::microseconds> timings;
+        if (pipeline)
+        {
+            const auto stages_count = pipeline->get_stages_count();
+            const auto timestamps = resolve_timestamps(d3d12_device.Get(), command_queue.Get(), command_allocator.Get(), command_list.Get(), performance_collector);
 
-        uint64_t timestamp_frequency = 0;
-        command_queue->GetTimestampFrequency(&timestamp_frequency);
+            // every iteration: start timestamp + timestamp after each stage
+            std::vector<std::vector<std::chrono::microseconds>> stages_timings(stages_count);
+            for (std::uint32_t i = 0; i < opts.dispatch_iterations; i++)
+            {
+                const auto* iter_timestamps = &timestamps[i * (stages_count + 1)];
+                for (std::uint32_t s = 0; s < stages_count; s++)
+                {
+                    stages_timings[s].push_back(iter_timestamps[s + 1] - iter_timestamps[s]);
+                }
+                timings.push_back(iter_timestamps[stages_count] - iter_timestamps[0]);
+            }
 
-        const auto timestamps_timings = get_timestamps_timings_from_ptr<std::chrono::microseconds>(timestamp_frequency, performance_collector.timestamp_readback, performance_collector.timestamp_index);
-        performance_collector.timestamp_index = 0;
+            for (std::uint32_t s = 0; s < stages_count; s++)
+            {
+                std::cout << std::format("Stage {} ({}):\n", s, pipeline->get_stage(s).name);
+                print_performance_stats(stages_timings[s]);
+            }
+            std::cout << "Pipeline total:\n";
+        }
+        else
+        {
+            timings = resolve_timings(d3d12_device.Get(), command_queue.Get(), command_allocator.Get(), command_list.Get(), performance_collector);
+        }
+        print_performance_stats(timings);
 
-        std::vector<std::chrono::microseconds> timings(timestamps_timings.size() / 2);
-        for (uint32_t i = 0; i < timings.size(); i++)
+        if (opts.roofline)
         {
-            const auto t0 = timestamps_timings[i * 2];
-            const auto t1 = timestamps_timings[i * 2 + 1];
-            timings[i] = t1 - t0;
+            print_roofline_report(node->get_layer_cost(), *std::min_element(timings.begin(), timings.end()), roofline_peaks);
         }
 
-        print_performance_stats(timings);
+        if (opts.memory_stats)
+        {
+            print_memory_stats(get_resource_allocator()->get_stats());
+        }
     }
     catch (std::exception e)
     {
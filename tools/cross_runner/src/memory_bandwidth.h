@@ -1,6 +1,7 @@
 #pragma once
 #include <vector>
 #include <random>
+#include <algorithm>
 #include "dml_base_node.h"
 
 namespace gpu_op
@@ -9,26 +10,60 @@ namespace gpu_op
 class MemoryBandwidthDispatcher : public NodeDispatcher
 {
 public:
+    // has to match MODE_* defines in the kernel
+    enum class Mode
+    {
+        eCopy = 0,
+        eRead = 1,     // reduce to single dword per thread
+        eWrite = 2,    // fill with constant
+        eStrided = 3,  // gather with stride of threads count
+    };
+
     struct create_params_t
     {
         DataType dt;
         TensorShape shape;
         std::uint32_t items_per_hw = 128;
         std::uint32_t lws_x = 1;
+        Mode mode = Mode::eCopy;
         bool dump_asm;
         bool large_grf;
         bool print_reg_usage;
 
+        // sweeps, shape is the biggest working set when sweeping sizes
+        bool sweep_sizes = false;
+        std::uint32_t sweep_min_bytes = 16 * 1024;
+        std::vector<std::uint32_t> sweep_items_per_hw;
+        std::vector<std::uint32_t> sweep_lws_x;
+
         inline static void add_cli_options(CLI::App* opts, create_params_t& params)
         {
             add_data_type_cli_option(opts, "--data_type", params.dt)->required();
             opts->add_option("--shape", params.shape, "shape: <n,c,h,w>")->required();
             opts->add_option("--items_per_hw", params.items_per_hw)->required();
             opts->add_option("--lws_x", params.lws_x);
+            opts->add_option("--mode", params.mode, "Memory access pattern.")
+                ->check(CLI::IsMember({ Mode::eCopy, Mode::eRead, Mode::eWrite, Mode::eStrided }))->
+                transform(CLI::Transformer(std::map<std::string, Mode>{
+                    { "copy", Mode::eCopy },
+                    { "read", Mode::eRead },
+                    { "write", Mode::eWrite },
+                    { "strided", Mode::eStrided },
+            }, CLI::ignore_case));
 
             opts->add_flag("--dump_asm", params.dump_asm)->default_val(false);
             opts->add_flag("--large_grf", params.large_grf)->default_val(false);
             opts->add_flag("--print_reg_usage", params.print_reg_usage)->default_val(false);
+
+            opts->add_flag("--sweep_sizes", params.sweep_sizes, "Sweep working set from sweep_min_bytes up to shape size (x2 steps) to find caches knees.")->default_val(false);
+            opts->add_option("--sweep_min_bytes", params.sweep_min_bytes);
+            opts->add_option("--sweep_items_per_hw", params.sweep_items_per_hw, "List of items_per_hw to sweep over.")->delimiter(',');
+            opts->add_option("--sweep_lws_x", params.sweep_lws_x, "List of lws_x to sweep over.")->delimiter(',');
+        }
+
+        inline bool is_sweep() const
+        {
+            return sweep_sizes || !sweep_items_per_hw.empty() || !sweep_lws_x.empty();
         }
     };
 public:
@@ -38,6 +73,13 @@ public:
         , intc_ext_(intc_ext)
         , d3d12_device_(d3d12_device)
     {
+        const auto dwords_per_hw = params_.items_per_hw * get_data_type_bytes_width(params_.dt) / sizeof(std::uint32_t);
+        assert(params_.shape.get_elements_count() % (params_.items_per_hw * params_.lws_x) == 0);
+        if (params_.mode == Mode::eStrided && dwords_per_hw % 16 != 0)
+        {
+            throw std::runtime_error("Strided mode requires items_per_hw to be multiple of 16 dwords.");
+        }
+
         // randomize data
         std::mt19937 random_generator(42); // static, create it once!
         std::uniform_real_distribution<float> uniform_distribution(0.0f, 5.0f);
@@ -58,26 +100,14 @@ public:
         const auto tensor_input_bytes_width = input_data_.size();
         const auto tensor_out_bytes_width = tensor_input_bytes_width;
 
-        upload_buffer_ = create_buffer(d3d12_device_, tensor_input_bytes_width,
-            D3D12_HEAP_TYPE_UPLOAD, D3D12_RESOURCE_STATE_GENERIC_READ);
         input_buffer_ = create_buffer(d3d12_device, tensor_input_bytes_width,
             D3D12_HEAP_TYPE_DEFAULT, D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS);
         output_buffer_ = create_buffer(d3d12_device, tensor_out_bytes_width,
             D3D12_HEAP_TYPE_DEFAULT, D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS);
 
 
-        // copy data into buffer
-        std::byte* upload_mapped_ptr = nullptr;
-        upload_buffer_->Map(0, nullptr, reinterpret_cast<void**>(&upload_mapped_ptr));
-        std::size_t memcopy_offset = 0;
-        std::memcpy(upload_mapped_ptr, input_data_.data(), tensor_input_bytes_width);
-        memcopy_offset += tensor_input_bytes_width;
-        // unmap memory
-        upload_buffer_->Unmap(0, nullptr);
-
-        memcopy_offset = 0;
-        cmd_list->CopyBufferRegion(input_buffer_.Get(), 0, upload_buffer_.Get(), 0, tensor_input_bytes_width);
-        memcopy_offset += tensor_input_bytes_width;
+        // copy data into buffer, barrier below is executed after the upload (see close_execute_reset_wait)
+        get_staging_ring().upload(input_buffer_.Get(), 0, input_data_);
 
         std::vector<CD3DX12_RESOURCE_BARRIER> barriers;
         barriers.push_back(CD3DX12_RESOURCE_BARRIER::Transition(input_buffer_.Get(),
@@ -114,7 +144,10 @@ public:
             build_options += pre_jit + name + between_name_and_value + value_str + post_jit;
         };
 
+        add_define("DT", params_.dt == DataType::eFp16 ? "half" : "float");
         add_define("ITEMS_PER_HW", params_.items_per_hw);
+        add_define("MODE", static_cast<std::uint32_t>(params_.mode));
+        add_define("THREADS_COUNT", get_threads_count());
 
         // kernel compilation
         const auto dump_asm_str = params_.dump_asm ? " -mdump_asm" : "";
@@ -183,7 +216,7 @@ public:
             cmd_list->SetComputeRootDescriptorTable(root_index++, gpu_heap_handle);
         }
 
-        const auto gws_x = (params_.shape.n * params_.shape.c * params_.shape.h * params_.shape.w) / params_.items_per_hw;
+        const auto gws_x = get_threads_count();
 
         assert(gws_x % params_.lws_x == 0);
 
@@ -196,43 +229,116 @@ public:
     ConformanceResult validate_conformance(ID3D12CommandQueue* command_queue,
         ID3D12CommandAllocator* command_allocator, ID3D12GraphicsCommandList* command_list) override
     {
-        const auto tensor_out_bytes_width = output_buffer_->GetDesc().Width;
-
-        // readback data and validate
-        auto readback_buffer = create_buffer(d3d12_device_, tensor_out_bytes_width, D3D12_HEAP_TYPE_READBACK, D3D12_RESOURCE_STATE_COPY_DEST);
-        auto readback_output_barrirer = CD3DX12_RESOURCE_BARRIER::Transition(output_buffer_.Get(),
-            D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_COPY_SOURCE);
-        command_list->ResourceBarrier(1, &readback_output_barrirer);
-        command_list->CopyResource(readback_buffer.Get(), output_buffer_.Get());
-        close_execute_reset_wait(d3d12_device_, command_queue, command_allocator, command_list);
-
-        std::vector<std::byte> data_out(tensor_out_bytes_width);
-        std::byte* readback_mapped_ptr = nullptr;
-        readback_buffer->Map(0, nullptr, reinterpret_cast<void**>(&readback_mapped_ptr));
-        std::memcpy(data_out.data(), readback_mapped_ptr, data_out.size());
-        readback_buffer->Unmap(0, nullptr);
-
-        //
-        //  calc reference with dml non-mc mvn
-        //
-        readback_output_barrirer = CD3DX12_RESOURCE_BARRIER::Transition(output_buffer_.Get(),
-            D3D12_RESOURCE_STATE_COPY_SOURCE, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
-        command_list->ResourceBarrier(1, &readback_output_barrirer);
+        const auto reference = get_reference_result(command_queue, command_allocator, command_list);
+        const auto data_out = readback_buffer_data(d3d12_device_, command_queue, command_allocator, command_list, output_buffer_.Get(), reference.size());
 
+        // results are raw bit patterns (sums, thread ids), so compare bit exact
+        const auto* out_typed = reinterpret_cast<const std::uint32_t*>(data_out.data());
+        const auto* ref_typed = reinterpret_cast<const std::uint32_t*>(reference.data());
+        ConformanceResult ret{};
+        for (std::uint32_t i = 0; i < reference.size() / sizeof(std::uint32_t); i++)
+        {
+            if (out_typed[i] != ref_typed[i] && ret.passed)
+            {
+                ret.passed = false;
+                ret.index = i;
+                ret.node_value = static_cast<float>(out_typed[i]);
+                ret.reference_value = static_cast<float>(ref_typed[i]);
+                std::cout << std::format("Mismatch, gpu: {}, cpu: {}, at dword index: {}.\n", out_typed[i], ref_typed[i], i);
+            }
+            ret.tested_samples_count++;
+        }
+        return ret;
+    }
 
-        if (params_.dt == DataType::eFp32)
+    std::vector<std::byte> get_reference_result(ID3D12CommandQueue* command_queue,
+        ID3D12CommandAllocator* command_allocator, ID3D12GraphicsCommandList* command_list) override
+    {
+        const auto threads_count = get_threads_count();
+        const auto dwords_per_hw = static_cast<std::uint32_t>(input_data_.size() / sizeof(std::uint32_t) / threads_count);
+        const auto* input_typed = reinterpret_cast<const std::uint32_t*>(input_data_.data());
+
+        if (params_.mode == Mode::eCopy)
         {
-            return run_conformance_check<float>(data_out, input_data_, 0.0f);
+            return input_data_;
         }
-        else if (params_.dt == DataType::eFp16)
+
+        std::vector<std::byte> ret(params_.mode == Mode::eRead ? threads_count * sizeof(std::uint32_t) : input_data_.size());
+        auto* ret_typed = reinterpret_cast<std::uint32_t*>(ret.data());
+        for (std::uint32_t t = 0; t < threads_count; t++)
         {
-            return run_conformance_check<Half>(data_out, input_data_, 0.0f);
+            if (params_.mode == Mode::eRead)
+            {
+                std::uint32_t sum = 0;
+                for (std::uint32_t i = 0; i < dwords_per_hw; i++)
+                {
+                    sum += input_typed[t * dwords_per_hw + i];
+                }
+                ret_typed[t] = sum;
+            }
+            else
+            {
+                for (std::uint32_t i = 0; i < dwords_per_hw; i++)
+                {
+                    ret_typed[t * dwords_per_hw + i] = params_.mode == Mode::eWrite ? t : input_typed[i * threads_count + t];
+                }
+            }
+        }
+        return ret;
+    }
+
+    LayerCost get_layer_cost() const override
+    {
+        LayerCost ret{};
+        switch (params_.mode)
+        {
+        case Mode::eRead:  ret.bytes = input_data_.size() + get_threads_count() * sizeof(std::uint32_t); break;
+        case Mode::eWrite: ret.bytes = input_data_.size(); break;
+        default:
+            ret.bytes = 2 * input_data_.size();  // read input and write output
+        }
+        return ret;
+    }
+
+    /*
+    *   Configurations requested by the sweep options. Sizes are rounded down to be dispatchable with given items_per_hw and lws_x.
+    */
+    static std::vector<create_params_t> get_sweep_configs(const create_params_t& params)
+    {
+        const auto items_per_hw_list = params.sweep_items_per_hw.empty() ? std::vector<std::uint32_t>{ params.items_per_hw } : params.sweep_items_per_hw;
+        const auto lws_x_list = params.sweep_lws_x.empty() ? std::vector<std::uint32_t>{ params.lws_x } : params.sweep_lws_x;
+        const auto dt_size = get_data_type_bytes_width(params.dt);
+        const std::size_t max_elements = params.shape.get_elements_count();
+
+        std::vector<create_params_t> ret;
+        for (const auto items_per_hw : items_per_hw_list)
+        {
+            for (const auto lws_x : lws_x_list)
+            {
+                const std::size_t granularity = static_cast<std::size_t>(items_per_hw) * lws_x;
+                std::size_t elements = params.sweep_sizes ? std::max<std::size_t>(params.sweep_min_bytes / dt_size, granularity) : max_elements;
+                while (elements <= max_elements)
+                {
+                    auto config = params;
+                    config.items_per_hw = items_per_hw;
+                    config.lws_x = lws_x;
+                    config.shape = TensorShape(1, 1, 1, static_cast<std::uint32_t>((elements / granularity) * granularity));
+                    config.sweep_sizes = false;
+                    config.sweep_items_per_hw.clear();
+                    config.sweep_lws_x.clear();
+                    ret.push_back(std::move(config));
+                    elements *= 2;
+                }
+            }
         }
-        ConformanceResult ret{};
         return ret;
     }
 
 protected:
+    inline std::uint32_t get_threads_count() const
+    {
+        return static_cast<std::uint32_t>(params_.shape.get_elements_count() / params_.items_per_hw);
+    }
 
 protected:
     create_params_t params_;
@@ -247,6 +353,77 @@ protected:
     std::vector<std::byte> input_data_;
     ComPtr<ID3D12Resource> input_buffer_;
     ComPtr<ID3D12Resource> output_buffer_;
-    ComPtr<ID3D12Resource> upload_buffer_;
 };
+
+struct MemoryBandwidthSample
+{
+    std::size_t working_set_bytes = 0;
+    std::uint32_t items_per_hw = 0;
+    std::uint32_t lws_x = 0;
+    std::chrono::microseconds time{};
+    double bandwidth_gbps = 0.0;
+};
+
+/*
+*   Knee is a size where bandwidth drops by more than drop_threshold compared to the plateau before it.
+*   Expects samples of single configuration sorted by working set size. Returns indices of the first samples after every knee.
+*/
+inline std::vector<std::size_t> find_bandwidth_knees(std::span<const MemoryBandwidthSample> samples, double drop_threshold = 0.15)
+{
+    std::vector<std::size_t> ret;
+    double plateau = 0.0;
+    for (std::size_t i = 0; i < samples.size(); i++)
+    {
+        const auto bw = samples[i].bandwidth_gbps;
+        if (plateau > 0.0 && bw < (1.0 - drop_threshold) * plateau)
+        {
+            ret.push_back(i);
+            plateau = bw;
+        }
+        else
+        {
+            plateau = std::max(plateau, bw);
+        }
+    }
+    return ret;
+}
+
+inline void print_bandwidth_curve(std::span<const MemoryBandwidthSample> samples)
+{
+    std::size_t begin = 0;
+    while (begin < samples.size())
+    {
+        // samples are grouped by configuration
+        auto end = begin + 1;
+        while (end < samples.size() && samples[end].items_per_hw == samples[begin].items_per_hw && samples[end].lws_x == samples[begin].lws_x)
+        {
+            end++;
+        }
+        const auto curve = samples.subspan(begin, end - begin);
+
+        std::cout << std::format("items_per_hw: {}, lws_x: {}\n", curve.front().items_per_hw, curve.front().lws_x);
+        std::cout << std::format("{:>14} {:>10} {:>12}\n", "size [KB]", "time [us]", "BW [GB/s]");
+        for (const auto& sample : curve)
+        {
+            std::cout << std::format("{:>14} {:>10} {:>12.2f}\n", sample.working_set_bytes / 1024, sample.time.count(), sample.bandwidth_gbps);
+        }
+
+        const auto knees = find_bandwidth_knees(curve);
+        for (std::size_t k = 0; k < knees.size(); k++)
+        {
+            const auto& before = curve[knees[k] - 1];
+            const auto& after = curve[knees[k]];
+            std::cout << std::format("Knee {}: between {} KB and {} KB, {:.2f} GB/s -> {:.2f} GB/s\n",
+                k, before.working_set_bytes / 1024, after.working_set_bytes / 1024, before.bandwidth_gbps, after.bandwidth_gbps);
+        }
+        begin = end;
+    }
+
+    const auto best = std::max_element(samples.begin(), samples.end(), [](const auto& a, const auto& b) { return a.bandwidth_gbps < b.bandwidth_gbps; });
+    if (best != samples.end())
+    {
+        std::cout << std::format("Best: {:.2f} GB/s (size: {} KB, items_per_hw: {}, lws_x: {})\n", best->bandwidth_gbps, best->working_set_bytes / 1024, best->items_per_hw, best->lws_x);
+    }
+}
+
 }
@@ -249,8 +249,6 @@ public:
         const auto tensor_scale_bytes_width = scale_data_.size();
         const auto tensor_out_bytes_width = tensor_input_bytes_width;
 
-        upload_buffer_ = create_buffer(d3d12_device_, tensor_input_bytes_width + tensor_bias_bytes_width + tensor_scale_bytes_width,
-            D3D12_HEAP_TYPE_UPLOAD, D3D12_RESOURCE_STATE_GENERIC_READ);
         input_buffer_ = create_buffer(d3d12_device, tensor_input_bytes_width,
             D3D12_HEAP_TYPE_DEFAULT, D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS);
         if (use_bias())
@@ -267,37 +265,16 @@ public:
             D3D12_HEAP_TYPE_DEFAULT, D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS);
 
 
-        // copy data into buffer
-        std::byte* upload_mapped_ptr = nullptr;
-        upload_buffer_->Map(0, nullptr, reinterpret_cast<void**>(&upload_mapped_ptr));
-        std::size_t memcopy_offset = 0;
-        std::memcpy(upload_mapped_ptr, input_data_.data(), tensor_input_bytes_width);
-        memcopy_offset += tensor_input_bytes_width;
+        // copy data into buffers, barriers below are executed after the uploads (see close_execute_reset_wait)
+        auto& staging_ring = get_staging_ring();
+        staging_ring.upload(input_buffer_.Get(), 0, input_data_);
         if (use_bias())
         {
-            std::memcpy(upload_mapped_ptr + memcopy_offset, bias_data_.data(), tensor_bias_bytes_width);
-            memcopy_offset += tensor_bias_bytes_width;
+            staging_ring.upload(bias_buffer_.Get(), 0, bias_data_);
         }
         if (use_scale())
         {
-            std::memcpy(upload_mapped_ptr + memcopy_offset, scale_data_.data(), tensor_scale_bytes_width);
-            memcopy_offset += tensor_scale_bytes_width;
-        }
-        // unmap memory
-        upload_buffer_->Unmap(0, nullptr);
-
-        memcopy_offset = 0;
-        cmd_list->CopyBufferRegion(input_buffer_.Get(), 0, upload_buffer_.Get(), 0, tensor_input_bytes_width);
-        memcopy_offset += tensor_input_bytes_width;
-        if (use_bias())
-        {
-            cmd_list->CopyBufferRegion(bias_buffer_.Get(), 0, upload_buffer_.Get(), memcopy_offset, tensor_bias_bytes_width);
-            memcopy_offset += tensor_bias_bytes_width;
-        }
-        if (use_scale())
-        {
-            cmd_list->CopyBufferRegion(scale_buffer_.Get(), 0, upload_buffer_.Get(), memcopy_offset, tensor_scale_bytes_width);
-            memcopy_offset += tensor_scale_bytes_width;
+            staging_ring.upload(scale_buffer_.Get(), 0, scale_data_);
         }
 
         std::vector<CD3DX12_RESOURCE_BARRIER> barriers;
@@ -320,73 +297,129 @@ public:
     virtual ConformanceResult validate_conformance(ID3D12CommandQueue* command_queue,
         ID3D12CommandAllocator* command_allocator, ID3D12GraphicsCommandList* command_list)
     {
-        const auto tensor_out_bytes_width = output_buffer_->GetDesc().Width;
+        return validate_conformance_with_reference(get_reference_result(command_queue, command_allocator, command_list), command_queue, command_allocator, command_list);
+    }
+
+    ConformanceResult validate_conformance_with_reference(const std::vector<std::byte>& reference, ID3D12CommandQueue* command_queue,
+        ID3D12CommandAllocator* command_allocator, ID3D12GraphicsCommandList* command_list) override
+    {
+        const auto tensor_out_bytes_width = input_data_.size();
 
         // readback data and validate
-        auto readback_buffer = create_buffer(d3d12_device_, tensor_out_bytes_width, D3D12_HEAP_TYPE_READBACK, D3D12_RESOURCE_STATE_COPY_DEST);
-        auto readback_output_barrirer = CD3DX12_RESOURCE_BARRIER::Transition(output_buffer_.Get(),
-            D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_COPY_SOURCE);
-        command_list->ResourceBarrier(1, &readback_output_barrirer);
-        command_list->CopyResource(readback_buffer.Get(), output_buffer_.Get());
-        close_execute_reset_wait(d3d12_device_, command_queue, command_allocator, command_list);
+        const auto data_out = readback_buffer_data(d3d12_device_, command_queue, command_allocator, command_list, output_buffer_.Get(), tensor_out_bytes_width);
+
+        if (params_.dt == DataType::eFp32)
+        {
+            return run_conformance_check<float>(data_out, reference, 0.001f);
+        }
+        else if (params_.dt == DataType::eFp16)
+        {
+            return run_conformance_check<Half>(data_out, reference, 0.05f);
+        }
+        assert(false && "Unsupported output data type!");
+        ConformanceResult ret{};
+        return ret;
+    }
 
-        std::vector<std::byte> data_out(tensor_out_bytes_width);
-        std::byte* readback_mapped_ptr = nullptr;
-        readback_buffer->Map(0, nullptr, reinterpret_cast<void**>(&readback_mapped_ptr));
-        std::memcpy(data_out.data(), readback_mapped_ptr, data_out.size());
-        readback_buffer->Unmap(0, nullptr);
+    std::vector<std::byte> get_reference_result(ID3D12CommandQueue* command_queue,
+        ID3D12CommandAllocator* command_allocator, ID3D12GraphicsCommandList* command_list) override
+    {
+        const auto tensor_out_bytes_width = input_data_.size();
 
         //
-        //  calc reference with dml non-mc mvn
+        //  calc reference with dml non-mc mvn, inputs are uploaded from host data (node inputs can be bound to other node outputs)
         //
-        readback_output_barrirer = CD3DX12_RESOURCE_BARRIER::Transition(output_buffer_.Get(),
-            D3D12_RESOURCE_STATE_COPY_SOURCE, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
-        command_list->ResourceBarrier(1, &readback_output_barrirer);
+        auto ref_input = upload_data_to_new_buffer(d3d12_device_, command_queue, command_allocator, command_list, input_data_);
+        ComPtr<ID3D12Resource> ref_scale;
+        if (use_scale())
+        {
+            ref_scale = upload_data_to_new_buffer(d3d12_device_, command_queue, command_allocator, command_list, scale_data_);
+        }
+        ComPtr<ID3D12Resource> ref_bias;
+        if (use_bias())
+        {
+            ref_bias = upload_data_to_new_buffer(d3d12_device_, command_queue, command_allocator, command_list, bias_data_);
+        }
+        auto ref_output = create_buffer(d3d12_device_, tensor_out_bytes_width,
+            D3D12_HEAP_TYPE_DEFAULT, D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS);
 
         gpu_op::Mvn mvn_ref(params_.shape, to_dml_data_type(params_.dt), to_dml_tensor_policy(params_.layout),
             params_.no_scale, params_.no_bias, params_.epsilon, dml_device_, d3d12_device_, true /*disable mc for ref calc*/);
         // bind descriptor heap
-        auto descriptor_heap = create_descriptor_heap(d3d12_device_, mvn_ref.get_total_descriptor_count());
-        ID3D12DescriptorHeap* d3d12_descriptor_heaps[] = { descriptor_heap.Get() };
-        command_list->SetDescriptorHeaps(1, d3d12_descriptor_heaps);
+        auto& descriptor_heap_allocator = get_descriptor_heap_allocator();
+        const auto descriptors = descriptor_heap_allocator.allocate(mvn_ref.get_total_descriptor_count());
+        descriptor_heap_allocator.bind(command_list);
 
-        mvn_ref.create_binding_tables(descriptor_heap->GetCPUDescriptorHandleForHeapStart(), descriptor_heap->GetGPUDescriptorHandleForHeapStart());
+        mvn_ref.create_binding_tables(descriptors.get_cpu_handle(), descriptors.get_gpu_handle());
         mvn_ref.record_initialize(dml_cmd_recorder_, command_list);
         close_execute_reset_wait(d3d12_device_, command_queue, command_allocator, command_list);
 
-        command_list->SetDescriptorHeaps(1, d3d12_descriptor_heaps);
+        descriptor_heap_allocator.bind(command_list);
         mvn_ref.record_execute(dml_cmd_recorder_, command_list,
-            output_buffer_.Get(), input_buffer_.Get(), scale_buffer_.Get(), bias_buffer_.Get());
-        close_execute_reset_wait(d3d12_device_, command_queue, command_allocator, command_list);
-
-        readback_output_barrirer = CD3DX12_RESOURCE_BARRIER::Transition(output_buffer_.Get(),
-            D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_COPY_SOURCE);
-        command_list->ResourceBarrier(1, &readback_output_barrirer);
-        command_list->CopyResource(readback_buffer.Get(), output_buffer_.Get());
+            ref_output.Get(), ref_input.Get(), ref_scale.Get(), ref_bias.Get());
         close_execute_reset_wait(d3d12_device_, command_queue, command_allocator, command_list);
 
-        std::vector<std::byte> dnnl_untyped_result(tensor_out_bytes_width);
-        readback_mapped_ptr = nullptr;
-        readback_buffer->Map(0, nullptr, reinterpret_cast<void**>(&readback_mapped_ptr));
-        std::memcpy(dnnl_untyped_result.data(), readback_mapped_ptr, dnnl_untyped_result.size());
-        readback_buffer->Unmap(0, nullptr);
-
         // dnnl seems to be broken, use mvn non-mc path
         //const auto dnnl_untyped_result = cpu_op::mvn(params_.shape, params_.layout, params_.dt, input_data_.data(), scale_data_.data(), bias_data_.data(), params_.epsilon);
+        return readback_buffer_data(d3d12_device_, command_queue, command_allocator, command_list, ref_output.Get(), tensor_out_bytes_width);
+    }
 
-        if (params_.dt == DataType::eFp32)
+    ID3D12Resource* get_output_resource() override
+    {
+        return output_buffer_.Get();
+    }
+
+    ID3D12Resource* get_input_resource(std::uint32_t idx) override
+    {
+        assert(idx < 3);
+        return idx == 0 ? input_buffer_.Get() : (idx == 1 ? scale_buffer_.Get() : bias_buffer_.Get());
+    }
+
+    void set_input_resource(std::uint32_t idx, ComPtr<ID3D12Resource> resource) override
+    {
+        assert(idx < 3);
+        check_input_resource_size(resource.Get(), get_input_data(idx).size());
+        auto& buffer = idx == 0 ? input_buffer_ : (idx == 1 ? scale_buffer_ : bias_buffer_);
+        buffer = std::move(resource);
+    }
+
+    const std::vector<std::byte>& get_input_data(std::uint32_t idx) const override
+    {
+        assert(idx < 3);
+        return idx == 0 ? input_data_ : (idx == 1 ? scale_data_ : bias_data_);
+    }
+
+    void set_input_data(std::uint32_t idx, std::vector<std::byte> data) override
+    {
+        assert(idx < 3);
+        auto& input_data = idx == 0 ? input_data_ : (idx == 1 ? scale_data_ : bias_data_);
+        check_input_data_size(data, input_data.size());
+        input_data = std::move(data);
+    }
+
+    LayerCost get_layer_cost() const override
+    {
+        LayerCost ret{};
+        // mean: add, variance: sub + mad, normalize: sub + mul, optional scale and bias
+        std::uint64_t flops_per_element = 5;
+        if (use_scale())
         {
-            return run_conformance_check<float>(data_out, dnnl_untyped_result, 0.001f);
+            flops_per_element++;
         }
-        else if (params_.dt == DataType::eFp16)
+        if (use_bias())
         {
-            return run_conformance_check<Half>(data_out, dnnl_untyped_result, 0.05f);
+            flops_per_element++;
         }
-        assert(false && "Unsupported output data type!");
-        ConformanceResult ret{};
+        ret.flops = flops_per_element * params_.shape.get_elements_count();
+        ret.bytes = 2 * input_data_.size() + scale_data_.size() + bias_data_.size();
         return ret;
     }
 
+    DataType get_compute_data_type() const override
+    {
+        return params_.dt;
+    }
+
 protected:
     inline bool use_bias() const
     {
@@ -412,7 +445,6 @@ protected:
     ComPtr<ID3D12Resource> scale_buffer_;
     ComPtr<ID3D12Resource> bias_buffer_;
     ComPtr<ID3D12Resource> output_buffer_;
-    ComPtr<ID3D12Resource> upload_buffer_;
 };
 
 class MvnDmlDispatcher : public MvnBaseDispatcher
@@ -0,0 +1,233 @@
+#pragma once
+#include <vector>
+#include <string>
+#include <memory>
+#include <optional>
+#include <algorithm>
+#include "dx12_utils.h"
+#include "layers_utils.h"
+
+/*
+*   Connection of a stage input with other stage output (or other stage input, when both stages share the same tensor, ex. KV in attention).
+*   Textual form: <input_idx>=<src_stage>:out or <input_idx>=<src_stage>:in<src_input_idx>
+*/
+struct PipelineInputLink
+{
+    std::uint32_t input_idx = 0;
+    std::uint32_t src_stage = 0;
+    std::optional<std::uint32_t> src_input_idx = std::nullopt;  // nullopt means output of the src stage
+};
+
+inline PipelineInputLink parse_pipeline_input_link(const std::string& str)
+{
+    const auto eq_pos = str.find('=');
+    const auto colon_pos = str.find(':');
+    if (eq_pos == std::string::npos || colon_pos == std::string::npos || colon_pos < eq_pos)
+    {
+        throw std::runtime_error(std::format("Wrong pipeline input link format: {}. Expected <input_idx>=<stage>:out or <input_idx>=<stage>:in<idx>.", str));
+    }
+
+    PipelineInputLink ret{};
+    ret.input_idx = std::stoi(str.substr(0, eq_pos));
+    ret.src_stage = std::stoi(str.substr(eq_pos + 1, colon_pos - eq_pos - 1));
+    const auto src = str.substr(colon_pos + 1);
+    if (src.starts_with("in"))
+    {
+        ret.src_input_idx = std::stoi(src.substr(2));
+    }
+    else if (src != "out")
+    {
+        throw std::runtime_error(std::format("Wrong pipeline input link source: {}.", src));
+    }
+    return ret;
+}
+
+/*
+*   Chain of nodes recorded back to back into single command list.
+*   Stage outputs are bound directly as inputs of the following stages (no copies),
+*   so caches reuse between layers and barriers costs are part of the measurment.
+*/
+class Pipeline : public NodeDispatcher
+{
+public:
+    struct Stage
+    {
+        std::string name;
+        std::unique_ptr<NodeDispatcher> node;
+        std::vector<PipelineInputLink> links;
+    };
+
+public:
+    // Nodes construction commands have to be executed before creating pipeline, as stages inputs are replaced here.
+    Pipeline(std::vector<Stage>&& stages, ID3D12Device* d3d12_device)
+        : stages_(std::move(stages))
+        , d3d12_device_(d3d12_device)
+    {
+        if (stages_.empty())
+        {
+            throw std::runtime_error("Pipeline has to have at least one stage.");
+        }
+
+        for (std::uint32_t i = 0; i < stages_.size(); i++)
+        {
+            auto& stage = stages_[i];
+            const auto has_first_input_link = std::any_of(stage.links.begin(), stage.links.end(), [](const auto& l) { return l.input_idx == 0; });
+            if (i > 0 && !has_first_input_link)
+            {
+                // by default stage consumes output of the previous one
+                stage.links.push_back({ 0, i - 1, std::nullopt });
+            }
+
+            for (const auto& link : stage.links)
+            {
+                if (link.src_stage >= i)
+                {
+                    throw std::runtime_error(std::format("Stage {} can be linked only with previous stages (requested: {}).", i, link.src_stage));
+                }
+                auto& src_node = stages_[link.src_stage].node;
+                ComPtr<ID3D12Resource> resource = link.src_input_idx ? src_node->get_input_resource(*link.src_input_idx) : src_node->get_output_resource();
+                stage.node->set_input_resource(link.input_idx, resource);
+            }
+        }
+    }
+
+    std::uint32_t get_total_descriptor_count() override
+    {
+        std::uint32_t ret = 0;
+        for (auto& stage : stages_)
+        {
+            ret += stage.node->get_total_descriptor_count();
+        }
+        return ret;
+    }
+
+    void initialize(ID3D12GraphicsCommandList* cmd_list, D3D12_CPU_DESCRIPTOR_HANDLE cpu_handle, D3D12_GPU_DESCRIPTOR_HANDLE gpu_handle) override
+    {
+        const auto increment_size = d3d12_device_->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+        for (auto& stage : stages_)
+        {
+            stage.node->initialize(cmd_list, cpu_handle, gpu_handle);
+            const auto descriptors_count = stage.node->get_total_descriptor_count();
+            cpu_handle.ptr += static_cast<std::size_t>(descriptors_count) * increment_size;
+            gpu_handle.ptr += static_cast<std::uint64_t>(descriptors_count) * increment_size;
+        }
+    }
+
+    void execute(ID3D12GraphicsCommandList* cmd_list) override
+    {
+        execute_profiled(cmd_list, nullptr);
+    }
+
+    // Adds timestamp before first stage and after every stage (stages_count + 1 timestamps per call).
+    void execute_profiled(ID3D12GraphicsCommandList* cmd_list, PerfCollectorDX12* performance_collector)
+    {
+        if (performance_collector)
+        {
+            performance_collector->add_timestamp(cmd_list);
+        }
+        for (auto& stage : stages_)
+        {
+            stage.node->execute(cmd_list);
+
+            // next stage reads output of this one
+            const auto barrier = CD3DX12_RESOURCE_BARRIER::UAV(stage.node->get_output_resource());
+            cmd_list->ResourceBarrier(1, &barrier);
+
+            if (performance_collector)
+            {
+                performance_collector->add_timestamp(cmd_list);
+            }
+        }
+    }
+
+    ConformanceResult validate_conformance(ID3D12CommandQueue* command_queue,
+        ID3D12CommandAllocator* command_allocator, ID3D12GraphicsCommandList* command_list) override
+    {
+        // reference is chained as well: every stage reference consumes reference results of the stages it is linked with
+        std::vector<std::vector<std::byte>> references(stages_.size());
+        ConformanceResult ret{};
+        for (std::uint32_t i = 0; i < stages_.size(); i++)
+        {
+            auto& stage = stages_[i];
+            for (const auto& link : stage.links)
+            {
+                const auto& src_node = stages_[link.src_stage].node;
+                stage.node->set_input_data(link.input_idx, link.src_input_idx ? src_node->get_input_data(*link.src_input_idx) : references[link.src_stage]);
+            }
+
+            // computed once, it's compared with the stage output and consumed by the next stages
+            references[i] = stage.node->get_reference_result(command_queue, command_allocator, command_list);
+            const auto stage_result = stage.node->validate_conformance_with_reference(references[i], command_queue, command_allocator, command_list);
+            std::cout << std::format("Stage {} ({}) conformance {}. Biggest difference: {}.\n", i, stage.name, stage_result.passed, stage_result.biggest_difference);
+
+            // every stage has to pass, the worst difference is reported
+            ret.passed = ret.passed && stage_result.passed;
+            ret.tested_samples_count += stage_result.tested_samples_count;
+            if (i == 0 || stage_result.biggest_difference > ret.biggest_difference)
+            {
+                ret.epsilon = stage_result.epsilon;
+                ret.biggest_difference = stage_result.biggest_difference;
+                ret.node_value = stage_result.node_value;
+                ret.reference_value = stage_result.reference_value;
+                ret.index = stage_result.index;
+            }
+        }
+        return ret;
+    }
+
+    bool start_reference_async() override
+    {
+        // references of other stages depend on references of the previous ones
+        return stages_.front().node->start_reference_async();
+    }
+
+    LayerCost get_layer_cost() const override
+    {
+        LayerCost ret{};
+        for (const auto& stage : stages_)
+        {
+            const auto stage_cost = stage.node->get_layer_cost();
+            ret.flops += stage_cost.flops;
+            ret.bytes += stage_cost.bytes;
+        }
+        return ret;
+    }
+
+    // fp16 roof only if all the stages compute in fp16, otherwise the slower fp32 math bounds the pipeline
+    DataType get_compute_data_type() const override
+    {
+        auto ret = DataType::eCount;
+        for (const auto& stage : stages_)
+        {
+            const auto dt = stage.node->get_compute_data_type();
+            if (dt == DataType::eFp32)
+            {
+                return dt;
+            }
+            if (ret == DataType::eCount)
+            {
+                ret = dt;
+            }
+        }
+        return ret;
+    }
+
+    ID3D12Resource* get_output_resource() override
+    {
+        return stages_.back().node->get_output_resource();
+    }
+
+    std::size_t get_stages_count() const
+    {
+        return stages_.size();
+    }
+
+    const Stage& get_stage(std::size_t idx) const
+    {
+        return stages_[idx];
+    }
+
+private:
+    std::vector<Stage> stages_;
+    ID3D12Device* d3d12_device_;
+};
@@ -0,0 +1,194 @@
+#pragma once
+#include <vector>
+#include <chrono>
+#include <optional>
+#include "dml_base_node.h"
+
+namespace gpu_op
+{
+
+/*
+*   Microkernel with long chains of independent mads and no memory traffic (except single store per thread).
+*   Used to find the compute roof of the device.
+*/
+class ComputePeakDispatcher : public NodeDispatcher
+{
+public:
+    struct create_params_t
+    {
+        DataType dt = DataType::eFp16;
+        std::uint32_t threads_count = 64 * 1024;
+        std::uint32_t lws_x = 16;
+        std::uint32_t iterations = 4096;
+
+        // has to match CHAINS define in the kernel
+        static constexpr std::uint32_t chains_count = 4;
+
+        inline std::uint32_t get_simd() const
+        {
+            return dt == DataType::eFp16 ? 32 : 16;
+        }
+    };
+
+public:
+    ComputePeakDispatcher(create_params_t&& params, ID3D12Device* d3d12_device, IntelExtension& intc_ext)
+        : params_(std::move(params))
+        , d3d12_device_(d3d12_device)
+        , intc_ext_(intc_ext)
+    {
+        assert(params_.threads_count % params_.lws_x == 0);
+
+        const auto output_bytes_width = static_cast<std::size_t>(params_.threads_count) * params_.get_simd() * get_data_type_bytes_width(params_.dt);
+        output_buffer_ = create_buffer(d3d12_device_, output_bytes_width,
+            D3D12_HEAP_TYPE_DEFAULT, D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS);
+
+        // root signature
+        {
+            // output
+            std::vector<DescType> desc_list = { DescType::eUav };
+            root_signature_ = create_root_signature(d3d12_device_, desc_list);
+            assert(root_signature_);
+        }
+
+        // kernel jits
+        std::string build_options = "";
+        const std::string pre_jit = "-D";
+        const std::string post_jit = " ";
+        const std::string between_name_and_value = "=";
+
+        auto add_define = [&](const std::string& name, auto value) {
+            using namespace std;
+            std::string value_str;
+            if (std::is_floating_point<decltype(value)>::value)
+            {// to_*string precision is not enough to ensure good match betweeen GPU and CPU or pytorch execution results:
+                value_str = (std::stringstream() << std::setiosflags(std::ios_base::showpoint | std::ios_base::fixed) << std::setprecision((std::numeric_limits<decltype(value)>::max_digits10 + 1)) << value).str();
+            }
+            else
+            { // fine for other types:
+                value_str = to_string(value);
+            }
+
+            build_options += pre_jit + name + between_name_and_value + value_str + post_jit;
+        };
+
+        add_define("DT", params_.dt == DataType::eFp16 ? "half" : "float");
+        add_define("SIMD", params_.get_simd());
+        add_define("ITERATIONS", params_.iterations);
+
+        // kernel compilation
+        const auto lws_x = " -DLWS_SIZE_X=" + std::to_string(params_.lws_x);
+        const auto lws_y = " -DLWS_SIZE_Y=1";
+        const auto lws_z = " -DLWS_SIZE_Z=1";
+        const auto build_options_final = " -I \" \" " + build_options + lws_x + lws_y + lws_z;
+
+        auto kernel_source_content = []()
+        {
+            const auto path = "compute_peak.cpp";
+            std::fstream file(path);
+            if (!file.is_open())
+            {
+                const auto msg = std::format("Kernel file cant be opened:{} \n.", path);
+                throw std::runtime_error(msg);
+            }
+            return std::string((std::istreambuf_iterator<char>(file)), (std::istreambuf_iterator<char>()));
+        }();
+
+        CD3DX12_SHADER_BYTECODE byte_code;
+        byte_code.pShaderBytecode = kernel_source_content.data();
+        byte_code.BytecodeLength = kernel_source_content.size();
+        pso_ = intc_ext_.create_pipeline(byte_code, build_options_final, root_signature_.Get(), INTC_D3D12_SHADER_INPUT_TYPE::CM);
+    }
+
+    std::uint32_t get_total_descriptor_count() override
+    {
+        // output
+        return 1u;
+    }
+
+    void initialize(ID3D12GraphicsCommandList* cmd_list, D3D12_CPU_DESCRIPTOR_HANDLE cpu_handle, D3D12_GPU_DESCRIPTOR_HANDLE gpu_handle) override
+    {
+        std::vector<std::pair<DescType, ID3D12Resource*>> resources_list;
+        resources_list.reserve(get_total_descriptor_count());
+        resources_list.push_back({ DescType::eUav, output_buffer_.Get() });
+
+        gpu_handles_ = create_resource_views_and_handles(d3d12_device_, resources_list, cpu_handle, gpu_handle);
+        assert(!gpu_handles_.empty());
+    }
+
+    void execute(ID3D12GraphicsCommandList* cmd_list) override
+    {
+        dispatch_kernel(cmd_list, pso_.Get(), root_signature_.Get(), gpu_handles_, params_.threads_count / params_.lws_x, 1, 1);
+    }
+
+    ConformanceResult validate_conformance(ID3D12CommandQueue* command_queue,
+        ID3D12CommandAllocator* command_allocator, ID3D12GraphicsCommandList* command_list) override
+    {
+        // nothing to validate, output is only a sink for the mads
+        return ConformanceResult{};
+    }
+
+    LayerCost get_layer_cost() const override
+    {
+        LayerCost ret{};
+        ret.flops = 2ull * params_.threads_count * params_.iterations * create_params_t::chains_count * params_.get_simd();
+        ret.bytes = output_buffer_->GetDesc().Width;
+        return ret;
+    }
+
+private:
+    create_params_t params_;
+    ID3D12Device* d3d12_device_;
+    IntelExtension& intc_ext_;
+    std::vector<CD3DX12_GPU_DESCRIPTOR_HANDLE> gpu_handles_;
+
+    ComPtr<ID3D12PipelineState> pso_;
+    ComPtr<ID3D12RootSignature> root_signature_;
+    ComPtr<ID3D12Resource> output_buffer_;
+};
+
+}  // namespace gpu_op
+
+struct RooflinePeaks
+{
+    double bandwidth_gbps = 0.0;
+    std::optional<double> gflops = std::nullopt;
+};
+
+inline double to_giga_per_second(std::uint64_t count, std::chrono::microseconds time)
+{
+    if (time.count() == 0)
+    {
+        return 0.0;
+    }
+    // count / us = mega per second
+    return static_cast<double>(count) / static_cast<double>(time.count()) / 1000.0;
+}
+
+inline void print_roofline_report(const LayerCost& cost, std::chrono::microseconds time, const RooflinePeaks& peaks)
+{
+    assert(peaks.bandwidth_gbps > 0.0);
+
+    const auto arithmetic_intensity = cost.get_arithmetic_intensity();
+    const auto achieved_gflops = to_giga_per_second(cost.flops, time);
+    const auto achieved_bandwidth = to_giga_per_second(cost.bytes, time);
+
+    // without compute peak only memory roof is known
+    const auto memory_roof_gflops = arithmetic_intensity * peaks.bandwidth_gbps;
+    const auto attainable_gflops = peaks.gflops.has_value() ? std::min(*peaks.gflops, memory_roof_gflops) : memory_roof_gflops;
+    const auto memory_bound = !peaks.gflops.has_value() || memory_roof_gflops < *peaks.gflops;
+
+    // memory bound layers without flops (copies) are measured against the bandwidth roof
+    const auto efficiency = cost.flops == 0 ? 100.0 * achieved_bandwidth / peaks.bandwidth_gbps
+        : (attainable_gflops > 0.0 ? 100.0 * achieved_gflops / attainable_gflops : 0.0);
+
+    std::cout << "Roofline:" << std::endl;
+    std::cout << std::format("  Peak bandwidth: {:.2f} GB/s\n", peaks.bandwidth_gbps);
+    if (peaks.gflops.has_value())
+    {
+        std::cout << std::format("  Peak compute: {:.2f} GFLOPS, ridge point: {:.2f} FLOP/byte\n", *peaks.gflops, *peaks.gflops / peaks.bandwidth_gbps);
+    }
+    std::cout << std::format("  Layer: {} FLOP, {} bytes, arithmetic intensity: {:.2f} FLOP/byte\n", cost.flops, cost.bytes, arithmetic_intensity);
+    std::cout << std::format("  Achieved: {:.2f} GFLOPS, {:.2f} GB/s (time: {} us)\n", achieved_gflops, achieved_bandwidth, time.count());
+    std::cout << std::format("  Attainable: {:.2f} GFLOPS, bound by: {}\n", attainable_gflops, memory_bound ? "memory" : "compute");
+    std::cout << std::format("  Efficiency: {:.2f}% of roofline\n", efficiency);
+}
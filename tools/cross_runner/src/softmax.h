@@ -121,7 +121,6 @@ public:
         const auto tensor_out_bytes_width = input_data_.size();
 
 
-        upload_buffer_ = create_buffer(d3d12_device, tensor_a_bytes_width, D3D12_HEAP_TYPE_UPLOAD, D3D12_RESOURCE_STATE_GENERIC_READ);
         input_buffer_ = create_buffer(d3d12_device, tensor_a_bytes_width,
             D3D12_HEAP_TYPE_DEFAULT, D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS);
         output_buffer_ = create_buffer(d3d12_device, tensor_out_bytes_width,
@@ -144,14 +143,8 @@ public:
             assert(false && "Unsupported data type in convolution dispatcher!");
         }
 
-        // copy data into buffer
-        std::byte* upload_mapped_ptr = nullptr;
-        upload_buffer_->Map(0, nullptr, reinterpret_cast<void**>(&upload_mapped_ptr));
-        std::memcpy(upload_mapped_ptr, input_data_.data(), tensor_a_bytes_width);
-        // unmap memory
-        upload_buffer_->Unmap(0, nullptr);
-
-        cmd_list->CopyBufferRegion(input_buffer_.Get(), 0, upload_buffer_.Get(), 0, tensor_a_bytes_width);
+        // copy data into buffer, barrier below is executed after the upload (see close_execute_reset_wait)
+        get_staging_ring().upload(input_buffer_.Get(), 0, input_data_);
 
         std::vector<CD3DX12_RESOURCE_BARRIER> barriers;
         barriers.push_back(CD3DX12_RESOURCE_BARRIER::Transition(input_buffer_.Get(),
@@ -161,38 +154,81 @@ public:
 
     ConformanceResult validate_conformance(ID3D12CommandQueue* command_queue,
         ID3D12CommandAllocator* command_allocator, ID3D12GraphicsCommandList* command_list)
+    {
+        return validate_conformance_with_reference(get_reference_result(command_queue, command_allocator, command_list), command_queue, command_allocator, command_list);
+    }
+
+    ConformanceResult validate_conformance_with_reference(const std::vector<std::byte>& reference, ID3D12CommandQueue* command_queue,
+        ID3D12CommandAllocator* command_allocator, ID3D12GraphicsCommandList* command_list) override
     {
         const auto tensor_out_bytes_width = input_data_.size();
 
         // readback data and validate
-        auto readback_buffer = create_buffer(d3d12_device_, tensor_out_bytes_width, D3D12_HEAP_TYPE_READBACK, D3D12_RESOURCE_STATE_COPY_DEST);
-        auto readback_output_barrirer = CD3DX12_RESOURCE_BARRIER::Transition(output_buffer_.Get(),
-            D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_COPY_SOURCE);
-        command_list->ResourceBarrier(1, &readback_output_barrirer);
-        command_list->CopyResource(readback_buffer.Get(), output_buffer_.Get());
-        close_execute_reset_wait(d3d12_device_, command_queue, command_allocator, command_list);
-
-        std::vector<std::byte> data_out(tensor_out_bytes_width);
-        std::byte* readback_mapped_ptr = nullptr;
-        readback_buffer->Map(0, nullptr, reinterpret_cast<void**>(&readback_mapped_ptr));
-        std::memcpy(data_out.data(), readback_mapped_ptr, data_out.size());
-        readback_buffer->Unmap(0, nullptr);
-
-        const auto dnnl_untyped_result = cpu_op::softmax(params_.axis, input_data_.data(), params_.shape, params_.dt, params_.layout);
+        const auto data_out = readback_buffer_data(d3d12_device_, command_queue, command_allocator, command_list, output_buffer_.Get(), tensor_out_bytes_width);
 
         if (params_.dt == DataType::eFp32)
         {
-            return run_conformance_check<float>(data_out, dnnl_untyped_result, 0.0001f);
+            return run_conformance_check<float>(data_out, reference, 0.0001f);
         }
         else if (params_.dt == DataType::eFp16)
         {
-            return run_conformance_check<Half>(data_out, dnnl_untyped_result, 0.005f);
+            return run_conformance_check<Half>(data_out, reference, 0.005f);
         }
         assert(false && "Unsupported output data type!");
         ConformanceResult ret{};
         return ret;
     }
 
+    std::vector<std::byte> get_reference_result(ID3D12CommandQueue* command_queue,
+        ID3D12CommandAllocator* command_allocator, ID3D12GraphicsCommandList* command_list) override
+    {
+        return cpu_op::softmax(params_.axis, input_data_.data(), params_.shape, params_.dt, params_.layout);
+    }
+
+    ID3D12Resource* get_output_resource() override
+    {
+        return output_buffer_.Get();
+    }
+
+    ID3D12Resource* get_input_resource(std::uint32_t idx) override
+    {
+        assert(idx == 0);
+        return input_buffer_.Get();
+    }
+
+    void set_input_resource(std::uint32_t idx, ComPtr<ID3D12Resource> resource) override
+    {
+        assert(idx == 0);
+        check_input_resource_size(resource.Get(), input_data_.size());
+        input_buffer_ = std::move(resource);
+    }
+
+    const std::vector<std::byte>& get_input_data(std::uint32_t idx) const override
+    {
+        assert(idx == 0);
+        return input_data_;
+    }
+
+    void set_input_data(std::uint32_t idx, std::vector<std::byte> data) override
+    {
+        assert(idx == 0);
+        check_input_data_size(data, input_data_.size());
+        input_data_ = std::move(data);
+    }
+
+    LayerCost get_layer_cost() const override
+    {
+        LayerCost ret{};
+        // max, sub, exp, sum and div per element
+        ret.flops = 5 * params_.shape.get_elements_count();
+        ret.bytes = 2 * input_data_.size();
+        return ret;
+    }
+
+    DataType get_compute_data_type() const override
+    {
+        return params_.dt;
+    }
 
 protected:
     create_params_t params_;
@@ -203,7 +239,6 @@ protected:
 
     ComPtr<ID3D12Resource> input_buffer_;
     ComPtr<ID3D12Resource> output_buffer_;
-    ComPtr<ID3D12Resource> upload_buffer_;
 };
 
 class SoftmaxDmlDispatcher : public SoftmaxBaseDispatcher
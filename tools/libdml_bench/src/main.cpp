@@ -0,0 +1,362 @@
+#include <dml_types.hpp>
+#include <dml_convolution.hpp>
+#include <dml_gemm.hpp>
+
+#include "CLI/App.hpp"
+#include "CLI/Formatter.hpp"
+#include "CLI/Config.hpp"
+
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <string>
+#include <chrono>
+#include <atomic>
+#include <type_traits>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+
+/*
+*   Allocations counter, all operator new variants used by libdml end up in the replaced operator new(size_t).
+*/
+namespace
+{
+std::atomic<std::uint64_t> g_allocations_count = 0;
+}
+
+void* operator new(std::size_t size)
+{
+    g_allocations_count.fetch_add(1, std::memory_order_relaxed);
+    if (void* ptr = std::malloc(size ? size : 1))
+    {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept
+{
+    std::free(ptr);
+}
+
+namespace
+{
+
+template<typename Descriptor>
+struct BenchCase
+{
+    std::string name;
+    Descriptor desc;
+};
+
+using ConvolutionCase = BenchCase<libdml::ConvolutionDescriptor>;
+using GemmCase = BenchCase<libdml::GemmDescriptor>;
+
+struct ConvParams
+{
+    std::uint32_t batch;
+    std::uint32_t ic;
+    std::uint32_t oc;
+    std::uint32_t height;
+    std::uint32_t width;
+    std::uint32_t kernel_size;
+    std::uint32_t stride;
+    bool bias;
+};
+
+ConvolutionCase make_conv_case(const std::string& name, const ConvParams& params)
+{
+    using namespace libdml;
+    const auto pad = static_cast<std::int32_t>(params.kernel_size / 2);
+    const auto out_height = (params.height + 2 * pad - params.kernel_size) / params.stride + 1;
+    const auto out_width = (params.width + 2 * pad - params.kernel_size) / params.stride + 1;
+
+    const auto as_dim = [](std::uint32_t value) { return static_cast<std::int32_t>(value); };
+    ConvolutionDescriptor desc{};
+    desc.tensor_input = { { as_dim(params.batch), as_dim(params.ic), as_dim(params.height), as_dim(params.width) }, DataLayout::eNCHW, DataType::eFp16 };
+    desc.tensor_output = { { as_dim(params.batch), as_dim(params.oc), as_dim(out_height), as_dim(out_width) }, DataLayout::eNCHW, DataType::eFp16 };
+    desc.tensor_weights = { { as_dim(params.oc), as_dim(params.ic), as_dim(params.kernel_size), as_dim(params.kernel_size) }, DataLayout::eOIYX, DataType::eFp16 };
+    if (params.bias)
+    {
+        desc.tensor_bias = Tensor{ { 1, as_dim(params.oc), 1, 1 }, DataLayout::eNCHW, DataType::eFp16 };
+    }
+    desc.strides = { as_dim(params.stride), as_dim(params.stride) };
+    desc.dilations = { 1, 1 };
+    desc.start_padding = { pad, pad };
+    desc.end_padding = { pad, pad };
+    desc.group_count = 1;
+    return { name, desc };
+}
+
+/*
+*   Convolutions of the models we load most often, fp16 NCHW (layout of the CM implementations):
+*       - Stable Diffusion 1.5 UNet with 512x512 image (64x64 latents), resnet blocks, down/up samplers, skip and attention projections,
+*         and the first convolution of the VAE encoder,
+*       - LLM linear layers (hidden 4096, MLP 11008) executed as 1x1 convolutions, for token generation and 128 tokens prefill.
+*   Implementations accept input channels < 16 (any kernel size) and 1x1 without bias (input channels % 16, output channels % 8).
+*   Other descriptors (3x3 with many channels, 1x1 with bias) are kept, they are reported separately as the rejection path.
+*/
+std::vector<ConvolutionCase> get_convolution_corpus()
+{
+    const std::vector<std::pair<std::string, ConvParams>> shapes = {
+        { "vae_conv_in",            { 1, 3,    128,  512, 512, 3, 1, true } },
+        { "unet_conv_in",           { 2, 4,    320,  64, 64, 3, 1, true } },
+        { "unet_res_320",           { 2, 320,  320,  64, 64, 3, 1, true } },
+        { "unet_down_320",          { 2, 320,  320,  64, 64, 3, 2, true } },
+        { "unet_res_640",           { 2, 640,  640,  32, 32, 3, 1, true } },
+        { "unet_res_320_640",       { 2, 320,  640,  32, 32, 3, 1, true } },
+        { "unet_skip_320_640",      { 2, 320,  640,  32, 32, 1, 1, true } },
+        { "unet_res_1280",          { 2, 1280, 1280, 16, 16, 3, 1, true } },
+        { "unet_res_1280_8x8",      { 2, 1280, 1280, 8,  8,  3, 1, true } },
+        { "unet_skip_2560_1280",    { 2, 2560, 1280, 16, 16, 1, 1, true } },
+        { "unet_skip_960_640",      { 2, 960,  640,  32, 32, 1, 1, true } },
+        { "unet_proj_320",          { 2, 320,  320,  64, 64, 1, 1, true } },
+        { "unet_proj_1280",         { 2, 1280, 1280, 16, 16, 1, 1, true } },
+        { "unet_conv_out",          { 2, 320,  4,    64, 64, 3, 1, true } },
+        { "llm_qkv_gen",            { 1, 4096, 12288, 1, 1, 1, 1, false } },
+        { "llm_o_proj_gen",         { 1, 4096, 4096,  1, 1, 1, 1, false } },
+        { "llm_mlp_up_gen",         { 1, 4096, 11008, 1, 1, 1, 1, false } },
+        { "llm_mlp_down_gen",       { 1, 11008, 4096, 1, 1, 1, 1, false } },
+        { "llm_qkv_prefill",        { 1, 4096, 12288, 1, 128, 1, 1, false } },
+        { "llm_mlp_up_prefill",     { 1, 4096, 11008, 1, 128, 1, 1, false } },
+        { "llm_mlp_down_prefill",   { 1, 11008, 4096, 1, 128, 1, 1, false } },
+    };
+
+    std::vector<ConvolutionCase> ret;
+    ret.reserve(shapes.size());
+    for (const auto& [name, params] : shapes)
+    {
+        ret.push_back(make_conv_case(name, params));
+    }
+    return ret;
+}
+
+/*
+*   Attention gemms of Stable Diffusion 1.5 UNet (batch 2, 8 heads) on every level of the UNet:
+*   self attention on the stacked QKV and cross attention with 77 text tokens (stacked KV), see libdml::GemmType.
+*/
+std::vector<GemmCase> get_gemm_corpus()
+{
+    using namespace libdml;
+    struct AttentionLevel
+    {
+        std::string name;
+        std::int32_t seq_len;
+        std::int32_t head_size;
+    };
+    const std::vector<AttentionLevel> levels = {
+        { "64x64", 4096, 40 },
+        { "32x32", 1024, 80 },
+        { "16x16", 256,  160 },
+        { "8x8",   64,   160 },
+    };
+    const std::int32_t batch = 2;
+    const std::int32_t heads = 8;
+    const std::int32_t text_tokens = 77;
+
+    std::vector<GemmCase> ret;
+    ret.reserve(levels.size() * 4);
+    for (const auto& level : levels)
+    {
+        const auto seq = level.seq_len;
+        const auto scale = 1.0f / std::sqrt(static_cast<float>(level.head_size));
+        const Tensor qkv{ { batch, seq, heads, 3, level.head_size }, DataLayout::eStackedHeads, DataType::eFp16 };
+        const Tensor q{ { batch, seq, heads, 1, level.head_size }, DataLayout::eStackedHeads, DataType::eFp16 };
+        const Tensor kv{ { batch, text_tokens, heads, 2, level.head_size }, DataLayout::eStackedHeads, DataType::eFp16 };
+        const Tensor self_scores{ { batch, heads, seq, seq }, DataLayout::eNCHW, DataType::eFp16 };
+        const Tensor cross_scores{ { batch, heads, seq, text_tokens }, DataLayout::eNCHW, DataType::eFp16 };
+        const Tensor attention_output{ { batch, heads, seq, level.head_size }, DataLayout::eNCHW, DataType::eFp16 };
+
+        GemmDescriptor desc{};
+        desc.type = GemmType::eQK_QKV;
+        desc.tensor_a = qkv;
+        desc.tensor_output = self_scores;
+        desc.alpha = scale;
+        ret.push_back({ "unet_self_qk_" + level.name, desc });
+
+        desc = GemmDescriptor{};
+        desc.type = GemmType::eSV_S_QKV;
+        desc.tensor_a = self_scores;
+        desc.tensor_b = qkv;
+        desc.tensor_output = attention_output;
+        ret.push_back({ "unet_self_sv_" + level.name, desc });
+
+        desc = GemmDescriptor{};
+        desc.type = GemmType::eQK_Q_KV;
+        desc.tensor_a = q;
+        desc.tensor_b = kv;
+        desc.tensor_output = cross_scores;
+        desc.alpha = scale;
+        ret.push_back({ "unet_cross_qk_" + level.name, desc });
+
+        desc = GemmDescriptor{};
+        desc.type = GemmType::eSV_S_KV;
+        desc.tensor_a = cross_scores;
+        desc.tensor_b = kv;
+        desc.tensor_output = attention_output;
+        ret.push_back({ "unet_cross_sv_" + level.name, desc });
+    }
+    return ret;
+}
+
+struct Measurement
+{
+    std::uint64_t calls = 0;
+    std::uint64_t allocations = 0;
+    std::chrono::nanoseconds time{ 0 };
+};
+
+// Runs func once per call and measures the whole loop (single call is too short for the clock).
+template<typename Func>
+Measurement measure(std::uint64_t calls, Func&& func)
+{
+    Measurement ret{};
+    ret.calls = calls;
+    const auto allocations_before = g_allocations_count.load(std::memory_order_relaxed);
+    const auto start = std::chrono::steady_clock::now();
+    for (std::uint64_t i = 0; i < calls; i++)
+    {
+        func(i);
+    }
+    ret.time = std::chrono::steady_clock::now() - start;
+    ret.allocations = g_allocations_count.load(std::memory_order_relaxed) - allocations_before;
+    return ret;
+}
+
+void print_measurement(const std::string& name, const Measurement& m)
+{
+    const auto calls = static_cast<double>(m.calls ? m.calls : 1);
+    std::cout << std::left << std::setw(40) << name << std::right << std::fixed
+        << std::setw(12) << std::setprecision(1) << static_cast<double>(m.time.count()) / calls << " ns/call"
+        << std::setw(10) << std::setprecision(2) << static_cast<double>(m.allocations) / calls << " allocs/call"
+        << std::setw(10) << m.calls << " calls" << std::endl;
+}
+
+struct CliOptions
+{
+    std::uint32_t iterations = 10'000;
+    std::uint32_t cold_rounds = 20;
+    libdml::HwPlatform platform = libdml::HwPlatform::eDG2;
+    std::uint32_t eu_count = 512;
+    bool per_case = false;
+};
+
+/*
+*   Phases of one primitive type. Cases are split by the support on the device: rejection is much cheaper than the real selection
+*   (no implementation is created), so the mixed average would describe neither of them. Queries run only on the supported cases.
+*   get_list(device_info, desc) returns the implementation list, get_kernel_info(primitive) queries the kernel of the fastest one.
+*/
+template<typename Descriptor, typename GetList, typename GetKernelInfo>
+void bench_primitive(const std::string& primitive_name, const std::vector<BenchCase<Descriptor>>& corpus, const CliOptions& opts,
+    GetList&& get_list, GetKernelInfo&& get_kernel_info)
+{
+    const libdml::DeviceInfo device_info{ opts.platform, opts.eu_count };
+
+    // also warms up the cache for device_info used by the cached phases
+    std::vector<const BenchCase<Descriptor>*> supported;
+    std::vector<const BenchCase<Descriptor>*> unsupported;
+    for (const auto& c : corpus)
+    {
+        (get_list(device_info, c.desc).empty() ? unsupported : supported).push_back(&c);
+    }
+    std::cout << "libdml bench: " << corpus.size() << " " << primitive_name << " descriptors, " << supported.size() << " supported on the device." << std::endl;
+
+    const auto bench_selection = [&](const std::string& group_name, const std::vector<const BenchCase<Descriptor>*>& cases)
+    {
+        if (cases.empty())
+        {
+            return;
+        }
+        const auto cases_count = static_cast<std::uint64_t>(cases.size());
+        // Cold selection: lists are cached per (device_info, desc) for the process lifetime,
+        // so every round uses different eu_count to miss the cache.
+        print_measurement(primitive_name + " selection (cold, " + group_name + ")", measure(cases_count * opts.cold_rounds, [&](std::uint64_t i)
+            {
+                const libdml::DeviceInfo round_device_info{ opts.platform, opts.eu_count + 1 + static_cast<std::uint32_t>(i / cases_count) };
+                (void)get_list(round_device_info, cases[i % cases_count]->desc);
+            }));
+        print_measurement(primitive_name + " selection (cached, " + group_name + ")", measure(cases_count * opts.iterations, [&](std::uint64_t i)
+            {
+                (void)get_list(device_info, cases[i % cases_count]->desc);
+            }));
+    };
+    bench_selection("supported", supported);
+    bench_selection("unsupported", unsupported);
+
+    // queries on the fastest implementation
+    using Primitive = std::decay_t<decltype(get_list(device_info, Descriptor{}).front())>;
+    std::vector<const Primitive*> primitives;
+    primitives.reserve(supported.size());
+    for (const auto* c : supported)
+    {
+        primitives.push_back(&get_list(device_info, c->desc).front());
+    }
+    const auto primitives_count = static_cast<std::uint64_t>(primitives.size());
+    if (primitives_count > 0)
+    {
+        print_measurement(primitive_name + " get_kernel_info", measure(primitives_count * opts.iterations, [&](std::uint64_t i)
+            {
+                (void)get_kernel_info(*primitives[i % primitives_count]);
+            }));
+        print_measurement(primitive_name + " get_execution_map", measure(primitives_count * opts.iterations, [&](std::uint64_t i)
+            {
+                libdml::ErrorCode error_code = libdml::ErrorCode::eSuccess;
+                (void)primitives[i % primitives_count]->get_execution_map(&error_code);
+            }));
+    }
+
+    if (opts.per_case)
+    {
+        std::cout << std::endl;
+        for (std::size_t i = 0; i < corpus.size(); i++)
+        {
+            const auto& list = get_list(device_info, corpus[i].desc);
+            std::cout << corpus[i].name << ": " << (list.empty() ? std::string("not supported") : list.front().get_info().name) << std::endl;
+            const libdml::DeviceInfo case_device_info{ opts.platform, opts.eu_count + opts.cold_rounds + 1 + static_cast<std::uint32_t>(i) };
+            print_measurement("  selection (cold)", measure(1, [&](std::uint64_t) { (void)get_list(case_device_info, corpus[i].desc); }));
+            print_measurement("  selection (cached)", measure(opts.iterations, [&](std::uint64_t) { (void)get_list(device_info, corpus[i].desc); }));
+            if (!list.empty())
+            {
+                print_measurement("  get_kernel_info", measure(opts.iterations, [&](std::uint64_t) { (void)get_kernel_info(list.front()); }));
+                print_measurement("  get_execution_map", measure(opts.iterations, [&](std::uint64_t)
+                    {
+                        libdml::ErrorCode error_code = libdml::ErrorCode::eSuccess;
+                        (void)list.front().get_execution_map(&error_code);
+                    }));
+            }
+        }
+    }
+    std::cout << std::endl;
+}
+
+} // namespace
+
+int main(int argc, const char*argv[])
+{
+    CliOptions opts;
+    CLI::App app{ "Measures latency and heap allocations of the libdml selection and query calls.", "libdml bench." };
+    app.add_option("--iters", opts.iterations, "How many times every descriptor is queried in the warm phases.")->check(CLI::Range(1u, 10'000'000u));
+    app.add_option("--cold_rounds", opts.cold_rounds, "How many times every descriptor goes through selection with empty cache.")->check(CLI::Range(1u, 1'000u));
+    app.add_option("--platform", opts.platform, "Platform passed in device info (libdml::HwPlatform value).")
+        ->check(CLI::IsMember({ libdml::HwPlatform::eSKL, libdml::HwPlatform::eTGL, libdml::HwPlatform::eADL, libdml::HwPlatform::eDG1, libdml::HwPlatform::eDG2 }));
+    app.add_option("--eu_count", opts.eu_count, "EU count passed in device info.")->check(CLI::Range(1u, 65'536u));
+    app.add_flag("--per_case", opts.per_case, "Print measurements of every descriptor, not only the whole corpus.");
+    CLI11_PARSE(app, argc, argv);
+
+    bench_primitive("convolution", get_convolution_corpus(), opts,
+        [](const libdml::DeviceInfo& device_info, const libdml::ConvolutionDescriptor& desc) -> const auto& { return libdml::get_convolution_implementation_list(device_info, desc); },
+        // layouts are queried with the kernel info, runtime does both before the kernel compilation
+        [](const libdml::ConvolutionPrimitive& primitive) { return primitive.get_kernel_info(primitive.query_preffered_layouts()); });
+
+    bench_primitive("gemm", get_gemm_corpus(), opts,
+        [](const libdml::DeviceInfo& device_info, const libdml::GemmDescriptor& desc) -> const auto& { return libdml::get_gemm_implementation_list(device_info, desc); },
+        [](const libdml::GemmPrimitive& primitive) { return primitive.get_kernel_info(); });
+    return 0;
+}